@@ -0,0 +1,2 @@
+/* Host build stand-in, see moto_kshim.h */
+#include "moto_kshim.h"
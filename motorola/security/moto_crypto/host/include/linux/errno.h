@@ -0,0 +1,3 @@
+/* Host build stand-in, see moto_kshim.h */
+#include <asm/errno.h>
+#include "moto_kshim.h"
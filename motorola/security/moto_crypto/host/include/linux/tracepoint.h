@@ -0,0 +1,18 @@
+/*
+ * Host build stand-in, see moto_kshim.h. Trace events compile to empty
+ * functions with the event's prototype.
+ */
+#include "moto_kshim.h"
+
+#ifndef _MOTO_KSHIM_TRACEPOINT_H
+#define _MOTO_KSHIM_TRACEPOINT_H
+
+#define TP_PROTO(args...) args
+#define TP_ARGS(args...) args
+#define DECLARE_EVENT_CLASS(name, proto, args, tstruct, assign, print)
+#define DEFINE_EVENT(template, name, proto, args) \
+    static inline void trace_##name(proto) { }
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print) \
+    static inline void trace_##name(proto) { }
+
+#endif
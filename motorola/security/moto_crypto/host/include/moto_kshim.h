@@ -0,0 +1,774 @@
+/*
+ * Userspace stand-ins for the subset of the kernel API used by the
+ * moto_crypto algorithm cores, so that they and moto_testmgr.c can be built
+ * and run on the host. Everything runs in one thread: locks are no-ops,
+ * per-CPU data is indexed by kshim_cpu and work items only run from
+ * kshim_run_work().
+ */
+#ifndef _MOTO_KSHIM_H
+#define _MOTO_KSHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+
+typedef uint8_t u8; typedef uint16_t u16; typedef uint32_t u32; typedef unsigned long long u64;
+typedef int8_t s8; typedef int16_t s16; typedef int32_t s32; typedef long long s64;
+typedef uint8_t __u8; typedef uint16_t __u16; typedef uint32_t __u32; typedef unsigned long long __u64;
+typedef u16 __le16, __be16; typedef u32 __le32, __be32; typedef u64 __le64, __be64;
+typedef unsigned int gfp_t;
+
+#define __be32_to_cpu(x) __builtin_bswap32(x)
+#define __be64_to_cpu(x) __builtin_bswap64(x)
+#define __cpu_to_be32(x) __builtin_bswap32(x)
+#define __cpu_to_be64(x) __builtin_bswap64(x)
+#define le32_to_cpu(x) ((u32)(x))
+#define cpu_to_le32(x) ((u32)(x))
+#define le64_to_cpu(x) ((u64)(x))
+#define cpu_to_le64(x) ((u64)(x))
+#define be32_to_cpu(x) __builtin_bswap32(x)
+#define cpu_to_be32(x) __builtin_bswap32(x)
+#define be64_to_cpu(x) __builtin_bswap64(x)
+#define cpu_to_be64(x) __builtin_bswap64(x)
+#define le32_to_cpup(p) (*(const u32 *)(p))
+#define be32_to_cpup(p) be32_to_cpu(*(const u32 *)(p))
+#define cpu_to_be16(x) __builtin_bswap16(x)
+static inline u32 get_unaligned_be32(const void *p) { u32 v; memcpy(&v, p, 4); return be32_to_cpu(v); }
+static inline u64 get_unaligned_be64(const void *p) { u64 v; memcpy(&v, p, 8); return be64_to_cpu(v); }
+static inline void put_unaligned_be32(u32 v, void *p) { v = cpu_to_be32(v); memcpy(p, &v, 4); }
+static inline void put_unaligned_be64(u64 v, void *p) { v = cpu_to_be64(v); memcpy(p, &v, 8); }
+static inline u32 get_unaligned_le32(const void *p) { u32 v; memcpy(&v, p, 4); return v; }
+static inline void put_unaligned_le32(u32 v, void *p) { memcpy(p, &v, 4); }
+static inline u64 get_unaligned_le64(const void *p) { u64 v; memcpy(&v, p, 8); return v; }
+static inline void put_unaligned_le64(u64 v, void *p) { memcpy(p, &v, 8); }
+static inline u32 rol32(u32 w, unsigned s) { return (w << s) | (w >> ((32 - s) & 31)); }
+static inline u32 ror32(u32 w, unsigned s) { return (w >> s) | (w << ((32 - s) & 31)); }
+static inline u64 ror64(u64 w, unsigned s) { return (w >> s) | (w << ((64 - s) & 63)); }
+static inline u64 rol64(u64 w, unsigned s) { return (w << s) | (w >> ((64 - s) & 63)); }
+
+#define __init
+#define __exit
+#define __initdata
+#define __read_mostly
+#define __used __attribute__((used))
+#define __aligned(x) __attribute__((aligned(x)))
+#undef __attribute_const__
+#define __attribute_const__
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+#define ACCESS_ONCE(x) (*(volatile typeof(x) *)&(x))
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define ALIGN(x, a) (((x) + ((a) - 1)) & ~((typeof(x))(a) - 1))
+#define PTR_ALIGN(p, a) ((typeof(p))ALIGN((unsigned long)(p), (a)))
+#define IS_ALIGNED(x, a) (((x) & ((typeof(x))(a) - 1)) == 0)
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define min_t(t, a, b) ((t)(a) < (t)(b) ? (t)(a) : (t)(b))
+#define max_t(t, a, b) ((t)(a) > (t)(b) ? (t)(a) : (t)(b))
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#define BUG_ON(c) do { if (c) { fprintf(stderr, "BUG at %s:%d\n", __FILE__, __LINE__); abort(); } } while (0)
+#define BUG() BUG_ON(1)
+#define WARN_ON(c) ({ int __w = !!(c); if (__w) fprintf(stderr, "WARN at %s:%d\n", __FILE__, __LINE__); __w; })
+#define BUILD_BUG_ON(c) _Static_assert(!(c), #c)
+#define barrier() __asm__ __volatile__("" ::: "memory")
+
+#define KERN_EMERG "<0>"
+#define KERN_ALERT "<1>"
+#define KERN_CRIT "<2>"
+#define KERN_ERR "<3>"
+#define KERN_WARNING "<4>"
+#define KERN_NOTICE "<5>"
+#define KERN_INFO "<6>"
+#define KERN_DEBUG "<7>"
+#define KERN_CONT ""
+extern int kshim_verbose;
+#define printk(...) (kshim_verbose ? printf(__VA_ARGS__) : 0)
+#define pr_info(...) printk(__VA_ARGS__)
+#define pr_err(...) printk(__VA_ARGS__)
+#define pr_debug(...) 0
+enum { DUMP_PREFIX_NONE, DUMP_PREFIX_ADDRESS, DUMP_PREFIX_OFFSET };
+void print_hex_dump(const char *level, const char *prefix, int type, int rowsize,
+        int groupsize, const void *buf, size_t len, bool ascii);
+void panic(const char *fmt, ...) __attribute__((noreturn));
+
+struct module { int dummy; };
+extern struct module __this_module;
+#define THIS_MODULE (&__this_module)
+#define EXPORT_SYMBOL(x)
+#define EXPORT_SYMBOL_GPL(x)
+#define MODULE_LICENSE(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_AUTHOR(x)
+#define MODULE_ALIAS(x)
+#define module_param(n, t, p) __typeof__(n) *kshim_param_##n(void) { return &n; }
+#define module_param_named(n, v, t, p)
+#define MODULE_PARM_DESC(n, d)
+#define module_init(f)
+#define module_exit(f)
+#define late_initcall(f)
+
+#define GFP_KERNEL 0
+#define GFP_ATOMIC 1
+#define __GFP_ZERO 2
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1UL << PAGE_SHIFT)
+#define PAGE_MASK (~(PAGE_SIZE - 1))
+#define offset_in_page(p) ((unsigned long)(p) & ~PAGE_MASK)
+static inline void *kmalloc(size_t n, gfp_t f) { void *p = malloc(n ? n : 1); if (p && (f & __GFP_ZERO)) memset(p, 0, n); return p; }
+static inline void *kzalloc(size_t n, gfp_t f) { return calloc(1, n ? n : 1); }
+static inline void kfree(const void *p) { free((void *)p); }
+static inline void kzfree(const void *p) { free((void *)p); }
+static inline void *vmalloc(size_t n) { return malloc(n); }
+static inline void vfree(const void *p) { free((void *)p); }
+static inline unsigned long __get_free_page(gfp_t f) { void *p = NULL; if (posix_memalign(&p, PAGE_SIZE, PAGE_SIZE)) return 0; return (unsigned long)p; }
+static inline unsigned long get_zeroed_page(gfp_t f) { unsigned long p = __get_free_page(f); if (p) memset((void *)p, 0, PAGE_SIZE); return p; }
+static inline void free_page(unsigned long p) { free((void *)p); }
+
+#define MAX_ERRNO 4095
+#define IS_ERR_VALUE(x) ((unsigned long)(x) >= (unsigned long)-MAX_ERRNO)
+static inline void *ERR_PTR(long e) { return (void *)e; }
+static inline long PTR_ERR(const void *p) { return (long)p; }
+static inline bool IS_ERR(const void *p) { return IS_ERR_VALUE((unsigned long)p); }
+static inline bool IS_ERR_OR_NULL(const void *p) { return !p || IS_ERR(p); }
+#define ERESTARTSYS 512
+
+typedef struct { int dummy; } spinlock_t;
+#define spin_lock_init(l) ((void)(l))
+#define spin_lock(l) ((void)(l))
+#define spin_unlock(l) ((void)(l))
+#define spin_lock_bh(l) ((void)(l))
+#define spin_unlock_bh(l) ((void)(l))
+#define spin_lock_irqsave(l, f) ((void)(l), (f) = 0)
+#define spin_unlock_irqrestore(l, f) ((void)(l), (void)(f))
+#define DEFINE_SPINLOCK(x) spinlock_t x
+struct mutex { int dummy; };
+#define DEFINE_MUTEX(x) struct mutex x
+#define mutex_init(m) ((void)(m))
+#define mutex_lock(m) ((void)(m))
+#define mutex_unlock(m) ((void)(m))
+
+/*
+ * Static per-CPU variables have a single instance that belongs to cpu 0;
+ * per_cpu() reads of the other CPUs see zeroes so that sums over
+ * for_each_possible_cpu() stay exact.
+ */
+#define DEFINE_PER_CPU(type, name) __typeof__(type) per_cpu__##name
+extern const u64 kshim_percpu_zero[];
+#define per_cpu(var, cpu) (*((cpu) ? \
+        (__typeof__(per_cpu__##var) *)kshim_percpu_zero : &per_cpu__##var))
+#define this_cpu_inc(x) ((per_cpu__##x)++)
+#define this_cpu_add(x, v) ((per_cpu__##x) += (v))
+#define get_cpu_var(name) (per_cpu__##name)
+#define __get_cpu_var(name) (per_cpu__##name)
+#define put_cpu_var(name) ((void)0)
+#define KSHIM_NR_CPUS 4
+extern int kshim_cpu;
+#define __percpu
+#define smp_processor_id() kshim_cpu
+#define alloc_percpu(type) ((type *)calloc(KSHIM_NR_CPUS, sizeof(type)))
+#define free_percpu(p) free(p)
+#define per_cpu_ptr(p, cpu) (&(p)[cpu])
+#define get_cpu_ptr(p) (&(p)[kshim_cpu])
+#define put_cpu_ptr(p) ((void)(p))
+#define for_each_possible_cpu(c) for ((c) = 0; (c) < KSHIM_NR_CPUS; (c)++)
+#define get_cpu() 0
+#define put_cpu() ((void)0)
+#define preempt_disable() ((void)0)
+#define preempt_enable() ((void)0)
+#define local_bh_disable() ((void)0)
+#define local_bh_enable() ((void)0)
+#define might_sleep() ((void)0)
+#define cond_resched() ((void)0)
+
+struct completion { int done; };
+#define init_completion(c) ((c)->done = 0)
+#define complete(c) ((c)->done = 1)
+#define complete_all(c) ((c)->done = 1)
+#define wait_for_completion(c) ((void)0)
+#define wait_for_completion_interruptible(c) 0
+#define INIT_COMPLETION(c) ((c).done = 0)
+
+
+struct list_head { struct list_head *next, *prev; };
+#define LIST_HEAD_INIT(name) { &(name), &(name) }
+#define LIST_HEAD(name) struct list_head name = LIST_HEAD_INIT(name)
+static inline void list_add_tail(struct list_head *n, struct list_head *h) { n->prev = h->prev; n->next = h; h->prev->next = n; h->prev = n; }
+static inline void list_del(struct list_head *e) { e->prev->next = e->next; e->next->prev = e->prev; }
+#define list_entry(p, t, m) container_of(p, t, m)
+#define list_for_each_entry(pos, head, m) for (pos = list_entry((head)->next, __typeof__(*pos), m); &pos->m != (head); pos = list_entry(pos->m.next, __typeof__(*pos), m))
+#define list_for_each_entry_safe(pos, n, head, m) for (pos = list_entry((head)->next, __typeof__(*pos), m), n = list_entry(pos->m.next, __typeof__(*pos), m); &pos->m != (head); pos = n, n = list_entry(n->m.next, __typeof__(*n), m))
+struct task_struct { int pid; };
+extern struct task_struct kshim_task;
+#define current (&kshim_task)
+#define scnprintf(b, n, ...) ({ int __r = snprintf(b, n, __VA_ARGS__); (size_t)__r >= (size_t)(n) ? (int)((n) ? (n) - 1 : 0) : __r; })
+
+/* ------------------------------------------------------------------ */
+/* scatterlist */
+
+struct page;
+struct scatterlist {
+    void *buf;
+    unsigned int offset;
+    unsigned int length;
+    struct scatterlist *chain;
+    bool end;
+};
+
+static inline void sg_init_table(struct scatterlist *sg, unsigned int n)
+{
+    memset(sg, 0, sizeof(*sg) * n);
+    sg[n - 1].end = true;
+}
+static inline void sg_set_buf(struct scatterlist *sg, const void *buf, unsigned int len)
+{
+    /* kernel layout: page base plus offset within the page */
+    sg->buf = (void *)((unsigned long)buf & ~4095UL); sg->offset = (unsigned long)buf & 4095; sg->length = len;
+}
+static inline void sg_init_one(struct scatterlist *sg, const void *buf, unsigned int len)
+{
+    sg_init_table(sg, 1);
+    sg_set_buf(sg, buf, len);
+}
+static inline void sg_mark_end(struct scatterlist *sg) { sg->end = true; }
+static inline struct scatterlist *sg_next(struct scatterlist *sg)
+{
+    if (sg->end)
+        return NULL;
+    sg++;
+    if (sg->chain)
+        sg = sg->chain;
+    return sg;
+}
+static inline void sg_chain(struct scatterlist *prv, unsigned int nents, struct scatterlist *sgl)
+{
+    prv[nents - 1].chain = sgl; prv[nents - 1].end = false;
+}
+static inline void sg_set_page(struct scatterlist *sg, struct page *page, unsigned int len, unsigned int offset)
+{
+    sg->buf = (void *)page; sg->offset = offset; sg->length = len;
+}
+static inline void *sg_virt(struct scatterlist *sg) { return (u8 *)sg->buf + sg->offset; }
+#define for_each_sg(sglist, sg, nr, __i) \
+    for (__i = 0, sg = (sglist); __i < (nr); __i++, sg = sg_next(sg))
+
+/* ------------------------------------------------------------------ */
+/* crypto core */
+
+#define CRYPTO_MAX_ALG_NAME 64
+#define CRYPTO_ALG_TYPE_MASK 0x0000000f
+#define CRYPTO_ALG_TYPE_CIPHER 0x00000001
+#define CRYPTO_ALG_TYPE_COMPRESS 0x00000002
+#define CRYPTO_ALG_TYPE_AEAD 0x00000003
+#define CRYPTO_ALG_TYPE_BLKCIPHER 0x00000004
+#define CRYPTO_ALG_TYPE_ABLKCIPHER 0x00000005
+#define CRYPTO_ALG_TYPE_GIVCIPHER 0x00000006
+#define CRYPTO_ALG_TYPE_DIGEST 0x00000008
+#define CRYPTO_ALG_TYPE_HASH 0x00000008
+#define CRYPTO_ALG_TYPE_SHASH 0x00000009
+#define CRYPTO_ALG_TYPE_AHASH 0x0000000a
+#define CRYPTO_ALG_TYPE_RNG 0x0000000c
+#define CRYPTO_ALG_TYPE_HASH_MASK 0x0000000e
+#define CRYPTO_ALG_TYPE_AHASH_MASK 0x0000000e
+#define CRYPTO_ALG_TYPE_BLKCIPHER_MASK 0x0000000c
+#define CRYPTO_ALG_ASYNC 0x00000080
+#define CRYPTO_ALG_NEED_FALLBACK 0x00000100
+#define CRYPTO_ALG_INSTANCE 0x00000800
+#define CRYPTO_TFM_REQ_MASK 0x000fff00
+#define CRYPTO_TFM_RES_MASK 0xfff00000
+#define CRYPTO_TFM_REQ_WEAK_KEY 0x00000100
+#define CRYPTO_TFM_REQ_MAY_SLEEP 0x00000200
+#define CRYPTO_TFM_REQ_MAY_BACKLOG 0x00000400
+#define CRYPTO_TFM_RES_WEAK_KEY 0x00100000
+#define CRYPTO_TFM_RES_BAD_KEY_LEN 0x00200000
+#define CRYPTO_TFM_RES_BAD_KEY_SCHED 0x00400000
+#define CRYPTO_TFM_RES_BAD_BLOCK_LEN 0x00800000
+#define CRYPTO_TFM_RES_BAD_FLAGS 0x01000000
+#define CRYPTO_MINALIGN 16
+#define CRYPTO_MINALIGN_ATTR __attribute__((aligned(CRYPTO_MINALIGN)))
+
+struct crypto_tfm;
+struct crypto_blkcipher;
+struct crypto_rng;
+struct crypto_aead;
+struct crypto_type;
+struct aead_request;
+struct aead_givcrypt_request;
+struct scatterlist;
+
+struct blkcipher_desc {
+    struct crypto_blkcipher *tfm;
+    void *info;
+    u32 flags;
+};
+
+struct blkcipher_alg {
+    int (*setkey)(struct crypto_tfm *tfm, const u8 *key, unsigned int keylen);
+    int (*encrypt)(struct blkcipher_desc *desc, struct scatterlist *dst,
+            struct scatterlist *src, unsigned int nbytes);
+    int (*decrypt)(struct blkcipher_desc *desc, struct scatterlist *dst,
+            struct scatterlist *src, unsigned int nbytes);
+    const char *geniv;
+    unsigned int min_keysize;
+    unsigned int max_keysize;
+    unsigned int ivsize;
+};
+
+struct cipher_alg {
+    unsigned int cia_min_keysize;
+    unsigned int cia_max_keysize;
+    int (*cia_setkey)(struct crypto_tfm *tfm, const u8 *key, unsigned int keylen);
+    void (*cia_encrypt)(struct crypto_tfm *tfm, u8 *dst, const u8 *src);
+    void (*cia_decrypt)(struct crypto_tfm *tfm, u8 *dst, const u8 *src);
+};
+
+struct rng_alg {
+    int (*rng_make_random)(struct crypto_rng *tfm, u8 *rdata, unsigned int dlen);
+    int (*rng_reset)(struct crypto_rng *tfm, u8 *seed, unsigned int slen);
+    unsigned int seedsize;
+};
+
+struct aead_alg {
+    int (*setkey)(struct crypto_aead *tfm, const u8 *key, unsigned int keylen);
+    int (*setauthsize)(struct crypto_aead *tfm, unsigned int authsize);
+    int (*encrypt)(struct aead_request *req);
+    int (*decrypt)(struct aead_request *req);
+    int (*givencrypt)(struct aead_givcrypt_request *req);
+    int (*givdecrypt)(struct aead_givcrypt_request *req);
+    const char *geniv;
+    unsigned int ivsize;
+    unsigned int maxauthsize;
+};
+
+struct crypto_alg {
+    struct list_head cra_list;
+    struct list_head cra_users;
+    u32 cra_flags;
+    unsigned int cra_blocksize;
+    unsigned int cra_ctxsize;
+    unsigned int cra_alignmask;
+    int cra_priority;
+    int cra_refcnt;
+    char cra_name[CRYPTO_MAX_ALG_NAME];
+    char cra_driver_name[CRYPTO_MAX_ALG_NAME];
+    const struct crypto_type *cra_type;
+    union {
+        struct blkcipher_alg blkcipher;
+        struct cipher_alg cipher;
+        struct rng_alg rng;
+        struct aead_alg aead;
+    } cra_u;
+    int (*cra_init)(struct crypto_tfm *tfm);
+    void (*cra_exit)(struct crypto_tfm *tfm);
+    void (*cra_destroy)(struct crypto_alg *alg);
+    struct module *cra_module;
+    /* shim */
+    struct crypto_alg *kshim_next;
+    int kshim_registered;
+};
+#define cra_blkcipher cra_u.blkcipher
+#define cra_cipher cra_u.cipher
+#define cra_rng cra_u.rng
+#define cra_aead cra_u.aead
+
+struct crypto_type { int id; };
+extern const struct crypto_type crypto_blkcipher_type;
+extern const struct crypto_type crypto_rng_type;
+extern const struct crypto_type crypto_aead_type;
+extern const struct crypto_type crypto_ablkcipher_type;
+
+struct crypto_tfm {
+    u32 crt_flags;
+    u8 crt_iv[64];
+    unsigned int crt_authsize;
+    unsigned int crt_reqsize;
+    void (*exit)(struct crypto_tfm *tfm);
+    struct crypto_alg *__crt_alg;
+    void *__crt_ctx[] CRYPTO_MINALIGN_ATTR;
+};
+
+static inline void *crypto_tfm_ctx(struct crypto_tfm *tfm) { return tfm->__crt_ctx; }
+static inline unsigned int crypto_tfm_ctx_alignment(void) { return CRYPTO_MINALIGN; }
+static inline const char *crypto_tfm_alg_name(struct crypto_tfm *tfm) { return tfm->__crt_alg->cra_name; }
+static inline const char *crypto_tfm_alg_driver_name(struct crypto_tfm *tfm) { return tfm->__crt_alg->cra_driver_name; }
+static inline unsigned int crypto_tfm_alg_blocksize(struct crypto_tfm *tfm) { return tfm->__crt_alg->cra_blocksize; }
+static inline unsigned int crypto_tfm_alg_alignmask(struct crypto_tfm *tfm) { return tfm->__crt_alg->cra_alignmask; }
+static inline u32 crypto_tfm_get_flags(struct crypto_tfm *tfm) { return tfm->crt_flags; }
+static inline void crypto_tfm_set_flags(struct crypto_tfm *tfm, u32 f) { tfm->crt_flags |= f; }
+static inline void crypto_tfm_clear_flags(struct crypto_tfm *tfm, u32 f) { tfm->crt_flags &= ~f; }
+
+int crypto_register_alg(struct crypto_alg *alg);
+int crypto_unregister_alg(struct crypto_alg *alg);
+int crypto_register_algs(struct crypto_alg *algs, int count);
+int crypto_unregister_algs(struct crypto_alg *algs, int count);
+struct crypto_alg *kshim_find_alg(const char *name, u32 type, u32 mask);
+void *kshim_alloc_tfm(struct crypto_alg *alg, size_t head);
+int crypto_has_alg(const char *name, u32 type, u32 mask);
+static inline void crypto_mod_put(struct crypto_alg *alg) { }
+
+/* blkcipher */
+struct crypto_blkcipher { struct crypto_tfm base; };
+static inline struct crypto_tfm *crypto_blkcipher_tfm(struct crypto_blkcipher *t) { return &t->base; }
+static inline void *crypto_blkcipher_ctx(struct crypto_blkcipher *t) { return crypto_tfm_ctx(&t->base); }
+static inline struct crypto_blkcipher *__crypto_blkcipher_cast(struct crypto_tfm *t) { return (struct crypto_blkcipher *)t; }
+static inline u32 crypto_blkcipher_get_flags(struct crypto_blkcipher *t) { return t->base.crt_flags; }
+static inline void crypto_blkcipher_set_flags(struct crypto_blkcipher *t, u32 f) { t->base.crt_flags |= f; }
+static inline void crypto_blkcipher_clear_flags(struct crypto_blkcipher *t, u32 f) { t->base.crt_flags &= ~f; }
+static inline unsigned int crypto_blkcipher_blocksize(struct crypto_blkcipher *t) { return t->base.__crt_alg->cra_blocksize; }
+static inline unsigned int crypto_blkcipher_ivsize(struct crypto_blkcipher *t) { return t->base.__crt_alg->cra_blkcipher.ivsize; }
+static inline struct crypto_blkcipher *crypto_blkcipher_cast(struct crypto_tfm *t) { return (struct crypto_blkcipher *)t; }
+struct crypto_blkcipher *crypto_alloc_blkcipher(const char *name, u32 type, u32 mask);
+void crypto_free_blkcipher(struct crypto_blkcipher *t);
+int crypto_blkcipher_setkey(struct crypto_blkcipher *t, const u8 *key, unsigned int keylen);
+int crypto_blkcipher_encrypt(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n);
+int crypto_blkcipher_decrypt(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n);
+int crypto_blkcipher_encrypt_iv(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n);
+int crypto_blkcipher_decrypt_iv(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n);
+static inline void crypto_blkcipher_set_iv(struct crypto_blkcipher *t, const u8 *iv, unsigned int len) { memcpy(t->base.crt_iv, iv, len); }
+
+struct scatter_walk {
+    struct scatterlist *sg;
+    unsigned int offset;
+};
+
+struct blkcipher_walk {
+    union { struct { void *addr; } virt; } src, dst;
+    struct scatter_walk in, out;
+    u8 *iv;
+    unsigned int nbytes;
+    unsigned int total;
+    unsigned int blocksize;
+    int slow;
+    u8 bounce[64];
+};
+void blkcipher_walk_init(struct blkcipher_walk *w, struct scatterlist *dst, struct scatterlist *src, unsigned int nbytes);
+int blkcipher_walk_virt(struct blkcipher_desc *d, struct blkcipher_walk *w);
+int blkcipher_walk_virt_block(struct blkcipher_desc *d, struct blkcipher_walk *w, unsigned int bs);
+int blkcipher_walk_done(struct blkcipher_desc *d, struct blkcipher_walk *w, int err);
+
+void scatterwalk_start(struct scatter_walk *w, struct scatterlist *sg);
+void scatterwalk_copychunks(void *buf, struct scatter_walk *w, size_t nbytes, int out);
+void scatterwalk_map_and_copy(void *buf, struct scatterlist *sg, unsigned int start, unsigned int nbytes, int out);
+static inline void scatterwalk_crypto_chain(struct scatterlist *head, struct scatterlist *sg, int chain, int num)
+{
+    if (chain) { head->length += sg->length; sg = sg_next(sg); }
+    if (sg) sg_chain(head, num, sg); else sg_mark_end(head);
+}
+
+/* ablkcipher (synchronous wrapper over blkcipher) */
+struct crypto_async_request;
+typedef void (*crypto_completion_t)(struct crypto_async_request *req, int err);
+struct crypto_async_request {
+    crypto_completion_t complete;
+    void *data;
+    struct crypto_tfm *tfm;
+    u32 flags;
+};
+struct crypto_ablkcipher { struct crypto_tfm base; };
+struct ablkcipher_request {
+    struct crypto_async_request base;
+    unsigned int nbytes;
+    void *info;
+    struct scatterlist *src;
+    struct scatterlist *dst;
+};
+struct crypto_ablkcipher *crypto_alloc_ablkcipher(const char *name, u32 type, u32 mask);
+static inline void crypto_free_ablkcipher(struct crypto_ablkcipher *t) { crypto_free_blkcipher((struct crypto_blkcipher *)t); }
+static inline struct crypto_tfm *crypto_ablkcipher_tfm(struct crypto_ablkcipher *t) { return &t->base; }
+static inline u32 crypto_ablkcipher_get_flags(struct crypto_ablkcipher *t) { return t->base.crt_flags; }
+static inline void crypto_ablkcipher_set_flags(struct crypto_ablkcipher *t, u32 f) { t->base.crt_flags |= f; }
+static inline void crypto_ablkcipher_clear_flags(struct crypto_ablkcipher *t, u32 f) { t->base.crt_flags &= ~f; }
+static inline int crypto_ablkcipher_setkey(struct crypto_ablkcipher *t, const u8 *k, unsigned int l) { return crypto_blkcipher_setkey((struct crypto_blkcipher *)t, k, l); }
+static inline struct ablkcipher_request *ablkcipher_request_alloc(struct crypto_ablkcipher *t, gfp_t g)
+{ struct ablkcipher_request *r = calloc(1, sizeof(*r)); r->base.tfm = &t->base; return r; }
+static inline void ablkcipher_request_free(struct ablkcipher_request *r) { free(r); }
+static inline void ablkcipher_request_set_callback(struct ablkcipher_request *r, u32 f, crypto_completion_t c, void *d)
+{ r->base.flags = f; r->base.complete = c; r->base.data = d; }
+static inline void ablkcipher_request_set_crypt(struct ablkcipher_request *r, struct scatterlist *src, struct scatterlist *dst, unsigned int n, void *iv)
+{ r->src = src; r->dst = dst; r->nbytes = n; r->info = iv; }
+int crypto_ablkcipher_encrypt(struct ablkcipher_request *r);
+int crypto_ablkcipher_decrypt(struct ablkcipher_request *r);
+
+/* rng */
+struct crypto_rng { struct crypto_tfm base; };
+static inline struct crypto_tfm *crypto_rng_tfm(struct crypto_rng *t) { return &t->base; }
+static inline void *crypto_rng_ctx(struct crypto_rng *t) { return crypto_tfm_ctx(&t->base); }
+static inline struct crypto_rng *__crypto_rng_cast(struct crypto_tfm *t) { return (struct crypto_rng *)t; }
+struct crypto_rng *crypto_alloc_rng(const char *name, u32 type, u32 mask);
+static inline void crypto_free_rng(struct crypto_rng *t) { crypto_free_blkcipher((struct crypto_blkcipher *)t); }
+static inline int crypto_rng_seedsize(struct crypto_rng *t) { return t->base.__crt_alg->cra_rng.seedsize; }
+static inline int crypto_rng_reset(struct crypto_rng *t, u8 *seed, unsigned int slen) { return t->base.__crt_alg->cra_rng.rng_reset(t, seed, slen); }
+static inline int crypto_rng_get_bytes(struct crypto_rng *t, u8 *buf, unsigned int len) { return t->base.__crt_alg->cra_rng.rng_make_random(t, buf, len); }
+
+/* aead */
+struct crypto_aead { struct crypto_tfm base; };
+struct aead_request {
+    struct crypto_async_request base;
+    unsigned int assoclen;
+    unsigned int cryptlen;
+    u8 *iv;
+    struct scatterlist *assoc;
+    struct scatterlist *src;
+    struct scatterlist *dst;
+};
+struct crypto_aead *crypto_alloc_aead(const char *name, u32 type, u32 mask);
+static inline void crypto_free_aead(struct crypto_aead *t) { crypto_free_blkcipher((struct crypto_blkcipher *)t); }
+static inline struct crypto_tfm *crypto_aead_tfm(struct crypto_aead *t) { return &t->base; }
+static inline void *crypto_aead_ctx(struct crypto_aead *t) { return crypto_tfm_ctx(&t->base); }
+static inline unsigned int crypto_aead_authsize(struct crypto_aead *t) { return t->base.crt_authsize; }
+static inline unsigned int crypto_aead_ivsize(struct crypto_aead *t) { return t->base.__crt_alg->cra_aead.ivsize; }
+static inline u32 crypto_aead_get_flags(struct crypto_aead *t) { return t->base.crt_flags; }
+static inline void crypto_aead_set_flags(struct crypto_aead *t, u32 f) { t->base.crt_flags |= f; }
+static inline void crypto_aead_clear_flags(struct crypto_aead *t, u32 f) { t->base.crt_flags &= ~f; }
+static inline struct crypto_aead *crypto_aead_reqtfm(struct aead_request *r) { return (struct crypto_aead *)r->base.tfm; }
+int crypto_aead_setkey(struct crypto_aead *t, const u8 *key, unsigned int keylen);
+int crypto_aead_setauthsize(struct crypto_aead *t, unsigned int authsize);
+static inline struct aead_request *aead_request_alloc(struct crypto_aead *t, gfp_t g)
+{ struct aead_request *r = calloc(1, sizeof(*r)); r->base.tfm = &t->base; return r; }
+static inline void aead_request_free(struct aead_request *r) { free(r); }
+static inline void aead_request_set_callback(struct aead_request *r, u32 f, crypto_completion_t c, void *d)
+{ r->base.flags = f; r->base.complete = c; r->base.data = d; }
+static inline void aead_request_set_crypt(struct aead_request *r, struct scatterlist *src, struct scatterlist *dst, unsigned int n, void *iv)
+{ r->src = src; r->dst = dst; r->cryptlen = n; r->iv = iv; }
+static inline void aead_request_set_assoc(struct aead_request *r, struct scatterlist *assoc, unsigned int n)
+{ r->assoc = assoc; r->assoclen = n; }
+static inline int crypto_aead_encrypt(struct aead_request *r) { return r->base.tfm->__crt_alg->cra_aead.encrypt(r); }
+static inline int crypto_aead_decrypt(struct aead_request *r) { return r->base.tfm->__crt_alg->cra_aead.decrypt(r); }
+struct aead_givcrypt_request { u64 seq; u8 *giv; struct aead_request areq; };
+static inline struct crypto_aead *aead_givcrypt_reqtfm(struct aead_givcrypt_request *r) { return crypto_aead_reqtfm(&r->areq); }
+static inline int crypto_aead_givencrypt(struct aead_givcrypt_request *r) { return r->areq.base.tfm->__crt_alg->cra_aead.givencrypt(r); }
+
+/* scatterwalk, pages are simulated at 4K boundaries of the virtual address */
+static inline unsigned int scatterwalk_clamp(struct scatter_walk *w, unsigned int nbytes)
+{
+    unsigned long addr = (unsigned long)w->sg->buf + w->offset;
+    unsigned int len = w->sg->offset + w->sg->length - w->offset;
+    unsigned int page = 4096 - (addr & 4095);
+    if (len > page) len = page;
+    return nbytes > len ? len : nbytes;
+}
+static inline void *scatterwalk_map(struct scatter_walk *w) { return (u8 *)w->sg->buf + w->offset; }
+static inline void scatterwalk_unmap(void *p) { }
+static inline struct page *scatterwalk_page(struct scatter_walk *w) { return (struct page *)((unsigned long)scatterwalk_map(w) & ~4095UL); }
+static inline void scatterwalk_advance(struct scatter_walk *w, unsigned int n) { w->offset += n; }
+static inline void scatterwalk_done(struct scatter_walk *w, int out, int more)
+{
+    while (more && w->sg && w->offset >= w->sg->offset + w->sg->length) {
+        w->sg = sg_next(w->sg);
+        w->offset = w->sg ? w->sg->offset : 0;
+    }
+}
+
+/* shash */
+struct crypto_shash;
+struct shash_desc {
+    struct crypto_shash *tfm;
+    u32 flags;
+    void *__ctx[] CRYPTO_MINALIGN_ATTR;
+};
+struct shash_alg {
+    int (*init)(struct shash_desc *desc);
+    int (*update)(struct shash_desc *desc, const u8 *data, unsigned int len);
+    int (*final)(struct shash_desc *desc, u8 *out);
+    int (*finup)(struct shash_desc *desc, const u8 *data, unsigned int len, u8 *out);
+    int (*digest)(struct shash_desc *desc, const u8 *data, unsigned int len, u8 *out);
+    int (*export)(struct shash_desc *desc, void *out);
+    int (*import)(struct shash_desc *desc, const void *in);
+    int (*setkey)(struct crypto_shash *tfm, const u8 *key, unsigned int keylen);
+    unsigned int descsize;
+    unsigned int digestsize;
+    unsigned int statesize;
+    struct crypto_alg base;
+};
+struct crypto_shash {
+    unsigned int descsize;
+    struct crypto_tfm base;
+};
+static inline struct shash_alg *__crypto_shash_alg(struct crypto_alg *a) { return container_of(a, struct shash_alg, base); }
+static inline struct shash_alg *crypto_shash_alg(struct crypto_shash *t) { return __crypto_shash_alg(t->base.__crt_alg); }
+static inline struct crypto_tfm *crypto_shash_tfm(struct crypto_shash *t) { return &t->base; }
+static inline struct crypto_shash *__crypto_shash_cast(struct crypto_tfm *t) { return container_of(t, struct crypto_shash, base); }
+static inline void *crypto_shash_ctx(struct crypto_shash *t) { return crypto_tfm_ctx(&t->base); }
+static inline void *crypto_shash_ctx_aligned(struct crypto_shash *t) { return crypto_tfm_ctx(&t->base); }
+static inline void *shash_desc_ctx(struct shash_desc *d) { return d->__ctx; }
+static inline unsigned int crypto_shash_descsize(struct crypto_shash *t) { return t->descsize; }
+static inline unsigned int crypto_shash_digestsize(struct crypto_shash *t) { return crypto_shash_alg(t)->digestsize; }
+static inline unsigned int crypto_shash_statesize(struct crypto_shash *t) { return crypto_shash_alg(t)->statesize; }
+static inline unsigned int crypto_shash_blocksize(struct crypto_shash *t) { return t->base.__crt_alg->cra_blocksize; }
+static inline unsigned int crypto_shash_alignmask(struct crypto_shash *t) { return t->base.__crt_alg->cra_alignmask; }
+static inline u32 crypto_shash_get_flags(struct crypto_shash *t) { return t->base.crt_flags; }
+static inline void crypto_shash_set_flags(struct crypto_shash *t, u32 f) { t->base.crt_flags |= f; }
+static inline void crypto_shash_clear_flags(struct crypto_shash *t, u32 f) { t->base.crt_flags &= ~f; }
+struct crypto_shash *crypto_alloc_shash(const char *name, u32 type, u32 mask);
+void crypto_free_shash(struct crypto_shash *t);
+int crypto_shash_setkey(struct crypto_shash *t, const u8 *key, unsigned int keylen);
+int crypto_shash_init(struct shash_desc *d);
+int crypto_shash_update(struct shash_desc *d, const u8 *data, unsigned int len);
+int crypto_shash_final(struct shash_desc *d, u8 *out);
+int crypto_shash_finup(struct shash_desc *d, const u8 *data, unsigned int len, u8 *out);
+int crypto_shash_digest(struct shash_desc *d, const u8 *data, unsigned int len, u8 *out);
+int crypto_shash_export(struct shash_desc *d, void *out);
+int crypto_shash_import(struct shash_desc *d, const void *in);
+int crypto_register_shash(struct shash_alg *alg);
+int crypto_unregister_shash(struct shash_alg *alg);
+int crypto_register_shashes(struct shash_alg *algs, int count);
+int crypto_unregister_shashes(struct shash_alg *algs, int count);
+
+/* ahash (synchronous wrapper over shash) */
+struct crypto_ahash { struct crypto_shash *child; unsigned int reqsize; };
+struct ahash_request {
+    struct crypto_async_request base;
+    unsigned int nbytes;
+    struct scatterlist *src;
+    u8 *result;
+    struct crypto_ahash *tfm;
+    struct shash_desc desc;
+};
+struct crypto_ahash *crypto_alloc_ahash(const char *name, u32 type, u32 mask);
+void crypto_free_ahash(struct crypto_ahash *t);
+static inline struct crypto_tfm *crypto_ahash_tfm(struct crypto_ahash *t) { return &t->child->base; }
+static inline unsigned int crypto_ahash_digestsize(struct crypto_ahash *t) { return crypto_shash_digestsize(t->child); }
+static inline void crypto_ahash_clear_flags(struct crypto_ahash *t, u32 f) { t->child->base.crt_flags &= ~f; }
+static inline int crypto_ahash_setkey(struct crypto_ahash *t, const u8 *k, unsigned int l) { return crypto_shash_setkey(t->child, k, l); }
+struct ahash_request *ahash_request_alloc(struct crypto_ahash *t, gfp_t g);
+static inline void ahash_request_free(struct ahash_request *r) { free(r); }
+static inline void ahash_request_set_callback(struct ahash_request *r, u32 f, crypto_completion_t c, void *d)
+{ r->base.flags = f; r->base.complete = c; r->base.data = d; }
+static inline void ahash_request_set_crypt(struct ahash_request *r, struct scatterlist *src, u8 *result, unsigned int n)
+{ r->src = src; r->result = result; r->nbytes = n; }
+int crypto_ahash_init(struct ahash_request *r);
+int crypto_ahash_update(struct ahash_request *r);
+int crypto_ahash_final(struct ahash_request *r);
+int crypto_ahash_digest(struct ahash_request *r);
+
+/* legacy hash */
+struct crypto_hash { struct crypto_shash *child; };
+struct hash_desc { struct crypto_hash *tfm; u32 flags; struct shash_desc *sd; };
+struct crypto_hash *crypto_alloc_hash(const char *name, u32 type, u32 mask);
+void crypto_free_hash(struct crypto_hash *t);
+static inline unsigned int crypto_hash_digestsize(struct crypto_hash *t) { return crypto_shash_digestsize(t->child); }
+static inline int crypto_hash_setkey(struct crypto_hash *t, const u8 *k, unsigned int l) { return crypto_shash_setkey(t->child, k, l); }
+int crypto_hash_init(struct hash_desc *d);
+int crypto_hash_update(struct hash_desc *d, struct scatterlist *sg, unsigned int n);
+int crypto_hash_final(struct hash_desc *d, u8 *out);
+int crypto_hash_digest(struct hash_desc *d, struct scatterlist *sg, unsigned int n, u8 *out);
+
+#define ERR_CAST(p) ((void *)(p))
+/* templates */
+struct rtattr { unsigned short rta_len; unsigned short rta_type; };
+#define RTA_ALIGN(len) (((len) + 3) & ~3)
+#define RTA_LENGTH(len) (RTA_ALIGN(sizeof(struct rtattr)) + (len))
+#define RTA_DATA(rta) ((void *)(((char *)(rta)) + RTA_LENGTH(0)))
+#define RTA_PAYLOAD(rta) ((int)((rta)->rta_len) - RTA_LENGTH(0))
+#define RTA_OK(rta, len) ((len) >= (int)sizeof(struct rtattr) && \
+        (rta)->rta_len >= sizeof(struct rtattr) && (rta)->rta_len <= (len))
+#define RTA_NEXT(rta, attrlen) ((attrlen) -= RTA_ALIGN((rta)->rta_len), \
+        (struct rtattr *)(((char *)(rta)) + RTA_ALIGN((rta)->rta_len)))
+enum { CRYPTOA_UNSPEC, CRYPTOA_ALG, CRYPTOA_TYPE, CRYPTOA_U32 };
+struct crypto_attr_alg { char name[CRYPTO_MAX_ALG_NAME]; };
+struct crypto_attr_type { u32 type; u32 mask; };
+
+struct crypto_template;
+struct crypto_instance {
+    struct crypto_alg alg;
+    struct crypto_template *tmpl;
+    void *__ctx[] CRYPTO_MINALIGN_ATTR;
+};
+struct crypto_template {
+    struct crypto_instance *(*alloc)(struct rtattr **tb);
+    void (*free)(struct crypto_instance *inst);
+    int (*create)(struct crypto_template *tmpl, struct rtattr **tb);
+    struct module *module;
+    char name[CRYPTO_MAX_ALG_NAME];
+    struct crypto_template *kshim_next;
+};
+struct crypto_spawn { struct crypto_alg *alg; struct crypto_instance *inst; };
+struct crypto_shash_spawn { struct crypto_spawn base; };
+struct shash_instance {
+    union {
+        struct {
+            char head[offsetof(struct shash_alg, base)];
+            struct crypto_instance base;
+        } s;
+        struct shash_alg alg;
+    };
+};
+static inline void *crypto_instance_ctx(struct crypto_instance *inst) { return inst->__ctx; }
+static inline struct crypto_instance *shash_crypto_instance(struct shash_instance *inst) { return container_of(&inst->alg.base, struct crypto_instance, alg); }
+static inline void *shash_instance_ctx(struct shash_instance *inst) { return crypto_instance_ctx(shash_crypto_instance(inst)); }
+static inline struct shash_instance *shash_instance(struct crypto_instance *inst) { return container_of(__crypto_shash_alg(&inst->alg), struct shash_instance, alg); }
+int crypto_register_template(struct crypto_template *tmpl);
+void crypto_unregister_template(struct crypto_template *tmpl);
+struct crypto_attr_type *crypto_get_attr_type(struct rtattr **tb);
+int crypto_check_attr_type(struct rtattr **tb, u32 type);
+const char *crypto_attr_alg_name(struct rtattr *rta);
+struct crypto_alg *crypto_attr_alg(struct rtattr *rta, u32 type, u32 mask);
+struct shash_alg *shash_attr_alg(struct rtattr *rta, u32 type, u32 mask);
+struct shash_instance *shash_alloc_instance(const char *name, struct crypto_alg *alg);
+void *crypto_alloc_instance2(const char *name, struct crypto_alg *alg, unsigned int head);
+int crypto_init_shash_spawn(struct crypto_shash_spawn *spawn, struct shash_alg *alg, struct crypto_instance *inst);
+int crypto_init_spawn(struct crypto_spawn *spawn, struct crypto_alg *alg, struct crypto_instance *inst, u32 mask);
+void crypto_drop_spawn(struct crypto_spawn *spawn);
+static inline void crypto_drop_shash(struct crypto_shash_spawn *spawn) { crypto_drop_spawn(&spawn->base); }
+struct crypto_shash *crypto_spawn_shash(struct crypto_shash_spawn *spawn);
+struct crypto_blkcipher *crypto_spawn_blkcipher(struct crypto_spawn *spawn);
+void get_random_bytes(void *buf, int n);
+struct crypto_authenc_key_param { __be32 enckeylen; };
+enum { CRYPTO_AUTHENC_KEYA_UNSPEC, CRYPTO_AUTHENC_KEYA_PARAM };
+int shash_register_instance(struct crypto_template *tmpl, struct shash_instance *inst);
+void shash_free_instance(struct crypto_instance *inst);
+int crypto_register_instance(struct crypto_template *tmpl, struct crypto_instance *inst);
+
+/* x86 FPU / cpufeature */
+#define X86_FEATURE_AES "aes"
+#define X86_FEATURE_SSSE3 "ssse3"
+#define X86_FEATURE_XMM4_1 "sse4.1"
+#define X86_FEATURE_AVX2 "avx2"
+#define X86_FEATURE_SHA_NI "sha"
+/* gcc's avx check includes the OS support XSAVE stands for */
+#define X86_FEATURE_OSXSAVE "avx"
+#define boot_cpu_has(f) (__builtin_cpu_supports(f))
+extern int kshim_fpu_usable;
+#define irq_fpu_usable() (kshim_fpu_usable)
+static inline void kernel_fpu_begin(void) {}
+static inline void kernel_fpu_end(void) {}
+
+/* atomics and a manually driven workqueue */
+typedef struct { int counter; } atomic_t;
+typedef struct { long long counter; } atomic64_t;
+#define ATOMIC_INIT(i) { (i) }
+#define ATOMIC64_INIT(i) { (i) }
+#define atomic_read(v) ((v)->counter)
+#define atomic_add(i, v) ((v)->counter += (i))
+#define atomic_sub(i, v) ((v)->counter -= (i))
+#define atomic_inc(v) ((v)->counter++)
+#define atomic64_read(v) ((v)->counter)
+#define atomic64_add(i, v) ((v)->counter += (i))
+struct work_struct { void (*func)(struct work_struct *); int pending; };
+#define INIT_WORK(w, f) ((w)->func = (f), (w)->pending = 0)
+int schedule_work(struct work_struct *w);
+int cancel_work_sync(struct work_struct *w);
+void kshim_run_work(void);
+
+/* ktime, nanoseconds of CLOCK_MONOTONIC */
+typedef s64 ktime_t;
+static inline ktime_t ktime_get(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (s64)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+static inline s64 ktime_us_delta(ktime_t a, ktime_t b) { return (a - b) / 1000; }
+#define ktime_set(s, ns) ((ktime_t)(s) * 1000000000LL + (ns))
+#define ktime_sub(a, b) ((a) - (b))
+#define ktime_to_ns(k) ((s64)(k))
+static inline int fls64(u64 x) { return x ? 64 - __builtin_clzll(x) : 0; }
+
+#endif
@@ -0,0 +1 @@
+/* Host build stand-in, trace events are not instantiated */
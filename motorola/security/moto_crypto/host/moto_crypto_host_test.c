@@ -0,0 +1,105 @@
+/*
+ * Host test runner, registers the algorithms through their start functions
+ * as moto_crypto_init() does, which replays the moto_testmgr.c vectors of
+ * each driver, and reports the result per driver.
+ *
+ * Usage: moto_crypto_host_test [-v]
+ *     -v  show the module printk output
+ */
+#include <unistd.h>
+#include <moto_aes.h>
+#include <moto_sha.h>
+#include <moto_sha256_mb.h>
+#include <moto_tdes.h>
+
+#include "moto_crypto_main.h"
+#include "moto_testmgr.h"
+
+extern int moto_prng_init(void);
+extern void moto_prng_finish(void);
+
+#ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
+unsigned fault_injection_mask;
+char *fault_injection_mask_string;
+#endif
+
+static unsigned failures;
+
+int moto_crypto_error_state;
+
+void moto_crypto_post_failure(unsigned failure)
+{
+    failures |= failure;
+    moto_crypto_error_state = 1;
+}
+
+static const struct {
+    const char *name;
+    int (*start)(void);
+    void (*finish)(void);
+    unsigned failure;
+} moto_host_tests[] = {
+    { "aes", moto_aes_start, moto_aes_finish, MOTO_CRYPTO_FAILED_ALG_AES },
+    { "aes_bs", moto_aes_bs_start, moto_aes_bs_finish,
+            MOTO_CRYPTO_FAILED_ALG_AES },
+    { "aes_ni", moto_aes_ni_start, moto_aes_ni_finish,
+            MOTO_CRYPTO_FAILED_ALG_AES },
+    { "tdes", moto_tdes_start, moto_tdes_finish,
+            MOTO_CRYPTO_FAILED_ALG_TDES },
+    { "sha1", moto_sha1_start, moto_sha1_finish,
+            MOTO_CRYPTO_FAILED_ALG_SHA1 },
+    { "sha256", moto_sha256_start, moto_sha256_finish,
+            MOTO_CRYPTO_FAILED_ALG_SHA256 },
+    { "sha_x86", moto_sha_x86_start, moto_sha_x86_finish,
+            MOTO_CRYPTO_FAILED_ALG_SHA256 },
+    /* the ahash driver is kernel only, test the engine it runs */
+    { "sha256_mb", moto_sha256_mb_self_test, NULL,
+            MOTO_CRYPTO_FAILED_ALG_SHA256 },
+    { "sha512", moto_sha512_start, moto_sha512_finish,
+            MOTO_CRYPTO_FAILED_ALG_SHA512 },
+    { "hmac", moto_hmac_start, moto_hmac_finish,
+            MOTO_CRYPTO_FAILED_ALG_HMAC },
+    { "rng", moto_prng_init, moto_prng_finish, MOTO_CRYPTO_FAILED_ALG_RNG },
+};
+
+int main(int argc, char **argv)
+{
+    char buf[4096];
+    int i, err;
+
+    while ((i = getopt(argc, argv, "v")) != -1) {
+        switch (i) {
+        case 'v':
+            kshim_verbose = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(moto_host_tests); i++) {
+        err = moto_host_tests[i].start();
+        printf("%s start: %d\n", moto_host_tests[i].name, err);
+        if (err)
+            failures |= moto_host_tests[i].failure;
+    }
+
+    moto_post_alg_show(buf, sizeof(buf));
+    printf("%s", buf);
+    moto_post_alg_show_timing(buf, sizeof(buf));
+    printf("%s", buf);
+
+    for (i = ARRAY_SIZE(moto_host_tests) - 1; i >= 0; i--) {
+        if (moto_host_tests[i].finish)
+            moto_host_tests[i].finish();
+    }
+    kshim_run_work();
+    moto_post_alg_free();
+
+    if (failures)
+        printf("FAILED 0x%08x\n", failures);
+    else
+        printf("PASSED\n");
+    return failures ? 1 : 0;
+}
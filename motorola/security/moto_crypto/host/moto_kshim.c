@@ -0,0 +1,799 @@
+/*
+ * Host implementation of the kernel crypto API subset declared in
+ * moto_kshim.h: an algorithm and template registry, tfm allocation, the
+ * blkcipher and scatterlist walks, and shash with the ahash and legacy
+ * hash interfaces layered on top of it.
+ */
+#include "moto_kshim.h"
+
+int kshim_verbose;
+struct module __this_module;
+const struct crypto_type crypto_blkcipher_type = { 1 };
+const struct crypto_type crypto_rng_type = { 2 };
+const struct crypto_type crypto_aead_type = { 3 };
+const struct crypto_type crypto_ablkcipher_type = { 4 };
+
+static struct crypto_alg *algs;
+static struct crypto_template *tmpls;
+
+void print_hex_dump(const char *level, const char *prefix, int type, int rowsize,
+        int groupsize, const void *buf, size_t len, bool ascii)
+{
+    const u8 *p = buf;
+    size_t i;
+    if (!kshim_verbose)
+        return;
+    for (i = 0; i < len; i++)
+        printf("%02x%s", p[i], (i % rowsize == rowsize - 1 || i == len - 1) ? "\n" : " ");
+}
+
+void panic(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    abort();
+}
+
+int crypto_register_alg(struct crypto_alg *alg)
+{
+    struct crypto_alg *a;
+    for (a = algs; a; a = a->kshim_next)
+        if (a == alg || !strcmp(a->cra_driver_name, alg->cra_driver_name))
+            return -EEXIST;
+    if (!alg->cra_driver_name[0])
+        strcpy(alg->cra_driver_name, alg->cra_name);
+    alg->kshim_next = algs;
+    algs = alg;
+    alg->kshim_registered = 1;
+    return 0;
+}
+
+int crypto_unregister_alg(struct crypto_alg *alg)
+{
+    struct crypto_alg **pp;
+    for (pp = &algs; *pp; pp = &(*pp)->kshim_next)
+        if (*pp == alg) {
+            *pp = alg->kshim_next;
+            alg->kshim_registered = 0;
+            return 0;
+        }
+    return -ENOENT;
+}
+
+int crypto_register_algs(struct crypto_alg *a, int n)
+{
+    int i, err;
+    for (i = 0; i < n; i++)
+        if ((err = crypto_register_alg(&a[i])))
+            return err;
+    return 0;
+}
+
+int crypto_unregister_algs(struct crypto_alg *a, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        crypto_unregister_alg(&a[i]);
+    return 0;
+}
+
+static struct crypto_alg *lookup(const char *name, u32 type, u32 mask)
+{
+    struct crypto_alg *a, *best = NULL;
+    for (a = algs; a; a = a->kshim_next) {
+        if ((a->cra_flags ^ type) & mask)
+            continue;
+        if (!strcmp(a->cra_driver_name, name))
+            return a;
+        if (!strcmp(a->cra_name, name) && (!best || a->cra_priority > best->cra_priority))
+            best = a;
+    }
+    return best;
+}
+
+static struct crypto_alg *instantiate(const char *name)
+{
+    char tname[CRYPTO_MAX_ALG_NAME], inner[CRYPTO_MAX_ALG_NAME];
+    const char *p = strchr(name, '(');
+    size_t n;
+    struct crypto_template *t;
+    struct {
+        struct rtattr rta;
+        struct crypto_attr_type data;
+    } ptype;
+    struct {
+        struct rtattr rta;
+        struct crypto_attr_alg data;
+    } palg[4];
+    struct rtattr *tb[6];
+    int i = 0, depth = 0, err;
+    const char *s, *start;
+
+    if (!p || name[strlen(name) - 1] != ')')
+        return NULL;
+    n = p - name;
+    memcpy(tname, name, n);
+    tname[n] = 0;
+    for (t = tmpls; t; t = t->kshim_next)
+        if (!strcmp(t->name, tname))
+            break;
+    if (!t)
+        return NULL;
+
+    memset(tb, 0, sizeof(tb));
+    ptype.rta.rta_type = CRYPTOA_TYPE;
+    ptype.rta.rta_len = sizeof(ptype);
+    tb[0] = &ptype.rta;
+    start = p + 1;
+    for (s = p + 1; *s; s++) {
+        if (*s == '(')
+            depth++;
+        else if (*s == ')' && depth)
+            depth--;
+        else if ((*s == ',' && !depth) || (*s == ')' && !depth)) {
+            n = s - start;
+            memcpy(inner, start, n);
+            inner[n] = 0;
+            memset(&palg[i], 0, sizeof(palg[i]));
+            palg[i].rta.rta_type = CRYPTOA_ALG;
+            palg[i].rta.rta_len = sizeof(palg[i]);
+            strcpy(palg[i].data.name, inner);
+            tb[i + 1] = &palg[i].rta;
+            i++;
+            start = s + 1;
+        }
+    }
+    if (t->alloc) {
+        struct crypto_instance *inst = t->alloc(tb);
+        if (IS_ERR(inst))
+            return NULL;
+        err = crypto_register_instance(t, inst);
+    } else
+        err = t->create(t, tb);
+    if (err)
+        return NULL;
+    return lookup(name, 0, 0);
+}
+
+struct crypto_alg *kshim_find_alg(const char *name, u32 type, u32 mask)
+{
+    struct crypto_alg *a = lookup(name, type, mask);
+    if (!a)
+        a = instantiate(name);
+    return a;
+}
+
+int crypto_has_alg(const char *name, u32 type, u32 mask)
+{
+    return kshim_find_alg(name, type, mask) != NULL;
+}
+
+void *kshim_alloc_tfm(struct crypto_alg *alg, size_t head)
+{
+    size_t sz = head + sizeof(struct crypto_tfm) + alg->cra_ctxsize + 64;
+    u8 *mem = calloc(1, sz);
+    struct crypto_tfm *tfm = (struct crypto_tfm *)(mem + head);
+    tfm->__crt_alg = alg;
+    tfm->exit = alg->cra_exit;
+    if (alg->cra_init && alg->cra_init(tfm)) {
+        free(mem);
+        return NULL;
+    }
+    return mem;
+}
+
+static void free_tfm(struct crypto_tfm *tfm, void *mem)
+{
+    if (tfm->exit)
+        tfm->exit(tfm);
+    free(mem);
+}
+
+/* ------------------------------------------------------------------ */
+
+struct crypto_blkcipher *crypto_alloc_blkcipher(const char *name, u32 type, u32 mask)
+{
+    struct crypto_alg *a = kshim_find_alg(name, CRYPTO_ALG_TYPE_BLKCIPHER, CRYPTO_ALG_TYPE_MASK);
+    struct crypto_blkcipher *t;
+    if (!a)
+        return ERR_PTR(-ENOENT);
+    t = kshim_alloc_tfm(a, 0);
+    return t ? t : ERR_PTR(-ENOMEM);
+}
+
+void crypto_free_blkcipher(struct crypto_blkcipher *t)
+{
+    if (t)
+        free_tfm(&t->base, t);
+}
+
+int crypto_blkcipher_setkey(struct crypto_blkcipher *t, const u8 *key, unsigned int keylen)
+{
+    struct blkcipher_alg *b = &t->base.__crt_alg->cra_blkcipher;
+    if (keylen < b->min_keysize || keylen > b->max_keysize) {
+        t->base.crt_flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+        return -EINVAL;
+    }
+    return b->setkey(&t->base, key, keylen);
+}
+
+int crypto_blkcipher_encrypt_iv(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n)
+{
+    return d->tfm->base.__crt_alg->cra_blkcipher.encrypt(d, dst, src, n);
+}
+
+int crypto_blkcipher_decrypt_iv(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n)
+{
+    return d->tfm->base.__crt_alg->cra_blkcipher.decrypt(d, dst, src, n);
+}
+
+int crypto_blkcipher_encrypt(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n)
+{
+    d->info = d->tfm->base.crt_iv;
+    return crypto_blkcipher_encrypt_iv(d, dst, src, n);
+}
+
+int crypto_blkcipher_decrypt(struct blkcipher_desc *d, struct scatterlist *dst, struct scatterlist *src, unsigned int n)
+{
+    d->info = d->tfm->base.crt_iv;
+    return crypto_blkcipher_decrypt_iv(d, dst, src, n);
+}
+
+/* scatter walk */
+void scatterwalk_start(struct scatter_walk *w, struct scatterlist *sg)
+{
+    w->sg = sg;
+    w->offset = sg ? sg->offset : 0;
+}
+
+static void sw_skip_empty(struct scatter_walk *w)
+{
+    while (w->sg && w->offset >= w->sg->offset + w->sg->length) {
+        w->sg = sg_next(w->sg);
+        w->offset = w->sg ? w->sg->offset : 0;
+    }
+}
+
+static unsigned int sw_avail(struct scatter_walk *w)
+{
+    sw_skip_empty(w);
+    return w->sg ? w->sg->offset + w->sg->length - w->offset : 0;
+}
+
+static u8 *sw_ptr(struct scatter_walk *w)
+{
+    sw_skip_empty(w);
+    return (u8 *)w->sg->buf + w->offset;
+}
+
+void scatterwalk_copychunks(void *buf, struct scatter_walk *w, size_t nbytes, int out)
+{
+    u8 *b = buf;
+    while (nbytes) {
+        unsigned int n = sw_avail(w);
+        BUG_ON(!n);
+        if (n > nbytes)
+            n = nbytes;
+        if (out)
+            memcpy(sw_ptr(w), b, n);
+        else
+            memcpy(b, sw_ptr(w), n);
+        w->offset += n;
+        b += n;
+        nbytes -= n;
+    }
+}
+
+void scatterwalk_map_and_copy(void *buf, struct scatterlist *sg, unsigned int start, unsigned int nbytes, int out)
+{
+    struct scatter_walk w;
+    u8 dummy[256];
+    if (!nbytes)
+        return;
+    scatterwalk_start(&w, sg);
+    while (start) {
+        unsigned int n = start > sizeof(dummy) ? sizeof(dummy) : start;
+        scatterwalk_copychunks(dummy, &w, n, 0);
+        start -= n;
+    }
+    scatterwalk_copychunks(buf, &w, nbytes, out);
+}
+
+/* blkcipher walk */
+void blkcipher_walk_init(struct blkcipher_walk *w, struct scatterlist *dst, struct scatterlist *src, unsigned int nbytes)
+{
+    memset(w, 0, sizeof(*w));
+    scatterwalk_start(&w->in, src);
+    scatterwalk_start(&w->out, dst);
+    w->total = nbytes;
+}
+
+static int walk_next(struct blkcipher_walk *w)
+{
+    unsigned int n;
+    if (!w->total) {
+        w->nbytes = 0;
+        return 0;
+    }
+    n = w->total;
+    if (sw_avail(&w->in) < n)
+        n = sw_avail(&w->in);
+    if (sw_avail(&w->out) < n)
+        n = sw_avail(&w->out);
+    if (n >= w->blocksize && !(((unsigned long)sw_ptr(&w->in) | (unsigned long)sw_ptr(&w->out)) & 3)) {
+        n -= n % w->blocksize;
+        w->slow = 0;
+        w->src.virt.addr = sw_ptr(&w->in);
+        w->dst.virt.addr = sw_ptr(&w->out);
+    } else {
+        struct scatter_walk tmp = w->in;
+        n = w->total < w->blocksize ? w->total : w->blocksize;
+        w->slow = 1;
+        scatterwalk_copychunks(w->bounce, &tmp, n, 0);
+        w->src.virt.addr = w->dst.virt.addr = w->bounce;
+    }
+    w->nbytes = n;
+    return 0;
+}
+
+static int walk_first(struct blkcipher_desc *d, struct blkcipher_walk *w)
+{
+    w->iv = d->info;
+    return walk_next(w);
+}
+
+int blkcipher_walk_virt(struct blkcipher_desc *d, struct blkcipher_walk *w)
+{
+    w->blocksize = d->tfm->base.__crt_alg->cra_blocksize;
+    return walk_first(d, w);
+}
+
+int blkcipher_walk_virt_block(struct blkcipher_desc *d, struct blkcipher_walk *w, unsigned int bs)
+{
+    w->blocksize = bs;
+    return walk_first(d, w);
+}
+
+int blkcipher_walk_done(struct blkcipher_desc *d, struct blkcipher_walk *w, int err)
+{
+    unsigned int n;
+    u8 tmp[64];
+    if (err < 0) {
+        w->nbytes = 0;
+        return err;
+    }
+    n = w->nbytes - err;
+    if (w->slow) {
+        scatterwalk_copychunks(w->bounce, &w->out, n, 1);
+        scatterwalk_copychunks(tmp, &w->in, n, 0);
+    } else {
+        w->in.offset += n;
+        w->out.offset += n;
+    }
+    w->total -= n;
+    if (err > 0 && !w->total)
+        return -EINVAL;
+    return walk_next(w);
+}
+
+/* ablkcipher */
+struct crypto_ablkcipher *crypto_alloc_ablkcipher(const char *name, u32 type, u32 mask)
+{
+    return (struct crypto_ablkcipher *)crypto_alloc_blkcipher(name, type, mask);
+}
+
+static int abk_op(struct ablkcipher_request *r, int enc)
+{
+    struct blkcipher_desc d = { (struct crypto_blkcipher *)r->base.tfm, r->info, r->base.flags };
+    return enc ? crypto_blkcipher_encrypt_iv(&d, r->dst, r->src, r->nbytes)
+            : crypto_blkcipher_decrypt_iv(&d, r->dst, r->src, r->nbytes);
+}
+int crypto_ablkcipher_encrypt(struct ablkcipher_request *r) { return abk_op(r, 1); }
+int crypto_ablkcipher_decrypt(struct ablkcipher_request *r) { return abk_op(r, 0); }
+
+/* rng */
+struct crypto_rng *crypto_alloc_rng(const char *name, u32 type, u32 mask)
+{
+    struct crypto_alg *a = kshim_find_alg(name, CRYPTO_ALG_TYPE_RNG, CRYPTO_ALG_TYPE_MASK);
+    struct crypto_rng *t;
+    if (!a)
+        return ERR_PTR(-ENOENT);
+    t = kshim_alloc_tfm(a, 0);
+    return t ? t : ERR_PTR(-ENOMEM);
+}
+
+/* aead */
+struct crypto_aead *crypto_alloc_aead(const char *name, u32 type, u32 mask)
+{
+    struct crypto_alg *a = kshim_find_alg(name, CRYPTO_ALG_TYPE_AEAD, CRYPTO_ALG_TYPE_MASK);
+    struct crypto_aead *t;
+    if (!a)
+        return ERR_PTR(-ENOENT);
+    t = kshim_alloc_tfm(a, 0);
+    if (!t)
+        return ERR_PTR(-ENOMEM);
+    t->base.crt_authsize = a->cra_aead.maxauthsize;
+    return t;
+}
+
+int crypto_aead_setkey(struct crypto_aead *t, const u8 *key, unsigned int keylen)
+{
+    return t->base.__crt_alg->cra_aead.setkey(t, key, keylen);
+}
+
+int crypto_aead_setauthsize(struct crypto_aead *t, unsigned int authsize)
+{
+    struct aead_alg *a = &t->base.__crt_alg->cra_aead;
+    int err;
+    if (authsize > a->maxauthsize)
+        return -EINVAL;
+    err = a->setauthsize ? a->setauthsize(t, authsize) : 0;
+    if (!err)
+        t->base.crt_authsize = authsize;
+    return err;
+}
+
+/* ------------------------------------------------------------------ */
+/* shash */
+
+static int shash_default_export(struct shash_desc *d, void *out)
+{
+    memcpy(out, shash_desc_ctx(d), crypto_shash_descsize(d->tfm));
+    return 0;
+}
+
+static int shash_default_import(struct shash_desc *d, const void *in)
+{
+    memcpy(shash_desc_ctx(d), in, crypto_shash_descsize(d->tfm));
+    return 0;
+}
+
+static void shash_prepare(struct shash_alg *s)
+{
+    s->base.cra_flags = (s->base.cra_flags & ~CRYPTO_ALG_TYPE_MASK) | CRYPTO_ALG_TYPE_SHASH;
+    if (!s->export) {
+        s->export = shash_default_export;
+        s->import = shash_default_import;
+        s->statesize = s->descsize;
+    }
+    s->base.cra_ctxsize += 0;
+}
+
+int crypto_register_shash(struct shash_alg *s)
+{
+    shash_prepare(s);
+    return crypto_register_alg(&s->base);
+}
+
+int crypto_unregister_shash(struct shash_alg *s)
+{
+    return crypto_unregister_alg(&s->base);
+}
+
+int crypto_register_shashes(struct shash_alg *s, int n)
+{
+    int i, err;
+    for (i = 0; i < n; i++)
+        if ((err = crypto_register_shash(&s[i])))
+            return err;
+    return 0;
+}
+
+int crypto_unregister_shashes(struct shash_alg *s, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        crypto_unregister_shash(&s[i]);
+    return 0;
+}
+
+static struct crypto_shash *alloc_shash_alg(struct crypto_alg *a)
+{
+    u8 *mem;
+    struct crypto_shash *t;
+    size_t sz = sizeof(struct crypto_shash) + a->cra_ctxsize + 64;
+    mem = calloc(1, sz);
+    t = (struct crypto_shash *)mem;
+    t->base.__crt_alg = a;
+    t->base.exit = a->cra_exit;
+    t->descsize = __crypto_shash_alg(a)->descsize;
+    if (a->cra_init && a->cra_init(&t->base)) {
+        free(mem);
+        return ERR_PTR(-EINVAL);
+    }
+    return t;
+}
+
+struct crypto_shash *crypto_alloc_shash(const char *name, u32 type, u32 mask)
+{
+    struct crypto_alg *a = kshim_find_alg(name, CRYPTO_ALG_TYPE_SHASH, CRYPTO_ALG_TYPE_MASK);
+    if (!a)
+        return ERR_PTR(-ENOENT);
+    return alloc_shash_alg(a);
+}
+
+void crypto_free_shash(struct crypto_shash *t)
+{
+    if (t->base.exit)
+        t->base.exit(&t->base);
+    free(t);
+}
+
+int crypto_shash_setkey(struct crypto_shash *t, const u8 *key, unsigned int keylen)
+{
+    struct shash_alg *s = crypto_shash_alg(t);
+    if (!s->setkey)
+        return -ENOSYS;
+    return s->setkey(t, key, keylen);
+}
+
+int crypto_shash_init(struct shash_desc *d) { return crypto_shash_alg(d->tfm)->init(d); }
+int crypto_shash_update(struct shash_desc *d, const u8 *data, unsigned int len) { return crypto_shash_alg(d->tfm)->update(d, data, len); }
+int crypto_shash_final(struct shash_desc *d, u8 *out) { return crypto_shash_alg(d->tfm)->final(d, out); }
+int crypto_shash_finup(struct shash_desc *d, const u8 *data, unsigned int len, u8 *out)
+{
+    struct shash_alg *s = crypto_shash_alg(d->tfm);
+    if (s->finup)
+        return s->finup(d, data, len, out);
+    return s->update(d, data, len) ?: s->final(d, out);
+}
+int crypto_shash_digest(struct shash_desc *d, const u8 *data, unsigned int len, u8 *out)
+{
+    struct shash_alg *s = crypto_shash_alg(d->tfm);
+    if (s->digest)
+        return s->digest(d, data, len, out);
+    return s->init(d) ?: crypto_shash_finup(d, data, len, out);
+}
+int crypto_shash_export(struct shash_desc *d, void *out) { return crypto_shash_alg(d->tfm)->export(d, out); }
+int crypto_shash_import(struct shash_desc *d, const void *in) { return crypto_shash_alg(d->tfm)->import(d, in); }
+
+/* ahash */
+struct crypto_ahash *crypto_alloc_ahash(const char *name, u32 type, u32 mask)
+{
+    struct crypto_shash *s = crypto_alloc_shash(name, type, mask);
+    struct crypto_ahash *t;
+    if (IS_ERR(s))
+        return (void *)s;
+    t = calloc(1, sizeof(*t));
+    t->child = s;
+    return t;
+}
+
+void crypto_free_ahash(struct crypto_ahash *t)
+{
+    crypto_free_shash(t->child);
+    free(t);
+}
+
+struct ahash_request *ahash_request_alloc(struct crypto_ahash *t, gfp_t g)
+{
+    struct ahash_request *r = calloc(1, sizeof(*r) + crypto_shash_descsize(t->child) + 64);
+    r->tfm = t;
+    r->base.tfm = &t->child->base;
+    r->desc.tfm = t->child;
+    return r;
+}
+
+static int hash_walk(struct shash_desc *d, struct scatterlist *sg, unsigned int n)
+{
+    int err = 0;
+    while (n && sg && !err) {
+        unsigned int l = sg->length < n ? sg->length : n;
+        err = crypto_shash_update(d, sg_virt(sg), l);
+        n -= l;
+        sg = sg_next(sg);
+    }
+    return err;
+}
+
+int crypto_ahash_init(struct ahash_request *r) { r->desc.flags = r->base.flags; return crypto_shash_init(&r->desc); }
+int crypto_ahash_update(struct ahash_request *r) { return hash_walk(&r->desc, r->src, r->nbytes); }
+int crypto_ahash_final(struct ahash_request *r) { return crypto_shash_final(&r->desc, r->result); }
+int crypto_ahash_digest(struct ahash_request *r)
+{
+    return crypto_ahash_init(r) ?: crypto_ahash_update(r) ?: crypto_ahash_final(r);
+}
+
+/* legacy hash */
+struct crypto_hash *crypto_alloc_hash(const char *name, u32 type, u32 mask)
+{
+    struct crypto_shash *s = crypto_alloc_shash(name, type, mask);
+    struct crypto_hash *t;
+    if (IS_ERR(s))
+        return (void *)s;
+    t = calloc(1, sizeof(*t));
+    t->child = s;
+    return t;
+}
+
+void crypto_free_hash(struct crypto_hash *t)
+{
+    crypto_free_shash(t->child);
+    free(t);
+}
+
+static struct shash_desc *hd(struct hash_desc *d)
+{
+    if (!d->sd) {
+        d->sd = calloc(1, sizeof(struct shash_desc) + crypto_shash_descsize(d->tfm->child) + 64);
+        d->sd->tfm = d->tfm->child;
+    }
+    d->sd->flags = d->flags;
+    return d->sd;
+}
+int crypto_hash_init(struct hash_desc *d) { return crypto_shash_init(hd(d)); }
+int crypto_hash_update(struct hash_desc *d, struct scatterlist *sg, unsigned int n) { return hash_walk(hd(d), sg, n); }
+int crypto_hash_final(struct hash_desc *d, u8 *out) { return crypto_shash_final(hd(d), out); }
+int crypto_hash_digest(struct hash_desc *d, struct scatterlist *sg, unsigned int n, u8 *out)
+{
+    return crypto_hash_init(d) ?: crypto_hash_update(d, sg, n) ?: crypto_hash_final(d, out);
+}
+
+/* ------------------------------------------------------------------ */
+/* templates */
+
+int crypto_register_template(struct crypto_template *t)
+{
+    t->kshim_next = tmpls;
+    tmpls = t;
+    return 0;
+}
+
+void crypto_unregister_template(struct crypto_template *t)
+{
+    struct crypto_template **pp;
+    for (pp = &tmpls; *pp; pp = &(*pp)->kshim_next)
+        if (*pp == t) {
+            *pp = t->kshim_next;
+            return;
+        }
+}
+
+struct crypto_attr_type *crypto_get_attr_type(struct rtattr **tb)
+{
+    static struct crypto_attr_type any = { 0, 0 };
+    return &any;
+}
+
+int crypto_check_attr_type(struct rtattr **tb, u32 type)
+{
+    return 0;
+}
+
+const char *crypto_attr_alg_name(struct rtattr *rta)
+{
+    if (!rta)
+        return ERR_PTR(-ENOENT);
+    return ((struct crypto_attr_alg *)RTA_DATA(rta))->name;
+}
+
+struct crypto_alg *crypto_attr_alg(struct rtattr *rta, u32 type, u32 mask)
+{
+    const char *name = crypto_attr_alg_name(rta);
+    struct crypto_alg *a;
+    if (IS_ERR(name))
+        return (void *)name;
+    a = kshim_find_alg(name, type, mask);
+    return a ? a : ERR_PTR(-ENOENT);
+}
+
+struct shash_alg *shash_attr_alg(struct rtattr *rta, u32 type, u32 mask)
+{
+    struct crypto_alg *a = crypto_attr_alg(rta, CRYPTO_ALG_TYPE_SHASH, CRYPTO_ALG_TYPE_MASK);
+    return IS_ERR(a) ? (void *)a : __crypto_shash_alg(a);
+}
+
+void *crypto_alloc_instance2(const char *name, struct crypto_alg *alg, unsigned int head)
+{
+    u8 *p = calloc(1, head + sizeof(struct crypto_instance) + 512);
+    struct crypto_instance *inst = (struct crypto_instance *)(p + head);
+    snprintf(inst->alg.cra_name, CRYPTO_MAX_ALG_NAME, "%s(%s)", name, alg->cra_name);
+    snprintf(inst->alg.cra_driver_name, CRYPTO_MAX_ALG_NAME, "%s(%s)", name, alg->cra_driver_name);
+    return p;
+}
+
+struct shash_instance *shash_alloc_instance(const char *name, struct crypto_alg *alg)
+{
+    return crypto_alloc_instance2(name, alg, offsetof(struct shash_alg, base));
+}
+
+int crypto_init_spawn(struct crypto_spawn *spawn, struct crypto_alg *alg, struct crypto_instance *inst, u32 mask)
+{
+    spawn->alg = alg;
+    spawn->inst = inst;
+    return 0;
+}
+
+int crypto_init_shash_spawn(struct crypto_shash_spawn *spawn, struct shash_alg *alg, struct crypto_instance *inst)
+{
+    return crypto_init_spawn(&spawn->base, &alg->base, inst, 0);
+}
+
+void crypto_drop_spawn(struct crypto_spawn *spawn) { }
+
+struct crypto_shash *crypto_spawn_shash(struct crypto_shash_spawn *spawn)
+{
+    return alloc_shash_alg(spawn->base.alg);
+}
+
+struct crypto_blkcipher *crypto_spawn_blkcipher(struct crypto_spawn *spawn)
+{
+    struct crypto_blkcipher *t = kshim_alloc_tfm(spawn->alg, 0);
+    return t ? t : ERR_PTR(-ENOMEM);
+}
+
+void get_random_bytes(void *buf, int n)
+{
+    u8 *p = buf;
+    while (n--)
+        *p++ = rand();
+}
+
+int crypto_register_instance(struct crypto_template *tmpl, struct crypto_instance *inst)
+{
+    inst->tmpl = tmpl;
+    inst->alg.cra_flags |= CRYPTO_ALG_INSTANCE;
+    return crypto_register_alg(&inst->alg);
+}
+
+int shash_register_instance(struct crypto_template *tmpl, struct shash_instance *inst)
+{
+    shash_prepare(&inst->alg);
+    return crypto_register_instance(tmpl, shash_crypto_instance(inst));
+}
+
+void shash_free_instance(struct crypto_instance *inst)
+{
+    free(shash_instance(inst));
+}
+
+/* ------------------------------------------------------------------ */
+/* CPUs and work items */
+
+int kshim_fpu_usable = 1;
+int kshim_cpu;
+const u64 kshim_percpu_zero[4096];
+struct task_struct kshim_task;
+
+static struct work_struct *kshim_wq[64];
+static int kshim_nwq;
+
+int schedule_work(struct work_struct *w)
+{
+    if (w->pending)
+        return 0;
+    BUG_ON(kshim_nwq == ARRAY_SIZE(kshim_wq));
+    w->pending = 1;
+    kshim_wq[kshim_nwq++] = w;
+    return 1;
+}
+
+int cancel_work_sync(struct work_struct *w)
+{
+    int i;
+
+    for (i = 0; i < kshim_nwq; i++) {
+        if (kshim_wq[i] != w)
+            continue;
+        memmove(&kshim_wq[i], &kshim_wq[i + 1],
+                (kshim_nwq - i - 1) * sizeof(kshim_wq[0]));
+        kshim_nwq--;
+        w->pending = 0;
+        return 1;
+    }
+    return 0;
+}
+
+/* Runs queued work items, including any they queue, in FIFO order */
+void kshim_run_work(void)
+{
+    struct work_struct *w;
+
+    while (kshim_nwq) {
+        w = kshim_wq[0];
+        cancel_work_sync(w);
+        w->func(w);
+    }
+}
@@ -20,6 +20,14 @@
 #define AES_IV_SIZE     16
 #define AES_ALIGN_MASK  3
 
+/*
+ * Number of blocks handled by one call of the interleaved block functions.
+ * The rounds of the independent blocks are computed side by side, so the
+ * table lookups of one block overlap with those of the others instead of
+ * serializing on the dependency chain of a single block.
+ */
+#define AES_INTERLEAVE  4
+
 #define AES_ECB_MODE 1
 #define AES_CBC_MODE 2
 #define AES_CTR_MODE 4
@@ -39,7 +47,70 @@ extern const u32 moto_crypto_fl_tab[4][256];
 extern const u32 moto_crypto_it_tab[4][256];
 extern const u32 moto_crypto_il_tab[4][256];
 
+/*
+ * The portable implementation, shared with the accelerated drivers, which
+ * use the same context and fall back to these when they cannot run.
+ */
+int moto_aes_set_key(struct crypto_tfm *tfm, const u8 *in_key,
+        unsigned int key_len);
+void moto_aes_exit(struct crypto_tfm *tfm);
+int moto_ecb_aes_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes);
+int moto_ecb_aes_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes);
+int moto_cbc_aes_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes);
+int moto_cbc_aes_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes);
+int moto_ctr_aes_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes);
+
+/*
+ * Raw block functions on an expanded key, for users such as the CPRNG that
+ * encrypt single blocks and cannot afford a scatterlist walk per block, or
+ * moto_authenc, which walks its scatterlists itself.
+ * Buffers must be 32-bit aligned.
+ */
+int moto_crypto_aes_expand_key(struct moto_crypto_aes_ctx *ctx,
+        const u8 *in_key, unsigned int key_len);
+void moto_aes_encrypt_ctx(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in);
+void moto_aes_encrypt_x4(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in);
+void moto_aes_cbc_encrypt_ctx(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in, unsigned int nbytes, u8 *iv);
+
 int moto_aes_start(void);
 void moto_aes_finish(void);
+int moto_aes_bs_start(void);
+void moto_aes_bs_finish(void);
+
+#ifdef CONFIG_X86_64
+/*
+ * SSSE3 core of the bitsliced drivers, eight blocks per call on round keys
+ * laid out by moto_aes_bs_x86_set_key(). The caller owns the FPU.
+ */
+#define MOTO_AES_BS_X86_KEY_SIZE    (8 * AES_BLOCK_SIZE * 15)
+
+int moto_aes_bs_x86_usable(void);
+void moto_aes_bs_x86_set_key(u8 *sk, const u32 *skey, unsigned int rounds);
+void moto_aes_bs_x86_encrypt8(const u8 *sk, unsigned int rounds, u8 *out,
+        const u8 *in);
+void moto_aes_bs_x86_decrypt8(const u8 *sk, unsigned int rounds, u8 *out,
+        const u8 *in);
+#endif
+
+#ifdef CONFIG_X86
+int moto_aes_ni_start(void);
+void moto_aes_ni_finish(void);
+#else
+static inline int moto_aes_ni_start(void) { return 0; }
+static inline void moto_aes_ni_finish(void) { }
+#endif
 
 #endif
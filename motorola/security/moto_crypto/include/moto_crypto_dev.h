@@ -0,0 +1,127 @@
+/*
+ * /dev/moto_crypto batch interface.
+ *
+ * A process opens the device, sizes its rings and data arena with
+ * MOTO_CRYPTO_IOC_SETUP and maps them with one mmap() of setup.mmap_size
+ * bytes at offset 0. Sessions bind a key to a moto-* transform. Jobs are
+ * written to the submission ring and all queued jobs are run by a single
+ * MOTO_CRYPTO_IOC_SUBMIT; each one produces a completion entry. Job data,
+ * IVs and digests are addressed by their offset in the arena, which the
+ * drivers read and write in place.
+ *
+ * Both rings are single producer, single consumer: the producer only
+ * writes tail, the consumer only writes head, and both count freely,
+ * the slot being index & mask.
+ */
+
+#ifndef __MOTO_CRYPTO_DEV_H
+#define __MOTO_CRYPTO_DEV_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+#define MOTO_CRYPTO_DEV_NAME            "moto_crypto"
+
+#define MOTO_CRYPTO_DEV_MAX_ENTRIES     4096
+#define MOTO_CRYPTO_DEV_MAX_ARENA       (16 << 20)
+#define MOTO_CRYPTO_DEV_MAX_SESSIONS    64
+#define MOTO_CRYPTO_DEV_MAX_JOB_LEN     65536
+#define MOTO_CRYPTO_DEV_MAX_KEY         64
+
+/* Session types */
+#define MOTO_CRYPTO_SESSION_CIPHER      0
+#define MOTO_CRYPTO_SESSION_HASH        1
+
+/* Job operations, ENCRYPT and DECRYPT for ciphers, DIGEST for hashes */
+#define MOTO_CRYPTO_OP_ENCRYPT          0
+#define MOTO_CRYPTO_OP_DECRYPT          1
+#define MOTO_CRYPTO_OP_DIGEST           2
+
+struct moto_crypto_ring {
+    __u32 head;
+    __u32 tail;
+    __u32 mask;
+    __u32 entries;
+};
+
+/* At offset 0 of the mapping */
+struct moto_crypto_rings {
+    struct moto_crypto_ring sq;
+    struct moto_crypto_ring cq;
+};
+
+/*
+ * Cipher jobs read len bytes at src_off and write them at dst_off, which
+ * may be the same offset. The IV at iv_off is updated with the chaining
+ * value, so consecutive CBC or CTR jobs continue one stream. Digest jobs
+ * hash len bytes at src_off into dst_off; iv_off is unused.
+ */
+struct moto_crypto_sqe {
+    __u64 user_data;
+    __u32 session;
+    __u32 op;
+    __u32 src_off;
+    __u32 dst_off;
+    __u32 iv_off;
+    __u32 len;
+};
+
+/* result is 0 or a negative errno, len the number of bytes written */
+struct moto_crypto_cqe {
+    __u64 user_data;
+    __s32 result;
+    __u32 len;
+};
+
+/*
+ * sq_entries and cq_entries are rounded up to a power of two, arena_size
+ * to a page. The offsets are relative to the start of the mapping.
+ */
+struct moto_crypto_dev_setup {
+    __u32 sq_entries;
+    __u32 cq_entries;
+    __u32 arena_size;
+    __u32 sq_off;
+    __u32 cq_off;
+    __u32 arena_off;
+    __u32 mmap_size;
+};
+
+/*
+ * driver is a moto transform driver name, "moto-aes-cbc" or
+ * "moto_hmac(moto-sha256)" for instance. key is a user pointer, keylen 0
+ * for unkeyed hashes. ivsize and digestsize are returned with the session.
+ */
+struct moto_crypto_dev_session {
+    char driver[64];
+    __u64 key;
+    __u32 keylen;
+    __u32 type;
+    __u32 session;
+    __u32 ivsize;
+    __u32 digestsize;
+    __u32 pad;
+};
+
+#define MOTO_CRYPTO_IOC_MAGIC           'M'
+#define MOTO_CRYPTO_IOC_SETUP \
+    _IOWR(MOTO_CRYPTO_IOC_MAGIC, 0, struct moto_crypto_dev_setup)
+#define MOTO_CRYPTO_IOC_SESSION \
+    _IOWR(MOTO_CRYPTO_IOC_MAGIC, 1, struct moto_crypto_dev_session)
+#define MOTO_CRYPTO_IOC_END_SESSION \
+    _IOW(MOTO_CRYPTO_IOC_MAGIC, 2, __u32)
+/* Returns the number of jobs consumed from the submission ring */
+#define MOTO_CRYPTO_IOC_SUBMIT \
+    _IO(MOTO_CRYPTO_IOC_MAGIC, 3)
+
+#ifdef __KERNEL__
+#ifdef CONFIG_CRYPTO_MOTOROLA_FIPS_DEV
+int moto_crypto_dev_start(void);
+void moto_crypto_dev_finish(void);
+#else
+static inline int moto_crypto_dev_start(void) { return 0; }
+static inline void moto_crypto_dev_finish(void) { }
+#endif
+#endif
+
+#endif /* __MOTO_CRYPTO_DEV_H */
@@ -0,0 +1,160 @@
+/*
+ * Tracepoints on the moto_crypto hot paths, see
+ * /sys/kernel/debug/tracing/events/moto_crypto/
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM moto_crypto
+
+#if !defined(_MOTO_CRYPTO_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _MOTO_CRYPTO_TRACE_H
+
+#include <linux/crypto.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(moto_cipher_op,
+
+    TP_PROTO(struct crypto_tfm *tfm, int enc, unsigned int nbytes),
+
+    TP_ARGS(tfm, enc, nbytes),
+
+    TP_STRUCT__entry(
+        __string(driver, crypto_tfm_alg_driver_name(tfm))
+        __field(int, enc)
+        __field(unsigned int, nbytes)
+    ),
+
+    TP_fast_assign(
+        __assign_str(driver, crypto_tfm_alg_driver_name(tfm));
+        __entry->enc = enc;
+        __entry->nbytes = nbytes;
+    ),
+
+    TP_printk("%s %s nbytes=%u", __get_str(driver),
+        __entry->enc ? "encrypt" : "decrypt", __entry->nbytes)
+);
+
+DEFINE_EVENT(moto_cipher_op, moto_cipher_start,
+
+    TP_PROTO(struct crypto_tfm *tfm, int enc, unsigned int nbytes),
+
+    TP_ARGS(tfm, enc, nbytes)
+);
+
+/*
+ * segments is the number of blkcipher walk steps, inplace how many of
+ * them had the same source and destination.
+ */
+TRACE_EVENT(moto_cipher_done,
+
+    TP_PROTO(struct crypto_tfm *tfm, int enc, unsigned int nbytes,
+        unsigned int segments, unsigned int inplace, int err),
+
+    TP_ARGS(tfm, enc, nbytes, segments, inplace, err),
+
+    TP_STRUCT__entry(
+        __string(driver, crypto_tfm_alg_driver_name(tfm))
+        __field(int, enc)
+        __field(unsigned int, nbytes)
+        __field(unsigned int, segments)
+        __field(unsigned int, inplace)
+        __field(int, err)
+    ),
+
+    TP_fast_assign(
+        __assign_str(driver, crypto_tfm_alg_driver_name(tfm));
+        __entry->enc = enc;
+        __entry->nbytes = nbytes;
+        __entry->segments = segments;
+        __entry->inplace = inplace;
+        __entry->err = err;
+    ),
+
+    TP_printk("%s %s nbytes=%u segments=%u inplace=%u err=%d",
+        __get_str(driver), __entry->enc ? "encrypt" : "decrypt",
+        __entry->nbytes, __entry->segments, __entry->inplace,
+        __entry->err)
+);
+
+/* op is one of "update", "final", "finup" or "setkey" */
+DECLARE_EVENT_CLASS(moto_hash_op,
+
+    TP_PROTO(struct crypto_tfm *tfm, const char *op, unsigned int nbytes),
+
+    TP_ARGS(tfm, op, nbytes),
+
+    TP_STRUCT__entry(
+        __string(driver, crypto_tfm_alg_driver_name(tfm))
+        __string(op, op)
+        __field(unsigned int, nbytes)
+    ),
+
+    TP_fast_assign(
+        __assign_str(driver, crypto_tfm_alg_driver_name(tfm));
+        __assign_str(op, op);
+        __entry->nbytes = nbytes;
+    ),
+
+    TP_printk("%s %s nbytes=%u", __get_str(driver), __get_str(op),
+        __entry->nbytes)
+);
+
+DEFINE_EVENT(moto_hash_op, moto_hash_start,
+
+    TP_PROTO(struct crypto_tfm *tfm, const char *op, unsigned int nbytes),
+
+    TP_ARGS(tfm, op, nbytes)
+);
+
+DEFINE_EVENT(moto_hash_op, moto_hash_done,
+
+    TP_PROTO(struct crypto_tfm *tfm, const char *op, unsigned int nbytes),
+
+    TP_ARGS(tfm, op, nbytes)
+);
+
+/* ctx identifies the generator, the CPRNG has one per tfm or per CPU */
+DECLARE_EVENT_CLASS(moto_prng_op,
+
+    TP_PROTO(const void *ctx, unsigned int nbytes, int err),
+
+    TP_ARGS(ctx, nbytes, err),
+
+    TP_STRUCT__entry(
+        __field(const void *, ctx)
+        __field(unsigned int, nbytes)
+        __field(int, err)
+    ),
+
+    TP_fast_assign(
+        __entry->ctx = ctx;
+        __entry->nbytes = nbytes;
+        __entry->err = err;
+    ),
+
+    TP_printk("ctx=%p nbytes=%u err=%d", __entry->ctx, __entry->nbytes,
+        __entry->err)
+);
+
+DEFINE_EVENT(moto_prng_op, moto_prng_start,
+
+    TP_PROTO(const void *ctx, unsigned int nbytes, int err),
+
+    TP_ARGS(ctx, nbytes, err)
+);
+
+DEFINE_EVENT(moto_prng_op, moto_prng_done,
+
+    TP_PROTO(const void *ctx, unsigned int nbytes, int err),
+
+    TP_ARGS(ctx, nbytes, err)
+);
+
+#endif /* _MOTO_CRYPTO_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE moto_crypto_trace
+#include <trace/define_trace.h>
@@ -22,6 +22,9 @@
 #define SHA512_DIGEST_SIZE      64
 #define SHA512_BLOCK_SIZE       128
 
+#define SHA512_224_DIGEST_SIZE  28
+#define SHA512_256_DIGEST_SIZE  32
+
 #define SHA1_H0     0x67452301UL
 #define SHA1_H1     0xefcdab89UL
 #define SHA1_H2     0x98badcfeUL
@@ -64,6 +67,25 @@
 #define SHA512_H6   0x1f83d9abfb41bd6bULL
 #define SHA512_H7   0x5be0cd19137e2179ULL
 
+/* FIPS 180-4 5.3.6, the SHA-512/t IV generation function for t = 224, 256 */
+#define SHA512_224_H0   0x8c3d37c819544da2ULL
+#define SHA512_224_H1   0x73e1996689dcd4d6ULL
+#define SHA512_224_H2   0x1dfab7ae32ff9c82ULL
+#define SHA512_224_H3   0x679dd514582f9fcfULL
+#define SHA512_224_H4   0x0f6d2b697bd44da8ULL
+#define SHA512_224_H5   0x77e36f7304c48942ULL
+#define SHA512_224_H6   0x3f9d85a86a1d36c8ULL
+#define SHA512_224_H7   0x1112e6ad91d692a1ULL
+
+#define SHA512_256_H0   0x22312194fc2bf72cULL
+#define SHA512_256_H1   0x9f555fa3c84c64c2ULL
+#define SHA512_256_H2   0x2393b86b6f53b151ULL
+#define SHA512_256_H3   0x963877195940eabdULL
+#define SHA512_256_H4   0x96283ee2a88effe3ULL
+#define SHA512_256_H5   0xbe5e1e2553863992ULL
+#define SHA512_256_H6   0x2b0199fc2c85b8aaULL
+#define SHA512_256_H7   0x0eb72ddc81c52ca2ULL
+
 struct moto_sha1_state {
     u64 count;
     u32 state[SHA1_DIGEST_SIZE / 4];
@@ -82,6 +104,42 @@ struct moto_sha512_state {
     u8 buf[SHA512_BLOCK_SIZE];
 };
 
+/* Block transforms, nblocks whole blocks without padding */
+void moto_sha1_transform_blocks(u32 *digest, const u8 *in,
+        unsigned int nblocks);
+void moto_sha256_transform_blocks(u32 *state, const u8 *input,
+        unsigned int nblocks);
+void moto_sha512_transform_blocks(u64 *state, const u8 *input,
+        unsigned int nblocks);
+
+/* Block function of the moto-sha1 and moto-sha224/256 shash drivers */
+typedef void (moto_sha_block_fn)(u32 *state, const u8 *data,
+        unsigned int nblocks);
+
+/* Rounds of one block, the message schedule W[] already expanded */
+void moto_sha1_transform_w(u32 *digest, const u32 *W);
+void moto_sha256_transform_w(u32 *state, const u32 *W);
+
+extern const u32 moto_sha256_K[64];
+
+/* shash helpers running the block function given, for moto_sha_x86.c */
+struct shash_desc;
+int moto_sha1_init(struct shash_desc *desc);
+int moto_sha1_do_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len, moto_sha_block_fn *blocks);
+int moto_sha1_do_final(struct shash_desc *desc, u8 *out,
+        moto_sha_block_fn *blocks);
+int moto_sha224_init(struct shash_desc *desc);
+int moto_sha256_init(struct shash_desc *desc);
+int moto_sha256_do_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len, moto_sha_block_fn *blocks);
+int moto_sha256_do_final(struct shash_desc *desc, u8 *out,
+        moto_sha_block_fn *blocks);
+
+/* NULL restores the portable block function */
+void moto_sha1_set_blocks(moto_sha_block_fn *blocks);
+void moto_sha256_set_blocks(moto_sha_block_fn *blocks);
+
 int moto_sha1_start(void);
 void moto_sha1_finish(void);
 int moto_sha256_start(void);
@@ -89,6 +147,14 @@ void moto_sha256_finish(void);
 int moto_sha512_start(void);
 void moto_sha512_finish(void);
 
+#ifdef CONFIG_X86_64
+int moto_sha_x86_start(void);
+void moto_sha_x86_finish(void);
+#else
+static inline int moto_sha_x86_start(void) { return 0; }
+static inline void moto_sha_x86_finish(void) { }
+#endif
+
 int moto_hmac_start(void);
 void moto_hmac_finish(void);
 
@@ -0,0 +1,64 @@
+/*
+ * Multi-buffer SHA-256: independent messages hashed together, one block
+ * of each per SIMD lane and pass.
+ *
+ * moto_sha256_mb_digest() runs a batch of jobs to completion. The lanes
+ * are refilled as messages end, so short and long messages can be mixed
+ * freely. The moto-sha256-mb ahash driver collects digest() requests and
+ * runs them through the same engine.
+ */
+
+#ifndef _MOTO_CRYPTO_SHA256_MB_H
+#define _MOTO_CRYPTO_SHA256_MB_H
+
+#include <linux/types.h>
+#include <moto_sha.h>
+
+#define MOTO_SHA256_MB_MAX_LANES    8
+
+/* digest receives SHA256_DIGEST_SIZE bytes */
+struct moto_sha256_mb_job {
+    const u8 *data;
+    unsigned int len;
+    u8 *digest;
+};
+
+/*
+ * A lane implementation: blocks() transforms one block in each of the
+ * lanes, state[8][lanes] and W[64][lanes] are stored lane after lane with
+ * the first 16 rows of W loaded.
+ */
+struct moto_sha256_mb_lanes {
+    const char *name;
+    unsigned int lanes;
+    void (*blocks)(u32 *state, u32 *W);
+};
+
+struct moto_sha256_mb_ctx;
+
+void moto_sha256_transform_lanes(u32 *state, u32 *W, unsigned int lanes);
+
+/* lanes NULL picks the best implementation for the CPU */
+struct moto_sha256_mb_ctx *moto_sha256_mb_alloc(
+        const struct moto_sha256_mb_lanes *lanes, gfp_t gfp);
+void moto_sha256_mb_free(struct moto_sha256_mb_ctx *ctx);
+void moto_sha256_mb_digest(struct moto_sha256_mb_ctx *ctx,
+        struct moto_sha256_mb_job *jobs, unsigned int njobs);
+
+int moto_sha256_mb_self_test(void);
+
+int moto_sha256_mb_start(void);
+void moto_sha256_mb_finish(void);
+
+#ifdef CONFIG_X86_64
+/* The i-th lane implementation the CPU supports, best first, or NULL */
+const struct moto_sha256_mb_lanes *moto_sha256_mb_x86_lanes(unsigned int i);
+#else
+static inline const struct moto_sha256_mb_lanes *moto_sha256_mb_x86_lanes(
+        unsigned int i)
+{
+    return NULL;
+}
+#endif
+
+#endif
@@ -108,6 +108,7 @@ make_compat() {
 
     echo " Generating moto_crypto HMAC"
     ${COMPAT_SRC_DIR}/scripts/fips_module_hmac.py 3c091d83745f3ed32cab47458950bca648561bc54d738fe5ee34235ff1100d4a ${MODULE_DEST}/moto_crypto.ko > ${MODULE_DEST}/moto_crypto_hmac_sha256
+    ${COMPAT_SRC_DIR}/scripts/fips_module_hmac.py 3c091d83745f3ed32cab47458950bca648561bc54d738fe5ee34235ff1100d4a ${MODULE_DEST}/moto_crypto.ko tree > ${MODULE_DEST}/moto_crypto_hmac_sha256_tree 2> /dev/null
     cd ${TOP}
 }
 
@@ -329,3 +329,179 @@ def writeResults(respFile, filename, resps, tests, enc):
             writeTag(respFile, 'PLAINTEXT', hexbuf)
         respFile.write('\n')
 
+
+# Parses the AES XTS tests req files (XTSGenAES128.req, XTSGenAES256.req)
+# reqdir: directory where to find the req files
+# Returns a dict which maps the req file name to the data returned by processXTSFile
+def parseXTS(reqdir):
+    reqdata = {}
+    for r,d,f in os.walk(reqdir):
+        for arq in f:
+            if arq.startswith('XTS') & arq.endswith(".req"):
+                reqdata[arq] = processXTSFile(os.path.join(r,arq))
+    return reqdata
+
+# Parses one AES XTS req file. Same structure as processAESFile, but the
+# counts of the XTS files start at 1 on each section.
+def processXTSFile(arq):
+    reqdata = {}
+    section = None
+    for line in open(arq, 'r').readlines():
+        line = line.strip()
+        if len(line) > 0:
+            first = line[:1]
+            if first != '#':
+                if first =='[':
+                    close = line.rindex(']')
+                    section = line[1:close]
+                    reqdata[section] = {}
+                    count = -1
+                else:
+                    parts = line.split()
+                    if parts[1] != '=':
+                        print "Error format line=", line
+                        continue
+                    if parts[0].lower() == 'count':
+                        count = int(parts[2])
+                        reqdata[section][count] = {}
+                    else:
+                        reqdata[section][count][parts[0]] = parts[2]
+    return reqdata
+
+# Returns the tweak of a XTS test as a hex string. The req files give it
+# either directly (i) or as a data unit sequence number, which is encoded
+# little endian in 16 bytes.
+def xtsTweak(value):
+    if value.has_key('i'):
+        return value['i']
+    seq = int(value['DataUnitSeqNumber'])
+    tweak = []
+    for i in range(16):
+        tweak.append('%02x' % ((seq >> (8 * i)) & 0xff))
+    return ''.join(tweak)
+
+# Only whole blocks are supported by the driver, tests with a data unit
+# length that is not a multiple of the block size are skipped
+def xtsSupported(value):
+    return int(value['DataUnitLen']) % 128 == 0
+
+def writeXTSTests(prefix, out, reqdata):
+    enccount = 0
+    deccount = 0
+    for (section, suffix) in [('ENCRYPT', '_enc'), ('DECRYPT', '_dec')]:
+        first = True
+        for filename, filedata in reqdata.items():
+            toprocess = [(count, value) for count, value in filedata[section].items() if xtsSupported(value)]
+            if len(toprocess) == 0:
+                continue
+            if first:
+                out.write('static struct moto_test_cipher_testvec ')
+                out.write(prefix)
+                out.write(suffix)
+                out.write('[] = {\n')
+                first = False
+            else:
+                out.write(',\n')
+            if section == 'ENCRYPT':
+                enccount += len(toprocess)
+            else:
+                deccount += len(toprocess)
+            xtswrite(out, filename, toprocess, section == 'ENCRYPT')
+        if not first:
+            out.write('\n};\n')
+    return (enccount, deccount)
+
+# Write the parameters of a specific AES XTS test, see aeswrite
+def xtswrite(f, tname, testvector, encrypt):
+    ident = ' ' * 4
+    doubleident = ident * 2
+    first = True
+    for count, value in testvector:
+        if not first:
+            f.write(',\n')
+        if encrypt:
+            inputstr = value['PT']
+        else:
+            inputstr = value['CT']
+        keystr = value['Key']
+        ivstr = xtsTweak(value)
+        f.write(ident)
+        f.write('{\n')
+        f.write(doubleident)
+        f.write('.test_file_name = "')
+        f.write(tname)
+        f.write('",\n')
+        f.write(doubleident)
+        f.write('.count = ')
+        f.write(str(count))
+        f.write(',\n')
+        f.write(doubleident)
+        f.write('.key = "')
+        f.write(hex2c(keystr))
+        f.write('",\n')
+        f.write(doubleident)
+        f.write('.klen = ')
+        f.write(str(len(keystr)/2))
+        f.write(',\n')
+        f.write(doubleident)
+        f.write('.iv = "')
+        f.write(hex2c(ivstr))
+        f.write('",\n')
+        f.write(doubleident)
+        f.write('.input = "')
+        f.write(hex2c(inputstr))
+        f.write('",\n')
+        f.write(doubleident)
+        f.write('.ilen = ')
+        f.write(str(len(inputstr)/2))
+        f.write(',\n')
+        f.write(ident)
+        f.write('}')
+        first = False
+
+def writeXTSResp(data, logData):
+    for filename, testData in data.items():
+        encDec = logData.get(filename)
+        if encDec == None:
+            print 'Log data not found for file', filename
+            continue
+        filenameParts = filename.split('.')
+        respFile = open(filenameParts[0] + '.rsp', 'w')
+        for (section, enc) in [('ENCRYPT', '1'), ('DECRYPT', '0')]:
+            tests = testData.get(section)
+            if tests == None:
+                print section, 'test data not found for file', filename
+                continue
+            resps = encDec.get(enc)
+            if resps == None:
+                print 'No log data for', section, 'tests found for file', filename
+                continue
+            writeXTSResults(respFile, filename, resps, tests, section == 'ENCRYPT')
+        respFile.close()
+
+def writeXTSResults(respFile, filename, resps, tests, enc):
+    if enc:
+        respFile.write('[ENCRYPT]\n\n')
+    else:
+        respFile.write('[DECRYPT]\n\n')
+    for count, params in tests.items():
+        if not xtsSupported(params):
+            continue
+        hexbuf = resps.get(count)
+        if hexbuf == None:
+            print 'No response found for count', count, 'and file', filename
+            continue
+        writeTag(respFile, 'COUNT', str(count))
+        writeTag(respFile, 'DataUnitLen', params['DataUnitLen'])
+        writeTag(respFile, 'Key', params['Key'])
+        if params.has_key('i'):
+            writeTag(respFile, 'i', params['i'])
+        else:
+            writeTag(respFile, 'DataUnitSeqNumber', params['DataUnitSeqNumber'])
+        if enc:
+            writeTag(respFile, 'PT', params['PT'])
+            writeTag(respFile, 'CT', hexbuf)
+        else:
+            writeTag(respFile, 'CT', params['CT'])
+            writeTag(respFile, 'PT', hexbuf)
+        respFile.write('\n')
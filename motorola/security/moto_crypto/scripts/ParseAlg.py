@@ -7,12 +7,16 @@ Created on Sep 20, 2012
 '''
 
 import argparse
+import os
 from AESParser import parseAES
 from AESParser import writeAESTests
 from AESParser import parseAESKernelLogLine
 from AESParser import parseAESMonteKernelLogLine
 from AESParser import writeAESResp
 from AESParser import writeAESMonteResp
+from AESParser import parseXTS
+from AESParser import writeXTSTests
+from AESParser import writeXTSResp
 from SHAParser import parseSHA
 from SHAParser import writeShaTests
 from SHAParser import writeShaMonteTests
@@ -49,7 +53,7 @@ def main():
     args = parser.parse_args()
     args.algs = map(str.lower, args.algs)
     for alg in args.algs:
-        if not alg in ['aes','sha','tdes','rng','hmac']:
+        if not alg in ['aes','xts','sha','tdes','rng','hmac']:
             print 'Unknown algorithm', alg
             exit()
     if args.reqdir != None:
@@ -80,11 +84,25 @@ def generateTestCode(reqdir, algs):
         cbcPickleFile.close()
         cbcCount = writeAESTests('moto_aes_cbc', aesFile, cbcData, cbcMonteData)
         aesFile.close()
+    xtsCount = (0, 0)
+    if 'xts' in algs:
+        xtsFile = open('alg_test_aes_xts.c', 'w')
+        xtsData = parseXTS(reqdir)
+        xtsPickleFile = open('xtsdata.bin', 'w')
+        cPickle.dump(xtsData, xtsPickleFile, cPickle.HIGHEST_PROTOCOL)
+        xtsPickleFile.close()
+        xtsCount = writeXTSTests('moto_aes_xts', xtsFile, xtsData)
+        xtsFile.close()
     shaCount = None
     if 'sha' in algs:
         shaCount = {}
-        for alg in ['SHA1', 'SHA224', 'SHA256', 'SHA384', 'SHA512']:
+        for alg in ['SHA1', 'SHA224', 'SHA256', 'SHA384', 'SHA512', 'SHA512_224', 'SHA512_256']:
             (shaData, shaMonteData) = parseSHA(alg, reqdir)
+            if shaMonteData is None and len(shaData) == 0:
+                # older req sets have no SHA-512/t files
+                print 'No req files for', alg
+                shaCount[alg] = 0
+                continue
             shaPickleFile = open('shadata_' + alg + '.bin', 'w')
             cPickle.dump(shaData, shaPickleFile, cPickle.HIGHEST_PROTOCOL)
             shaPickleFile.close()
@@ -136,12 +154,13 @@ def generateTestCode(reqdir, algs):
         hmacCount = writeHMACTests(hmacFile, hmacData)
          
     generalFile = open('alg_test.c', 'w')
-    writeTestDesc(generalFile, ecbCount, cbcCount, shaCount, tdesEcbCount, tdesCbcCount, rngCount, hmacCount)
+    writeTestDesc(generalFile, ecbCount, cbcCount, shaCount, tdesEcbCount, tdesCbcCount, rngCount, hmacCount, xtsCount)
     generalFile.close()
 
 def generateRespFile(klogfile, algs):
     aesLogData = {}
     aesMonteLogData = {}
+    xtsLogData = {}
     shaLogData = {}
     shaMonteLogData = {}
     tdesLogData = {}
@@ -149,6 +168,7 @@ def generateRespFile(klogfile, algs):
     rngLogData = {}
     hmacLogData = {}
     aes = 'aes' in algs
+    xts = 'xts' in algs
     sha = 'sha' in algs
     tdes = 'tdes' in algs
     rng = 'rng' in algs
@@ -182,6 +202,11 @@ def generateRespFile(klogfile, algs):
                         parseAESKernelLogLine(line, aesLogData)
                     else:
                         continue
+                elif parts[1].startswith('XTS'):
+                    if xts:
+                        parseAESKernelLogLine(line, xtsLogData)
+                    else:
+                        continue
                 elif parts[1].startswith('SHA'):
                     if sha:
                         parseSHAKernelLogLine(line, shaLogData)
@@ -219,8 +244,17 @@ def generateRespFile(klogfile, algs):
         writeAESResp(cbcData, aesLogData)
         writeAESMonteResp(cbcMonteData, aesMonteLogData)
 
+    if xts:
+        xtsPickleFile = open('xtsdata.bin', 'r')
+        xtsData = cPickle.load(xtsPickleFile)
+        xtsPickleFile.close()
+        writeXTSResp(xtsData, xtsLogData)
+
     if sha:
-        for (alg, size) in [('SHA1', '20'), ('SHA224', '28'), ('SHA256', '32'), ('SHA384', '48'), ('SHA512', '64')]:
+        for (alg, size) in [('SHA1', '20'), ('SHA224', '28'), ('SHA256', '32'), ('SHA384', '48'), ('SHA512', '64'),
+                            ('SHA512_224', '28'), ('SHA512_256', '32')]:
+            if not os.path.exists('shadata_' + alg + '.bin'):
+                continue
             shaPickleFile = open('shadata_' + alg + '.bin', 'r')
             shaData = cPickle.load(shaPickleFile)
             shaPickleFile.close()
@@ -265,7 +299,8 @@ def generateRespFile(klogfile, algs):
 # ecbCount: array with the number of AES ECB encryption (position 0) and decryption tests (position 1)
 # cbcCount: array with the number of AES CBC encryption (position 0) and decryption tests (position 1)
 # shaCount: number of SHA1 tests
-def writeTestDesc(out, ecbCount, cbcCount, shaCount, tdesEcbCount, tdesCbcCount, rngCount, hmacCount):
+# xtsCount: array with the number of AES XTS encryption (position 0) and decryption tests (position 1)
+def writeTestDesc(out, ecbCount, cbcCount, shaCount, tdesEcbCount, tdesCbcCount, rngCount, hmacCount, xtsCount):
     out.write('''
 /* Please keep this list sorted by algorithm name. */
 static const struct moto_alg_test_desc moto_alg_test_descs[] = {
@@ -551,6 +586,65 @@ static const struct moto_alg_test_desc moto_alg_test_descs[] = {
     },
 #endif
     ''')
+        if shaCount['SHA512_224'] > 0:
+            out.write('''
+#ifdef TEST_SHA512_224
+    {
+        .alg = "sha512_224",
+        .test = moto_alg_test_hash,
+        .suite = {
+            .hash = {
+                .vecs = moto_sha512_224,
+                .count = ''')
+            out.write(str(shaCount['SHA512_224']))
+            out.write('''
+            }
+        }
+    },
+#endif
+    ''')
+        if shaCount['SHA512_256'] > 0:
+            out.write('''
+#ifdef TEST_SHA512_256
+    {
+        .alg = "sha512_256",
+        .test = moto_alg_test_hash,
+        .suite = {
+            .hash = {
+                .vecs = moto_sha512_256,
+                .count = ''')
+            out.write(str(shaCount['SHA512_256']))
+            out.write('''
+            }
+        }
+    },
+#endif
+    ''')
+    if xtsCount[0] > 0:
+        out.write('''
+#ifdef TEST_AES_XTS
+    {
+        .alg = "xts(aes)",
+        .test = moto_alg_test_skcipher,
+        .suite = {
+            .cipher = {
+                .enc = {
+                    .vecs = moto_aes_xts_enc,
+                    .count = ''')
+        out.write(str(xtsCount[0]))
+        out.write('''
+                },
+                .dec = {
+                    .vecs = moto_aes_xts_dec,
+                    .count = ''')
+        out.write(str(xtsCount[1]))
+        out.write('''
+                }
+            }
+        }
+    },
+#endif
+''')
     out.write('''
 };
 
@@ -11,13 +11,15 @@ from ParseUtils import writeTag
 
 def parseSHA(alg, reqdir):
     reqdata = {}
+    shaMonte = None
     monte = alg + 'Monte'
     for r,d,f in os.walk(reqdir):
         for arq in f:
             if arq.endswith('.req'):
+                # SHA512 must not pick up the SHA512_224 and SHA512_256 files
                 if arq.startswith(monte):
                     shaMonte = processSHAMonteFile(os.path.join(r,arq))
-                elif arq.startswith(alg):
+                elif arq.startswith(alg + 'ShortMsg') or arq.startswith(alg + 'LongMsg'):
                     reqdata[arq] = processSHAFile(os.path.join(r,arq))
     return (reqdata, shaMonte)
                 
@@ -1,6 +1,11 @@
 #!/usr/bin/python
 # This script calculates the HMAC-SHA256 of one file and writes the result
 # to stdout
+#
+# With "tree" as third argument it writes the root of the tree integrity
+# format instead: the SHA-256 of every CHUNK_SIZE bytes chunk is written
+# to stderr and the HMAC-SHA256 of the concatenated chunk digests is
+# written to stdout as hmac_sha256_tree=
 
 import binascii
 import hashlib
@@ -12,10 +17,22 @@ from elftools.elf.descriptions import _DESCR_SH_TYPE
 
 sys.path.extend(['.', '..'])
 
+# Chunk size of the tree format, must match MOTO_INTEGRITY_CHUNK_SIZE in
+# src/moto_crypto_main.c
+CHUNK_SIZE = 16384
+
 from elftools.common.py3compat import bytes2str
 from elftools.elf.elffile import ELFFile
 
-def process_file(hash_key, filename):
+def tree_hmac(hash_key, data):
+    leaves = bytearray()
+    for offset in range(0, len(data), CHUNK_SIZE):
+        leaf = hashlib.sha256(bytes(data[offset:offset + CHUNK_SIZE]))
+        sys.stderr.write('%d %s\n' % (offset // CHUNK_SIZE, leaf.hexdigest()))
+        leaves.extend(leaf.digest())
+    return hmac.new(binascii.unhexlify(hash_key), bytes(leaves), hashlib.sha256).hexdigest()
+
+def process_file(hash_key, filename, tree=False):
     with open(filename, 'rb') as f:
         elffile = ELFFile(f)
 
@@ -78,8 +95,11 @@ def process_file(hash_key, filename):
 
         # Create the right content "hmac_sha256=yyy", yyy is the hmac sha256 value
         # worked out by python hashlib from the file argv[1]
-        params = "hmac_sha256=" + hmac.new(binascii.unhexlify(hash_key), bytes(canonicalized_data), hashlib.sha256).hexdigest();
+        if tree:
+            params = "hmac_sha256_tree=" + tree_hmac(hash_key, canonicalized_data)
+        else:
+            params = "hmac_sha256=" + hmac.new(binascii.unhexlify(hash_key), bytes(canonicalized_data), hashlib.sha256).hexdigest();
         sys.stdout.write(params)
 
 # Process the given arguments
-process_file(sys.argv[1], sys.argv[2])
+process_file(sys.argv[1], sys.argv[2], len(sys.argv) > 3 and sys.argv[3] == 'tree')
@@ -0,0 +1,598 @@
+#!/usr/bin/env python
+#
+# Generates the inline assembly of moto_aes_bs_ssse3_encrypt8() and
+# moto_aes_bs_ssse3_decrypt8() in src/moto_aes_bs_x86.c.
+#
+# The rounds are written below as operations on whole bit planes, the
+# same circuits as the portable code in src/moto_aes_bs.c, and this script
+# assigns them the sixteen xmm registers, spilling to the scratch area
+# when they run out, and checks the result against FIPS-197 by running the
+# instruction stream it emits.
+#
+#   moto_aes_bs_x86.py          print the two functions
+#   moto_aes_bs_x86.py check    only run the known answer tests
+#
+# Layout: the eight blocks are transposed so that register k holds bit k
+# of every state byte, bit j of each of its bytes coming from block j.
+# Byte 4r + c of a register is row r, column c of the state, so ShiftRows
+# is a pshufb within each dword and MixColumns rotates whole dwords.
+# The round keys are laid out the same way, eight registers per round,
+# with the 0x63 of the S-box affine map folded into rounds 1 and up: it
+# passes unchanged through ShiftRows and (Inv)MixColumns, so the circuits
+# here leave out all its NOTs.
+
+import re
+import sys
+
+NREGS = 16
+
+SBOX_GATES = """
+    y14 = x3 ^ x5; y13 = x0 ^ x6; y9 = x0 ^ x3; y8 = x0 ^ x5;
+    t0 = x1 ^ x2; y1 = t0 ^ x7; y4 = y1 ^ x3; y12 = y13 ^ y14;
+    y2 = y1 ^ x0; y5 = y1 ^ x6; y3 = y5 ^ y8; t1 = x4 ^ y12;
+    y15 = t1 ^ x5; y20 = t1 ^ x1; y6 = y15 ^ x7; y10 = y15 ^ t0;
+    y11 = y20 ^ y9; y7 = x7 ^ y11; y17 = y10 ^ y11; y19 = y10 ^ y8;
+    y16 = t0 ^ y11; y21 = y13 ^ y16; y18 = x0 ^ y16;
+    t2 = y12 & y15; t3 = y3 & y6; t4 = t3 ^ t2; t5 = y4 & x7;
+    t6 = t5 ^ t2; t7 = y13 & y16; t8 = y5 & y1; t9 = t8 ^ t7;
+    t10 = y2 & y7; t11 = t10 ^ t7; t12 = y9 & y11; t13 = y14 & y17;
+    t14 = t13 ^ t12; t15 = y8 & y10; t16 = t15 ^ t12; t17 = t4 ^ t14;
+    t18 = t6 ^ t16; t19 = t9 ^ t14; t20 = t11 ^ t16; t21 = t17 ^ y20;
+    t22 = t18 ^ y19; t23 = t19 ^ y21; t24 = t20 ^ y18;
+    t25 = t21 ^ t22; t26 = t21 & t23; t27 = t24 ^ t26; t28 = t25 & t27;
+    t29 = t28 ^ t22; t30 = t23 ^ t24; t31 = t22 ^ t26; t32 = t31 & t30;
+    t33 = t32 ^ t24; t34 = t23 ^ t33; t35 = t27 ^ t33; t36 = t24 & t35;
+    t37 = t36 ^ t34; t38 = t27 ^ t36; t39 = t29 & t38; t40 = t25 ^ t39;
+    t41 = t40 ^ t37; t42 = t29 ^ t33; t43 = t29 ^ t40; t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15; z1 = t37 & y6; z2 = t33 & x7; z3 = t43 & y16;
+    z4 = t40 & y1; z5 = t29 & y7; z6 = t42 & y11; z7 = t45 & y17;
+    z8 = t41 & y10; z9 = t44 & y12; z10 = t37 & y3; z11 = t33 & y4;
+    z12 = t43 & y13; z13 = t40 & y5; z14 = t29 & y2; z15 = t42 & y9;
+    z16 = t45 & y14; z17 = t41 & y8;
+    t46 = z15 ^ z16; t47 = z10 ^ z11; t48 = z5 ^ z13; t49 = z9 ^ z10;
+    t50 = z2 ^ z12; t51 = z2 ^ z5; t52 = z7 ^ z8; t53 = z0 ^ z3;
+    t54 = z6 ^ z7; t55 = z16 ^ z17; t56 = z12 ^ t48; t57 = t50 ^ t53;
+    t58 = z4 ^ t46; t59 = z3 ^ t54; t60 = t46 ^ t57; t61 = z14 ^ t57;
+    t62 = t52 ^ t58; t63 = t49 ^ t58; t64 = z4 ^ t59; t65 = t61 ^ t62;
+    t66 = z1 ^ t63; s0 = t59 ^ t63; s6 = t56 ^ t62; s7 = t48 ^ t60;
+    t67 = t64 ^ t65; s3 = t53 ^ t66; s4 = t51 ^ t66; s5 = t47 ^ t65;
+    s1 = t64 ^ s3; s2 = t55 ^ t67;
+"""
+
+# Offsets in struct moto_aes_bs_x86_consts
+CONSTS = {'m0': 0, 'sr': 16, 'isr': 32, 'm55': 48, 'm33': 64, 'm0f': 80}
+
+M0 = [4 * (p % 4) + p // 4 for p in range(16)]
+SR = [4 * (p // 4) + (p % 4 + p // 4) % 4 for p in range(16)]
+ISR = [4 * (p // 4) + (p % 4 - p // 4) % 4 for p in range(16)]
+MASKS = {'m0': M0, 'sr': SR, 'isr': ISR,
+        'm55': [0x55] * 16, 'm33': [0x33] * 16, 'm0f': [0x0f] * 16}
+
+
+class Val(object):
+    def __init__(self, name):
+        self.name = name
+
+
+class Prog(object):
+    """A straight line of operations on 128 bit values"""
+
+    def __init__(self, inputs):
+        self.inputs = [Val('b%d' % k) for k in range(inputs)]
+        self.ops = []
+
+    def _op(self, kind, args, name=None):
+        v = Val(name)
+        self.ops.append((kind, v, args))
+        return v
+
+    def xor(self, a, b, name=None):
+        return self._op('pxor', (a, b), name)
+
+    def and_(self, a, b, name=None):
+        return self._op('pand', (a, b), name)
+
+    def srl(self, a, n):
+        return self._op('psrlq', (a, n))
+
+    def sll(self, a, n):
+        return self._op('psllq', (a, n))
+
+    def shufb(self, a, mask):
+        return self._op('pshufb', (a, mask))
+
+    def shufd(self, a, imm):
+        return self._op('pshufd', (a, imm))
+
+    def load(self, base, off):
+        return self._op('movdqu', (base, off))
+
+    def store(self, base, off, a):
+        self.ops.append(('store', None, (base, off, a)))
+
+
+def sbox(p, q):
+    x = dict(('x%d' % i, q[7 - i]) for i in range(8))
+    for gate in re.findall(r'(\w+) = (\w+) ([&^]) (\w+);', SBOX_GATES):
+        out, a, op, b = gate
+        if op == '^':
+            x[out] = p.xor(x[a], x[b], out)
+        else:
+            x[out] = p.and_(x[a], x[b], out)
+    return [x['s%d' % (7 - k)] for k in range(8)]
+
+
+def inv_affine(p, q):
+    r = [None] * 8
+    r[7] = p.xor(p.xor(q[1], q[4]), q[6])
+    r[6] = p.xor(p.xor(q[0], q[3]), q[5])
+    r[5] = p.xor(p.xor(q[7], q[2]), q[4])
+    r[4] = p.xor(p.xor(q[6], q[1]), q[3])
+    r[3] = p.xor(p.xor(q[5], q[0]), q[2])
+    r[2] = p.xor(p.xor(q[4], q[7]), q[1])
+    r[1] = p.xor(p.xor(q[3], q[6]), q[0])
+    r[0] = p.xor(p.xor(q[2], q[5]), q[7])
+    return r
+
+
+def inv_sbox(p, q):
+    return inv_affine(p, sbox(p, inv_affine(p, q)))
+
+
+def shift_rows(p, q, mask):
+    return [p.shufb(v, mask) for v in q]
+
+
+def mix_columns(p, q):
+    r = [p.shufd(v, 0x39) for v in q]
+    t = [p.xor(q[i], r[i]) for i in range(8)]
+    out = [None] * 8
+    for i in range(8):
+        v = p.xor(r[i], p.shufd(t[i], 0x4e))
+        if i:
+            v = p.xor(v, t[i - 1])
+        if i in (0, 1, 3, 4):
+            v = p.xor(v, t[7])
+        out[i] = v
+    return out
+
+
+def inv_mix_columns(p, q):
+    u = [p.xor(v, p.shufd(v, 0x4e)) for v in q]
+    pre = ((6,), (7, 6), (0, 7), (1, 6), (2, 7, 6), (3, 7), (4,), (5,))
+    r = list(q)
+    for i, srcs in enumerate(pre):
+        for s in srcs:
+            r[i] = p.xor(r[i], u[s])
+    return mix_columns(p, r)
+
+
+def add_round_key(p, q, off):
+    return [p.xor(q[k], p.load('rk', off + 16 * k)) for k in range(8)]
+
+
+def transpose(p, q):
+    q = list(q)
+    for n, mask, pairs in ((1, 'm55', ((0, 1), (2, 3), (4, 5), (6, 7))),
+            (2, 'm33', ((0, 2), (1, 3), (4, 6), (5, 7))),
+            (4, 'm0f', ((0, 4), (1, 5), (2, 6), (3, 7)))):
+        for lo, hi in pairs:
+            t = p.and_(p.xor(p.srl(q[lo], n), q[hi]), mask)
+            q[hi] = p.xor(q[hi], t)
+            q[lo] = p.xor(q[lo], p.sll(t, n))
+    return q
+
+
+def load_blocks(p):
+    return transpose(p, [p.shufb(p.load('in', 16 * j), 'm0')
+            for j in range(8)])
+
+
+def store_blocks(p, q):
+    q = transpose(p, q)
+    for j in range(8):
+        p.store('out', 16 * j, p.shufb(q[j], 'm0'))
+
+
+def fragments(decrypt):
+    """Prologue, loop body and final round, the state in %xmm0-7 between"""
+    first = Prog(0)
+    q = load_blocks(first)
+    q = add_round_key(first, q, 0)
+    first.outputs = q
+
+    body = Prog(8)
+    q = body.inputs
+    if decrypt:
+        q = inv_sbox(body, shift_rows(body, q, 'isr'))
+        q = inv_mix_columns(body, add_round_key(body, q, 0))
+    else:
+        q = mix_columns(body, shift_rows(body, sbox(body, q), 'sr'))
+        q = add_round_key(body, q, 0)
+    body.outputs = q
+
+    last = Prog(8)
+    q = last.inputs
+    if decrypt:
+        q = inv_sbox(last, shift_rows(last, q, 'isr'))
+        q = add_round_key(last, q, -128)
+    else:
+        q = shift_rows(last, sbox(last, q), 'sr')
+        q = add_round_key(last, q, 128)
+    store_blocks(last, q)
+    last.outputs = []
+    return first, body, last
+
+
+class Alloc(object):
+    """Greedy register assignment, spilling the value used furthest away"""
+
+    def __init__(self, prog):
+        self.prog = prog
+        self.lines = []
+        self.reg = {}       # value -> register
+        self.slot = {}      # value -> spill slot
+        self.free_slots = []
+        self.nslots = 0
+        self.uses = {}
+        for i, (kind, dst, args) in enumerate(prog.ops):
+            for a in args:
+                if isinstance(a, Val):
+                    self.uses.setdefault(a, []).append(i)
+        end = len(prog.ops)
+        for v in prog.outputs:
+            self.uses.setdefault(v, []).append(end)
+
+    def next_use(self, v, i):
+        for u in self.uses.get(v, ()):
+            if u > i:
+                return u
+        return None
+
+    def emit(self, text, comment=None):
+        self.lines.append((text, comment))
+
+    def loc(self, v):
+        if v in self.reg:
+            return '%%%%xmm%d' % self.reg[v]
+        return '%d(%%[s])' % (16 * self.slot[v])
+
+    def get_reg(self, i, keep=()):
+        used = set(self.reg.values())
+        for r in range(NREGS):
+            if r not in used:
+                return r
+        victim = None
+        for v in self.reg:
+            if v in keep:
+                continue
+            n = self.next_use(v, i)
+            if victim is None or n is None or \
+                    (vn is not None and n > vn):
+                victim, vn = v, n
+                if n is None:
+                    break
+        r = self.reg.pop(victim)
+        if victim not in self.slot and self.next_use(victim, i) is not None:
+            if self.free_slots:
+                s = self.free_slots.pop()
+            else:
+                s = self.nslots
+                self.nslots += 1
+            self.slot[victim] = s
+            self.emit('movdqa %%%%xmm%d, %d(%%[s])' % (r, 16 * s))
+        return r
+
+    def ensure_reg(self, v, i, keep=()):
+        if v not in self.reg:
+            r = self.get_reg(i, keep)
+            self.emit('movdqa %s, %%%%xmm%d' % (self.loc(v), r))
+            self.reg[v] = r
+        return self.reg[v]
+
+    def release(self, i):
+        for v in list(self.reg) + list(self.slot):
+            if self.next_use(v, i) is None:
+                if v in self.reg:
+                    del self.reg[v]
+                if v in self.slot:
+                    self.free_slots.append(self.slot.pop(v))
+
+    def operand(self, a):
+        if isinstance(a, str):
+            return '%d(%%[c])' % CONSTS[a]
+        return self.loc(a)
+
+    def run(self):
+        for k, v in enumerate(self.prog.inputs):
+            self.reg[v] = k
+        for i, (kind, dst, args) in enumerate(self.prog.ops):
+            if kind == 'store':
+                base, off, a = args
+                r = self.ensure_reg(a, i)
+                self.emit('movdqu %%%%xmm%d, %d(%%[%s])' % (r, off, base))
+            elif kind == 'movdqu':
+                base, off = args
+                r = self.get_reg(i)
+                self.emit('movdqu %d(%%[%s]), %%%%xmm%d' % (off, base, r))
+                self.reg[dst] = r
+            elif kind == 'pshufd':
+                a, imm = args
+                r = self.get_reg(i, (a,))
+                self.emit('pshufd $0x%02x, %s, %%%%xmm%d' %
+                        (imm, self.operand(a), r))
+                self.reg[dst] = r
+            elif kind in ('psrlq', 'psllq', 'pshufb'):
+                a, n = args
+                if a in self.reg and self.next_use(a, i) is None:
+                    r = self.reg.pop(a)
+                else:
+                    r = self.get_reg(i, (a,))
+                    self.emit('movdqa %s, %%%%xmm%d' % (self.loc(a), r))
+                if kind == 'pshufb':
+                    self.emit('pshufb %s, %%%%xmm%d' % (self.operand(n), r))
+                else:
+                    self.emit('%s $%d, %%%%xmm%d' % (kind, n, r))
+                self.reg[dst] = r
+            else:
+                a, b = args
+                if isinstance(b, Val) and b in self.reg and \
+                        self.next_use(b, i) is None and \
+                        not (a in self.reg and self.next_use(a, i) is None):
+                    a, b = b, a
+                if a in self.reg and self.next_use(a, i) is None:
+                    r = self.reg.pop(a)
+                else:
+                    r = self.get_reg(i, (a, b))
+                    self.emit('movdqa %s, %%%%xmm%d' % (self.loc(a), r))
+                self.emit('%s %s, %%%%xmm%d' % (kind, self.operand(b), r),
+                        dst.name and '%s' % dst.name)
+                self.reg[dst] = r
+            self.release(i)
+        self.place_outputs()
+        return self.lines
+
+    def place_outputs(self):
+        """Move the outputs to %xmm0-7, output k to register k"""
+        want = dict((v, k) for k, v in enumerate(self.prog.outputs))
+        pending = [v for v in self.prog.outputs
+                if self.reg.get(v) != want[v]]
+        while pending:
+            held = dict((r, v) for v, r in self.reg.items())
+            for v in pending:
+                blocker = held.get(want[v])
+                if blocker is None:
+                    break
+            else:
+                # a cycle, move one of the blockers out of the way
+                v = pending[0]
+                blocker = held[want[v]]
+                used = set(self.reg.values())
+                r = [x for x in range(NREGS) if x not in used][0]
+                self.emit('movdqa %%%%xmm%d, %%%%xmm%d' % (want[v], r))
+                self.reg[blocker] = r
+            self.emit('movdqa %s, %%%%xmm%d' % (self.loc(v), want[v]))
+            self.reg.pop(v, None)
+            self.reg[v] = want[v]
+            pending.remove(v)
+
+
+# ----- simulation of the emitted code -----
+
+def to_bytes(x):
+    return [(x >> (8 * i)) & 0xff for i in range(16)]
+
+
+def from_bytes(b):
+    return sum(v << (8 * i) for i, v in enumerate(b))
+
+
+def simulate(lines, xmm, mem, rk):
+    """Run emitted lines, mem maps a base name to a bytearray"""
+    loops = 0
+
+    def ea(text):
+        m = re.match(r'(-?\d+)\(%\[(\w+)\]\)', text)
+        off, base = int(m.group(1)), m.group(2)
+        if base == 'rk':
+            off += rk[0]
+        return base, off
+
+    def read(text):
+        if text.startswith('%%xmm'):
+            return xmm[int(text[5:])]
+        base, off = ea(text)
+        return from_bytes(mem[base][off:off + 16])
+
+    def write(text, val):
+        if text.startswith('%%xmm'):
+            xmm[int(text[5:])] = val
+        else:
+            base, off = ea(text)
+            mem[base][off:off + 16] = bytearray(to_bytes(val))
+
+    for text, _ in lines:
+        op, rest = text.split(' ', 1)
+        args = [a.strip() for a in rest.split(', ')]
+        if op in ('movdqa', 'movdqu'):
+            write(args[1], read(args[0]))
+        elif op in ('pxor', 'pand'):
+            a, b = read(args[0]), read(args[1])
+            write(args[1], a ^ b if op == 'pxor' else a & b)
+        elif op in ('psrlq', 'psllq'):
+            n = int(args[0][1:])
+            v = read(args[1])
+            lanes = [(v >> s) & (2 ** 64 - 1) for s in (0, 64)]
+            if op == 'psrlq':
+                lanes = [l >> n for l in lanes]
+            else:
+                lanes = [(l << n) & (2 ** 64 - 1) for l in lanes]
+            write(args[1], lanes[0] | (lanes[1] << 64))
+        elif op == 'pshufb':
+            m = to_bytes(read(args[0]))
+            v = to_bytes(read(args[1]))
+            write(args[1], from_bytes([v[i & 15] for i in m]))
+        elif op == 'pshufd':
+            imm = int(args[0][1:], 16)
+            v = read(args[1])
+            d = [(v >> (32 * i)) & 0xffffffff for i in range(4)]
+            write(args[2], sum(d[(imm >> (2 * i)) & 3] << (32 * i)
+                    for i in range(4)))
+        else:
+            raise ValueError(op)
+
+
+def aes_sbox():
+    s = []
+    for x in range(256):
+        inv = 0
+        if x:
+            inv = [y for y in range(1, 256) if gf_mul(x, y) == 1][0]
+        b = inv
+        for i in range(1, 5):
+            b ^= ((inv << i) | (inv >> (8 - i))) & 0xff
+        s.append(b ^ 0x63)
+    return s
+
+
+def gf_mul(a, b):
+    r = 0
+    while b:
+        if b & 1:
+            r ^= a
+        a = (a << 1) ^ (0x11b if a & 0x80 else 0)
+        b >>= 1
+    return r
+
+
+def expand_key(key):
+    s = aes_sbox()
+    nk = len(key) // 4
+    rounds = nk + 6
+    w = [list(key[4 * i:4 * i + 4]) for i in range(nk)]
+    rcon = 1
+    for i in range(nk, 4 * (rounds + 1)):
+        t = list(w[i - 1])
+        if i % nk == 0:
+            t = [s[b] for b in t[1:] + t[:1]]
+            t[0] ^= rcon
+            rcon = gf_mul(rcon, 2)
+        elif nk > 6 and i % nk == 4:
+            t = [s[b] for b in t]
+        w.append([a ^ b for a, b in zip(w[i - nk], t)])
+    return rounds, [b for word in w for b in word]
+
+
+def bitslice_key(rounds, rk):
+    """As moto_aes_bs_x86_set_key() lays out the round keys"""
+    out = bytearray()
+    for u in range(rounds + 1):
+        k = rk[16 * u:16 * u + 16]
+        for bit in range(8):
+            flip = u and (0x63 >> bit) & 1
+            for p in range(16):
+                v = (k[M0[p]] >> bit) & 1
+                out.append(0xff if v ^ flip else 0)
+    return out
+
+
+def run(frags, decrypt, key, blocks):
+    rounds, rk = expand_key(key)
+    consts = bytearray()
+    for name in sorted(CONSTS, key=CONSTS.get):
+        consts += bytearray(MASKS[name])
+    mem = {'in': bytearray(blocks), 'out': bytearray(128),
+            'c': consts, 'rk': bitslice_key(rounds, rk),
+            's': bytearray(16 * 64)}
+    xmm = [0] * NREGS
+    ptr = [128 * rounds if decrypt else 0]
+    simulate(frags[0], xmm, mem, ptr)
+    for n in range(rounds - 1):
+        ptr[0] += -128 if decrypt else 128
+        simulate(frags[1], xmm, mem, ptr)
+    simulate(frags[2], xmm, mem, ptr)
+    return bytes(mem['out'])
+
+
+def check(enc, dec):
+    vectors = (
+        ('000102030405060708090a0b0c0d0e0f',
+            '69c4e0d86a7b0430d8cdb78070b4c55a'),
+        ('000102030405060708090a0b0c0d0e0f1011121314151617',
+            'dda97ca4864cdfe06eaf70a0ec0d7191'),
+        ('000102030405060708090a0b0c0d0e0f'
+            '101112131415161718191a1b1c1d1e1f',
+            '8ea2b7ca516745bfeafc49904b496089'),
+    )
+    pt = bytearray.fromhex('00112233445566778899aabbccddeeff')
+    ok = True
+    for key, ct in vectors:
+        key = bytearray.fromhex(key)
+        ct = bytearray.fromhex(ct)
+        # the vector in every lane but one, which must not leak into them
+        blocks = pt * 7 + bytearray(range(16))
+        out = run(enc, False, key, blocks)
+        if bytearray(out[:112]) != ct * 7:
+            ok = False
+        back = run(dec, True, key, bytearray(out))
+        if bytearray(back) != blocks:
+            ok = False
+    return ok
+
+
+def c_function(name, frags, decrypt):
+    step = 'sub' if decrypt else 'add'
+    out = []
+    out.append('static void %s(const u8 *sk, unsigned long n, u8 *out,' %
+            name)
+    out.append('        const u8 *in, u8 *s)')
+    out.append('{')
+    out.append('    asm volatile(')
+    sections = ((frags[0], None), (frags[1], '1'), (frags[2], None))
+    for i, (lines, label) in enumerate(sections):
+        if label:
+            out.append('        "%s:\\n\\t"' % label)
+            out.append('        "%s $128, %%[rk]\\n\\t"' % step)
+        for text, comment in lines:
+            line = '        "%s\\n\\t"' % text
+            if comment:
+                line = '%-56s/* %s */' % (line, comment)
+            out.append(line)
+        if label:
+            out.append('        "dec %[n]\\n\\t"')
+            out.append('        "jnz 1b\\n\\t"')
+    out.append('        : [rk] "+r" (sk), [n] "+r" (n)')
+    out.append('        : [in] "r" (in), [out] "r" (out), '
+            '[c] "r" (&moto_aes_bs_x86_consts),')
+    out.append('          [s] "r" (s)')
+    out.append('        : "cc", "memory");')
+    out.append('}')
+    return '\n'.join(out)
+
+
+def main():
+    result = {}
+    slots = 0
+    for decrypt in (False, True):
+        frags = []
+        for prog in fragments(decrypt):
+            a = Alloc(prog)
+            frags.append(a.run())
+            slots = max(slots, a.nslots)
+        result[decrypt] = frags
+    if not check(result[False], result[True]):
+        sys.stderr.write('known answer test failed\n')
+        return 1
+    if sys.argv[1:] == ['check']:
+        return 0
+    print('#define MOTO_AES_BS_X86_SPILLS %d' % slots)
+    print('')
+    print(c_function('moto_aes_bs_ssse3_encrypt8', result[False], False))
+    print('')
+    print(c_function('moto_aes_bs_ssse3_decrypt8', result[True], True))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -48,6 +48,8 @@
  */
 
 #include <crypto/algapi.h>
+#include <crypto/aead.h>
+#include <crypto/scatterwalk.h>
 #include <moto_aes.h>
 #include <linux/module.h>
 #include <linux/init.h>
@@ -55,9 +57,13 @@
 #include <linux/errno.h>
 #include <linux/crypto.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
 
 #include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 
 static inline u8 byte(const u32 x, const unsigned n)
 {
@@ -1212,7 +1218,7 @@ const u32 moto_crypto_il_tab[4][256] = {
  * described in FIPS-197. The first slot (16 bytes) of each key (enc or dec) is
  * for the initial combination, the second slot for the first round and so on.
  */
-static int moto_crypto_aes_expand_key(struct moto_crypto_aes_ctx *ctx,
+int moto_crypto_aes_expand_key(struct moto_crypto_aes_ctx *ctx,
         const u8 *in_key, unsigned int key_len)
 {
     const __le32 *key = (const __le32 *)in_key;
@@ -1284,7 +1290,7 @@ static int moto_crypto_aes_expand_key(struct moto_crypto_aes_ctx *ctx,
  * &crypto_aes_ctx _must_ be the private data embedded in @tfm which is
  * retrieved with crypto_tfm_ctx().
  */
-static int moto_aes_set_key(struct crypto_tfm *tfm, const u8 *in_key,
+int moto_aes_set_key(struct crypto_tfm *tfm, const u8 *in_key,
         unsigned int key_len)
 {
     struct moto_crypto_aes_ctx *ctx = crypto_tfm_ctx(tfm);
@@ -1331,9 +1337,9 @@ static int moto_aes_set_key(struct crypto_tfm *tfm, const u8 *in_key,
         f_rl(bo, bi, 3, k);	\
 } while (0)
 
-static void moto_aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+void moto_aes_encrypt_ctx(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in)
 {
-    const struct moto_crypto_aes_ctx *ctx = crypto_tfm_ctx(tfm);
     const __le32 *src = (const __le32 *)in;
     __le32 *dst = (__le32 *)out;
     u32 b0[4], b1[4];
@@ -1372,6 +1378,106 @@ static void moto_aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
     dst[3] = cpu_to_le32(b0[3]);
 }
 
+static void moto_aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+{
+    moto_aes_encrypt_ctx(crypto_tfm_ctx(tfm), out, in);
+}
+
+/*
+ * CBC encryption of @nbytes, a multiple of the block size, from @in to
+ * @out, which may be equal.  @iv is chained through and left holding the
+ * last ciphertext block.
+ */
+void moto_aes_cbc_encrypt_ctx(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in, unsigned int nbytes, u8 *iv)
+{
+    for (; nbytes >= AES_BLOCK_SIZE; nbytes -= AES_BLOCK_SIZE) {
+        moto_crypto_xor(iv, in, AES_BLOCK_SIZE);
+        moto_aes_encrypt_ctx(ctx, iv, iv);
+        memcpy(out, iv, AES_BLOCK_SIZE);
+
+        in += AES_BLOCK_SIZE;
+        out += AES_BLOCK_SIZE;
+    }
+}
+
+#define f_nround_x4(bo, bi, k)	do {\
+        f_rn(bo[0], bi[0], 0, k);	\
+        f_rn(bo[1], bi[1], 0, k);	\
+        f_rn(bo[2], bi[2], 0, k);	\
+        f_rn(bo[3], bi[3], 0, k);	\
+        f_rn(bo[0], bi[0], 1, k);	\
+        f_rn(bo[1], bi[1], 1, k);	\
+        f_rn(bo[2], bi[2], 1, k);	\
+        f_rn(bo[3], bi[3], 1, k);	\
+        f_rn(bo[0], bi[0], 2, k);	\
+        f_rn(bo[1], bi[1], 2, k);	\
+        f_rn(bo[2], bi[2], 2, k);	\
+        f_rn(bo[3], bi[3], 2, k);	\
+        f_rn(bo[0], bi[0], 3, k);	\
+        f_rn(bo[1], bi[1], 3, k);	\
+        f_rn(bo[2], bi[2], 3, k);	\
+        f_rn(bo[3], bi[3], 3, k);	\
+        k += 4;			\
+} while (0)
+
+#define f_lround_x4(bo, bi, k)	do {\
+        f_lround(bo[0], bi[0], k);	\
+        f_lround(bo[1], bi[1], k);	\
+        f_lround(bo[2], bi[2], k);	\
+        f_lround(bo[3], bi[3], k);	\
+} while (0)
+
+/*
+ * Encrypt AES_INTERLEAVE consecutive blocks. @out may be equal to @in, all
+ * input words are loaded before the first output word is stored.
+ */
+void moto_aes_encrypt_x4(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    const __le32 *src = (const __le32 *)in;
+    __le32 *dst = (__le32 *)out;
+    u32 b0[AES_INTERLEAVE][4], b1[AES_INTERLEAVE][4];
+    const u32 *kp = ctx->key_enc + 4;
+    const int key_len = ctx->key_length;
+    int i;
+
+    for (i = 0; i < AES_INTERLEAVE; i++, src += 4) {
+        b0[i][0] = le32_to_cpu(src[0]) ^ ctx->key_enc[0];
+        b0[i][1] = le32_to_cpu(src[1]) ^ ctx->key_enc[1];
+        b0[i][2] = le32_to_cpu(src[2]) ^ ctx->key_enc[2];
+        b0[i][3] = le32_to_cpu(src[3]) ^ ctx->key_enc[3];
+    }
+
+    if (key_len > 24) {
+        f_nround_x4(b1, b0, kp);
+        f_nround_x4(b0, b1, kp);
+    }
+
+    if (key_len > 16) {
+        f_nround_x4(b1, b0, kp);
+        f_nround_x4(b0, b1, kp);
+    }
+
+    f_nround_x4(b1, b0, kp);
+    f_nround_x4(b0, b1, kp);
+    f_nround_x4(b1, b0, kp);
+    f_nround_x4(b0, b1, kp);
+    f_nround_x4(b1, b0, kp);
+    f_nround_x4(b0, b1, kp);
+    f_nround_x4(b1, b0, kp);
+    f_nround_x4(b0, b1, kp);
+    f_nround_x4(b1, b0, kp);
+    f_lround_x4(b0, b1, kp);
+
+    for (i = 0; i < AES_INTERLEAVE; i++, dst += 4) {
+        dst[0] = cpu_to_le32(b0[i][0]);
+        dst[1] = cpu_to_le32(b0[i][1]);
+        dst[2] = cpu_to_le32(b0[i][2]);
+        dst[3] = cpu_to_le32(b0[i][3]);
+    }
+}
+
 /* decrypt a block of text */
 
 #define i_rn(bo, bi, n, k)	do {				\
@@ -1403,9 +1509,9 @@ static void moto_aes_encrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
         i_rl(bo, bi, 3, k);	\
 } while (0)
 
-static void moto_aes_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+static void moto_aes_decrypt_ctx(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in)
 {
-    const struct moto_crypto_aes_ctx *ctx = crypto_tfm_ctx(tfm);
     const __le32 *src = (const __le32 *)in;
     __le32 *dst = (__le32 *)out;
     u32 b0[4], b1[4];
@@ -1444,19 +1550,110 @@ static void moto_aes_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
     dst[3] = cpu_to_le32(b0[3]);
 }
 
+static void moto_aes_decrypt(struct crypto_tfm *tfm, u8 *out, const u8 *in)
+{
+    moto_aes_decrypt_ctx(crypto_tfm_ctx(tfm), out, in);
+}
+
+#define i_nround_x4(bo, bi, k)	do {\
+        i_rn(bo[0], bi[0], 0, k);	\
+        i_rn(bo[1], bi[1], 0, k);	\
+        i_rn(bo[2], bi[2], 0, k);	\
+        i_rn(bo[3], bi[3], 0, k);	\
+        i_rn(bo[0], bi[0], 1, k);	\
+        i_rn(bo[1], bi[1], 1, k);	\
+        i_rn(bo[2], bi[2], 1, k);	\
+        i_rn(bo[3], bi[3], 1, k);	\
+        i_rn(bo[0], bi[0], 2, k);	\
+        i_rn(bo[1], bi[1], 2, k);	\
+        i_rn(bo[2], bi[2], 2, k);	\
+        i_rn(bo[3], bi[3], 2, k);	\
+        i_rn(bo[0], bi[0], 3, k);	\
+        i_rn(bo[1], bi[1], 3, k);	\
+        i_rn(bo[2], bi[2], 3, k);	\
+        i_rn(bo[3], bi[3], 3, k);	\
+        k += 4;			\
+} while (0)
+
+#define i_lround_x4(bo, bi, k)	do {\
+        i_lround(bo[0], bi[0], k);	\
+        i_lround(bo[1], bi[1], k);	\
+        i_lround(bo[2], bi[2], k);	\
+        i_lround(bo[3], bi[3], k);	\
+} while (0)
+
+/*
+ * Decrypt AES_INTERLEAVE consecutive blocks. @out may be equal to @in, all
+ * input words are loaded before the first output word is stored.
+ */
+static void moto_aes_decrypt_x4(const struct moto_crypto_aes_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    const __le32 *src = (const __le32 *)in;
+    __le32 *dst = (__le32 *)out;
+    u32 b0[AES_INTERLEAVE][4], b1[AES_INTERLEAVE][4];
+    const int key_len = ctx->key_length;
+    const u32 *kp = ctx->key_dec + 4;
+    int i;
+
+    for (i = 0; i < AES_INTERLEAVE; i++, src += 4) {
+        b0[i][0] = le32_to_cpu(src[0]) ^ ctx->key_dec[0];
+        b0[i][1] = le32_to_cpu(src[1]) ^ ctx->key_dec[1];
+        b0[i][2] = le32_to_cpu(src[2]) ^ ctx->key_dec[2];
+        b0[i][3] = le32_to_cpu(src[3]) ^ ctx->key_dec[3];
+    }
+
+    if (key_len > 24) {
+        i_nround_x4(b1, b0, kp);
+        i_nround_x4(b0, b1, kp);
+    }
+
+    if (key_len > 16) {
+        i_nround_x4(b1, b0, kp);
+        i_nround_x4(b0, b1, kp);
+    }
+
+    i_nround_x4(b1, b0, kp);
+    i_nround_x4(b0, b1, kp);
+    i_nround_x4(b1, b0, kp);
+    i_nround_x4(b0, b1, kp);
+    i_nround_x4(b1, b0, kp);
+    i_nround_x4(b0, b1, kp);
+    i_nround_x4(b1, b0, kp);
+    i_nround_x4(b0, b1, kp);
+    i_nround_x4(b1, b0, kp);
+    i_lround_x4(b0, b1, kp);
+
+    for (i = 0; i < AES_INTERLEAVE; i++, dst += 4) {
+        dst[0] = cpu_to_le32(b0[i][0]);
+        dst[1] = cpu_to_le32(b0[i][1]);
+        dst[2] = cpu_to_le32(b0[i][2]);
+        dst[3] = cpu_to_le32(b0[i][3]);
+    }
+}
+
 static int moto_ecb_aes_operate(struct blkcipher_desc *desc,
         struct scatterlist *dst, struct scatterlist *src,
         unsigned int nbytes, void (*fn)(struct crypto_tfm *, u8 *, const u8 *))
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
+    int enc = (fn == moto_aes_encrypt);
     int err;
     u8 *wsrc;
     u8 *wdst;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
     if (nbytes % AES_BLOCK_SIZE)
         return -EINVAL;
 
+    trace_moto_cipher_start(crypto_blkcipher_tfm(desc->tfm), enc, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
 
     err = blkcipher_walk_virt(desc, &walk);
@@ -1466,6 +1663,9 @@ static int moto_ecb_aes_operate(struct blkcipher_desc *desc,
 
         wsrc = walk.src.virt.addr;
         wdst = walk.dst.virt.addr;
+        segments++;
+        if (wsrc == wdst)
+            inplace++;
 
         do {
             fn(crypto_blkcipher_tfm(tfm), wdst, wsrc);
@@ -1477,11 +1677,14 @@ static int moto_ecb_aes_operate(struct blkcipher_desc *desc,
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(desc->tfm), enc, total,
+            segments, inplace, err);
+    moto_stats_account(MOTO_STATS_AES_ECB, total, start);
     return err;
 
 }
 
-static int moto_ecb_aes_encrypt(struct blkcipher_desc *desc,
+int moto_ecb_aes_encrypt(struct blkcipher_desc *desc,
         struct scatterlist *dst, struct scatterlist *src,
         unsigned int nbytes)
 {
@@ -1489,7 +1692,7 @@ static int moto_ecb_aes_encrypt(struct blkcipher_desc *desc,
 }
 
 
-static int moto_ecb_aes_decrypt(struct blkcipher_desc *desc,
+int moto_ecb_aes_decrypt(struct blkcipher_desc *desc,
         struct scatterlist *dst, struct scatterlist *src,
         unsigned int nbytes)
 {
@@ -1539,25 +1742,38 @@ static int moto_cbc_aes_encrypt_inplace(struct blkcipher_desc *desc,
     return nbytes;
 }
 
-static int moto_cbc_aes_encrypt(struct blkcipher_desc *desc,
+int moto_cbc_aes_encrypt(struct blkcipher_desc *desc,
         struct scatterlist *dst, struct scatterlist *src,
         unsigned int nbytes)
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm = desc->tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
     int err;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_cipher_start(crypto_blkcipher_tfm(tfm), 1, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
     err = blkcipher_walk_virt(desc, &walk);
 
     while ((nbytes = walk.nbytes)) {
-        if (walk.src.virt.addr == walk.dst.virt.addr)
+        segments++;
+        if (walk.src.virt.addr == walk.dst.virt.addr) {
+            inplace++;
             nbytes = moto_cbc_aes_encrypt_inplace(desc, &walk, tfm);
-        else
+        } else
             nbytes = moto_cbc_aes_encrypt_segment(desc, &walk, tfm);
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(tfm), 1, total, segments,
+            inplace, err);
+    moto_stats_account(MOTO_STATS_AES_CBC, total, start);
     return err;
 }
 
@@ -1565,19 +1781,34 @@ static int moto_cbc_aes_decrypt_segment(struct blkcipher_desc *desc,
         struct blkcipher_walk *walk,
         struct crypto_blkcipher *tfm)
 {
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(tfm);
     unsigned int nbytes = walk->nbytes;
     u8 *src = walk->src.virt.addr;
     u8 *dst = walk->dst.virt.addr;
     u8 *iv = walk->iv;
 
-    do {
+    /* decrypt several blocks at once, then apply the chaining */
+    while (nbytes >= AES_INTERLEAVE * AES_BLOCK_SIZE) {
+        moto_aes_decrypt_x4(ctx, dst, src);
+        moto_crypto_xor(dst, iv, AES_BLOCK_SIZE);
+        moto_crypto_xor(dst + AES_BLOCK_SIZE, src,
+                (AES_INTERLEAVE - 1) * AES_BLOCK_SIZE);
+        iv = src + (AES_INTERLEAVE - 1) * AES_BLOCK_SIZE;
+
+        src += AES_INTERLEAVE * AES_BLOCK_SIZE;
+        dst += AES_INTERLEAVE * AES_BLOCK_SIZE;
+        nbytes -= AES_INTERLEAVE * AES_BLOCK_SIZE;
+    }
+
+    while (nbytes >= AES_BLOCK_SIZE) {
         moto_aes_decrypt(crypto_blkcipher_tfm(tfm), dst, src);
         moto_crypto_xor(dst, iv, AES_BLOCK_SIZE);
         iv = src;
 
         src += AES_BLOCK_SIZE;
         dst += AES_BLOCK_SIZE;
-    } while ((nbytes -= AES_BLOCK_SIZE) >= AES_BLOCK_SIZE);
+        nbytes -= AES_BLOCK_SIZE;
+    }
 
     memcpy(walk->iv, iv, AES_BLOCK_SIZE);
 
@@ -1588,9 +1819,33 @@ static int moto_cbc_aes_decrypt_inplace(struct blkcipher_desc *desc,
         struct blkcipher_walk *walk,
         struct crypto_blkcipher *tfm)
 {
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(tfm);
     unsigned int nbytes = walk->nbytes;
     u8 *src = walk->src.virt.addr;
     u8 last_iv[AES_BLOCK_SIZE];
+    u32 buf[AES_INTERLEAVE * AES_BLOCK_SIZE / sizeof(u32)];
+
+    /*
+     * Decrypt whole groups into a bounce buffer, so the ciphertext the
+     * chaining needs is still in place, and carry the last ciphertext
+     * block of each group over in walk->iv.
+     */
+    while (nbytes >= AES_INTERLEAVE * AES_BLOCK_SIZE) {
+        moto_aes_decrypt_x4(ctx, (u8 *)buf, src);
+        moto_crypto_xor((u8 *)buf, walk->iv, AES_BLOCK_SIZE);
+        moto_crypto_xor((u8 *)buf + AES_BLOCK_SIZE, src,
+                (AES_INTERLEAVE - 1) * AES_BLOCK_SIZE);
+        memcpy(walk->iv, src + (AES_INTERLEAVE - 1) * AES_BLOCK_SIZE,
+                AES_BLOCK_SIZE);
+        memcpy(src, buf, AES_INTERLEAVE * AES_BLOCK_SIZE);
+
+        src += AES_INTERLEAVE * AES_BLOCK_SIZE;
+        nbytes -= AES_INTERLEAVE * AES_BLOCK_SIZE;
+    }
+    memset(buf, 0, sizeof(buf));
+
+    if (nbytes < AES_BLOCK_SIZE)
+        return nbytes;
 
     /* Start of the last block. */
     src += nbytes - (nbytes & (AES_BLOCK_SIZE - 1)) - AES_BLOCK_SIZE;
@@ -1611,25 +1866,38 @@ static int moto_cbc_aes_decrypt_inplace(struct blkcipher_desc *desc,
     return nbytes;
 }
 
-static int moto_cbc_aes_decrypt(struct blkcipher_desc *desc,
+int moto_cbc_aes_decrypt(struct blkcipher_desc *desc,
         struct scatterlist *dst, struct scatterlist *src,
         unsigned int nbytes)
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm = desc->tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
     int err;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_cipher_start(crypto_blkcipher_tfm(tfm), 0, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
     err = blkcipher_walk_virt(desc, &walk);
 
     while ((nbytes = walk.nbytes)) {
-        if (walk.src.virt.addr == walk.dst.virt.addr)
+        segments++;
+        if (walk.src.virt.addr == walk.dst.virt.addr) {
+            inplace++;
             nbytes = moto_cbc_aes_decrypt_inplace(desc, &walk, tfm);
-        else
+        } else
             nbytes = moto_cbc_aes_decrypt_segment(desc, &walk, tfm);
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(tfm), 0, total, segments,
+            inplace, err);
+    moto_stats_account(MOTO_STATS_AES_CBC, total, start);
     return err;
 }
 
@@ -1653,12 +1921,25 @@ static void moto_ctr_aes_operate_final(struct blkcipher_walk *walk,
 static int moto_ctr_aes_operate_segment(struct blkcipher_walk *walk,
         struct crypto_blkcipher *tfm)
 {
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(tfm);
     u8 *ctrblk = walk->iv;
     u8 *src = walk->src.virt.addr;
     u8 *dst = walk->dst.virt.addr;
     unsigned int nbytes = walk->nbytes;
+    u32 ctrblks[AES_INTERLEAVE * AES_BLOCK_SIZE / sizeof(u32)];
 
-    do {
+    /* create the keystream for several blocks at once */
+    while (nbytes >= AES_INTERLEAVE * AES_BLOCK_SIZE) {
+        moto_crypto_ctr_fill((u8 *)ctrblks, ctrblk, AES_INTERLEAVE);
+        moto_aes_encrypt_x4(ctx, dst, (u8 *)ctrblks);
+        moto_crypto_xor(dst, src, AES_INTERLEAVE * AES_BLOCK_SIZE);
+
+        src += AES_INTERLEAVE * AES_BLOCK_SIZE;
+        dst += AES_INTERLEAVE * AES_BLOCK_SIZE;
+        nbytes -= AES_INTERLEAVE * AES_BLOCK_SIZE;
+    }
+
+    while (nbytes >= AES_BLOCK_SIZE) {
         /* create keystream */
         moto_aes_encrypt(crypto_blkcipher_tfm(tfm), dst, ctrblk);
         moto_crypto_xor(dst, src, AES_BLOCK_SIZE);
@@ -1667,7 +1948,8 @@ static int moto_ctr_aes_operate_segment(struct blkcipher_walk *walk,
         moto_crypto_inc(ctrblk, AES_BLOCK_SIZE);
         src += AES_BLOCK_SIZE;
         dst += AES_BLOCK_SIZE;
-    } while ((nbytes -= AES_BLOCK_SIZE) >= AES_BLOCK_SIZE);
+        nbytes -= AES_BLOCK_SIZE;
+    }
 
     return nbytes;
 }
@@ -1675,56 +1957,623 @@ static int moto_ctr_aes_operate_segment(struct blkcipher_walk *walk,
 static int moto_ctr_aes_operate_inplace(struct blkcipher_walk *walk,
         struct crypto_blkcipher *tfm)
 {
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(tfm);
     unsigned int nbytes = walk->nbytes;
     u8 *ctrblk = walk->iv;
     u8 *src = walk->src.virt.addr;
-    u8 tmp[AES_BLOCK_SIZE + AES_ALIGN_MASK];
-    u8 *keystream = PTR_ALIGN(tmp + 0, AES_ALIGN_MASK + 1);
+    u32 keystream[AES_INTERLEAVE * AES_BLOCK_SIZE / sizeof(u32)];
 
-    do {
+    /* create the keystream for several blocks at once */
+    while (nbytes >= AES_INTERLEAVE * AES_BLOCK_SIZE) {
+        moto_crypto_ctr_fill((u8 *)keystream, ctrblk, AES_INTERLEAVE);
+        moto_aes_encrypt_x4(ctx, (u8 *)keystream, (u8 *)keystream);
+        moto_crypto_xor(src, (u8 *)keystream,
+                AES_INTERLEAVE * AES_BLOCK_SIZE);
+
+        src += AES_INTERLEAVE * AES_BLOCK_SIZE;
+        nbytes -= AES_INTERLEAVE * AES_BLOCK_SIZE;
+    }
+
+    while (nbytes >= AES_BLOCK_SIZE) {
         /* create keystream */
-        moto_aes_encrypt(crypto_blkcipher_tfm(tfm), keystream, ctrblk);
-        moto_crypto_xor(src, keystream, AES_BLOCK_SIZE);
+        moto_aes_encrypt(crypto_blkcipher_tfm(tfm), (u8 *)keystream,
+                ctrblk);
+        moto_crypto_xor(src, (u8 *)keystream, AES_BLOCK_SIZE);
 
         /* increment counter in counterblock */
         moto_crypto_inc(ctrblk, AES_BLOCK_SIZE);
 
         src += AES_BLOCK_SIZE;
-    } while ((nbytes -= AES_BLOCK_SIZE) >= AES_BLOCK_SIZE);
+        nbytes -= AES_BLOCK_SIZE;
+    }
 
     return nbytes;
 }
 
-static int moto_ctr_aes_operate(struct blkcipher_desc *desc,
+int moto_ctr_aes_operate(struct blkcipher_desc *desc,
         struct scatterlist *dst, 
         struct scatterlist *src,
         unsigned int nbytes)
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm = desc->tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
     int err;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_cipher_start(crypto_blkcipher_tfm(tfm), 1, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
     err = blkcipher_walk_virt_block(desc, &walk, AES_BLOCK_SIZE);
 
     while (walk.nbytes >= AES_BLOCK_SIZE) {
-        if (walk.src.virt.addr == walk.dst.virt.addr)
+        segments++;
+        if (walk.src.virt.addr == walk.dst.virt.addr) {
+            inplace++;
             nbytes = moto_ctr_aes_operate_inplace(&walk, tfm);
-        else
+        } else
             nbytes = moto_ctr_aes_operate_segment(&walk, tfm);
 
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
     if (walk.nbytes) {
+        segments++;
+        if (walk.src.virt.addr == walk.dst.virt.addr)
+            inplace++;
         moto_ctr_aes_operate_final(&walk, tfm);
         err = blkcipher_walk_done(desc, &walk, 0);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(tfm), 1, total, segments,
+            inplace, err);
+    moto_stats_account(MOTO_STATS_AES_CTR, total, start);
+    return err;
+}
+
+/*
+ * Number of tweaks computed in one batch, enough for a 512 byte sector, so
+ * that dm-crypt requests go through the cipher in groups of AES_INTERLEAVE
+ * blocks without a GF(2^128) doubling between them.
+ */
+#define AES_XTS_BATCH	32
+
+struct moto_aes_xts_ctx {
+    struct moto_crypto_aes_ctx crypt_ctx;
+    struct moto_crypto_aes_ctx tweak_ctx;
+};
+
+static int moto_aes_xts_set_key(struct crypto_tfm *tfm, const u8 *in_key,
+        unsigned int key_len)
+{
+    struct moto_aes_xts_ctx *ctx = crypto_tfm_ctx(tfm);
+    u32 *flags = &tfm->crt_flags;
+    int ret;
+
+    /* only XTS-AES-128 and XTS-AES-256 are defined by SP 800-38E */
+    if (key_len != 2 * AES_KEYSIZE_128 && key_len != 2 * AES_KEYSIZE_256) {
+        *flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+        return -EINVAL;
+    }
+
+    /* FIPS 140-2 IG A.9: the data key and the tweak key must differ */
+    key_len /= 2;
+    if (!memcmp(in_key, in_key + key_len, key_len)) {
+        *flags |= CRYPTO_TFM_RES_WEAK_KEY;
+        return -EINVAL;
+    }
+
+    ret = moto_crypto_aes_expand_key(&ctx->crypt_ctx, in_key, key_len);
+    if (!ret)
+        ret = moto_crypto_aes_expand_key(&ctx->tweak_ctx, in_key + key_len,
+                key_len);
+    if (!ret)
+        return 0;
+
+    *flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+    return -EINVAL;
+}
+
+/*
+ * Store @nblocks consecutive tweaks starting with @tweak in @tweaks and
+ * leave the one following them in @tweak. The tweak is a little endian
+ * element of GF(2^128), advancing it multiplies it by x.
+ */
+static void moto_aes_xts_tweaks(__le64 *tweaks, u8 *tweak,
+        unsigned int nblocks)
+{
+    u64 lo = get_unaligned_le64(tweak);
+    u64 hi = get_unaligned_le64(tweak + 8);
+    u64 carry;
+
+    for (; nblocks; nblocks--, tweaks += 2) {
+        tweaks[0] = cpu_to_le64(lo);
+        tweaks[1] = cpu_to_le64(hi);
+        carry = -(hi >> 63) & 0x87;
+        hi = (hi << 1) | (lo >> 63);
+        lo = (lo << 1) ^ carry;
+    }
+
+    put_unaligned_le64(lo, tweak);
+    put_unaligned_le64(hi, tweak + 8);
+}
+
+static int moto_aes_xts_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes, int enc)
+{
+    const struct moto_aes_xts_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    const struct moto_crypto_aes_ctx *cctx = &ctx->crypt_ctx;
+    struct blkcipher_walk walk;
+    __le64 tweaks[AES_XTS_BATCH * AES_BLOCK_SIZE / sizeof(__le64)];
+    unsigned int n, i;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (nbytes % AES_BLOCK_SIZE)
+        return -EINVAL;
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt(desc, &walk);
+    if (!walk.nbytes)
+        return err;
+
+    /* T = E(K2, i), walk.iv carries the next tweak between segments */
+    moto_aes_encrypt_ctx(&ctx->tweak_ctx, walk.iv, walk.iv);
+
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        do {
+            n = min(nbytes / AES_BLOCK_SIZE, (unsigned int)AES_XTS_BATCH);
+            moto_aes_xts_tweaks(tweaks, walk.iv, n);
+            n *= AES_BLOCK_SIZE;
+
+            if (wdst != wsrc)
+                memcpy(wdst, wsrc, n);
+            moto_crypto_xor(wdst, (u8 *)tweaks, n);
+
+            for (i = 0; i + AES_INTERLEAVE * AES_BLOCK_SIZE <= n;
+                    i += AES_INTERLEAVE * AES_BLOCK_SIZE) {
+                if (enc)
+                    moto_aes_encrypt_x4(cctx, wdst + i, wdst + i);
+                else
+                    moto_aes_decrypt_x4(cctx, wdst + i, wdst + i);
+            }
+            for (; i < n; i += AES_BLOCK_SIZE) {
+                if (enc)
+                    moto_aes_encrypt_ctx(cctx, wdst + i, wdst + i);
+                else
+                    moto_aes_decrypt_ctx(cctx, wdst + i, wdst + i);
+            }
+
+            moto_crypto_xor(wdst, (u8 *)tweaks, n);
+
+            wsrc += n;
+            wdst += n;
+        } while ((nbytes -= n) >= AES_BLOCK_SIZE);
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+
+    memset(tweaks, 0, sizeof(tweaks));
+    moto_stats_account(MOTO_STATS_AES_XTS, total, start);
     return err;
 }
 
-static void moto_aes_exit(struct crypto_tfm *tfm)
+static int moto_aes_xts_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_aes_xts_operate(desc, dst, src, nbytes, 1);
+}
+
+static int moto_aes_xts_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_aes_xts_operate(desc, dst, src, nbytes, 0);
+}
+
+static void moto_aes_xts_exit(struct crypto_tfm *tfm)
+{
+    struct moto_aes_xts_ctx *ctx = crypto_tfm_ctx(tfm);
+
+    memset(ctx, 0, sizeof (*ctx));
+#ifdef CONFIG_CRYPTO_MOTOROLA_SHOW_ZEROIZATION
+    printk(KERN_INFO "AES-XTS keys after zeroization:\n");
+    moto_hexdump((unsigned char *)ctx, sizeof(*ctx));
+#endif
+
+}
+
+/*
+ * GCM as specified in SP 800-38D, with 96 bit IVs only. GHASH uses Shoup's
+ * method: the 16 multiples of H by a 4 bit value are precomputed at set_key
+ * time, so a block costs 32 table lookups instead of 128 conditional
+ * shifts. The CTR keystream and GHASH run in the same walk over the data,
+ * each piece is hashed right after it is encrypted (or right before it is
+ * decrypted) while it is still in the cache.
+ */
+#define AES_GCM_IV_SIZE		12
+
+struct moto_aes_gcm_ctx {
+    struct moto_crypto_aes_ctx aes_ctx;
+    u64 htable[16][2];
+};
+
+struct moto_aes_gcm_state {
+    __be32 ctrblk[AES_BLOCK_SIZE / sizeof(__be32)];
+    u32 keystream[AES_INTERLEAVE * AES_BLOCK_SIZE / sizeof(u32)];
+    /* unused bytes left at the end of keystream */
+    unsigned int ks_len;
+    u32 xi[AES_BLOCK_SIZE / sizeof(u32)];
+    /* bytes already xored into the current GHASH block */
+    unsigned int xi_len;
+};
+
+/* reduction of the 4 bits shifted out of Z, see moto_aes_gcm_gmult() */
+static const u64 moto_aes_gcm_rem_4bit[16] = {
+        0x0000000000000000ULL, 0x1c20000000000000ULL,
+        0x3840000000000000ULL, 0x2460000000000000ULL,
+        0x7080000000000000ULL, 0x6ca0000000000000ULL,
+        0x48c0000000000000ULL, 0x54e0000000000000ULL,
+        0xe100000000000000ULL, 0xfd20000000000000ULL,
+        0xd940000000000000ULL, 0xc560000000000000ULL,
+        0x9180000000000000ULL, 0x8da0000000000000ULL,
+        0xa9c0000000000000ULL, 0xb5e0000000000000ULL
+};
+
+static void moto_aes_gcm_init_htable(u64 htable[16][2], const u8 *h)
+{
+    u64 hi = get_unaligned_be64(h);
+    u64 lo = get_unaligned_be64(h + 8);
+    u64 carry;
+    int i, j;
+
+    /* the bits are reflected, H * x lands at index 4, H * x^3 at 1 */
+    htable[0][0] = 0;
+    htable[0][1] = 0;
+    for (i = 8; i; i >>= 1) {
+        htable[i][0] = hi;
+        htable[i][1] = lo;
+        carry = -(lo & 1) & 0xe100000000000000ULL;
+        lo = (hi << 63) | (lo >> 1);
+        hi = (hi >> 1) ^ carry;
+    }
+
+    for (i = 2; i < 16; i <<= 1) {
+        for (j = 1; j < i; j++) {
+            htable[i + j][0] = htable[i][0] ^ htable[j][0];
+            htable[i + j][1] = htable[i][1] ^ htable[j][1];
+        }
+    }
+}
+
+/* Xi = Xi * H, one nibble of Xi at a time from the last byte backwards */
+static void moto_aes_gcm_gmult(u8 *xi, const u64 htable[16][2])
+{
+    u64 zhi, zlo, rem;
+    unsigned int nlo, nhi;
+    int cnt = AES_BLOCK_SIZE - 1;
+
+    nlo = xi[cnt];
+    nhi = nlo >> 4;
+    nlo &= 0xf;
+    zhi = htable[nlo][0];
+    zlo = htable[nlo][1];
+
+    for (;;) {
+        rem = zlo & 0xf;
+        zlo = (zhi << 60) | (zlo >> 4);
+        zhi = (zhi >> 4) ^ moto_aes_gcm_rem_4bit[rem] ^ htable[nhi][0];
+        zlo ^= htable[nhi][1];
+
+        if (--cnt < 0)
+            break;
+
+        nlo = xi[cnt];
+        nhi = nlo >> 4;
+        nlo &= 0xf;
+
+        rem = zlo & 0xf;
+        zlo = (zhi << 60) | (zlo >> 4);
+        zhi = (zhi >> 4) ^ moto_aes_gcm_rem_4bit[rem] ^ htable[nlo][0];
+        zlo ^= htable[nlo][1];
+    }
+
+    put_unaligned_be64(zhi, xi);
+    put_unaligned_be64(zlo, xi + 8);
+}
+
+/* scatterlist data carries no alignment guarantee */
+static void moto_aes_gcm_xor(u8 *dst, const u8 *src, unsigned int nbytes)
+{
+    if (IS_ALIGNED((unsigned long)dst | (unsigned long)src, sizeof(u32))) {
+        moto_crypto_xor(dst, src, nbytes);
+        return;
+    }
+
+    for (; nbytes; nbytes--)
+        *dst++ ^= *src++;
+}
+
+static void moto_aes_gcm_ghash(const struct moto_aes_gcm_ctx *ctx,
+        struct moto_aes_gcm_state *st, const u8 *src, unsigned int nbytes)
+{
+    u8 *xi = (u8 *)st->xi;
+    unsigned int n;
+
+    while (nbytes) {
+        n = min(nbytes, AES_BLOCK_SIZE - st->xi_len);
+        moto_aes_gcm_xor(xi + st->xi_len, src, n);
+        st->xi_len += n;
+        src += n;
+        nbytes -= n;
+
+        if (st->xi_len == AES_BLOCK_SIZE) {
+            moto_aes_gcm_gmult(xi, ctx->htable);
+            st->xi_len = 0;
+        }
+    }
+}
+
+/* the A and C strings are each zero padded to a whole block */
+static void moto_aes_gcm_ghash_pad(const struct moto_aes_gcm_ctx *ctx,
+        struct moto_aes_gcm_state *st)
+{
+    if (st->xi_len) {
+        moto_aes_gcm_gmult((u8 *)st->xi, ctx->htable);
+        st->xi_len = 0;
+    }
+}
+
+/*
+ * Only the low 32 bits of the counter block are incremented in GCM. With a
+ * 96 bit IV they start at 2 and a request cannot be long enough to wrap
+ * them, so moto_crypto_ctr_fill() produces the same counter blocks.
+ */
+static void moto_aes_gcm_ctr(const struct moto_aes_gcm_ctx *ctx,
+        struct moto_aes_gcm_state *st, u8 *dst, const u8 *src,
+        unsigned int nbytes)
+{
+    u8 *keystream = (u8 *)st->keystream;
+    u8 *ks;
+    unsigned int n;
+
+    while (nbytes) {
+        if (!st->ks_len) {
+            if (nbytes >= sizeof(st->keystream)) {
+                moto_crypto_ctr_fill(keystream, (u8 *)st->ctrblk,
+                        AES_INTERLEAVE);
+                moto_aes_encrypt_x4(&ctx->aes_ctx, keystream, keystream);
+                st->ks_len = sizeof(st->keystream);
+            } else {
+                ks = keystream + sizeof(st->keystream) - AES_BLOCK_SIZE;
+                moto_crypto_ctr_fill(ks, (u8 *)st->ctrblk, 1);
+                moto_aes_encrypt_ctx(&ctx->aes_ctx, ks, ks);
+                st->ks_len = AES_BLOCK_SIZE;
+            }
+        }
+
+        n = min(nbytes, st->ks_len);
+        ks = keystream + sizeof(st->keystream) - st->ks_len;
+        if (dst != src)
+            memcpy(dst, src, n);
+        moto_aes_gcm_xor(dst, ks, n);
+
+        st->ks_len -= n;
+        src += n;
+        dst += n;
+        nbytes -= n;
+    }
+}
+
+static void moto_aes_gcm_hash_sg(const struct moto_aes_gcm_ctx *ctx,
+        struct moto_aes_gcm_state *st, struct scatterlist *sg,
+        unsigned int nbytes)
+{
+    struct scatter_walk walk;
+    unsigned int n;
+    u8 *src;
+
+    if (!nbytes)
+        return;
+
+    scatterwalk_start(&walk, sg);
+
+    while (nbytes) {
+        n = scatterwalk_clamp(&walk, nbytes);
+        src = scatterwalk_map(&walk);
+
+        moto_aes_gcm_ghash(ctx, st, src, n);
+
+        scatterwalk_unmap(src);
+        scatterwalk_advance(&walk, n);
+        nbytes -= n;
+        scatterwalk_done(&walk, 0, nbytes);
+    }
+}
+
+static void moto_aes_gcm_crypt_sg(const struct moto_aes_gcm_ctx *ctx,
+        struct moto_aes_gcm_state *st, struct scatterlist *dst,
+        struct scatterlist *src, unsigned int nbytes, int enc)
+{
+    struct scatter_walk src_walk;
+    struct scatter_walk dst_walk;
+    unsigned int n;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (!nbytes)
+        return;
+
+    scatterwalk_start(&src_walk, src);
+    scatterwalk_start(&dst_walk, dst);
+
+    while (nbytes) {
+        n = scatterwalk_clamp(&src_walk, nbytes);
+        n = scatterwalk_clamp(&dst_walk, n);
+        wsrc = scatterwalk_map(&src_walk);
+        wdst = scatterwalk_map(&dst_walk);
+
+        /* GHASH always covers the ciphertext */
+        if (!enc)
+            moto_aes_gcm_ghash(ctx, st, wsrc, n);
+        moto_aes_gcm_ctr(ctx, st, wdst, wsrc, n);
+        if (enc)
+            moto_aes_gcm_ghash(ctx, st, wdst, n);
+
+        scatterwalk_unmap(wdst);
+        scatterwalk_unmap(wsrc);
+        scatterwalk_advance(&src_walk, n);
+        scatterwalk_advance(&dst_walk, n);
+        nbytes -= n;
+        scatterwalk_done(&src_walk, 0, nbytes);
+        scatterwalk_done(&dst_walk, 1, nbytes);
+    }
+}
+
+static int moto_aes_gcm_set_key(struct crypto_aead *aead, const u8 *in_key,
+        unsigned int key_len)
+{
+    struct moto_aes_gcm_ctx *ctx = crypto_aead_ctx(aead);
+    u32 h[AES_BLOCK_SIZE / sizeof(u32)];
+    int ret;
+
+    ret = moto_crypto_aes_expand_key(&ctx->aes_ctx, in_key, key_len);
+    if (ret) {
+        crypto_aead_set_flags(aead, CRYPTO_TFM_RES_BAD_KEY_LEN);
+        return -EINVAL;
+    }
+
+    /* H = E(K, 0^128) */
+    memset(h, 0, sizeof(h));
+    moto_aes_encrypt_ctx(&ctx->aes_ctx, (u8 *)h, (u8 *)h);
+    moto_aes_gcm_init_htable(ctx->htable, (u8 *)h);
+    memset(h, 0, sizeof(h));
+
+    return 0;
+}
+
+static int moto_aes_gcm_set_authsize(struct crypto_aead *aead,
+        unsigned int authsize)
+{
+    switch (authsize) {
+    case 4:
+    case 8:
+    case 12:
+    case 13:
+    case 14:
+    case 15:
+    case 16:
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+static int moto_aes_gcm_operate(struct aead_request *req, int enc)
+{
+    struct crypto_aead *aead = crypto_aead_reqtfm(req);
+    const struct moto_aes_gcm_ctx *ctx = crypto_aead_ctx(aead);
+    unsigned int authsize = crypto_aead_authsize(aead);
+    unsigned int cryptlen = req->cryptlen;
+    struct moto_aes_gcm_state st;
+    u32 tag[AES_BLOCK_SIZE / sizeof(u32)];
+    u8 itag[AES_BLOCK_SIZE];
+    __be64 lens[2];
+    unsigned int i;
+    u8 diff = 0;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (!enc) {
+        if (cryptlen < authsize)
+            return -EINVAL;
+        cryptlen -= authsize;
+    }
+
+    /* J0 = IV || 0^31 || 1, E(K, J0) masks the tag */
+    memcpy(st.ctrblk, req->iv, AES_GCM_IV_SIZE);
+    st.ctrblk[3] = cpu_to_be32(1);
+    moto_aes_encrypt_ctx(&ctx->aes_ctx, (u8 *)tag, (u8 *)st.ctrblk);
+    st.ctrblk[3] = cpu_to_be32(2);
+    st.ks_len = 0;
+    memset(st.xi, 0, sizeof(st.xi));
+    st.xi_len = 0;
+
+    moto_aes_gcm_hash_sg(ctx, &st, req->assoc, req->assoclen);
+    moto_aes_gcm_ghash_pad(ctx, &st);
+
+    moto_aes_gcm_crypt_sg(ctx, &st, req->dst, req->src, cryptlen, enc);
+    moto_aes_gcm_ghash_pad(ctx, &st);
+
+    lens[0] = cpu_to_be64((u64)req->assoclen * 8);
+    lens[1] = cpu_to_be64((u64)cryptlen * 8);
+    moto_aes_gcm_ghash(ctx, &st, (u8 *)lens, sizeof(lens));
+    moto_crypto_xor((u8 *)tag, (u8 *)st.xi, AES_BLOCK_SIZE);
+
+    memset(&st, 0, sizeof(st));
+
+    if (enc) {
+        scatterwalk_map_and_copy(tag, req->dst, cryptlen, authsize, 1);
+        memset(tag, 0, sizeof(tag));
+        return 0;
+    }
+
+    /* constant time, the tag must not leak through early exit */
+    scatterwalk_map_and_copy(itag, req->src, cryptlen, authsize, 0);
+    for (i = 0; i < authsize; i++)
+        diff |= itag[i] ^ ((u8 *)tag)[i];
+    memset(tag, 0, sizeof(tag));
+
+    return diff ? -EBADMSG : 0;
+}
+
+static int moto_aes_gcm_encrypt(struct aead_request *req)
+{
+    ktime_t start = moto_stats_start();
+    int err = moto_aes_gcm_operate(req, 1);
+
+    moto_stats_account(MOTO_STATS_AES_GCM, req->cryptlen, start);
+    return err;
+}
+
+static int moto_aes_gcm_decrypt(struct aead_request *req)
+{
+    ktime_t start = moto_stats_start();
+    int err = moto_aes_gcm_operate(req, 0);
+
+    moto_stats_account(MOTO_STATS_AES_GCM, req->cryptlen, start);
+    return err;
+}
+
+static void moto_aes_gcm_exit(struct crypto_tfm *tfm)
+{
+    struct moto_aes_gcm_ctx *ctx = crypto_tfm_ctx(tfm);
+
+    memset(ctx, 0, sizeof (*ctx));
+#ifdef CONFIG_CRYPTO_MOTOROLA_SHOW_ZEROIZATION
+    printk(KERN_INFO "AES-GCM key after zeroization:\n");
+    moto_hexdump((unsigned char *)ctx, sizeof(*ctx));
+#endif
+
+}
+
+void moto_aes_exit(struct crypto_tfm *tfm)
 {
     struct moto_crypto_aes_ctx *ctx = crypto_tfm_ctx(tfm);
 
@@ -1807,14 +2656,66 @@ static struct crypto_alg moto_ctr_aes_alg = {
         }
 };
 
+static struct crypto_alg moto_xts_aes_alg = {
+        .cra_name       = "xts(aes)",
+        .cra_driver_name= "moto-aes-xts",
+        .cra_priority   = 1000,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_xts_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_xts_aes_alg.cra_list),
+        .cra_exit       = moto_aes_xts_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = 2 * AES_MIN_KEY_SIZE,
+                        .max_keysize    = 2 * AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_xts_set_key,
+                        .encrypt        = moto_aes_xts_encrypt,
+                        .decrypt        = moto_aes_xts_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_gcm_aes_alg = {
+        .cra_name       = "gcm(aes)",
+        .cra_driver_name= "moto-aes-gcm",
+        .cra_priority   = 1000,
+        .cra_flags      = CRYPTO_ALG_TYPE_AEAD,
+        .cra_type       = &crypto_aead_type,
+        .cra_blocksize  = 1,
+        .cra_ctxsize    = sizeof(struct moto_aes_gcm_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_gcm_aes_alg.cra_list),
+        .cra_exit       = moto_aes_gcm_exit,
+        .cra_u          = {
+                .aead = {
+                        .ivsize         = AES_GCM_IV_SIZE,
+                        .maxauthsize    = AES_BLOCK_SIZE,
+                        .setkey         = moto_aes_gcm_set_key,
+                        .setauthsize    = moto_aes_gcm_set_authsize,
+                        .encrypt        = moto_aes_gcm_encrypt,
+                        .decrypt        = moto_aes_gcm_decrypt,
+                        .geniv          = "seqiv"
+                }
+        }
+};
+
 int moto_aes_start(void)
 {
     int err;
 
-    err = crypto_register_alg(&moto_ecb_aes_alg);
+    err = moto_post_alg_defer(&moto_ecb_aes_alg, "moto-aes-ecb",
+            "ecb(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_ecb_aes_alg);
     printk (KERN_INFO "ecb(aes) register result: %d\n", err);
     if (!err) {
-        err = moto_alg_test("moto-aes-ecb", "ecb(aes)", 0, 0);
+        err = moto_post_alg_test("moto-aes-ecb", "ecb(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
         printk (KERN_INFO "ecb(aes) test result: %d\n", err);
         if (err)
             goto out;
@@ -1822,10 +2723,13 @@ int moto_aes_start(void)
     else {
         goto out;
     }
-    err = crypto_register_alg(&moto_cbc_aes_alg);
+    err = moto_post_alg_defer(&moto_cbc_aes_alg, "moto-aes-cbc",
+            "cbc(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_cbc_aes_alg);
     printk (KERN_INFO "cbc(aes) register result: %d\n", err);
     if (!err) {
-        err = moto_alg_test("moto-aes-cbc", "cbc(aes)", 0, 0);
+        err = moto_post_alg_test("moto-aes-cbc", "cbc(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
         printk (KERN_INFO "cbc(aes) test result: %d\n", err);
         if (err)
             goto out;
@@ -1833,11 +2737,42 @@ int moto_aes_start(void)
     else {
         goto out;
     }
-    err = crypto_register_alg(&moto_ctr_aes_alg);
+    err = moto_post_alg_defer(&moto_ctr_aes_alg, "moto-aes-ctr",
+            "ctr(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_ctr_aes_alg);
     printk (KERN_INFO "ctr(aes) register result: %d\n", err);
     if (!err) {
-        err = moto_alg_test("moto-aes-ctr", "ctr(aes)", 0, 0);
+        err = moto_post_alg_test("moto-aes-ctr", "ctr(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
         printk (KERN_INFO "ctr(aes) test result: %d\n", err);
+        if (err)
+            goto out;
+    }
+    else {
+        goto out;
+    }
+    err = moto_post_alg_defer(&moto_xts_aes_alg, "moto-aes-xts",
+            "xts(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_xts_aes_alg);
+    printk (KERN_INFO "xts(aes) register result: %d\n", err);
+    if (!err) {
+        err = moto_post_alg_test("moto-aes-xts", "xts(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
+        printk (KERN_INFO "xts(aes) test result: %d\n", err);
+        if (err)
+            goto out;
+    }
+    else {
+        goto out;
+    }
+    err = moto_post_alg_defer(&moto_gcm_aes_alg, "moto-aes-gcm",
+            "gcm(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_gcm_aes_alg);
+    printk (KERN_INFO "gcm(aes) register result: %d\n", err);
+    if (!err) {
+        err = moto_post_alg_test("moto-aes-gcm", "gcm(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
+        printk (KERN_INFO "gcm(aes) test result: %d\n", err);
     }
     out:
     return err;
@@ -1853,5 +2788,9 @@ void moto_aes_finish(void)
     printk (KERN_INFO "cbc(aes) unregister result: %d\n", err);
     err = crypto_unregister_alg(&moto_ctr_aes_alg);
     printk (KERN_INFO "ctr(aes) unregister result: %d\n", err);
+    err = crypto_unregister_alg(&moto_xts_aes_alg);
+    printk (KERN_INFO "xts(aes) unregister result: %d\n", err);
+    err = crypto_unregister_alg(&moto_gcm_aes_alg);
+    printk (KERN_INFO "gcm(aes) unregister result: %d\n", err);
 
 }
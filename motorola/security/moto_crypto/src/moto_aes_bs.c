@@ -0,0 +1,1273 @@
+/*
+ * Cryptographic API.
+ *
+ * Bitsliced, constant time AES Cipher Algorithm.
+ *
+ * The state of four blocks is spread over eight 64 bit words, word i
+ * holding bit i of every state byte, following the representation of
+ * Kaesper and Schwabe ("Faster and Timing-Attack Resistant AES-GCM").
+ * The S-box is evaluated with the circuit of Boyar and Peralta ("A new
+ * combinational logic minimization technique with applications to
+ * cryptology"), so neither the key schedule nor the rounds perform any
+ * key or data dependent memory access or branch.
+ *
+ * The moto-aes-bs-* drivers run this portable core; they are slower than
+ * the table drivers and only picked by name. On x86_64 with SSSE3 the
+ * moto-aes-bs-ssse3-* drivers run the eight blocks in the xmm registers
+ * instead, see moto_aes_bs_x86.c, which is faster than the tables: their
+ * ECB and CTR take precedence over them. CBC encryption is serial and
+ * gains nothing from the lanes, so moto-aes-bs-ssse3-cbc stays below
+ * moto-aes-cbc and is meant for decryption by name.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ */
+
+#include <crypto/algapi.h>
+#include <moto_aes.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/types.h>
+#include <linux/errno.h>
+#include <linux/crypto.h>
+#include <asm/byteorder.h>
+#ifdef CONFIG_X86_64
+#include <asm/i387.h>
+#endif
+
+#include "moto_crypto_util.h"
+#include "moto_testmgr.h"
+#include "moto_crypto_main.h"
+
+/* Blocks handled per call, as two interleaved sets of four blocks. */
+#define MOTO_AES_BS_BLOCKS	8
+#define MOTO_AES_BS_BYTES	(MOTO_AES_BS_BLOCKS * AES_BLOCK_SIZE)
+#define MOTO_AES_BS_SLICES	(MOTO_AES_BS_BLOCKS / 4)
+#define MOTO_AES_BS_MAX_ROUNDS	14
+
+struct moto_aes_bs_ctx {
+    u64 sk_exp[8 * (MOTO_AES_BS_MAX_ROUNDS + 1)];
+#ifdef CONFIG_X86_64
+    u8 sk_x86[MOTO_AES_BS_X86_KEY_SIZE];
+#endif
+    unsigned int rounds;
+};
+
+/*
+ * S-box of Boyar and Peralta, 113 gates. The input and output bits are
+ * numbered in reverse order in the paper, x0 is the most significant bit.
+ */
+static void moto_aes_bs_sbox(u64 *q)
+{
+    u64 x0, x1, x2, x3, x4, x5, x6, x7;
+    u64 y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    u64 y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    u64 y20, y21;
+    u64 z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    u64 z10, z11, z12, z13, z14, z15, z16, z17;
+    u64 t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    u64 t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    u64 t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    u64 t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    u64 t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    u64 t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    u64 t60, t61, t62, t63, t64, t65, t66, t67;
+    u64 s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    /* top linear transformation */
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    /* non-linear section */
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    /* bottom linear transformation */
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/*
+ * The inverse S-box reuses the forward circuit: the inverse affine map is
+ * applied before and the forward affine map is undone after it.
+ */
+static void moto_aes_bs_inv_affine(u64 *q)
+{
+    u64 q0, q1, q2, q3, q4, q5, q6, q7;
+
+    q0 = ~q[0];
+    q1 = ~q[1];
+    q2 = q[2];
+    q3 = q[3];
+    q4 = q[4];
+    q5 = ~q[5];
+    q6 = ~q[6];
+    q7 = q[7];
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+static void moto_aes_bs_inv_sbox(u64 *q)
+{
+    moto_aes_bs_inv_affine(q);
+    moto_aes_bs_sbox(q);
+    moto_aes_bs_inv_affine(q);
+}
+
+/* Transpose between the interleaved byte layout and the bitsliced one. */
+#define MOTO_AES_BS_SWAPN(cl, ch, s, x, y)	do {		\
+        u64 a, b;						\
+        a = (x);						\
+        b = (y);						\
+        (x) = (a & (u64)(cl)) | ((b & (u64)(cl)) << (s));	\
+        (y) = ((a & (u64)(ch)) >> (s)) | (b & (u64)(ch));	\
+} while (0)
+
+#define MOTO_AES_BS_SWAP2(x, y) \
+        MOTO_AES_BS_SWAPN(0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 1, x, y)
+#define MOTO_AES_BS_SWAP4(x, y) \
+        MOTO_AES_BS_SWAPN(0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2, x, y)
+#define MOTO_AES_BS_SWAP8(x, y) \
+        MOTO_AES_BS_SWAPN(0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL, 4, x, y)
+
+static void moto_aes_bs_ortho(u64 *q)
+{
+    MOTO_AES_BS_SWAP2(q[0], q[1]);
+    MOTO_AES_BS_SWAP2(q[2], q[3]);
+    MOTO_AES_BS_SWAP2(q[4], q[5]);
+    MOTO_AES_BS_SWAP2(q[6], q[7]);
+
+    MOTO_AES_BS_SWAP4(q[0], q[2]);
+    MOTO_AES_BS_SWAP4(q[1], q[3]);
+    MOTO_AES_BS_SWAP4(q[4], q[6]);
+    MOTO_AES_BS_SWAP4(q[5], q[7]);
+
+    MOTO_AES_BS_SWAP8(q[0], q[4]);
+    MOTO_AES_BS_SWAP8(q[1], q[5]);
+    MOTO_AES_BS_SWAP8(q[2], q[6]);
+    MOTO_AES_BS_SWAP8(q[3], q[7]);
+}
+
+/* Spread the four words of one block over two words of the state. */
+static void moto_aes_bs_interleave_in(u64 *q0, u64 *q1, const u32 *w)
+{
+    u64 x0, x1, x2, x3;
+
+    x0 = w[0];
+    x1 = w[1];
+    x2 = w[2];
+    x3 = w[3];
+    x0 |= (x0 << 16);
+    x1 |= (x1 << 16);
+    x2 |= (x2 << 16);
+    x3 |= (x3 << 16);
+    x0 &= 0x0000FFFF0000FFFFULL;
+    x1 &= 0x0000FFFF0000FFFFULL;
+    x2 &= 0x0000FFFF0000FFFFULL;
+    x3 &= 0x0000FFFF0000FFFFULL;
+    x0 |= (x0 << 8);
+    x1 |= (x1 << 8);
+    x2 |= (x2 << 8);
+    x3 |= (x3 << 8);
+    x0 &= 0x00FF00FF00FF00FFULL;
+    x1 &= 0x00FF00FF00FF00FFULL;
+    x2 &= 0x00FF00FF00FF00FFULL;
+    x3 &= 0x00FF00FF00FF00FFULL;
+    *q0 = x0 | (x2 << 8);
+    *q1 = x1 | (x3 << 8);
+}
+
+static void moto_aes_bs_interleave_out(u32 *w, u64 q0, u64 q1)
+{
+    u64 x0, x1, x2, x3;
+
+    x0 = q0 & 0x00FF00FF00FF00FFULL;
+    x1 = q1 & 0x00FF00FF00FF00FFULL;
+    x2 = (q0 >> 8) & 0x00FF00FF00FF00FFULL;
+    x3 = (q1 >> 8) & 0x00FF00FF00FF00FFULL;
+    x0 |= (x0 >> 8);
+    x1 |= (x1 >> 8);
+    x2 |= (x2 >> 8);
+    x3 |= (x3 >> 8);
+    x0 &= 0x0000FFFF0000FFFFULL;
+    x1 &= 0x0000FFFF0000FFFFULL;
+    x2 &= 0x0000FFFF0000FFFFULL;
+    x3 &= 0x0000FFFF0000FFFFULL;
+    w[0] = (u32)x0 | (u32)(x0 >> 16);
+    w[1] = (u32)x1 | (u32)(x1 >> 16);
+    w[2] = (u32)x2 | (u32)(x2 >> 16);
+    w[3] = (u32)x3 | (u32)(x3 >> 16);
+}
+
+/* Load four blocks from @in into the bitsliced state @q. */
+static void moto_aes_bs_load(u64 *q, const u8 *in)
+{
+    const __le32 *src = (const __le32 *)in;
+    u32 w[4];
+    int i;
+
+    for (i = 0; i < 4; i++, src += 4) {
+        w[0] = le32_to_cpu(src[0]);
+        w[1] = le32_to_cpu(src[1]);
+        w[2] = le32_to_cpu(src[2]);
+        w[3] = le32_to_cpu(src[3]);
+        moto_aes_bs_interleave_in(&q[i], &q[i + 4], w);
+    }
+    moto_aes_bs_ortho(q);
+}
+
+static void moto_aes_bs_store(u8 *out, u64 *q)
+{
+    __le32 *dst = (__le32 *)out;
+    u32 w[4];
+    int i;
+
+    moto_aes_bs_ortho(q);
+    for (i = 0; i < 4; i++, dst += 4) {
+        moto_aes_bs_interleave_out(w, q[i], q[i + 4]);
+        dst[0] = cpu_to_le32(w[0]);
+        dst[1] = cpu_to_le32(w[1]);
+        dst[2] = cpu_to_le32(w[2]);
+        dst[3] = cpu_to_le32(w[3]);
+    }
+}
+
+static void moto_aes_bs_add_round_key(u64 *q, const u64 *sk)
+{
+    q[0] ^= sk[0];
+    q[1] ^= sk[1];
+    q[2] ^= sk[2];
+    q[3] ^= sk[3];
+    q[4] ^= sk[4];
+    q[5] ^= sk[5];
+    q[6] ^= sk[6];
+    q[7] ^= sk[7];
+}
+
+static void moto_aes_bs_shift_rows(u64 *q)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        u64 x = q[i];
+
+        q[i] = (x & 0x000000000000FFFFULL)
+            | ((x & 0x00000000FFF00000ULL) >> 4)
+            | ((x & 0x00000000000F0000ULL) << 12)
+            | ((x & 0x0000FF0000000000ULL) >> 8)
+            | ((x & 0x000000FF00000000ULL) << 8)
+            | ((x & 0xF000000000000000ULL) >> 12)
+            | ((x & 0x0FFF000000000000ULL) << 4);
+    }
+}
+
+static void moto_aes_bs_inv_shift_rows(u64 *q)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        u64 x = q[i];
+
+        q[i] = (x & 0x000000000000FFFFULL)
+            | ((x & 0x000000000FFF0000ULL) << 4)
+            | ((x & 0x00000000F0000000ULL) >> 12)
+            | ((x & 0x000000FF00000000ULL) << 8)
+            | ((x & 0x0000FF0000000000ULL) >> 8)
+            | ((x & 0x000F000000000000ULL) << 12)
+            | ((x & 0xFFF0000000000000ULL) >> 4);
+    }
+}
+
+static inline u64 moto_aes_bs_rotr32(u64 x)
+{
+    return (x << 32) | (x >> 32);
+}
+
+static void moto_aes_bs_mix_columns(u64 *q)
+{
+    u64 q0, q1, q2, q3, q4, q5, q6, q7;
+    u64 r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0];
+    q1 = q[1];
+    q2 = q[2];
+    q3 = q[3];
+    q4 = q[4];
+    q5 = q[5];
+    q6 = q[6];
+    q7 = q[7];
+    r0 = (q0 >> 16) | (q0 << 48);
+    r1 = (q1 >> 16) | (q1 << 48);
+    r2 = (q2 >> 16) | (q2 << 48);
+    r3 = (q3 >> 16) | (q3 << 48);
+    r4 = (q4 >> 16) | (q4 << 48);
+    r5 = (q5 >> 16) | (q5 << 48);
+    r6 = (q6 >> 16) | (q6 << 48);
+    r7 = (q7 >> 16) | (q7 << 48);
+
+    q[0] = q7 ^ r7 ^ r0 ^ moto_aes_bs_rotr32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ moto_aes_bs_rotr32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ moto_aes_bs_rotr32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ moto_aes_bs_rotr32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ moto_aes_bs_rotr32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ moto_aes_bs_rotr32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ moto_aes_bs_rotr32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ moto_aes_bs_rotr32(q7 ^ r7);
+}
+
+static void moto_aes_bs_inv_mix_columns(u64 *q)
+{
+    u64 q0, q1, q2, q3, q4, q5, q6, q7;
+    u64 r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0];
+    q1 = q[1];
+    q2 = q[2];
+    q3 = q[3];
+    q4 = q[4];
+    q5 = q[5];
+    q6 = q[6];
+    q7 = q[7];
+    r0 = (q0 >> 16) | (q0 << 48);
+    r1 = (q1 >> 16) | (q1 << 48);
+    r2 = (q2 >> 16) | (q2 << 48);
+    r3 = (q3 >> 16) | (q3 << 48);
+    r4 = (q4 >> 16) | (q4 << 48);
+    r5 = (q5 >> 16) | (q5 << 48);
+    r6 = (q6 >> 16) | (q6 << 48);
+    r7 = (q7 >> 16) | (q7 << 48);
+
+    q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7
+        ^ moto_aes_bs_rotr32(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+    q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7
+        ^ moto_aes_bs_rotr32(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+    q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7
+        ^ moto_aes_bs_rotr32(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+    q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5
+        ^ moto_aes_bs_rotr32(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5
+                ^ r7);
+    q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7
+        ^ moto_aes_bs_rotr32(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+    q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7
+        ^ moto_aes_bs_rotr32(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+    q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7
+        ^ moto_aes_bs_rotr32(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+    q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7
+        ^ moto_aes_bs_rotr32(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+
+/*
+ * Run the cipher over @nslices sets of bitsliced state, four blocks each.
+ * The sets share the round keys and are advanced round by round together.
+ */
+static void moto_aes_bs_encrypt_slices(const struct moto_aes_bs_ctx *ctx,
+        u64 *q, int nslices)
+{
+    const u64 *sk = ctx->sk_exp;
+    unsigned int u;
+    int i;
+
+    for (i = 0; i < nslices; i++)
+        moto_aes_bs_add_round_key(q + 8 * i, sk);
+
+    for (u = 1; u < ctx->rounds; u++) {
+        for (i = 0; i < nslices; i++) {
+            moto_aes_bs_sbox(q + 8 * i);
+            moto_aes_bs_shift_rows(q + 8 * i);
+            moto_aes_bs_mix_columns(q + 8 * i);
+            moto_aes_bs_add_round_key(q + 8 * i, sk + 8 * u);
+        }
+    }
+
+    for (i = 0; i < nslices; i++) {
+        moto_aes_bs_sbox(q + 8 * i);
+        moto_aes_bs_shift_rows(q + 8 * i);
+        moto_aes_bs_add_round_key(q + 8 * i, sk + 8 * ctx->rounds);
+    }
+}
+
+static void moto_aes_bs_decrypt_slices(const struct moto_aes_bs_ctx *ctx,
+        u64 *q, int nslices)
+{
+    const u64 *sk = ctx->sk_exp;
+    unsigned int u;
+    int i;
+
+    for (i = 0; i < nslices; i++)
+        moto_aes_bs_add_round_key(q + 8 * i, sk + 8 * ctx->rounds);
+
+    for (u = ctx->rounds - 1; u > 0; u--) {
+        for (i = 0; i < nslices; i++) {
+            moto_aes_bs_inv_shift_rows(q + 8 * i);
+            moto_aes_bs_inv_sbox(q + 8 * i);
+            moto_aes_bs_add_round_key(q + 8 * i, sk + 8 * u);
+            moto_aes_bs_inv_mix_columns(q + 8 * i);
+        }
+    }
+
+    for (i = 0; i < nslices; i++) {
+        moto_aes_bs_inv_shift_rows(q + 8 * i);
+        moto_aes_bs_inv_sbox(q + 8 * i);
+        moto_aes_bs_add_round_key(q + 8 * i, sk);
+    }
+}
+
+/*
+ * Encrypt or decrypt MOTO_AES_BS_BLOCKS consecutive blocks. @out may be
+ * equal to @in.
+ */
+static void moto_aes_bs_encrypt8(const struct moto_aes_bs_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    u64 q[8 * MOTO_AES_BS_SLICES];
+
+    moto_aes_bs_load(q, in);
+    moto_aes_bs_load(q + 8, in + 4 * AES_BLOCK_SIZE);
+    moto_aes_bs_encrypt_slices(ctx, q, MOTO_AES_BS_SLICES);
+    moto_aes_bs_store(out, q);
+    moto_aes_bs_store(out + 4 * AES_BLOCK_SIZE, q + 8);
+}
+
+static void moto_aes_bs_decrypt8(const struct moto_aes_bs_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    u64 q[8 * MOTO_AES_BS_SLICES];
+
+    moto_aes_bs_load(q, in);
+    moto_aes_bs_load(q + 8, in + 4 * AES_BLOCK_SIZE);
+    moto_aes_bs_decrypt_slices(ctx, q, MOTO_AES_BS_SLICES);
+    moto_aes_bs_store(out, q);
+    moto_aes_bs_store(out + 4 * AES_BLOCK_SIZE, q + 8);
+}
+
+/* Encrypt a single block, the other lanes of the state are unused. */
+static void moto_aes_bs_encrypt1(const struct moto_aes_bs_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    u32 buf[4 * AES_BLOCK_SIZE / sizeof(u32)];
+    u64 q[8];
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, in, AES_BLOCK_SIZE);
+    moto_aes_bs_load(q, (u8 *)buf);
+    moto_aes_bs_encrypt_slices(ctx, q, 1);
+    moto_aes_bs_store((u8 *)buf, q);
+    memcpy(out, buf, AES_BLOCK_SIZE);
+}
+
+static u32 moto_aes_bs_sub_word(u32 x)
+{
+    u64 q[8];
+
+    memset(q, 0, sizeof(q));
+    q[0] = x;
+    moto_aes_bs_ortho(q);
+    moto_aes_bs_sbox(q);
+    moto_aes_bs_ortho(q);
+    return (u32)q[0];
+}
+
+static const u8 moto_aes_bs_rcon[10] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+};
+
+/*
+ * Expand the key as described in FIPS-197 and store every round key in
+ * bitsliced form, replicated for the four blocks of a state set. The same
+ * schedule serves for decryption.
+ */
+static int moto_aes_bs_expand_key(struct moto_aes_bs_ctx *ctx,
+        const u8 *in_key, unsigned int key_len)
+{
+    const __le32 *key = (const __le32 *)in_key;
+    u32 skey[4 * (MOTO_AES_BS_MAX_ROUNDS + 1)];
+    u32 tmp;
+    int i, j, k, nk, nkf;
+
+    switch (key_len) {
+    case AES_KEYSIZE_128:
+        ctx->rounds = 10;
+        break;
+    case AES_KEYSIZE_192:
+        ctx->rounds = 12;
+        break;
+    case AES_KEYSIZE_256:
+        ctx->rounds = 14;
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    nk = key_len >> 2;
+    nkf = (ctx->rounds + 1) << 2;
+    for (i = 0; i < nk; i++)
+        skey[i] = le32_to_cpu(key[i]);
+
+    tmp = skey[nk - 1];
+    for (i = nk, j = 0, k = 0; i < nkf; i++) {
+        if (j == 0) {
+            tmp = (tmp << 24) | (tmp >> 8);
+            tmp = moto_aes_bs_sub_word(tmp) ^ moto_aes_bs_rcon[k];
+        } else if (nk > 6 && j == 4) {
+            tmp = moto_aes_bs_sub_word(tmp);
+        }
+        tmp ^= skey[i - nk];
+        skey[i] = tmp;
+        if (++j == nk) {
+            j = 0;
+            k++;
+        }
+    }
+
+    for (i = 0; i < nkf; i += 4) {
+        u64 *q = ctx->sk_exp + 2 * i;
+
+        moto_aes_bs_interleave_in(&q[0], &q[4], skey + i);
+        q[1] = q[0];
+        q[2] = q[0];
+        q[3] = q[0];
+        q[5] = q[4];
+        q[6] = q[4];
+        q[7] = q[4];
+        moto_aes_bs_ortho(q);
+    }
+#ifdef CONFIG_X86_64
+    moto_aes_bs_x86_set_key(ctx->sk_x86, skey, ctx->rounds);
+#endif
+
+    memset(skey, 0, sizeof(skey));
+    tmp = 0;
+    return 0;
+}
+
+/* The block functions a request runs */
+struct moto_aes_bs_fns {
+    void (*encrypt8)(const struct moto_aes_bs_ctx *ctx, u8 *out,
+            const u8 *in);
+    void (*decrypt8)(const struct moto_aes_bs_ctx *ctx, u8 *out,
+            const u8 *in);
+    void (*encrypt1)(const struct moto_aes_bs_ctx *ctx, u8 *out,
+            const u8 *in);
+};
+
+static const struct moto_aes_bs_fns moto_aes_bs_portable = {
+    .encrypt8 = moto_aes_bs_encrypt8,
+    .decrypt8 = moto_aes_bs_decrypt8,
+    .encrypt1 = moto_aes_bs_encrypt1,
+};
+
+#ifdef CONFIG_X86_64
+static void moto_aes_bs_ssse3_encrypt8(const struct moto_aes_bs_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    moto_aes_bs_x86_encrypt8(ctx->sk_x86, ctx->rounds, out, in);
+}
+
+static void moto_aes_bs_ssse3_decrypt8(const struct moto_aes_bs_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    moto_aes_bs_x86_decrypt8(ctx->sk_x86, ctx->rounds, out, in);
+}
+
+/* A single block in the first lane, still cheaper than the portable core */
+static void moto_aes_bs_ssse3_encrypt1(const struct moto_aes_bs_ctx *ctx,
+        u8 *out, const u8 *in)
+{
+    u8 buf[MOTO_AES_BS_BYTES];
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, in, AES_BLOCK_SIZE);
+    moto_aes_bs_x86_encrypt8(ctx->sk_x86, ctx->rounds, buf, buf);
+    memcpy(out, buf, AES_BLOCK_SIZE);
+    memset(buf, 0, sizeof(buf));
+}
+
+static const struct moto_aes_bs_fns moto_aes_bs_ssse3 = {
+    .encrypt8 = moto_aes_bs_ssse3_encrypt8,
+    .decrypt8 = moto_aes_bs_ssse3_decrypt8,
+    .encrypt1 = moto_aes_bs_ssse3_encrypt1,
+};
+#endif
+
+/*
+ * The SSSE3 drivers hold the FPU for the whole walk when it is usable and
+ * fall back to the portable core when it is not.
+ */
+static const struct moto_aes_bs_fns *moto_aes_bs_begin(
+        struct blkcipher_desc *desc, int simd)
+{
+#ifdef CONFIG_X86_64
+    if (simd && irq_fpu_usable()) {
+        desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+        kernel_fpu_begin();
+        return &moto_aes_bs_ssse3;
+    }
+#endif
+    return &moto_aes_bs_portable;
+}
+
+static void moto_aes_bs_end(const struct moto_aes_bs_fns *fns)
+{
+#ifdef CONFIG_X86_64
+    if (fns == &moto_aes_bs_ssse3)
+        kernel_fpu_end();
+#endif
+}
+
+static int moto_aes_bs_set_key(struct crypto_tfm *tfm, const u8 *in_key,
+        unsigned int key_len)
+{
+    struct moto_aes_bs_ctx *ctx = crypto_tfm_ctx(tfm);
+    u32 *flags = &tfm->crt_flags;
+    int ret;
+
+    ret = moto_aes_bs_expand_key(ctx, in_key, key_len);
+    if (!ret)
+        return 0;
+
+    *flags |= CRYPTO_TFM_RES_BAD_KEY_LEN;
+    return -EINVAL;
+}
+
+static int moto_ecb_aes_bs_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes, int decrypt, int simd)
+{
+    const struct moto_aes_bs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    const struct moto_aes_bs_fns *fns;
+    struct blkcipher_walk walk;
+    u32 buf[MOTO_AES_BS_BYTES / sizeof(u32)];
+    void (*fn)(const struct moto_aes_bs_ctx *, u8 *, const u8 *);
+    unsigned int n;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (nbytes % AES_BLOCK_SIZE)
+        return -EINVAL;
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt_block(desc, &walk, AES_BLOCK_SIZE);
+    fns = moto_aes_bs_begin(desc, simd);
+    fn = decrypt ? fns->decrypt8 : fns->encrypt8;
+
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        while (nbytes >= MOTO_AES_BS_BYTES) {
+            fn(ctx, wdst, wsrc);
+
+            wsrc += MOTO_AES_BS_BYTES;
+            wdst += MOTO_AES_BS_BYTES;
+            nbytes -= MOTO_AES_BS_BYTES;
+        }
+
+        /* a short tail still costs one full pass */
+        if (nbytes >= AES_BLOCK_SIZE) {
+            n = nbytes & ~(AES_BLOCK_SIZE - 1);
+            memcpy(buf, wsrc, n);
+            fn(ctx, (u8 *)buf, (u8 *)buf);
+            memcpy(wdst, buf, n);
+            nbytes -= n;
+        }
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+    moto_aes_bs_end(fns);
+
+    memset(buf, 0, sizeof(buf));
+    return err;
+}
+
+static int moto_ecb_aes_bs_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_ecb_aes_bs_operate(desc, dst, src, nbytes, 0, 0);
+}
+
+static int moto_ecb_aes_bs_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_ecb_aes_bs_operate(desc, dst, src, nbytes, 1, 0);
+}
+
+/*
+ * CBC encryption is serial, every block goes through its own pass. Only
+ * decryption benefits from the eight lanes.
+ */
+static int moto_cbc_aes_bs_encrypt_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes, int simd)
+{
+    const struct moto_aes_bs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    const struct moto_aes_bs_fns *fns;
+    struct blkcipher_walk walk;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+    u8 *iv;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt(desc, &walk);
+    fns = moto_aes_bs_begin(desc, simd);
+
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+        iv = walk.iv;
+
+        do {
+            moto_crypto_xor(iv, wsrc, AES_BLOCK_SIZE);
+            fns->encrypt1(ctx, wdst, iv);
+            memcpy(iv, wdst, AES_BLOCK_SIZE);
+
+            wsrc += AES_BLOCK_SIZE;
+            wdst += AES_BLOCK_SIZE;
+        } while ((nbytes -= AES_BLOCK_SIZE) >= AES_BLOCK_SIZE);
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+    moto_aes_bs_end(fns);
+
+    return err;
+}
+
+static int moto_cbc_aes_bs_decrypt_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes, int simd)
+{
+    const struct moto_aes_bs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    const struct moto_aes_bs_fns *fns;
+    struct blkcipher_walk walk;
+    u32 buf[MOTO_AES_BS_BYTES / sizeof(u32)];
+    u8 last_iv[AES_BLOCK_SIZE];
+    unsigned int n;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt_block(desc, &walk, AES_BLOCK_SIZE);
+    fns = moto_aes_bs_begin(desc, simd);
+
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        /*
+         * Decrypt into the bounce buffer so the ciphertext needed for
+         * the chaining survives an in-place request.
+         */
+        while (nbytes >= AES_BLOCK_SIZE) {
+            n = min(nbytes & ~(AES_BLOCK_SIZE - 1),
+                    (unsigned int)MOTO_AES_BS_BYTES);
+            memcpy(buf, wsrc, n);
+            fns->decrypt8(ctx, (u8 *)buf, (u8 *)buf);
+            moto_crypto_xor((u8 *)buf, walk.iv, AES_BLOCK_SIZE);
+            moto_crypto_xor((u8 *)buf + AES_BLOCK_SIZE, wsrc,
+                    n - AES_BLOCK_SIZE);
+            memcpy(last_iv, wsrc + n - AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+            memcpy(wdst, buf, n);
+            memcpy(walk.iv, last_iv, AES_BLOCK_SIZE);
+
+            wsrc += n;
+            wdst += n;
+            nbytes -= n;
+        }
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+    moto_aes_bs_end(fns);
+
+    memset(buf, 0, sizeof(buf));
+    return err;
+}
+
+static int moto_cbc_aes_bs_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_cbc_aes_bs_encrypt_operate(desc, dst, src, nbytes, 0);
+}
+
+static int moto_cbc_aes_bs_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_cbc_aes_bs_decrypt_operate(desc, dst, src, nbytes, 0);
+}
+
+static int moto_ctr_aes_bs_crypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes, int simd)
+{
+    const struct moto_aes_bs_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    const struct moto_aes_bs_fns *fns;
+    struct blkcipher_walk walk;
+    u32 keystream[MOTO_AES_BS_BYTES / sizeof(u32)];
+    unsigned int n;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    memset(keystream, 0, sizeof(keystream));
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt_block(desc, &walk, AES_BLOCK_SIZE);
+    fns = moto_aes_bs_begin(desc, simd);
+
+    while ((nbytes = walk.nbytes) >= AES_BLOCK_SIZE) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        /* only as many counter values as there are whole blocks */
+        while (nbytes >= AES_BLOCK_SIZE) {
+            n = min(nbytes & ~(AES_BLOCK_SIZE - 1),
+                    (unsigned int)MOTO_AES_BS_BYTES);
+            moto_crypto_ctr_fill((u8 *)keystream, walk.iv,
+                    n / AES_BLOCK_SIZE);
+            fns->encrypt8(ctx, (u8 *)keystream, (u8 *)keystream);
+            if (wsrc != wdst)
+                memcpy(wdst, wsrc, n);
+            moto_crypto_xor(wdst, (u8 *)keystream, n);
+
+            wsrc += n;
+            wdst += n;
+            nbytes -= n;
+        }
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+
+    /* final partial block */
+    if (walk.nbytes) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+        moto_crypto_ctr_fill((u8 *)keystream, walk.iv, 1);
+        fns->encrypt1(ctx, (u8 *)keystream, (u8 *)keystream);
+        moto_crypto_xor((u8 *)keystream, wsrc, walk.nbytes);
+        memcpy(wdst, keystream, walk.nbytes);
+        err = blkcipher_walk_done(desc, &walk, 0);
+    }
+    moto_aes_bs_end(fns);
+
+    memset(keystream, 0, sizeof(keystream));
+    return err;
+}
+
+static int moto_ctr_aes_bs_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_ctr_aes_bs_crypt(desc, dst, src, nbytes, 0);
+}
+
+#ifdef CONFIG_X86_64
+static int moto_ecb_aes_bs_ssse3_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_ecb_aes_bs_operate(desc, dst, src, nbytes, 0, 1);
+}
+
+static int moto_ecb_aes_bs_ssse3_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_ecb_aes_bs_operate(desc, dst, src, nbytes, 1, 1);
+}
+
+static int moto_cbc_aes_bs_ssse3_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_cbc_aes_bs_encrypt_operate(desc, dst, src, nbytes, 1);
+}
+
+static int moto_cbc_aes_bs_ssse3_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_cbc_aes_bs_decrypt_operate(desc, dst, src, nbytes, 1);
+}
+
+static int moto_ctr_aes_bs_ssse3_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    return moto_ctr_aes_bs_crypt(desc, dst, src, nbytes, 1);
+}
+#endif
+
+static void moto_aes_bs_exit(struct crypto_tfm *tfm)
+{
+    struct moto_aes_bs_ctx *ctx = crypto_tfm_ctx(tfm);
+
+    memset(ctx, 0, sizeof (*ctx));
+#ifdef CONFIG_CRYPTO_MOTOROLA_SHOW_ZEROIZATION
+    printk(KERN_INFO "Bitsliced AES key after zeroization:\n");
+    moto_hexdump((unsigned char *)ctx, sizeof(*ctx));
+#endif
+
+}
+
+static struct crypto_alg moto_ecb_aes_bs_alg = {
+        .cra_name       = "ecb(aes)",
+        .cra_driver_name= "moto-aes-bs-ecb",
+        .cra_priority   = 900,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_bs_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_ecb_aes_bs_alg.cra_list),
+        .cra_exit       = moto_aes_bs_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .setkey         = moto_aes_bs_set_key,
+                        .encrypt        = moto_ecb_aes_bs_encrypt,
+                        .decrypt        = moto_ecb_aes_bs_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_cbc_aes_bs_alg = {
+        .cra_name       = "cbc(aes)",
+        .cra_driver_name= "moto-aes-bs-cbc",
+        .cra_priority   = 900,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_bs_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_cbc_aes_bs_alg.cra_list),
+        .cra_exit       = moto_aes_bs_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_bs_set_key,
+                        .encrypt        = moto_cbc_aes_bs_encrypt,
+                        .decrypt        = moto_cbc_aes_bs_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_ctr_aes_bs_alg = {
+        .cra_name       = "ctr(aes)",
+        .cra_driver_name= "moto-aes-bs-ctr",
+        .cra_priority   = 900,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_bs_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_ctr_aes_bs_alg.cra_list),
+        .cra_exit       = moto_aes_bs_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_bs_set_key,
+                        .encrypt        = moto_ctr_aes_bs_operate,
+                        .decrypt        = moto_ctr_aes_bs_operate
+                }
+        }
+};
+
+#ifdef CONFIG_X86_64
+static struct crypto_alg moto_ecb_aes_bs_ssse3_alg = {
+        .cra_name       = "ecb(aes)",
+        .cra_driver_name= "moto-aes-bs-ssse3-ecb",
+        .cra_priority   = 1050,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_bs_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_ecb_aes_bs_ssse3_alg.cra_list),
+        .cra_exit       = moto_aes_bs_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .setkey         = moto_aes_bs_set_key,
+                        .encrypt        = moto_ecb_aes_bs_ssse3_encrypt,
+                        .decrypt        = moto_ecb_aes_bs_ssse3_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_cbc_aes_bs_ssse3_alg = {
+        .cra_name       = "cbc(aes)",
+        .cra_driver_name= "moto-aes-bs-ssse3-cbc",
+        .cra_priority   = 950,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_bs_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_cbc_aes_bs_ssse3_alg.cra_list),
+        .cra_exit       = moto_aes_bs_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_bs_set_key,
+                        .encrypt        = moto_cbc_aes_bs_ssse3_encrypt,
+                        .decrypt        = moto_cbc_aes_bs_ssse3_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_ctr_aes_bs_ssse3_alg = {
+        .cra_name       = "ctr(aes)",
+        .cra_driver_name= "moto-aes-bs-ssse3-ctr",
+        .cra_priority   = 1050,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_aes_bs_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_ctr_aes_bs_ssse3_alg.cra_list),
+        .cra_exit       = moto_aes_bs_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_bs_set_key,
+                        .encrypt        = moto_ctr_aes_bs_ssse3_operate,
+                        .decrypt        = moto_ctr_aes_bs_ssse3_operate
+                }
+        }
+};
+#endif
+
+/*
+ * The portable drivers come first, their tests also cover the core the
+ * SSSE3 drivers fall back on.
+ */
+static struct moto_aes_bs_alg {
+    struct crypto_alg *alg;
+    int (*usable)(void);
+    int registered;
+} moto_aes_bs_algs[] = {
+    { &moto_ecb_aes_bs_alg },
+    { &moto_cbc_aes_bs_alg },
+    { &moto_ctr_aes_bs_alg },
+#ifdef CONFIG_X86_64
+    { &moto_ecb_aes_bs_ssse3_alg, moto_aes_bs_x86_usable },
+    { &moto_cbc_aes_bs_ssse3_alg, moto_aes_bs_x86_usable },
+    { &moto_ctr_aes_bs_ssse3_alg, moto_aes_bs_x86_usable },
+#endif
+};
+
+int moto_aes_bs_start(void)
+{
+    struct crypto_alg *alg;
+    unsigned int i;
+    int err;
+
+    for (i = 0; i < ARRAY_SIZE(moto_aes_bs_algs); i++) {
+        alg = moto_aes_bs_algs[i].alg;
+        if (moto_aes_bs_algs[i].usable && !moto_aes_bs_algs[i].usable()) {
+            printk (KERN_INFO "%s not supported by the CPU\n",
+                    alg->cra_driver_name);
+            continue;
+        }
+        err = moto_post_alg_defer(alg, alg->cra_driver_name,
+                alg->cra_name, MOTO_CRYPTO_FAILED_ALG_AES) ?:
+                crypto_register_alg(alg);
+        printk (KERN_INFO "%s register result: %d\n",
+                alg->cra_driver_name, err);
+        if (err)
+            return err;
+        moto_aes_bs_algs[i].registered = 1;
+        err = moto_post_alg_test(alg->cra_driver_name, alg->cra_name,
+                MOTO_CRYPTO_FAILED_ALG_AES);
+        printk (KERN_INFO "%s test result: %d\n",
+                alg->cra_driver_name, err);
+        if (err)
+            return err;
+    }
+    return 0;
+}
+
+void moto_aes_bs_finish(void)
+{
+    unsigned int i;
+    int err;
+
+    for (i = 0; i < ARRAY_SIZE(moto_aes_bs_algs); i++) {
+        if (!moto_aes_bs_algs[i].registered)
+            continue;
+        err = crypto_unregister_alg(moto_aes_bs_algs[i].alg);
+        moto_aes_bs_algs[i].registered = 0;
+        printk (KERN_INFO "%s unregister result: %d\n",
+                moto_aes_bs_algs[i].alg->cra_driver_name, err);
+    }
+}
@@ -0,0 +1,1575 @@
+/*
+ * Cryptographic API.
+ *
+ * SSSE3 core of the bitsliced AES drivers, for x86_64.
+ *
+ * The eight blocks of a call are bitsliced in the sixteen bytes of eight
+ * xmm registers, as described by Kaesper and Schwabe: register k holds bit
+ * k of every state byte, and byte 4r + c of it is row r, column c of the
+ * state, so ShiftRows is a pshufb and MixColumns a pair of dword rotations.
+ * The S-box is the Boyar and Peralta circuit of moto_aes_bs.c. Like there,
+ * nothing depends on the key or the data but the values computed.
+ *
+ * The round functions are generated by scripts/moto_aes_bs_x86.py, which
+ * assigns the registers and checks the result against FIPS-197; change the
+ * script rather than the assembly.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ */
+
+#include <crypto/algapi.h>
+#include <moto_aes.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/string.h>
+#include <asm/cpufeature.h>
+
+/* Operands of pshufb and pand, in the order the generator expects them */
+static const struct {
+    u8 m0[16];
+    u8 sr[16];
+    u8 isr[16];
+    u8 m55[16];
+    u8 m33[16];
+    u8 m0f[16];
+} moto_aes_bs_x86_consts __aligned(16) = {
+    /* column major bytes to row major, and back */
+    .m0 = { 0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15 },
+    .sr = { 0, 1, 2, 3, 5, 6, 7, 4, 10, 11, 8, 9, 15, 12, 13, 14 },
+    .isr = { 0, 1, 2, 3, 7, 4, 5, 6, 10, 11, 8, 9, 13, 14, 15, 12 },
+    /* the three swaps of the bit transposition */
+    .m55 = { [0 ... 15] = 0x55 },
+    .m33 = { [0 ... 15] = 0x33 },
+    .m0f = { [0 ... 15] = 0x0f },
+};
+
+/*
+ * Lay out the round keys expanded in @skey as the generated code reads
+ * them: eight registers per round, bit k of key byte i spread over byte i
+ * of register k. The 0x63 of the S-box affine map is added to rounds 1 and
+ * up, the circuits leave it out.
+ */
+void moto_aes_bs_x86_set_key(u8 *sk, const u32 *skey, unsigned int rounds)
+{
+    unsigned int u, k, p, i;
+    u8 bit;
+
+    for (u = 0; u <= rounds; u++, skey += 4) {
+        for (k = 0; k < 8; k++, sk += AES_BLOCK_SIZE) {
+            for (p = 0; p < AES_BLOCK_SIZE; p++) {
+                i = moto_aes_bs_x86_consts.m0[p];
+                bit = (skey[i / 4] >> (8 * (i % 4) + k)) & 1;
+                if (u)
+                    bit ^= (0x63 >> k) & 1;
+                sk[p] = -bit;
+            }
+        }
+    }
+}
+
+/*
+ * The helpers below use all sixteen xmm registers without declaring them
+ * as clobbered, as in moto_aes_ni.c: kernel code is built without SSE, so
+ * the compiler never keeps anything in them, and the user state is saved
+ * by kernel_fpu_begin(). @s holds the values spilled from the registers,
+ * the round keys are read from @sk onwards, one round per loop, @n times.
+ */
+#define MOTO_AES_BS_X86_SPILLS 13
+
+static void moto_aes_bs_ssse3_encrypt8(const u8 *sk, unsigned long n, u8 *out,
+        const u8 *in, u8 *s)
+{
+    asm volatile(
+        "movdqu 0(%[in]), %%xmm0\n\t"
+        "pshufb 0(%[c]), %%xmm0\n\t"
+        "movdqu 16(%[in]), %%xmm1\n\t"
+        "pshufb 0(%[c]), %%xmm1\n\t"
+        "movdqu 32(%[in]), %%xmm2\n\t"
+        "pshufb 0(%[c]), %%xmm2\n\t"
+        "movdqu 48(%[in]), %%xmm3\n\t"
+        "pshufb 0(%[c]), %%xmm3\n\t"
+        "movdqu 64(%[in]), %%xmm4\n\t"
+        "pshufb 0(%[c]), %%xmm4\n\t"
+        "movdqu 80(%[in]), %%xmm5\n\t"
+        "pshufb 0(%[c]), %%xmm5\n\t"
+        "movdqu 96(%[in]), %%xmm6\n\t"
+        "pshufb 0(%[c]), %%xmm6\n\t"
+        "movdqu 112(%[in]), %%xmm7\n\t"
+        "pshufb 0(%[c]), %%xmm7\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm2, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm3, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "movdqa %%xmm4, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "movdqa %%xmm6, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm2, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm3, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "movdqa %%xmm4, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "movdqa %%xmm5, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm4, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "movdqa %%xmm2, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "movdqa %%xmm3, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "movdqu 0(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqu 16(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "movdqu 32(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "movdqu 48(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "movdqu 64(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "movdqu 80(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "movdqu 96(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "movdqu 112(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "1:\n\t"
+        "add $128, %[rk]\n\t"
+        "movdqa %%xmm4, %%xmm8\n\t"
+        "pxor %%xmm2, %%xmm8\n\t"                       /* y14 */
+        "movdqa %%xmm7, %%xmm9\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"                       /* y13 */
+        "movdqa %%xmm7, %%xmm10\n\t"
+        "pxor %%xmm4, %%xmm10\n\t"                      /* y9 */
+        "movdqa %%xmm7, %%xmm11\n\t"
+        "pxor %%xmm2, %%xmm11\n\t"                      /* y8 */
+        "pxor %%xmm6, %%xmm5\n\t"                       /* t0 */
+        "movdqa %%xmm5, %%xmm12\n\t"
+        "pxor %%xmm0, %%xmm12\n\t"                      /* y1 */
+        "pxor %%xmm12, %%xmm4\n\t"                      /* y4 */
+        "movdqa %%xmm9, %%xmm13\n\t"
+        "pxor %%xmm8, %%xmm13\n\t"                      /* y12 */
+        "movdqa %%xmm12, %%xmm14\n\t"
+        "pxor %%xmm7, %%xmm14\n\t"                      /* y2 */
+        "pxor %%xmm12, %%xmm1\n\t"                      /* y5 */
+        "movdqa %%xmm1, %%xmm15\n\t"
+        "pxor %%xmm11, %%xmm15\n\t"                     /* y3 */
+        "pxor %%xmm13, %%xmm3\n\t"                      /* t1 */
+        "pxor %%xmm3, %%xmm2\n\t"                       /* y15 */
+        "pxor %%xmm6, %%xmm3\n\t"                       /* y20 */
+        "movdqa %%xmm2, %%xmm6\n\t"
+        "pxor %%xmm0, %%xmm6\n\t"                       /* y6 */
+        "movdqa %%xmm8, 0(%[s])\n\t"
+        "movdqa %%xmm2, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"                       /* y10 */
+        "movdqa %%xmm14, 16(%[s])\n\t"
+        "movdqa %%xmm3, %%xmm14\n\t"
+        "pxor %%xmm10, %%xmm14\n\t"                     /* y11 */
+        "movdqa %%xmm3, 32(%[s])\n\t"
+        "movdqa %%xmm0, %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"                      /* y7 */
+        "movdqa %%xmm10, 48(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm10\n\t"
+        "pxor %%xmm14, %%xmm10\n\t"                     /* y17 */
+        "movdqa %%xmm10, 64(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm10\n\t"
+        "pxor %%xmm11, %%xmm10\n\t"                     /* y19 */
+        "pxor %%xmm14, %%xmm5\n\t"                      /* y16 */
+        "movdqa %%xmm10, 80(%[s])\n\t"
+        "movdqa %%xmm9, %%xmm10\n\t"
+        "pxor %%xmm5, %%xmm10\n\t"                      /* y21 */
+        "pxor %%xmm5, %%xmm7\n\t"                       /* y18 */
+        "movdqa %%xmm7, 96(%[s])\n\t"
+        "movdqa %%xmm13, %%xmm7\n\t"
+        "pand %%xmm2, %%xmm7\n\t"                       /* t2 */
+        "movdqa %%xmm13, 112(%[s])\n\t"
+        "movdqa %%xmm15, %%xmm13\n\t"
+        "pand %%xmm6, %%xmm13\n\t"                      /* t3 */
+        "pxor %%xmm7, %%xmm13\n\t"                      /* t4 */
+        "movdqa %%xmm15, 128(%[s])\n\t"
+        "movdqa %%xmm4, %%xmm15\n\t"
+        "pand %%xmm0, %%xmm15\n\t"                      /* t5 */
+        "pxor %%xmm7, %%xmm15\n\t"                      /* t6 */
+        "movdqa %%xmm9, %%xmm7\n\t"
+        "pand %%xmm5, %%xmm7\n\t"                       /* t7 */
+        "movdqa %%xmm9, 144(%[s])\n\t"
+        "movdqa %%xmm1, %%xmm9\n\t"
+        "pand %%xmm12, %%xmm9\n\t"                      /* t8 */
+        "pxor %%xmm7, %%xmm9\n\t"                       /* t9 */
+        "movdqa %%xmm1, 160(%[s])\n\t"
+        "movdqa 16(%[s]), %%xmm1\n\t"
+        "pand %%xmm3, %%xmm1\n\t"                       /* t10 */
+        "pxor %%xmm7, %%xmm1\n\t"                       /* t11 */
+        "movdqa 48(%[s]), %%xmm7\n\t"
+        "pand %%xmm14, %%xmm7\n\t"                      /* t12 */
+        "movdqa %%xmm4, 176(%[s])\n\t"
+        "movdqa 0(%[s]), %%xmm4\n\t"
+        "pand 64(%[s]), %%xmm4\n\t"                     /* t13 */
+        "pxor %%xmm7, %%xmm4\n\t"                       /* t14 */
+        "movdqa %%xmm14, 192(%[s])\n\t"
+        "movdqa %%xmm11, %%xmm14\n\t"
+        "pand %%xmm8, %%xmm14\n\t"                      /* t15 */
+        "pxor %%xmm7, %%xmm14\n\t"                      /* t16 */
+        "pxor %%xmm4, %%xmm13\n\t"                      /* t17 */
+        "pxor %%xmm14, %%xmm15\n\t"                     /* t18 */
+        "pxor %%xmm4, %%xmm9\n\t"                       /* t19 */
+        "pxor %%xmm14, %%xmm1\n\t"                      /* t20 */
+        "pxor 32(%[s]), %%xmm13\n\t"                    /* t21 */
+        "pxor 80(%[s]), %%xmm15\n\t"                    /* t22 */
+        "pxor %%xmm10, %%xmm9\n\t"                      /* t23 */
+        "pxor 96(%[s]), %%xmm1\n\t"                     /* t24 */
+        "movdqa %%xmm13, %%xmm4\n\t"
+        "pxor %%xmm15, %%xmm4\n\t"                      /* t25 */
+        "pand %%xmm9, %%xmm13\n\t"                      /* t26 */
+        "movdqa %%xmm1, %%xmm7\n\t"
+        "pxor %%xmm13, %%xmm7\n\t"                      /* t27 */
+        "movdqa %%xmm4, %%xmm10\n\t"
+        "pand %%xmm7, %%xmm10\n\t"                      /* t28 */
+        "pxor %%xmm15, %%xmm10\n\t"                     /* t29 */
+        "movdqa %%xmm9, %%xmm14\n\t"
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t30 */
+        "pxor %%xmm13, %%xmm15\n\t"                     /* t31 */
+        "pand %%xmm14, %%xmm15\n\t"                     /* t32 */
+        "pxor %%xmm1, %%xmm15\n\t"                      /* t33 */
+        "pxor %%xmm15, %%xmm9\n\t"                      /* t34 */
+        "movdqa %%xmm7, %%xmm13\n\t"
+        "pxor %%xmm15, %%xmm13\n\t"                     /* t35 */
+        "pand %%xmm13, %%xmm1\n\t"                      /* t36 */
+        "pxor %%xmm1, %%xmm9\n\t"                       /* t37 */
+        "pxor %%xmm1, %%xmm7\n\t"                       /* t38 */
+        "pand %%xmm10, %%xmm7\n\t"                      /* t39 */
+        "pxor %%xmm7, %%xmm4\n\t"                       /* t40 */
+        "movdqa %%xmm4, %%xmm1\n\t"
+        "pxor %%xmm9, %%xmm1\n\t"                       /* t41 */
+        "movdqa %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm15, %%xmm7\n\t"                      /* t42 */
+        "movdqa %%xmm10, %%xmm13\n\t"
+        "pxor %%xmm4, %%xmm13\n\t"                      /* t43 */
+        "movdqa %%xmm15, %%xmm14\n\t"
+        "pxor %%xmm9, %%xmm14\n\t"                      /* t44 */
+        "movdqa %%xmm11, 96(%[s])\n\t"
+        "movdqa %%xmm7, %%xmm11\n\t"
+        "pxor %%xmm1, %%xmm11\n\t"                      /* t45 */
+        "pand %%xmm14, %%xmm2\n\t"                      /* z0 */
+        "pand %%xmm9, %%xmm6\n\t"                       /* z1 */
+        "pand %%xmm15, %%xmm0\n\t"                      /* z2 */
+        "pand %%xmm13, %%xmm5\n\t"                      /* z3 */
+        "pand %%xmm4, %%xmm12\n\t"                      /* z4 */
+        "pand %%xmm10, %%xmm3\n\t"                      /* z5 */
+        "movdqa %%xmm6, 80(%[s])\n\t"
+        "movdqa %%xmm7, %%xmm6\n\t"
+        "pand 192(%[s]), %%xmm6\n\t"                    /* z6 */
+        "movdqa %%xmm12, 192(%[s])\n\t"
+        "movdqa %%xmm11, %%xmm12\n\t"
+        "pand 64(%[s]), %%xmm12\n\t"                    /* z7 */
+        "pand %%xmm1, %%xmm8\n\t"                       /* z8 */
+        "pand 112(%[s]), %%xmm14\n\t"                   /* z9 */
+        "pand 128(%[s]), %%xmm9\n\t"                    /* z10 */
+        "pand 176(%[s]), %%xmm15\n\t"                   /* z11 */
+        "pand 144(%[s]), %%xmm13\n\t"                   /* z12 */
+        "pand 160(%[s]), %%xmm4\n\t"                    /* z13 */
+        "pand 16(%[s]), %%xmm10\n\t"                    /* z14 */
+        "pand 48(%[s]), %%xmm7\n\t"                     /* z15 */
+        "pand 0(%[s]), %%xmm11\n\t"                     /* z16 */
+        "pand 96(%[s]), %%xmm1\n\t"                     /* z17 */
+        "pxor %%xmm11, %%xmm7\n\t"                      /* t46 */
+        "pxor %%xmm9, %%xmm15\n\t"                      /* t47 */
+        "pxor %%xmm3, %%xmm4\n\t"                       /* t48 */
+        "pxor %%xmm9, %%xmm14\n\t"                      /* t49 */
+        "movdqa %%xmm0, %%xmm9\n\t"
+        "pxor %%xmm13, %%xmm9\n\t"                      /* t50 */
+        "pxor %%xmm3, %%xmm0\n\t"                       /* t51 */
+        "pxor %%xmm12, %%xmm8\n\t"                      /* t52 */
+        "pxor %%xmm5, %%xmm2\n\t"                       /* t53 */
+        "pxor %%xmm12, %%xmm6\n\t"                      /* t54 */
+        "pxor %%xmm1, %%xmm11\n\t"                      /* t55 */
+        "pxor %%xmm4, %%xmm13\n\t"                      /* t56 */
+        "pxor %%xmm2, %%xmm9\n\t"                       /* t57 */
+        "movdqa 192(%[s]), %%xmm1\n\t"
+        "pxor %%xmm7, %%xmm1\n\t"                       /* t58 */
+        "pxor %%xmm6, %%xmm5\n\t"                       /* t59 */
+        "pxor %%xmm9, %%xmm7\n\t"                       /* t60 */
+        "pxor %%xmm9, %%xmm10\n\t"                      /* t61 */
+        "pxor %%xmm1, %%xmm8\n\t"                       /* t62 */
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t63 */
+        "movdqa 192(%[s]), %%xmm1\n\t"
+        "pxor %%xmm5, %%xmm1\n\t"                       /* t64 */
+        "pxor %%xmm8, %%xmm10\n\t"                      /* t65 */
+        "movdqa 80(%[s]), %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"                      /* t66 */
+        "pxor %%xmm14, %%xmm5\n\t"                      /* s0 */
+        "pxor %%xmm8, %%xmm13\n\t"                      /* s6 */
+        "pxor %%xmm7, %%xmm4\n\t"                       /* s7 */
+        "movdqa %%xmm1, %%xmm6\n\t"
+        "pxor %%xmm10, %%xmm6\n\t"                      /* t67 */
+        "pxor %%xmm3, %%xmm2\n\t"                       /* s3 */
+        "pxor %%xmm3, %%xmm0\n\t"                       /* s4 */
+        "pxor %%xmm10, %%xmm15\n\t"                     /* s5 */
+        "pxor %%xmm2, %%xmm1\n\t"                       /* s1 */
+        "pxor %%xmm6, %%xmm11\n\t"                      /* s2 */
+        "pshufb 16(%[c]), %%xmm4\n\t"
+        "pshufb 16(%[c]), %%xmm13\n\t"
+        "pshufb 16(%[c]), %%xmm15\n\t"
+        "pshufb 16(%[c]), %%xmm0\n\t"
+        "pshufb 16(%[c]), %%xmm2\n\t"
+        "pshufb 16(%[c]), %%xmm11\n\t"
+        "pshufb 16(%[c]), %%xmm1\n\t"
+        "pshufb 16(%[c]), %%xmm5\n\t"
+        "pshufd $0x39, %%xmm4, %%xmm3\n\t"
+        "pshufd $0x39, %%xmm13, %%xmm6\n\t"
+        "pshufd $0x39, %%xmm15, %%xmm7\n\t"
+        "pshufd $0x39, %%xmm0, %%xmm8\n\t"
+        "pshufd $0x39, %%xmm2, %%xmm9\n\t"
+        "pshufd $0x39, %%xmm11, %%xmm10\n\t"
+        "pshufd $0x39, %%xmm1, %%xmm12\n\t"
+        "pshufd $0x39, %%xmm5, %%xmm14\n\t"
+        "pxor %%xmm3, %%xmm4\n\t"
+        "pxor %%xmm6, %%xmm13\n\t"
+        "pxor %%xmm7, %%xmm15\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "pxor %%xmm9, %%xmm2\n\t"
+        "pxor %%xmm10, %%xmm11\n\t"
+        "pxor %%xmm12, %%xmm1\n\t"
+        "pxor %%xmm14, %%xmm5\n\t"
+        "movdqa %%xmm14, 80(%[s])\n\t"
+        "pshufd $0x4e, %%xmm4, %%xmm14\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "pshufd $0x4e, %%xmm13, %%xmm14\n\t"
+        "pxor %%xmm14, %%xmm6\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        "pxor %%xmm5, %%xmm6\n\t"
+        "pshufd $0x4e, %%xmm15, %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm7\n\t"
+        "pxor %%xmm13, %%xmm7\n\t"
+        "pshufd $0x4e, %%xmm0, %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm8\n\t"
+        "pxor %%xmm15, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"
+        "pshufd $0x4e, %%xmm2, %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm9\n\t"
+        "pxor %%xmm0, %%xmm9\n\t"
+        "pxor %%xmm5, %%xmm9\n\t"
+        "pshufd $0x4e, %%xmm11, %%xmm0\n\t"
+        "pxor %%xmm0, %%xmm10\n\t"
+        "pxor %%xmm2, %%xmm10\n\t"
+        "pshufd $0x4e, %%xmm1, %%xmm0\n\t"
+        "pxor %%xmm0, %%xmm12\n\t"
+        "pxor %%xmm11, %%xmm12\n\t"
+        "pshufd $0x4e, %%xmm5, %%xmm0\n\t"
+        "pxor 80(%[s]), %%xmm0\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "movdqu 0(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm6\n\t"
+        "movdqu 32(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm7\n\t"
+        "movdqu 48(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "movdqu 64(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"
+        "movdqu 80(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm10\n\t"
+        "movdqu 96(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm12\n\t"
+        "movdqu 112(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "movdqa %%xmm6, %%xmm1\n\t"
+        "movdqa %%xmm7, %%xmm2\n\t"
+        "movdqa %%xmm9, %%xmm4\n\t"
+        "movdqa %%xmm10, %%xmm5\n\t"
+        "movdqa %%xmm12, %%xmm6\n\t"
+        "movdqa %%xmm0, %%xmm7\n\t"
+        "movdqa %%xmm3, %%xmm0\n\t"
+        "movdqa %%xmm8, %%xmm3\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "movdqa %%xmm4, %%xmm8\n\t"
+        "pxor %%xmm2, %%xmm8\n\t"                       /* y14 */
+        "movdqa %%xmm7, %%xmm9\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"                       /* y13 */
+        "movdqa %%xmm7, %%xmm10\n\t"
+        "pxor %%xmm4, %%xmm10\n\t"                      /* y9 */
+        "movdqa %%xmm7, %%xmm11\n\t"
+        "pxor %%xmm2, %%xmm11\n\t"                      /* y8 */
+        "pxor %%xmm6, %%xmm5\n\t"                       /* t0 */
+        "movdqa %%xmm5, %%xmm12\n\t"
+        "pxor %%xmm0, %%xmm12\n\t"                      /* y1 */
+        "pxor %%xmm12, %%xmm4\n\t"                      /* y4 */
+        "movdqa %%xmm9, %%xmm13\n\t"
+        "pxor %%xmm8, %%xmm13\n\t"                      /* y12 */
+        "movdqa %%xmm12, %%xmm14\n\t"
+        "pxor %%xmm7, %%xmm14\n\t"                      /* y2 */
+        "pxor %%xmm12, %%xmm1\n\t"                      /* y5 */
+        "movdqa %%xmm1, %%xmm15\n\t"
+        "pxor %%xmm11, %%xmm15\n\t"                     /* y3 */
+        "pxor %%xmm13, %%xmm3\n\t"                      /* t1 */
+        "pxor %%xmm3, %%xmm2\n\t"                       /* y15 */
+        "pxor %%xmm6, %%xmm3\n\t"                       /* y20 */
+        "movdqa %%xmm2, %%xmm6\n\t"
+        "pxor %%xmm0, %%xmm6\n\t"                       /* y6 */
+        "movdqa %%xmm8, 0(%[s])\n\t"
+        "movdqa %%xmm2, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"                       /* y10 */
+        "movdqa %%xmm14, 16(%[s])\n\t"
+        "movdqa %%xmm3, %%xmm14\n\t"
+        "pxor %%xmm10, %%xmm14\n\t"                     /* y11 */
+        "movdqa %%xmm3, 32(%[s])\n\t"
+        "movdqa %%xmm0, %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"                      /* y7 */
+        "movdqa %%xmm10, 48(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm10\n\t"
+        "pxor %%xmm14, %%xmm10\n\t"                     /* y17 */
+        "movdqa %%xmm10, 64(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm10\n\t"
+        "pxor %%xmm11, %%xmm10\n\t"                     /* y19 */
+        "pxor %%xmm14, %%xmm5\n\t"                      /* y16 */
+        "movdqa %%xmm10, 80(%[s])\n\t"
+        "movdqa %%xmm9, %%xmm10\n\t"
+        "pxor %%xmm5, %%xmm10\n\t"                      /* y21 */
+        "pxor %%xmm5, %%xmm7\n\t"                       /* y18 */
+        "movdqa %%xmm7, 96(%[s])\n\t"
+        "movdqa %%xmm13, %%xmm7\n\t"
+        "pand %%xmm2, %%xmm7\n\t"                       /* t2 */
+        "movdqa %%xmm13, 112(%[s])\n\t"
+        "movdqa %%xmm15, %%xmm13\n\t"
+        "pand %%xmm6, %%xmm13\n\t"                      /* t3 */
+        "pxor %%xmm7, %%xmm13\n\t"                      /* t4 */
+        "movdqa %%xmm15, 128(%[s])\n\t"
+        "movdqa %%xmm4, %%xmm15\n\t"
+        "pand %%xmm0, %%xmm15\n\t"                      /* t5 */
+        "pxor %%xmm7, %%xmm15\n\t"                      /* t6 */
+        "movdqa %%xmm9, %%xmm7\n\t"
+        "pand %%xmm5, %%xmm7\n\t"                       /* t7 */
+        "movdqa %%xmm9, 144(%[s])\n\t"
+        "movdqa %%xmm1, %%xmm9\n\t"
+        "pand %%xmm12, %%xmm9\n\t"                      /* t8 */
+        "pxor %%xmm7, %%xmm9\n\t"                       /* t9 */
+        "movdqa %%xmm1, 160(%[s])\n\t"
+        "movdqa 16(%[s]), %%xmm1\n\t"
+        "pand %%xmm3, %%xmm1\n\t"                       /* t10 */
+        "pxor %%xmm7, %%xmm1\n\t"                       /* t11 */
+        "movdqa 48(%[s]), %%xmm7\n\t"
+        "pand %%xmm14, %%xmm7\n\t"                      /* t12 */
+        "movdqa %%xmm4, 176(%[s])\n\t"
+        "movdqa 0(%[s]), %%xmm4\n\t"
+        "pand 64(%[s]), %%xmm4\n\t"                     /* t13 */
+        "pxor %%xmm7, %%xmm4\n\t"                       /* t14 */
+        "movdqa %%xmm14, 192(%[s])\n\t"
+        "movdqa %%xmm11, %%xmm14\n\t"
+        "pand %%xmm8, %%xmm14\n\t"                      /* t15 */
+        "pxor %%xmm7, %%xmm14\n\t"                      /* t16 */
+        "pxor %%xmm4, %%xmm13\n\t"                      /* t17 */
+        "pxor %%xmm14, %%xmm15\n\t"                     /* t18 */
+        "pxor %%xmm4, %%xmm9\n\t"                       /* t19 */
+        "pxor %%xmm14, %%xmm1\n\t"                      /* t20 */
+        "pxor 32(%[s]), %%xmm13\n\t"                    /* t21 */
+        "pxor 80(%[s]), %%xmm15\n\t"                    /* t22 */
+        "pxor %%xmm10, %%xmm9\n\t"                      /* t23 */
+        "pxor 96(%[s]), %%xmm1\n\t"                     /* t24 */
+        "movdqa %%xmm13, %%xmm4\n\t"
+        "pxor %%xmm15, %%xmm4\n\t"                      /* t25 */
+        "pand %%xmm9, %%xmm13\n\t"                      /* t26 */
+        "movdqa %%xmm1, %%xmm7\n\t"
+        "pxor %%xmm13, %%xmm7\n\t"                      /* t27 */
+        "movdqa %%xmm4, %%xmm10\n\t"
+        "pand %%xmm7, %%xmm10\n\t"                      /* t28 */
+        "pxor %%xmm15, %%xmm10\n\t"                     /* t29 */
+        "movdqa %%xmm9, %%xmm14\n\t"
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t30 */
+        "pxor %%xmm13, %%xmm15\n\t"                     /* t31 */
+        "pand %%xmm14, %%xmm15\n\t"                     /* t32 */
+        "pxor %%xmm1, %%xmm15\n\t"                      /* t33 */
+        "pxor %%xmm15, %%xmm9\n\t"                      /* t34 */
+        "movdqa %%xmm7, %%xmm13\n\t"
+        "pxor %%xmm15, %%xmm13\n\t"                     /* t35 */
+        "pand %%xmm13, %%xmm1\n\t"                      /* t36 */
+        "pxor %%xmm1, %%xmm9\n\t"                       /* t37 */
+        "pxor %%xmm1, %%xmm7\n\t"                       /* t38 */
+        "pand %%xmm10, %%xmm7\n\t"                      /* t39 */
+        "pxor %%xmm7, %%xmm4\n\t"                       /* t40 */
+        "movdqa %%xmm4, %%xmm1\n\t"
+        "pxor %%xmm9, %%xmm1\n\t"                       /* t41 */
+        "movdqa %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm15, %%xmm7\n\t"                      /* t42 */
+        "movdqa %%xmm10, %%xmm13\n\t"
+        "pxor %%xmm4, %%xmm13\n\t"                      /* t43 */
+        "movdqa %%xmm15, %%xmm14\n\t"
+        "pxor %%xmm9, %%xmm14\n\t"                      /* t44 */
+        "movdqa %%xmm11, 96(%[s])\n\t"
+        "movdqa %%xmm7, %%xmm11\n\t"
+        "pxor %%xmm1, %%xmm11\n\t"                      /* t45 */
+        "pand %%xmm14, %%xmm2\n\t"                      /* z0 */
+        "pand %%xmm9, %%xmm6\n\t"                       /* z1 */
+        "pand %%xmm15, %%xmm0\n\t"                      /* z2 */
+        "pand %%xmm13, %%xmm5\n\t"                      /* z3 */
+        "pand %%xmm4, %%xmm12\n\t"                      /* z4 */
+        "pand %%xmm10, %%xmm3\n\t"                      /* z5 */
+        "movdqa %%xmm6, 80(%[s])\n\t"
+        "movdqa %%xmm7, %%xmm6\n\t"
+        "pand 192(%[s]), %%xmm6\n\t"                    /* z6 */
+        "movdqa %%xmm12, 192(%[s])\n\t"
+        "movdqa %%xmm11, %%xmm12\n\t"
+        "pand 64(%[s]), %%xmm12\n\t"                    /* z7 */
+        "pand %%xmm1, %%xmm8\n\t"                       /* z8 */
+        "pand 112(%[s]), %%xmm14\n\t"                   /* z9 */
+        "pand 128(%[s]), %%xmm9\n\t"                    /* z10 */
+        "pand 176(%[s]), %%xmm15\n\t"                   /* z11 */
+        "pand 144(%[s]), %%xmm13\n\t"                   /* z12 */
+        "pand 160(%[s]), %%xmm4\n\t"                    /* z13 */
+        "pand 16(%[s]), %%xmm10\n\t"                    /* z14 */
+        "pand 48(%[s]), %%xmm7\n\t"                     /* z15 */
+        "pand 0(%[s]), %%xmm11\n\t"                     /* z16 */
+        "pand 96(%[s]), %%xmm1\n\t"                     /* z17 */
+        "pxor %%xmm11, %%xmm7\n\t"                      /* t46 */
+        "pxor %%xmm9, %%xmm15\n\t"                      /* t47 */
+        "pxor %%xmm3, %%xmm4\n\t"                       /* t48 */
+        "pxor %%xmm9, %%xmm14\n\t"                      /* t49 */
+        "movdqa %%xmm0, %%xmm9\n\t"
+        "pxor %%xmm13, %%xmm9\n\t"                      /* t50 */
+        "pxor %%xmm3, %%xmm0\n\t"                       /* t51 */
+        "pxor %%xmm12, %%xmm8\n\t"                      /* t52 */
+        "pxor %%xmm5, %%xmm2\n\t"                       /* t53 */
+        "pxor %%xmm12, %%xmm6\n\t"                      /* t54 */
+        "pxor %%xmm1, %%xmm11\n\t"                      /* t55 */
+        "pxor %%xmm4, %%xmm13\n\t"                      /* t56 */
+        "pxor %%xmm2, %%xmm9\n\t"                       /* t57 */
+        "movdqa 192(%[s]), %%xmm1\n\t"
+        "pxor %%xmm7, %%xmm1\n\t"                       /* t58 */
+        "pxor %%xmm6, %%xmm5\n\t"                       /* t59 */
+        "pxor %%xmm9, %%xmm7\n\t"                       /* t60 */
+        "pxor %%xmm9, %%xmm10\n\t"                      /* t61 */
+        "pxor %%xmm1, %%xmm8\n\t"                       /* t62 */
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t63 */
+        "movdqa 192(%[s]), %%xmm1\n\t"
+        "pxor %%xmm5, %%xmm1\n\t"                       /* t64 */
+        "pxor %%xmm8, %%xmm10\n\t"                      /* t65 */
+        "movdqa 80(%[s]), %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"                      /* t66 */
+        "pxor %%xmm14, %%xmm5\n\t"                      /* s0 */
+        "pxor %%xmm8, %%xmm13\n\t"                      /* s6 */
+        "pxor %%xmm7, %%xmm4\n\t"                       /* s7 */
+        "movdqa %%xmm1, %%xmm6\n\t"
+        "pxor %%xmm10, %%xmm6\n\t"                      /* t67 */
+        "pxor %%xmm3, %%xmm2\n\t"                       /* s3 */
+        "pxor %%xmm3, %%xmm0\n\t"                       /* s4 */
+        "pxor %%xmm10, %%xmm15\n\t"                     /* s5 */
+        "pxor %%xmm2, %%xmm1\n\t"                       /* s1 */
+        "pxor %%xmm6, %%xmm11\n\t"                      /* s2 */
+        "pshufb 16(%[c]), %%xmm4\n\t"
+        "pshufb 16(%[c]), %%xmm13\n\t"
+        "pshufb 16(%[c]), %%xmm15\n\t"
+        "pshufb 16(%[c]), %%xmm0\n\t"
+        "pshufb 16(%[c]), %%xmm2\n\t"
+        "pshufb 16(%[c]), %%xmm11\n\t"
+        "pshufb 16(%[c]), %%xmm1\n\t"
+        "pshufb 16(%[c]), %%xmm5\n\t"
+        "movdqu 128(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm4\n\t"
+        "movdqu 144(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm13\n\t"
+        "movdqu 160(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm15\n\t"
+        "movdqu 176(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm0\n\t"
+        "movdqu 192(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm2\n\t"
+        "movdqu 208(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm11\n\t"
+        "movdqu 224(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"
+        "movdqu 240(%[rk]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        "movdqa %%xmm4, %%xmm3\n\t"
+        "psrlq $1, %%xmm3\n\t"
+        "pxor %%xmm13, %%xmm3\n\t"
+        "pand 48(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm13\n\t"
+        "psllq $1, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm4\n\t"
+        "movdqa %%xmm15, %%xmm3\n\t"
+        "psrlq $1, %%xmm3\n\t"
+        "pxor %%xmm0, %%xmm3\n\t"
+        "pand 48(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm0\n\t"
+        "psllq $1, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm15\n\t"
+        "movdqa %%xmm2, %%xmm3\n\t"
+        "psrlq $1, %%xmm3\n\t"
+        "pxor %%xmm11, %%xmm3\n\t"
+        "pand 48(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm11\n\t"
+        "psllq $1, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm2\n\t"
+        "movdqa %%xmm1, %%xmm3\n\t"
+        "psrlq $1, %%xmm3\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "pand 48(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        "psllq $1, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm4, %%xmm3\n\t"
+        "psrlq $2, %%xmm3\n\t"
+        "pxor %%xmm15, %%xmm3\n\t"
+        "pand 64(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm15\n\t"
+        "psllq $2, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm4\n\t"
+        "movdqa %%xmm13, %%xmm3\n\t"
+        "psrlq $2, %%xmm3\n\t"
+        "pxor %%xmm0, %%xmm3\n\t"
+        "pand 64(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm0\n\t"
+        "psllq $2, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm13\n\t"
+        "movdqa %%xmm2, %%xmm3\n\t"
+        "psrlq $2, %%xmm3\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "pand 64(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"
+        "psllq $2, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm2\n\t"
+        "movdqa %%xmm11, %%xmm3\n\t"
+        "psrlq $2, %%xmm3\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "pand 64(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        "psllq $2, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm11\n\t"
+        "movdqa %%xmm4, %%xmm3\n\t"
+        "psrlq $4, %%xmm3\n\t"
+        "pxor %%xmm2, %%xmm3\n\t"
+        "pand 80(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm2\n\t"
+        "psllq $4, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm4\n\t"
+        "movdqa %%xmm13, %%xmm3\n\t"
+        "psrlq $4, %%xmm3\n\t"
+        "pxor %%xmm11, %%xmm3\n\t"
+        "pand 80(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm11\n\t"
+        "psllq $4, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm13\n\t"
+        "movdqa %%xmm15, %%xmm3\n\t"
+        "psrlq $4, %%xmm3\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "pand 80(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"
+        "psllq $4, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm15\n\t"
+        "movdqa %%xmm0, %%xmm3\n\t"
+        "psrlq $4, %%xmm3\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        "pand 80(%[c]), %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        "psllq $4, %%xmm3\n\t"
+        "pxor %%xmm3, %%xmm0\n\t"
+        "pshufb 0(%[c]), %%xmm4\n\t"
+        "movdqu %%xmm4, 0(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm13\n\t"
+        "movdqu %%xmm13, 16(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm15\n\t"
+        "movdqu %%xmm15, 32(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm0\n\t"
+        "movdqu %%xmm0, 48(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm2\n\t"
+        "movdqu %%xmm2, 64(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm11\n\t"
+        "movdqu %%xmm11, 80(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm1\n\t"
+        "movdqu %%xmm1, 96(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm5\n\t"
+        "movdqu %%xmm5, 112(%[out])\n\t"
+        : [rk] "+r" (sk), [n] "+r" (n)
+        : [in] "r" (in), [out] "r" (out), [c] "r" (&moto_aes_bs_x86_consts),
+          [s] "r" (s)
+        : "cc", "memory");
+}
+
+static void moto_aes_bs_ssse3_decrypt8(const u8 *sk, unsigned long n, u8 *out,
+        const u8 *in, u8 *s)
+{
+    asm volatile(
+        "movdqu 0(%[in]), %%xmm0\n\t"
+        "pshufb 0(%[c]), %%xmm0\n\t"
+        "movdqu 16(%[in]), %%xmm1\n\t"
+        "pshufb 0(%[c]), %%xmm1\n\t"
+        "movdqu 32(%[in]), %%xmm2\n\t"
+        "pshufb 0(%[c]), %%xmm2\n\t"
+        "movdqu 48(%[in]), %%xmm3\n\t"
+        "pshufb 0(%[c]), %%xmm3\n\t"
+        "movdqu 64(%[in]), %%xmm4\n\t"
+        "pshufb 0(%[c]), %%xmm4\n\t"
+        "movdqu 80(%[in]), %%xmm5\n\t"
+        "pshufb 0(%[c]), %%xmm5\n\t"
+        "movdqu 96(%[in]), %%xmm6\n\t"
+        "pshufb 0(%[c]), %%xmm6\n\t"
+        "movdqu 112(%[in]), %%xmm7\n\t"
+        "pshufb 0(%[c]), %%xmm7\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm2, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm3, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "movdqa %%xmm4, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "movdqa %%xmm6, %%xmm8\n\t"
+        "psrlq $1, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm8\n\t"
+        "pand 48(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "psllq $1, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm2, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm3, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "movdqa %%xmm4, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "movdqa %%xmm5, %%xmm8\n\t"
+        "psrlq $2, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm8\n\t"
+        "pand 64(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "psllq $2, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm4, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm5, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "movdqa %%xmm2, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "movdqa %%xmm3, %%xmm8\n\t"
+        "psrlq $4, %%xmm8\n\t"
+        "pxor %%xmm7, %%xmm8\n\t"
+        "pand 80(%[c]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "psllq $4, %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "movdqu 0(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm0\n\t"
+        "movdqu 16(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "movdqu 32(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm2\n\t"
+        "movdqu 48(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"
+        "movdqu 64(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm4\n\t"
+        "movdqu 80(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm5\n\t"
+        "movdqu 96(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm6\n\t"
+        "movdqu 112(%[rk]), %%xmm8\n\t"
+        "pxor %%xmm8, %%xmm7\n\t"
+        "1:\n\t"
+        "sub $128, %[rk]\n\t"
+        "pshufb 32(%[c]), %%xmm0\n\t"
+        "pshufb 32(%[c]), %%xmm1\n\t"
+        "pshufb 32(%[c]), %%xmm2\n\t"
+        "pshufb 32(%[c]), %%xmm3\n\t"
+        "pshufb 32(%[c]), %%xmm4\n\t"
+        "pshufb 32(%[c]), %%xmm5\n\t"
+        "pshufb 32(%[c]), %%xmm6\n\t"
+        "pshufb 32(%[c]), %%xmm7\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "pxor %%xmm4, %%xmm8\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "movdqa %%xmm0, %%xmm9\n\t"
+        "pxor %%xmm3, %%xmm9\n\t"
+        "pxor %%xmm5, %%xmm9\n\t"
+        "movdqa %%xmm7, %%xmm10\n\t"
+        "pxor %%xmm2, %%xmm10\n\t"
+        "pxor %%xmm4, %%xmm10\n\t"
+        "movdqa %%xmm6, %%xmm11\n\t"
+        "pxor %%xmm1, %%xmm11\n\t"
+        "pxor %%xmm3, %%xmm11\n\t"
+        "movdqa %%xmm5, %%xmm12\n\t"
+        "pxor %%xmm0, %%xmm12\n\t"
+        "pxor %%xmm2, %%xmm12\n\t"
+        "pxor %%xmm7, %%xmm4\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "pxor %%xmm6, %%xmm3\n\t"
+        "pxor %%xmm0, %%xmm3\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "pxor %%xmm7, %%xmm2\n\t"
+        "movdqa %%xmm11, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"                       /* y14 */
+        "movdqa %%xmm8, %%xmm1\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"                       /* y13 */
+        "movdqa %%xmm8, %%xmm5\n\t"
+        "pxor %%xmm11, %%xmm5\n\t"                      /* y9 */
+        "movdqa %%xmm8, %%xmm6\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"                       /* y8 */
+        "pxor %%xmm9, %%xmm10\n\t"                      /* t0 */
+        "movdqa %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm2, %%xmm7\n\t"                       /* y1 */
+        "pxor %%xmm7, %%xmm11\n\t"                      /* y4 */
+        "movdqa %%xmm1, %%xmm13\n\t"
+        "pxor %%xmm0, %%xmm13\n\t"                      /* y12 */
+        "movdqa %%xmm7, %%xmm14\n\t"
+        "pxor %%xmm8, %%xmm14\n\t"                      /* y2 */
+        "pxor %%xmm7, %%xmm3\n\t"                       /* y5 */
+        "movdqa %%xmm3, %%xmm15\n\t"
+        "pxor %%xmm6, %%xmm15\n\t"                      /* y3 */
+        "pxor %%xmm13, %%xmm12\n\t"                     /* t1 */
+        "pxor %%xmm12, %%xmm4\n\t"                      /* y15 */
+        "pxor %%xmm9, %%xmm12\n\t"                      /* y20 */
+        "movdqa %%xmm4, %%xmm9\n\t"
+        "pxor %%xmm2, %%xmm9\n\t"                       /* y6 */
+        "movdqa %%xmm0, 0(%[s])\n\t"
+        "movdqa %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm10, %%xmm0\n\t"                      /* y10 */
+        "movdqa %%xmm14, 16(%[s])\n\t"
+        "movdqa %%xmm12, %%xmm14\n\t"
+        "pxor %%xmm5, %%xmm14\n\t"                      /* y11 */
+        "movdqa %%xmm12, 32(%[s])\n\t"
+        "movdqa %%xmm2, %%xmm12\n\t"
+        "pxor %%xmm14, %%xmm12\n\t"                     /* y7 */
+        "movdqa %%xmm5, 48(%[s])\n\t"
+        "movdqa %%xmm0, %%xmm5\n\t"
+        "pxor %%xmm14, %%xmm5\n\t"                      /* y17 */
+        "movdqa %%xmm5, 64(%[s])\n\t"
+        "movdqa %%xmm0, %%xmm5\n\t"
+        "pxor %%xmm6, %%xmm5\n\t"                       /* y19 */
+        "pxor %%xmm14, %%xmm10\n\t"                     /* y16 */
+        "movdqa %%xmm5, 80(%[s])\n\t"
+        "movdqa %%xmm1, %%xmm5\n\t"
+        "pxor %%xmm10, %%xmm5\n\t"                      /* y21 */
+        "pxor %%xmm10, %%xmm8\n\t"                      /* y18 */
+        "movdqa %%xmm8, 96(%[s])\n\t"
+        "movdqa %%xmm13, %%xmm8\n\t"
+        "pand %%xmm4, %%xmm8\n\t"                       /* t2 */
+        "movdqa %%xmm13, 112(%[s])\n\t"
+        "movdqa %%xmm15, %%xmm13\n\t"
+        "pand %%xmm9, %%xmm13\n\t"                      /* t3 */
+        "pxor %%xmm8, %%xmm13\n\t"                      /* t4 */
+        "movdqa %%xmm15, 128(%[s])\n\t"
+        "movdqa %%xmm11, %%xmm15\n\t"
+        "pand %%xmm2, %%xmm15\n\t"                      /* t5 */
+        "pxor %%xmm8, %%xmm15\n\t"                      /* t6 */
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "pand %%xmm10, %%xmm8\n\t"                      /* t7 */
+        "movdqa %%xmm1, 144(%[s])\n\t"
+        "movdqa %%xmm3, %%xmm1\n\t"
+        "pand %%xmm7, %%xmm1\n\t"                       /* t8 */
+        "pxor %%xmm8, %%xmm1\n\t"                       /* t9 */
+        "movdqa %%xmm3, 160(%[s])\n\t"
+        "movdqa 16(%[s]), %%xmm3\n\t"
+        "pand %%xmm12, %%xmm3\n\t"                      /* t10 */
+        "pxor %%xmm8, %%xmm3\n\t"                       /* t11 */
+        "movdqa 48(%[s]), %%xmm8\n\t"
+        "pand %%xmm14, %%xmm8\n\t"                      /* t12 */
+        "movdqa %%xmm11, 176(%[s])\n\t"
+        "movdqa 0(%[s]), %%xmm11\n\t"
+        "pand 64(%[s]), %%xmm11\n\t"                    /* t13 */
+        "pxor %%xmm8, %%xmm11\n\t"                      /* t14 */
+        "movdqa %%xmm14, 192(%[s])\n\t"
+        "movdqa %%xmm6, %%xmm14\n\t"
+        "pand %%xmm0, %%xmm14\n\t"                      /* t15 */
+        "pxor %%xmm8, %%xmm14\n\t"                      /* t16 */
+        "pxor %%xmm11, %%xmm13\n\t"                     /* t17 */
+        "pxor %%xmm14, %%xmm15\n\t"                     /* t18 */
+        "pxor %%xmm11, %%xmm1\n\t"                      /* t19 */
+        "pxor %%xmm14, %%xmm3\n\t"                      /* t20 */
+        "pxor 32(%[s]), %%xmm13\n\t"                    /* t21 */
+        "pxor 80(%[s]), %%xmm15\n\t"                    /* t22 */
+        "pxor %%xmm5, %%xmm1\n\t"                       /* t23 */
+        "pxor 96(%[s]), %%xmm3\n\t"                     /* t24 */
+        "movdqa %%xmm13, %%xmm5\n\t"
+        "pxor %%xmm15, %%xmm5\n\t"                      /* t25 */
+        "pand %%xmm1, %%xmm13\n\t"                      /* t26 */
+        "movdqa %%xmm3, %%xmm8\n\t"
+        "pxor %%xmm13, %%xmm8\n\t"                      /* t27 */
+        "movdqa %%xmm5, %%xmm11\n\t"
+        "pand %%xmm8, %%xmm11\n\t"                      /* t28 */
+        "pxor %%xmm15, %%xmm11\n\t"                     /* t29 */
+        "movdqa %%xmm1, %%xmm14\n\t"
+        "pxor %%xmm3, %%xmm14\n\t"                      /* t30 */
+        "pxor %%xmm13, %%xmm15\n\t"                     /* t31 */
+        "pand %%xmm14, %%xmm15\n\t"                     /* t32 */
+        "pxor %%xmm3, %%xmm15\n\t"                      /* t33 */
+        "pxor %%xmm15, %%xmm1\n\t"                      /* t34 */
+        "movdqa %%xmm8, %%xmm13\n\t"
+        "pxor %%xmm15, %%xmm13\n\t"                     /* t35 */
+        "pand %%xmm13, %%xmm3\n\t"                      /* t36 */
+        "pxor %%xmm3, %%xmm1\n\t"                       /* t37 */
+        "pxor %%xmm3, %%xmm8\n\t"                       /* t38 */
+        "pand %%xmm11, %%xmm8\n\t"                      /* t39 */
+        "pxor %%xmm8, %%xmm5\n\t"                       /* t40 */
+        "movdqa %%xmm5, %%xmm3\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"                       /* t41 */
+        "movdqa %%xmm11, %%xmm8\n\t"
+        "pxor %%xmm15, %%xmm8\n\t"                      /* t42 */
+        "movdqa %%xmm11, %%xmm13\n\t"
+        "pxor %%xmm5, %%xmm13\n\t"                      /* t43 */
+        "movdqa %%xmm15, %%xmm14\n\t"
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t44 */
+        "movdqa %%xmm6, 96(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm6\n\t"
+        "pxor %%xmm3, %%xmm6\n\t"                       /* t45 */
+        "pand %%xmm14, %%xmm4\n\t"                      /* z0 */
+        "pand %%xmm1, %%xmm9\n\t"                       /* z1 */
+        "pand %%xmm15, %%xmm2\n\t"                      /* z2 */
+        "pand %%xmm13, %%xmm10\n\t"                     /* z3 */
+        "pand %%xmm5, %%xmm7\n\t"                       /* z4 */
+        "pand %%xmm11, %%xmm12\n\t"                     /* z5 */
+        "movdqa %%xmm9, 80(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm9\n\t"
+        "pand 192(%[s]), %%xmm9\n\t"                    /* z6 */
+        "movdqa %%xmm7, 192(%[s])\n\t"
+        "movdqa %%xmm6, %%xmm7\n\t"
+        "pand 64(%[s]), %%xmm7\n\t"                     /* z7 */
+        "pand %%xmm3, %%xmm0\n\t"                       /* z8 */
+        "pand 112(%[s]), %%xmm14\n\t"                   /* z9 */
+        "pand 128(%[s]), %%xmm1\n\t"                    /* z10 */
+        "pand 176(%[s]), %%xmm15\n\t"                   /* z11 */
+        "pand 144(%[s]), %%xmm13\n\t"                   /* z12 */
+        "pand 160(%[s]), %%xmm5\n\t"                    /* z13 */
+        "pand 16(%[s]), %%xmm11\n\t"                    /* z14 */
+        "pand 48(%[s]), %%xmm8\n\t"                     /* z15 */
+        "pand 0(%[s]), %%xmm6\n\t"                      /* z16 */
+        "pand 96(%[s]), %%xmm3\n\t"                     /* z17 */
+        "pxor %%xmm6, %%xmm8\n\t"                       /* t46 */
+        "pxor %%xmm1, %%xmm15\n\t"                      /* t47 */
+        "pxor %%xmm12, %%xmm5\n\t"                      /* t48 */
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t49 */
+        "movdqa %%xmm2, %%xmm1\n\t"
+        "pxor %%xmm13, %%xmm1\n\t"                      /* t50 */
+        "pxor %%xmm12, %%xmm2\n\t"                      /* t51 */
+        "pxor %%xmm7, %%xmm0\n\t"                       /* t52 */
+        "pxor %%xmm10, %%xmm4\n\t"                      /* t53 */
+        "pxor %%xmm7, %%xmm9\n\t"                       /* t54 */
+        "pxor %%xmm3, %%xmm6\n\t"                       /* t55 */
+        "pxor %%xmm5, %%xmm13\n\t"                      /* t56 */
+        "pxor %%xmm4, %%xmm1\n\t"                       /* t57 */
+        "movdqa 192(%[s]), %%xmm3\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"                       /* t58 */
+        "pxor %%xmm9, %%xmm10\n\t"                      /* t59 */
+        "pxor %%xmm1, %%xmm8\n\t"                       /* t60 */
+        "pxor %%xmm1, %%xmm11\n\t"                      /* t61 */
+        "pxor %%xmm3, %%xmm0\n\t"                       /* t62 */
+        "pxor %%xmm3, %%xmm14\n\t"                      /* t63 */
+        "movdqa 192(%[s]), %%xmm1\n\t"
+        "pxor %%xmm10, %%xmm1\n\t"                      /* t64 */
+        "pxor %%xmm0, %%xmm11\n\t"                      /* t65 */
+        "movdqa 80(%[s]), %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"                      /* t66 */
+        "pxor %%xmm14, %%xmm10\n\t"                     /* s0 */
+        "pxor %%xmm0, %%xmm13\n\t"                      /* s6 */
+        "pxor %%xmm8, %%xmm5\n\t"                       /* s7 */
+        "movdqa %%xmm1, %%xmm0\n\t"
+        "pxor %%xmm11, %%xmm0\n\t"                      /* t67 */
+        "pxor %%xmm3, %%xmm4\n\t"                       /* s3 */
+        "pxor %%xmm3, %%xmm2\n\t"                       /* s4 */
+        "pxor %%xmm11, %%xmm15\n\t"                     /* s5 */
+        "pxor %%xmm4, %%xmm1\n\t"                       /* s1 */
+        "pxor %%xmm0, %%xmm6\n\t"                       /* s2 */
+        "movdqa %%xmm13, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "movdqa %%xmm5, %%xmm3\n\t"
+        "pxor %%xmm2, %%xmm3\n\t"
+        "pxor %%xmm6, %%xmm3\n\t"
+        "movdqa %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm15, %%xmm7\n\t"
+        "pxor %%xmm4, %%xmm7\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "pxor %%xmm13, %%xmm8\n\t"
+        "pxor %%xmm2, %%xmm8\n\t"
+        "movdqa %%xmm6, %%xmm9\n\t"
+        "pxor %%xmm5, %%xmm9\n\t"
+        "pxor %%xmm15, %%xmm9\n\t"
+        "pxor %%xmm10, %%xmm4\n\t"
+        "pxor %%xmm13, %%xmm4\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "pxor %%xmm6, %%xmm15\n\t"
+        "pxor %%xmm10, %%xmm15\n\t"
+        "movdqu 0(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm15\n\t"
+        "movdqu 16(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "movdqu 32(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "movdqu 48(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"
+        "movdqu 64(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "movdqu 80(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm7\n\t"
+        "movdqu 96(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "movdqu 112(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "pshufd $0x4e, %%xmm15, %%xmm1\n\t"
+        "pxor %%xmm15, %%xmm1\n\t"
+        "pshufd $0x4e, %%xmm2, %%xmm5\n\t"
+        "pxor %%xmm2, %%xmm5\n\t"
+        "pshufd $0x4e, %%xmm4, %%xmm6\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        "pshufd $0x4e, %%xmm9, %%xmm10\n\t"
+        "pxor %%xmm9, %%xmm10\n\t"
+        "pshufd $0x4e, %%xmm8, %%xmm11\n\t"
+        "pxor %%xmm8, %%xmm11\n\t"
+        "pshufd $0x4e, %%xmm7, %%xmm12\n\t"
+        "pxor %%xmm7, %%xmm12\n\t"
+        "pshufd $0x4e, %%xmm3, %%xmm13\n\t"
+        "pxor %%xmm3, %%xmm13\n\t"
+        "pshufd $0x4e, %%xmm0, %%xmm14\n\t"
+        "pxor %%xmm0, %%xmm14\n\t"
+        "pxor %%xmm13, %%xmm15\n\t"
+        "pxor %%xmm14, %%xmm2\n\t"
+        "pxor %%xmm13, %%xmm2\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "pxor %%xmm14, %%xmm4\n\t"
+        "pxor %%xmm5, %%xmm9\n\t"
+        "pxor %%xmm13, %%xmm9\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "pxor %%xmm14, %%xmm8\n\t"
+        "pxor %%xmm13, %%xmm8\n\t"
+        "pxor %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm14, %%xmm7\n\t"
+        "pxor %%xmm11, %%xmm3\n\t"
+        "pxor %%xmm12, %%xmm0\n\t"
+        "pshufd $0x39, %%xmm15, %%xmm1\n\t"
+        "pshufd $0x39, %%xmm2, %%xmm5\n\t"
+        "pshufd $0x39, %%xmm4, %%xmm6\n\t"
+        "pshufd $0x39, %%xmm9, %%xmm10\n\t"
+        "pshufd $0x39, %%xmm8, %%xmm11\n\t"
+        "pshufd $0x39, %%xmm7, %%xmm12\n\t"
+        "pshufd $0x39, %%xmm3, %%xmm13\n\t"
+        "pshufd $0x39, %%xmm0, %%xmm14\n\t"
+        "pxor %%xmm1, %%xmm15\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "pxor %%xmm6, %%xmm4\n\t"
+        "pxor %%xmm10, %%xmm9\n\t"
+        "pxor %%xmm11, %%xmm8\n\t"
+        "pxor %%xmm12, %%xmm7\n\t"
+        "pxor %%xmm13, %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm0\n\t"
+        "movdqa %%xmm14, 80(%[s])\n\t"
+        "pshufd $0x4e, %%xmm15, %%xmm14\n\t"
+        "pxor %%xmm14, %%xmm1\n\t"
+        "pxor %%xmm0, %%xmm1\n\t"
+        "pshufd $0x4e, %%xmm2, %%xmm14\n\t"
+        "pxor %%xmm14, %%xmm5\n\t"
+        "pxor %%xmm15, %%xmm5\n\t"
+        "pxor %%xmm0, %%xmm5\n\t"
+        "pshufd $0x4e, %%xmm4, %%xmm14\n\t"
+        "pxor %%xmm14, %%xmm6\n\t"
+        "pxor %%xmm2, %%xmm6\n\t"
+        "pshufd $0x4e, %%xmm9, %%xmm2\n\t"
+        "pxor %%xmm2, %%xmm10\n\t"
+        "pxor %%xmm4, %%xmm10\n\t"
+        "pxor %%xmm0, %%xmm10\n\t"
+        "pshufd $0x4e, %%xmm8, %%xmm2\n\t"
+        "pxor %%xmm2, %%xmm11\n\t"
+        "pxor %%xmm9, %%xmm11\n\t"
+        "pxor %%xmm0, %%xmm11\n\t"
+        "pshufd $0x4e, %%xmm7, %%xmm2\n\t"
+        "pxor %%xmm2, %%xmm12\n\t"
+        "pxor %%xmm8, %%xmm12\n\t"
+        "pshufd $0x4e, %%xmm3, %%xmm2\n\t"
+        "pxor %%xmm2, %%xmm13\n\t"
+        "pxor %%xmm7, %%xmm13\n\t"
+        "pshufd $0x4e, %%xmm0, %%xmm2\n\t"
+        "pxor 80(%[s]), %%xmm2\n\t"
+        "pxor %%xmm3, %%xmm2\n\t"
+        "movdqa %%xmm1, %%xmm0\n\t"
+        "movdqa %%xmm5, %%xmm1\n\t"
+        "movdqa %%xmm10, %%xmm3\n\t"
+        "movdqa %%xmm11, %%xmm4\n\t"
+        "movdqa %%xmm12, %%xmm5\n\t"
+        "movdqa %%xmm2, %%xmm7\n\t"
+        "movdqa %%xmm6, %%xmm2\n\t"
+        "movdqa %%xmm13, %%xmm6\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "pshufb 32(%[c]), %%xmm0\n\t"
+        "pshufb 32(%[c]), %%xmm1\n\t"
+        "pshufb 32(%[c]), %%xmm2\n\t"
+        "pshufb 32(%[c]), %%xmm3\n\t"
+        "pshufb 32(%[c]), %%xmm4\n\t"
+        "pshufb 32(%[c]), %%xmm5\n\t"
+        "pshufb 32(%[c]), %%xmm6\n\t"
+        "pshufb 32(%[c]), %%xmm7\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "pxor %%xmm4, %%xmm8\n\t"
+        "pxor %%xmm6, %%xmm8\n\t"
+        "movdqa %%xmm0, %%xmm9\n\t"
+        "pxor %%xmm3, %%xmm9\n\t"
+        "pxor %%xmm5, %%xmm9\n\t"
+        "movdqa %%xmm7, %%xmm10\n\t"
+        "pxor %%xmm2, %%xmm10\n\t"
+        "pxor %%xmm4, %%xmm10\n\t"
+        "movdqa %%xmm6, %%xmm11\n\t"
+        "pxor %%xmm1, %%xmm11\n\t"
+        "pxor %%xmm3, %%xmm11\n\t"
+        "movdqa %%xmm5, %%xmm12\n\t"
+        "pxor %%xmm0, %%xmm12\n\t"
+        "pxor %%xmm2, %%xmm12\n\t"
+        "pxor %%xmm7, %%xmm4\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "pxor %%xmm6, %%xmm3\n\t"
+        "pxor %%xmm0, %%xmm3\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "pxor %%xmm7, %%xmm2\n\t"
+        "movdqa %%xmm11, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"                       /* y14 */
+        "movdqa %%xmm8, %%xmm1\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"                       /* y13 */
+        "movdqa %%xmm8, %%xmm5\n\t"
+        "pxor %%xmm11, %%xmm5\n\t"                      /* y9 */
+        "movdqa %%xmm8, %%xmm6\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"                       /* y8 */
+        "pxor %%xmm9, %%xmm10\n\t"                      /* t0 */
+        "movdqa %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm2, %%xmm7\n\t"                       /* y1 */
+        "pxor %%xmm7, %%xmm11\n\t"                      /* y4 */
+        "movdqa %%xmm1, %%xmm13\n\t"
+        "pxor %%xmm0, %%xmm13\n\t"                      /* y12 */
+        "movdqa %%xmm7, %%xmm14\n\t"
+        "pxor %%xmm8, %%xmm14\n\t"                      /* y2 */
+        "pxor %%xmm7, %%xmm3\n\t"                       /* y5 */
+        "movdqa %%xmm3, %%xmm15\n\t"
+        "pxor %%xmm6, %%xmm15\n\t"                      /* y3 */
+        "pxor %%xmm13, %%xmm12\n\t"                     /* t1 */
+        "pxor %%xmm12, %%xmm4\n\t"                      /* y15 */
+        "pxor %%xmm9, %%xmm12\n\t"                      /* y20 */
+        "movdqa %%xmm4, %%xmm9\n\t"
+        "pxor %%xmm2, %%xmm9\n\t"                       /* y6 */
+        "movdqa %%xmm0, 0(%[s])\n\t"
+        "movdqa %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm10, %%xmm0\n\t"                      /* y10 */
+        "movdqa %%xmm14, 16(%[s])\n\t"
+        "movdqa %%xmm12, %%xmm14\n\t"
+        "pxor %%xmm5, %%xmm14\n\t"                      /* y11 */
+        "movdqa %%xmm12, 32(%[s])\n\t"
+        "movdqa %%xmm2, %%xmm12\n\t"
+        "pxor %%xmm14, %%xmm12\n\t"                     /* y7 */
+        "movdqa %%xmm5, 48(%[s])\n\t"
+        "movdqa %%xmm0, %%xmm5\n\t"
+        "pxor %%xmm14, %%xmm5\n\t"                      /* y17 */
+        "movdqa %%xmm5, 64(%[s])\n\t"
+        "movdqa %%xmm0, %%xmm5\n\t"
+        "pxor %%xmm6, %%xmm5\n\t"                       /* y19 */
+        "pxor %%xmm14, %%xmm10\n\t"                     /* y16 */
+        "movdqa %%xmm5, 80(%[s])\n\t"
+        "movdqa %%xmm1, %%xmm5\n\t"
+        "pxor %%xmm10, %%xmm5\n\t"                      /* y21 */
+        "pxor %%xmm10, %%xmm8\n\t"                      /* y18 */
+        "movdqa %%xmm8, 96(%[s])\n\t"
+        "movdqa %%xmm13, %%xmm8\n\t"
+        "pand %%xmm4, %%xmm8\n\t"                       /* t2 */
+        "movdqa %%xmm13, 112(%[s])\n\t"
+        "movdqa %%xmm15, %%xmm13\n\t"
+        "pand %%xmm9, %%xmm13\n\t"                      /* t3 */
+        "pxor %%xmm8, %%xmm13\n\t"                      /* t4 */
+        "movdqa %%xmm15, 128(%[s])\n\t"
+        "movdqa %%xmm11, %%xmm15\n\t"
+        "pand %%xmm2, %%xmm15\n\t"                      /* t5 */
+        "pxor %%xmm8, %%xmm15\n\t"                      /* t6 */
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "pand %%xmm10, %%xmm8\n\t"                      /* t7 */
+        "movdqa %%xmm1, 144(%[s])\n\t"
+        "movdqa %%xmm3, %%xmm1\n\t"
+        "pand %%xmm7, %%xmm1\n\t"                       /* t8 */
+        "pxor %%xmm8, %%xmm1\n\t"                       /* t9 */
+        "movdqa %%xmm3, 160(%[s])\n\t"
+        "movdqa 16(%[s]), %%xmm3\n\t"
+        "pand %%xmm12, %%xmm3\n\t"                      /* t10 */
+        "pxor %%xmm8, %%xmm3\n\t"                       /* t11 */
+        "movdqa 48(%[s]), %%xmm8\n\t"
+        "pand %%xmm14, %%xmm8\n\t"                      /* t12 */
+        "movdqa %%xmm11, 176(%[s])\n\t"
+        "movdqa 0(%[s]), %%xmm11\n\t"
+        "pand 64(%[s]), %%xmm11\n\t"                    /* t13 */
+        "pxor %%xmm8, %%xmm11\n\t"                      /* t14 */
+        "movdqa %%xmm14, 192(%[s])\n\t"
+        "movdqa %%xmm6, %%xmm14\n\t"
+        "pand %%xmm0, %%xmm14\n\t"                      /* t15 */
+        "pxor %%xmm8, %%xmm14\n\t"                      /* t16 */
+        "pxor %%xmm11, %%xmm13\n\t"                     /* t17 */
+        "pxor %%xmm14, %%xmm15\n\t"                     /* t18 */
+        "pxor %%xmm11, %%xmm1\n\t"                      /* t19 */
+        "pxor %%xmm14, %%xmm3\n\t"                      /* t20 */
+        "pxor 32(%[s]), %%xmm13\n\t"                    /* t21 */
+        "pxor 80(%[s]), %%xmm15\n\t"                    /* t22 */
+        "pxor %%xmm5, %%xmm1\n\t"                       /* t23 */
+        "pxor 96(%[s]), %%xmm3\n\t"                     /* t24 */
+        "movdqa %%xmm13, %%xmm5\n\t"
+        "pxor %%xmm15, %%xmm5\n\t"                      /* t25 */
+        "pand %%xmm1, %%xmm13\n\t"                      /* t26 */
+        "movdqa %%xmm3, %%xmm8\n\t"
+        "pxor %%xmm13, %%xmm8\n\t"                      /* t27 */
+        "movdqa %%xmm5, %%xmm11\n\t"
+        "pand %%xmm8, %%xmm11\n\t"                      /* t28 */
+        "pxor %%xmm15, %%xmm11\n\t"                     /* t29 */
+        "movdqa %%xmm1, %%xmm14\n\t"
+        "pxor %%xmm3, %%xmm14\n\t"                      /* t30 */
+        "pxor %%xmm13, %%xmm15\n\t"                     /* t31 */
+        "pand %%xmm14, %%xmm15\n\t"                     /* t32 */
+        "pxor %%xmm3, %%xmm15\n\t"                      /* t33 */
+        "pxor %%xmm15, %%xmm1\n\t"                      /* t34 */
+        "movdqa %%xmm8, %%xmm13\n\t"
+        "pxor %%xmm15, %%xmm13\n\t"                     /* t35 */
+        "pand %%xmm13, %%xmm3\n\t"                      /* t36 */
+        "pxor %%xmm3, %%xmm1\n\t"                       /* t37 */
+        "pxor %%xmm3, %%xmm8\n\t"                       /* t38 */
+        "pand %%xmm11, %%xmm8\n\t"                      /* t39 */
+        "pxor %%xmm8, %%xmm5\n\t"                       /* t40 */
+        "movdqa %%xmm5, %%xmm3\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"                       /* t41 */
+        "movdqa %%xmm11, %%xmm8\n\t"
+        "pxor %%xmm15, %%xmm8\n\t"                      /* t42 */
+        "movdqa %%xmm11, %%xmm13\n\t"
+        "pxor %%xmm5, %%xmm13\n\t"                      /* t43 */
+        "movdqa %%xmm15, %%xmm14\n\t"
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t44 */
+        "movdqa %%xmm6, 96(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm6\n\t"
+        "pxor %%xmm3, %%xmm6\n\t"                       /* t45 */
+        "pand %%xmm14, %%xmm4\n\t"                      /* z0 */
+        "pand %%xmm1, %%xmm9\n\t"                       /* z1 */
+        "pand %%xmm15, %%xmm2\n\t"                      /* z2 */
+        "pand %%xmm13, %%xmm10\n\t"                     /* z3 */
+        "pand %%xmm5, %%xmm7\n\t"                       /* z4 */
+        "pand %%xmm11, %%xmm12\n\t"                     /* z5 */
+        "movdqa %%xmm9, 80(%[s])\n\t"
+        "movdqa %%xmm8, %%xmm9\n\t"
+        "pand 192(%[s]), %%xmm9\n\t"                    /* z6 */
+        "movdqa %%xmm7, 192(%[s])\n\t"
+        "movdqa %%xmm6, %%xmm7\n\t"
+        "pand 64(%[s]), %%xmm7\n\t"                     /* z7 */
+        "pand %%xmm3, %%xmm0\n\t"                       /* z8 */
+        "pand 112(%[s]), %%xmm14\n\t"                   /* z9 */
+        "pand 128(%[s]), %%xmm1\n\t"                    /* z10 */
+        "pand 176(%[s]), %%xmm15\n\t"                   /* z11 */
+        "pand 144(%[s]), %%xmm13\n\t"                   /* z12 */
+        "pand 160(%[s]), %%xmm5\n\t"                    /* z13 */
+        "pand 16(%[s]), %%xmm11\n\t"                    /* z14 */
+        "pand 48(%[s]), %%xmm8\n\t"                     /* z15 */
+        "pand 0(%[s]), %%xmm6\n\t"                      /* z16 */
+        "pand 96(%[s]), %%xmm3\n\t"                     /* z17 */
+        "pxor %%xmm6, %%xmm8\n\t"                       /* t46 */
+        "pxor %%xmm1, %%xmm15\n\t"                      /* t47 */
+        "pxor %%xmm12, %%xmm5\n\t"                      /* t48 */
+        "pxor %%xmm1, %%xmm14\n\t"                      /* t49 */
+        "movdqa %%xmm2, %%xmm1\n\t"
+        "pxor %%xmm13, %%xmm1\n\t"                      /* t50 */
+        "pxor %%xmm12, %%xmm2\n\t"                      /* t51 */
+        "pxor %%xmm7, %%xmm0\n\t"                       /* t52 */
+        "pxor %%xmm10, %%xmm4\n\t"                      /* t53 */
+        "pxor %%xmm7, %%xmm9\n\t"                       /* t54 */
+        "pxor %%xmm3, %%xmm6\n\t"                       /* t55 */
+        "pxor %%xmm5, %%xmm13\n\t"                      /* t56 */
+        "pxor %%xmm4, %%xmm1\n\t"                       /* t57 */
+        "movdqa 192(%[s]), %%xmm3\n\t"
+        "pxor %%xmm8, %%xmm3\n\t"                       /* t58 */
+        "pxor %%xmm9, %%xmm10\n\t"                      /* t59 */
+        "pxor %%xmm1, %%xmm8\n\t"                       /* t60 */
+        "pxor %%xmm1, %%xmm11\n\t"                      /* t61 */
+        "pxor %%xmm3, %%xmm0\n\t"                       /* t62 */
+        "pxor %%xmm3, %%xmm14\n\t"                      /* t63 */
+        "movdqa 192(%[s]), %%xmm1\n\t"
+        "pxor %%xmm10, %%xmm1\n\t"                      /* t64 */
+        "pxor %%xmm0, %%xmm11\n\t"                      /* t65 */
+        "movdqa 80(%[s]), %%xmm3\n\t"
+        "pxor %%xmm14, %%xmm3\n\t"                      /* t66 */
+        "pxor %%xmm14, %%xmm10\n\t"                     /* s0 */
+        "pxor %%xmm0, %%xmm13\n\t"                      /* s6 */
+        "pxor %%xmm8, %%xmm5\n\t"                       /* s7 */
+        "movdqa %%xmm1, %%xmm0\n\t"
+        "pxor %%xmm11, %%xmm0\n\t"                      /* t67 */
+        "pxor %%xmm3, %%xmm4\n\t"                       /* s3 */
+        "pxor %%xmm3, %%xmm2\n\t"                       /* s4 */
+        "pxor %%xmm11, %%xmm15\n\t"                     /* s5 */
+        "pxor %%xmm4, %%xmm1\n\t"                       /* s1 */
+        "pxor %%xmm0, %%xmm6\n\t"                       /* s2 */
+        "movdqa %%xmm13, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "movdqa %%xmm5, %%xmm3\n\t"
+        "pxor %%xmm2, %%xmm3\n\t"
+        "pxor %%xmm6, %%xmm3\n\t"
+        "movdqa %%xmm10, %%xmm7\n\t"
+        "pxor %%xmm15, %%xmm7\n\t"
+        "pxor %%xmm4, %%xmm7\n\t"
+        "movdqa %%xmm1, %%xmm8\n\t"
+        "pxor %%xmm13, %%xmm8\n\t"
+        "pxor %%xmm2, %%xmm8\n\t"
+        "movdqa %%xmm6, %%xmm9\n\t"
+        "pxor %%xmm5, %%xmm9\n\t"
+        "pxor %%xmm15, %%xmm9\n\t"
+        "pxor %%xmm10, %%xmm4\n\t"
+        "pxor %%xmm13, %%xmm4\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "pxor %%xmm5, %%xmm2\n\t"
+        "pxor %%xmm6, %%xmm15\n\t"
+        "pxor %%xmm10, %%xmm15\n\t"
+        "movdqu -128(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm15\n\t"
+        "movdqu -112(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "movdqu -96(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "movdqu -80(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"
+        "movdqu -64(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "movdqu -48(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm7\n\t"
+        "movdqu -32(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "movdqu -16(%[rk]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "movdqa %%xmm15, %%xmm1\n\t"
+        "psrlq $1, %%xmm1\n\t"
+        "pxor %%xmm2, %%xmm1\n\t"
+        "pand 48(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "psllq $1, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm15\n\t"
+        "movdqa %%xmm4, %%xmm1\n\t"
+        "psrlq $1, %%xmm1\n\t"
+        "pxor %%xmm9, %%xmm1\n\t"
+        "pand 48(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"
+        "psllq $1, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "movdqa %%xmm8, %%xmm1\n\t"
+        "psrlq $1, %%xmm1\n\t"
+        "pxor %%xmm7, %%xmm1\n\t"
+        "pand 48(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm7\n\t"
+        "psllq $1, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "movdqa %%xmm3, %%xmm1\n\t"
+        "psrlq $1, %%xmm1\n\t"
+        "pxor %%xmm0, %%xmm1\n\t"
+        "pand 48(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "psllq $1, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "movdqa %%xmm15, %%xmm1\n\t"
+        "psrlq $2, %%xmm1\n\t"
+        "pxor %%xmm4, %%xmm1\n\t"
+        "pand 64(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "psllq $2, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm15\n\t"
+        "movdqa %%xmm2, %%xmm1\n\t"
+        "psrlq $2, %%xmm1\n\t"
+        "pxor %%xmm9, %%xmm1\n\t"
+        "pand 64(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"
+        "psllq $2, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm8, %%xmm1\n\t"
+        "psrlq $2, %%xmm1\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"
+        "pand 64(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "psllq $2, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "movdqa %%xmm7, %%xmm1\n\t"
+        "psrlq $2, %%xmm1\n\t"
+        "pxor %%xmm0, %%xmm1\n\t"
+        "pand 64(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "psllq $2, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm7\n\t"
+        "movdqa %%xmm15, %%xmm1\n\t"
+        "psrlq $4, %%xmm1\n\t"
+        "pxor %%xmm8, %%xmm1\n\t"
+        "pand 80(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm8\n\t"
+        "psllq $4, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm15\n\t"
+        "movdqa %%xmm2, %%xmm1\n\t"
+        "psrlq $4, %%xmm1\n\t"
+        "pxor %%xmm7, %%xmm1\n\t"
+        "pand 80(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm7\n\t"
+        "psllq $4, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm4, %%xmm1\n\t"
+        "psrlq $4, %%xmm1\n\t"
+        "pxor %%xmm3, %%xmm1\n\t"
+        "pand 80(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm3\n\t"
+        "psllq $4, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm4\n\t"
+        "movdqa %%xmm9, %%xmm1\n\t"
+        "psrlq $4, %%xmm1\n\t"
+        "pxor %%xmm0, %%xmm1\n\t"
+        "pand 80(%[c]), %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm0\n\t"
+        "psllq $4, %%xmm1\n\t"
+        "pxor %%xmm1, %%xmm9\n\t"
+        "pshufb 0(%[c]), %%xmm15\n\t"
+        "movdqu %%xmm15, 0(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm2\n\t"
+        "movdqu %%xmm2, 16(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm4\n\t"
+        "movdqu %%xmm4, 32(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm9\n\t"
+        "movdqu %%xmm9, 48(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm8\n\t"
+        "movdqu %%xmm8, 64(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm7\n\t"
+        "movdqu %%xmm7, 80(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm3\n\t"
+        "movdqu %%xmm3, 96(%[out])\n\t"
+        "pshufb 0(%[c]), %%xmm0\n\t"
+        "movdqu %%xmm0, 112(%[out])\n\t"
+        : [rk] "+r" (sk), [n] "+r" (n)
+        : [in] "r" (in), [out] "r" (out), [c] "r" (&moto_aes_bs_x86_consts),
+          [s] "r" (s)
+        : "cc", "memory");
+}
+
+/*
+ * @s must be 16 byte aligned for the pxor and pand that read it. It holds
+ * spilled slices of the state, so it is cleared after each call.
+ */
+#define MOTO_AES_BS_X86_SCRATCH     (16 * MOTO_AES_BS_X86_SPILLS + 15)
+
+/* Eight blocks at @in to @out, which may be equal */
+void moto_aes_bs_x86_encrypt8(const u8 *sk, unsigned int rounds, u8 *out,
+        const u8 *in)
+{
+    u8 buf[MOTO_AES_BS_X86_SCRATCH];
+
+    moto_aes_bs_ssse3_encrypt8(sk, rounds - 1, out, in,
+            PTR_ALIGN(&buf[0], 16));
+    memset(buf, 0, sizeof(buf));
+}
+
+void moto_aes_bs_x86_decrypt8(const u8 *sk, unsigned int rounds, u8 *out,
+        const u8 *in)
+{
+    u8 buf[MOTO_AES_BS_X86_SCRATCH];
+
+    moto_aes_bs_ssse3_decrypt8(sk + 8 * AES_BLOCK_SIZE * rounds, rounds - 1,
+            out, in, PTR_ALIGN(&buf[0], 16));
+    memset(buf, 0, sizeof(buf));
+}
+
+int moto_aes_bs_x86_usable(void)
+{
+    return boot_cpu_has(X86_FEATURE_SSSE3);
+}
@@ -0,0 +1,549 @@
+/*
+ * Cryptographic API.
+ *
+ * AES Cipher Algorithm, using the x86 AES-NI instructions.
+ *
+ * The key schedule is the one expanded by moto_aes_set_key(): key_enc is
+ * laid out as the round keys expected by AESENC and key_dec already holds
+ * the "Equivalent Inverse Cipher" round keys expected by AESDEC, so the
+ * context is shared with the portable implementation, which also serves
+ * as the fallback when the FPU cannot be used.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ */
+
+#include <crypto/algapi.h>
+#include <moto_aes.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/types.h>
+#include <linux/errno.h>
+#include <linux/crypto.h>
+#include <asm/cpufeature.h>
+#include <asm/i387.h>
+
+#include "moto_crypto_util.h"
+#include "moto_testmgr.h"
+#include "moto_crypto_main.h"
+
+#define AESNI_INTERLEAVE 4
+
+/*
+ * The helpers below use %xmm0-%xmm4 without declaring them as clobbered:
+ * kernel code is built without SSE, so the compiler never keeps anything in
+ * those registers, and the user state is saved by kernel_fpu_begin().
+ * Every pass walks the round keys with the count of middle rounds in @n.
+ */
+static inline unsigned long moto_aesni_nrounds(
+        const struct moto_crypto_aes_ctx *ctx)
+{
+    return ctx->key_length / 4 + 6 - 1;
+}
+
+static void moto_aesni_enc(const u32 *rk, unsigned long n, u8 *out,
+        const u8 *in)
+{
+    asm volatile(
+        "movdqu (%[in]), %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "aesenc %%xmm4, %%xmm0\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm4\n\t"
+        "aesenclast %%xmm4, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        : [rk] "+r" (rk), [n] "+r" (n)
+        : [in] "r" (in), [out] "r" (out)
+        : "cc", "memory");
+}
+
+static void moto_aesni_dec(const u32 *rk, unsigned long n, u8 *out,
+        const u8 *in)
+{
+    asm volatile(
+        "movdqu (%[in]), %%xmm0\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "aesdec %%xmm4, %%xmm0\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm4\n\t"
+        "aesdeclast %%xmm4, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        : [rk] "+r" (rk), [n] "+r" (n)
+        : [in] "r" (in), [out] "r" (out)
+        : "cc", "memory");
+}
+
+/* Four independent blocks keep the AES unit pipeline busy. */
+static void moto_aesni_enc_x4(const u32 *rk, unsigned long n, u8 *out,
+        const u8 *in)
+{
+    asm volatile(
+        "movdqu (%[in]), %%xmm0\n\t"
+        "movdqu 16(%[in]), %%xmm1\n\t"
+        "movdqu 32(%[in]), %%xmm2\n\t"
+        "movdqu 48(%[in]), %%xmm3\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm1\n\t"
+        "pxor %%xmm4, %%xmm2\n\t"
+        "pxor %%xmm4, %%xmm3\n\t"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "aesenc %%xmm4, %%xmm0\n\t"
+        "aesenc %%xmm4, %%xmm1\n\t"
+        "aesenc %%xmm4, %%xmm2\n\t"
+        "aesenc %%xmm4, %%xmm3\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm4\n\t"
+        "aesenclast %%xmm4, %%xmm0\n\t"
+        "aesenclast %%xmm4, %%xmm1\n\t"
+        "aesenclast %%xmm4, %%xmm2\n\t"
+        "aesenclast %%xmm4, %%xmm3\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        "movdqu %%xmm1, 16(%[out])\n\t"
+        "movdqu %%xmm2, 32(%[out])\n\t"
+        "movdqu %%xmm3, 48(%[out])\n\t"
+        : [rk] "+r" (rk), [n] "+r" (n)
+        : [in] "r" (in), [out] "r" (out)
+        : "cc", "memory");
+}
+
+static void moto_aesni_dec_x4(const u32 *rk, unsigned long n, u8 *out,
+        const u8 *in)
+{
+    asm volatile(
+        "movdqu (%[in]), %%xmm0\n\t"
+        "movdqu 16(%[in]), %%xmm1\n\t"
+        "movdqu 32(%[in]), %%xmm2\n\t"
+        "movdqu 48(%[in]), %%xmm3\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "pxor %%xmm4, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm1\n\t"
+        "pxor %%xmm4, %%xmm2\n\t"
+        "pxor %%xmm4, %%xmm3\n\t"
+        "1:\n\t"
+        "add $16, %[rk]\n\t"
+        "movdqu (%[rk]), %%xmm4\n\t"
+        "aesdec %%xmm4, %%xmm0\n\t"
+        "aesdec %%xmm4, %%xmm1\n\t"
+        "aesdec %%xmm4, %%xmm2\n\t"
+        "aesdec %%xmm4, %%xmm3\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "movdqu 16(%[rk]), %%xmm4\n\t"
+        "aesdeclast %%xmm4, %%xmm0\n\t"
+        "aesdeclast %%xmm4, %%xmm1\n\t"
+        "aesdeclast %%xmm4, %%xmm2\n\t"
+        "aesdeclast %%xmm4, %%xmm3\n\t"
+        "movdqu %%xmm0, (%[out])\n\t"
+        "movdqu %%xmm1, 16(%[out])\n\t"
+        "movdqu %%xmm2, 32(%[out])\n\t"
+        "movdqu %%xmm3, 48(%[out])\n\t"
+        : [rk] "+r" (rk), [n] "+r" (n)
+        : [in] "r" (in), [out] "r" (out)
+        : "cc", "memory");
+}
+
+static int moto_ecb_aes_ni_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes, int enc)
+{
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    const u32 *rk = enc ? ctx->key_enc : ctx->key_dec;
+    unsigned long n = moto_aesni_nrounds(ctx);
+    struct blkcipher_walk walk;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (nbytes % AES_BLOCK_SIZE)
+        return -EINVAL;
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt(desc, &walk);
+    desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    kernel_fpu_begin();
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        while (nbytes >= AESNI_INTERLEAVE * AES_BLOCK_SIZE) {
+            if (enc)
+                moto_aesni_enc_x4(rk, n, wdst, wsrc);
+            else
+                moto_aesni_dec_x4(rk, n, wdst, wsrc);
+
+            wsrc += AESNI_INTERLEAVE * AES_BLOCK_SIZE;
+            wdst += AESNI_INTERLEAVE * AES_BLOCK_SIZE;
+            nbytes -= AESNI_INTERLEAVE * AES_BLOCK_SIZE;
+        }
+
+        while (nbytes >= AES_BLOCK_SIZE) {
+            if (enc)
+                moto_aesni_enc(rk, n, wdst, wsrc);
+            else
+                moto_aesni_dec(rk, n, wdst, wsrc);
+
+            wsrc += AES_BLOCK_SIZE;
+            wdst += AES_BLOCK_SIZE;
+            nbytes -= AES_BLOCK_SIZE;
+        }
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+    kernel_fpu_end();
+
+    return err;
+}
+
+static int moto_ecb_aes_ni_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    if (!irq_fpu_usable())
+        return moto_ecb_aes_encrypt(desc, dst, src, nbytes);
+
+    return moto_ecb_aes_ni_operate(desc, dst, src, nbytes, 1);
+}
+
+static int moto_ecb_aes_ni_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    if (!irq_fpu_usable())
+        return moto_ecb_aes_decrypt(desc, dst, src, nbytes);
+
+    return moto_ecb_aes_ni_operate(desc, dst, src, nbytes, 0);
+}
+
+static int moto_cbc_aes_ni_encrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    unsigned long n = moto_aesni_nrounds(ctx);
+    struct blkcipher_walk walk;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+    u8 *iv;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (!irq_fpu_usable())
+        return moto_cbc_aes_encrypt(desc, dst, src, nbytes);
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt(desc, &walk);
+    desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    kernel_fpu_begin();
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+        iv = walk.iv;
+
+        do {
+            moto_crypto_xor(iv, wsrc, AES_BLOCK_SIZE);
+            moto_aesni_enc(ctx->key_enc, n, wdst, iv);
+            memcpy(iv, wdst, AES_BLOCK_SIZE);
+
+            wsrc += AES_BLOCK_SIZE;
+            wdst += AES_BLOCK_SIZE;
+        } while ((nbytes -= AES_BLOCK_SIZE) >= AES_BLOCK_SIZE);
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+    kernel_fpu_end();
+
+    return err;
+}
+
+static int moto_cbc_aes_ni_decrypt(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    unsigned long n = moto_aesni_nrounds(ctx);
+    struct blkcipher_walk walk;
+    u32 buf[AESNI_INTERLEAVE * AES_BLOCK_SIZE / sizeof(u32)];
+    unsigned int len;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (!irq_fpu_usable())
+        return moto_cbc_aes_decrypt(desc, dst, src, nbytes);
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt(desc, &walk);
+    desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    kernel_fpu_begin();
+    while ((nbytes = walk.nbytes)) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        /*
+         * Keep a copy of the ciphertext, it is needed for the chaining
+         * after an in-place request has overwritten it.
+         */
+        while (nbytes >= AES_BLOCK_SIZE) {
+            len = AESNI_INTERLEAVE * AES_BLOCK_SIZE;
+            if (nbytes < len)
+                len = AES_BLOCK_SIZE;
+            memcpy(buf, wsrc, len);
+            if (len > AES_BLOCK_SIZE)
+                moto_aesni_dec_x4(ctx->key_dec, n, wdst, (u8 *)buf);
+            else
+                moto_aesni_dec(ctx->key_dec, n, wdst, (u8 *)buf);
+            moto_crypto_xor(wdst, walk.iv, AES_BLOCK_SIZE);
+            moto_crypto_xor(wdst + AES_BLOCK_SIZE, (u8 *)buf,
+                    len - AES_BLOCK_SIZE);
+            memcpy(walk.iv, (u8 *)buf + len - AES_BLOCK_SIZE,
+                    AES_BLOCK_SIZE);
+
+            wsrc += len;
+            wdst += len;
+            nbytes -= len;
+        }
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+    kernel_fpu_end();
+
+    memset(buf, 0, sizeof(buf));
+    return err;
+}
+
+static int moto_ctr_aes_ni_operate(struct blkcipher_desc *desc,
+        struct scatterlist *dst, struct scatterlist *src,
+        unsigned int nbytes)
+{
+    const struct moto_crypto_aes_ctx *ctx = crypto_blkcipher_ctx(desc->tfm);
+    unsigned long n = moto_aesni_nrounds(ctx);
+    struct blkcipher_walk walk;
+    u32 keystream[AESNI_INTERLEAVE * AES_BLOCK_SIZE / sizeof(u32)];
+    unsigned int len;
+    int err;
+    u8 *wsrc;
+    u8 *wdst;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    if (!irq_fpu_usable())
+        return moto_ctr_aes_operate(desc, dst, src, nbytes);
+
+    blkcipher_walk_init(&walk, dst, src, nbytes);
+    err = blkcipher_walk_virt_block(desc, &walk, AES_BLOCK_SIZE);
+    desc->flags &= ~CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    kernel_fpu_begin();
+    while ((nbytes = walk.nbytes) >= AES_BLOCK_SIZE) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+
+        while (nbytes >= AES_BLOCK_SIZE) {
+            len = AESNI_INTERLEAVE * AES_BLOCK_SIZE;
+            if (nbytes < len)
+                len = AES_BLOCK_SIZE;
+            moto_crypto_ctr_fill((u8 *)keystream, walk.iv,
+                    len / AES_BLOCK_SIZE);
+            if (len > AES_BLOCK_SIZE)
+                moto_aesni_enc_x4(ctx->key_enc, n, (u8 *)keystream,
+                        (u8 *)keystream);
+            else
+                moto_aesni_enc(ctx->key_enc, n, (u8 *)keystream,
+                        (u8 *)keystream);
+            if (wsrc != wdst)
+                memcpy(wdst, wsrc, len);
+            moto_crypto_xor(wdst, (u8 *)keystream, len);
+
+            wsrc += len;
+            wdst += len;
+            nbytes -= len;
+        }
+
+        err = blkcipher_walk_done(desc, &walk, nbytes);
+    }
+
+    /* final partial block */
+    if (walk.nbytes) {
+        wsrc = walk.src.virt.addr;
+        wdst = walk.dst.virt.addr;
+        moto_crypto_ctr_fill((u8 *)keystream, walk.iv, 1);
+        moto_aesni_enc(ctx->key_enc, n, (u8 *)keystream, (u8 *)keystream);
+        moto_crypto_xor((u8 *)keystream, wsrc, walk.nbytes);
+        memcpy(wdst, keystream, walk.nbytes);
+        err = blkcipher_walk_done(desc, &walk, 0);
+    }
+    kernel_fpu_end();
+
+    memset(keystream, 0, sizeof(keystream));
+    return err;
+}
+
+static struct crypto_alg moto_ecb_aes_ni_alg = {
+        .cra_name       = "ecb(aes)",
+        .cra_driver_name= "moto-aes-ni-ecb",
+        .cra_priority   = 1100,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_crypto_aes_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_ecb_aes_ni_alg.cra_list),
+        .cra_exit       = moto_aes_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .setkey         = moto_aes_set_key,
+                        .encrypt        = moto_ecb_aes_ni_encrypt,
+                        .decrypt        = moto_ecb_aes_ni_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_cbc_aes_ni_alg = {
+        .cra_name       = "cbc(aes)",
+        .cra_driver_name= "moto-aes-ni-cbc",
+        .cra_priority   = 1100,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_crypto_aes_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_cbc_aes_ni_alg.cra_list),
+        .cra_exit       = moto_aes_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_set_key,
+                        .encrypt        = moto_cbc_aes_ni_encrypt,
+                        .decrypt        = moto_cbc_aes_ni_decrypt
+                }
+        }
+};
+
+static struct crypto_alg moto_ctr_aes_ni_alg = {
+        .cra_name       = "ctr(aes)",
+        .cra_driver_name= "moto-aes-ni-ctr",
+        .cra_priority   = 1100,
+        .cra_flags      = CRYPTO_ALG_TYPE_BLKCIPHER,
+        .cra_type       = &crypto_blkcipher_type,
+        .cra_blocksize  = AES_BLOCK_SIZE,
+        .cra_ctxsize    = sizeof(struct moto_crypto_aes_ctx),
+        .cra_alignmask  = AES_ALIGN_MASK,
+        .cra_module     = THIS_MODULE,
+        .cra_list       = LIST_HEAD_INIT(moto_ctr_aes_ni_alg.cra_list),
+        .cra_exit       = moto_aes_exit,
+        .cra_u          = {
+                .blkcipher = {
+                        .min_keysize    = AES_MIN_KEY_SIZE,
+                        .max_keysize    = AES_MAX_KEY_SIZE,
+                        .ivsize         = AES_IV_SIZE,
+                        .setkey         = moto_aes_set_key,
+                        .encrypt        = moto_ctr_aes_ni_operate,
+                        .decrypt        = moto_ctr_aes_ni_operate
+                }
+        }
+};
+
+static int moto_aes_ni_registered;
+
+int moto_aes_ni_start(void)
+{
+    int err;
+
+    if (!boot_cpu_has(X86_FEATURE_AES)) {
+        printk (KERN_INFO "AES-NI not supported by the CPU\n");
+        return 0;
+    }
+
+    err = moto_post_alg_defer(&moto_ecb_aes_ni_alg, "moto-aes-ni-ecb",
+            "ecb(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_ecb_aes_ni_alg);
+    printk (KERN_INFO "ecb(aes) AES-NI register result: %d\n", err);
+    if (!err) {
+        moto_aes_ni_registered = 1;
+        err = moto_post_alg_test("moto-aes-ni-ecb", "ecb(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
+        printk (KERN_INFO "ecb(aes) AES-NI test result: %d\n", err);
+        if (err)
+            goto out;
+    }
+    else {
+        goto out;
+    }
+    err = moto_post_alg_defer(&moto_cbc_aes_ni_alg, "moto-aes-ni-cbc",
+            "cbc(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_cbc_aes_ni_alg);
+    printk (KERN_INFO "cbc(aes) AES-NI register result: %d\n", err);
+    if (!err) {
+        err = moto_post_alg_test("moto-aes-ni-cbc", "cbc(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
+        printk (KERN_INFO "cbc(aes) AES-NI test result: %d\n", err);
+        if (err)
+            goto out;
+    }
+    else {
+        goto out;
+    }
+    err = moto_post_alg_defer(&moto_ctr_aes_ni_alg, "moto-aes-ni-ctr",
+            "ctr(aes)", MOTO_CRYPTO_FAILED_ALG_AES) ?:
+            crypto_register_alg(&moto_ctr_aes_ni_alg);
+    printk (KERN_INFO "ctr(aes) AES-NI register result: %d\n", err);
+    if (!err) {
+        err = moto_post_alg_test("moto-aes-ni-ctr", "ctr(aes)",
+                MOTO_CRYPTO_FAILED_ALG_AES);
+        printk (KERN_INFO "ctr(aes) AES-NI test result: %d\n", err);
+    }
+    out:
+    return err;
+}
+
+void moto_aes_ni_finish(void)
+{
+    int err = 0;
+
+    if (!moto_aes_ni_registered)
+        return;
+    moto_aes_ni_registered = 0;
+
+    err = crypto_unregister_alg(&moto_ecb_aes_ni_alg);
+    printk (KERN_INFO "ecb(aes) AES-NI unregister result: %d\n", err);
+    err = crypto_unregister_alg(&moto_cbc_aes_ni_alg);
+    printk (KERN_INFO "cbc(aes) AES-NI unregister result: %d\n", err);
+    err = crypto_unregister_alg(&moto_ctr_aes_ni_alg);
+    printk (KERN_INFO "ctr(aes) AES-NI unregister result: %d\n", err);
+
+}
@@ -14,14 +14,21 @@
  */
 
 #include <crypto/internal/rng.h>
+#include <linux/atomic.h>
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
+#include <linux/percpu.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
+#include <moto_aes.h>
 
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 #include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 
 #define DEFAULT_PRNG_KEY "0123456789abcdef"
 #define DEFAULT_PRNG_KSZ 16
@@ -44,18 +51,58 @@
  */
 
 
+/*
+ * The block buffers follow the key schedule so that they stay 32-bit
+ * aligned for the AES block function, keep aes_ctx first.
+ */
 struct moto_prng_context {
-    spinlock_t prng_lock;
+    struct moto_crypto_aes_ctx aes_ctx;
     unsigned char rand_data[DEFAULT_BLK_SZ];
     unsigned char last_rand_data[DEFAULT_BLK_SZ];
     unsigned char DT[DEFAULT_BLK_SZ];
     unsigned char I[DEFAULT_BLK_SZ];
     unsigned char V[DEFAULT_BLK_SZ];
+    spinlock_t prng_lock;
     u32 rand_data_valid;
-    struct crypto_blkcipher *tfm;
     u32 flags;
 };
 
+/*
+ * Pre-generated output for moto_fips_ansi_cprng.  get_random is served
+ * from a ring of pooled bytes, a refill is queued once the ring drops
+ * below prng_pool_low and tops it up to prng_pool_high.  Setting
+ * prng_pool_low to 0 disables refills.
+ */
+#define MOTO_PRNG_POOL_SZ    2048
+#define MOTO_PRNG_POOL_CHUNK 256
+
+struct moto_prng_pool {
+    unsigned char data[MOTO_PRNG_POOL_SZ];
+    unsigned int head;
+    unsigned int count;
+    spinlock_t lock;
+    struct work_struct refill;
+};
+
+struct moto_fips_prng_context {
+    struct moto_prng_context prng;
+    struct moto_prng_pool pool;
+};
+
+static unsigned int prng_pool_low = MOTO_PRNG_POOL_SZ / 4;
+module_param(prng_pool_low, uint, 0644);
+MODULE_PARM_DESC(prng_pool_low, "CPRNG pool refill threshold in bytes");
+
+static unsigned int prng_pool_high = MOTO_PRNG_POOL_SZ;
+module_param(prng_pool_high, uint, 0644);
+MODULE_PARM_DESC(prng_pool_high, "CPRNG pool refill target in bytes");
+
+static atomic_t moto_prng_pool_bytes = ATOMIC_INIT(0);
+static atomic_t moto_prng_pool_refills = ATOMIC_INIT(0);
+static atomic64_t moto_prng_pool_refill_bytes = ATOMIC64_INIT(0);
+static atomic64_t moto_prng_pool_hit_bytes = ATOMIC64_INIT(0);
+static atomic64_t moto_prng_pool_miss_bytes = ATOMIC64_INIT(0);
+
 static int dbg = 0;
 
 static void hexdump(char *note, unsigned char *buf, unsigned int len)
@@ -82,6 +129,65 @@ static void moto_xor_vectors(unsigned char *in1, unsigned char *in2,
         out[i] = in1[i] ^ in2[i];
 
 }
+
+static void moto_inc_dt(unsigned char *DT)
+{
+    int i;
+
+    for (i = DEFAULT_BLK_SZ - 1; i >= 0; i--) {
+        DT[i] += 1;
+        if (DT[i] != 0)
+            break;
+    }
+}
+
+/*
+ * Second half of the state machine, I must already hold E(K, DT).
+ * Produces rand_data and the next V, the caller updates DT.
+ * returns 0 if generation succeeded, <0 if something went wrong
+ */
+static int _moto_prng_output(struct moto_prng_context *ctx, int cont_test)
+{
+    u32 tmp[DEFAULT_BLK_SZ / sizeof(u32)];
+
+    /*
+     * Next xor I with our secret vector V
+     * encrypt that result to obtain our
+     * pseudo random data which we output
+     */
+    moto_xor_vectors(ctx->I, ctx->V, (unsigned char *)tmp, DEFAULT_BLK_SZ);
+    hexdump("tmp stage 1: ", (unsigned char *)tmp, DEFAULT_BLK_SZ);
+    moto_aes_encrypt_ctx(&ctx->aes_ctx, ctx->rand_data, (u8 *)tmp);
+
+    /*
+     * First check that we didn't produce the same
+     * random data that we did last time around through this
+     */
+    if (!memcmp(ctx->rand_data, ctx->last_rand_data, DEFAULT_BLK_SZ)) {
+        if (cont_test) {
+            /* FSM_TRANS:T5 */
+            panic("cprng %p Failed repetition check!\n", ctx);
+        }
+
+        printk(KERN_ERR "ctx %p Failed repetition check!\n", ctx);
+
+        ctx->flags |= PRNG_NEED_RESET;
+        return -EINVAL;
+    }
+    memcpy(ctx->last_rand_data, ctx->rand_data, DEFAULT_BLK_SZ);
+
+    /*
+     * Lastly xor the random data with I
+     * and encrypt that to obtain a new secret vector V
+     */
+    moto_xor_vectors(ctx->rand_data, ctx->I, (unsigned char *)tmp,
+            DEFAULT_BLK_SZ);
+    hexdump("tmp stage 2: ", (unsigned char *)tmp, DEFAULT_BLK_SZ);
+    moto_aes_encrypt_ctx(&ctx->aes_ctx, ctx->V, (u8 *)tmp);
+
+    return 0;
+}
+
 /*
  * Returns DEFAULT_BLK_SZ bytes of random data per call
  * returns 0 if generation succeeded, <0 if something went wrong
@@ -89,14 +195,9 @@ static void moto_xor_vectors(unsigned char *in1, unsigned char *in2,
 static int _moto_get_more_prng_bytes(struct moto_prng_context *ctx, 
         int cont_test)
 {
-    int i;
-    unsigned char tmp[DEFAULT_BLK_SZ];
-    unsigned char *output = NULL;
-    struct blkcipher_desc desc;
-    struct scatterlist sg;
-    struct scatterlist sg_out;
-
+    int err;
 
+    trace_moto_prng_start(ctx, DEFAULT_BLK_SZ, 0);
     dbgprint(KERN_CRIT 
             "Calling _moto_get_more_prng_bytes for context %p\n",
             ctx);
@@ -106,85 +207,21 @@ static int _moto_get_more_prng_bytes(struct moto_prng_context *ctx,
     hexdump("Input V: ", ctx->V, DEFAULT_BLK_SZ);
 
     /*
-     * This algorithm is a 3 stage state machine
+     * Start by encrypting the counter value
+     * This gives us an intermediate value I
      */
-    for (i = 0; i < 3; i++) {
-
-        switch (i) {
-        case 0:
-            /*
-             * Start by encrypting the counter value
-             * This gives us an intermediate value I
-             */
-            memcpy(tmp, ctx->DT, DEFAULT_BLK_SZ);
-            output = ctx->I;
-            hexdump("tmp stage 0: ", tmp, DEFAULT_BLK_SZ);
-            break;
-        case 1:
-
-            /*
-             * Next xor I with our secret vector V
-             * encrypt that result to obtain our
-             * pseudo random data which we output
-             */
-            moto_xor_vectors(ctx->I, ctx->V, tmp, DEFAULT_BLK_SZ);
-            hexdump("tmp stage 1: ", tmp, DEFAULT_BLK_SZ);
-            output = ctx->rand_data;
-            break;
-        case 2:
-            /*
-             * First check that we didn't produce the same
-             * random data that we did last time around through this
-             */
-            if (!memcmp(ctx->rand_data, ctx->last_rand_data,
-                    DEFAULT_BLK_SZ)) {
-                if (cont_test) {
-                    /* FSM_TRANS:T5 */
-                    panic("cprng %p Failed repetition check!\n",
-                            ctx);
-                }
-
-                printk(KERN_ERR
-                        "ctx %p Failed repetition check!\n",
-                        ctx);
-
-                ctx->flags |= PRNG_NEED_RESET;
-                return -EINVAL;
-            }
-            memcpy(ctx->last_rand_data, ctx->rand_data,
-                    DEFAULT_BLK_SZ);
-
-            /*
-             * Lastly xor the random data with I
-             * and encrypt that to obtain a new secret vector V
-             */
-            moto_xor_vectors(ctx->rand_data, ctx->I, tmp,
-                    DEFAULT_BLK_SZ);
-            output = ctx->V;
-            hexdump("tmp stage 2: ", tmp, DEFAULT_BLK_SZ);
-            break;
-        }
-
-        desc.tfm = ctx->tfm;
-        desc.flags = 0;
-
-        sg_init_one(&sg, tmp, DEFAULT_BLK_SZ);
-
-        sg_init_one(&sg_out, output, DEFAULT_BLK_SZ);
-
-        /* do the encryption */
-        crypto_blkcipher_encrypt(&desc, &sg_out, &sg, DEFAULT_BLK_SZ);
+    moto_aes_encrypt_ctx(&ctx->aes_ctx, ctx->I, ctx->DT);
 
+    err = _moto_prng_output(ctx, cont_test);
+    if (err) {
+        trace_moto_prng_done(ctx, DEFAULT_BLK_SZ, err);
+        return err;
     }
 
     /*
      * Now update our DT value
      */
-    for (i = DEFAULT_BLK_SZ - 1; i >= 0; i--) {
-        ctx->DT[i] += 1;
-        if (ctx->DT[i] != 0)
-            break;
-    }
+    moto_inc_dt(ctx->DT);
 
     dbgprint("Returning new block for context %p\n", ctx);
     ctx->rand_data_valid = 0;
@@ -194,15 +231,64 @@ static int _moto_get_more_prng_bytes(struct moto_prng_context *ctx,
     hexdump("Output V: ", ctx->V, DEFAULT_BLK_SZ);
     hexdump("New Random Data: ", ctx->rand_data, DEFAULT_BLK_SZ);
 
+    trace_moto_prng_done(ctx, DEFAULT_BLK_SZ, 0);
     return 0;
 }
 
+/*
+ * Bulk mode, writes nblocks whole blocks of random data to buf. The
+ * intermediate values I = E(K, DT) do not depend on V, so they are
+ * computed AES_INTERLEAVE counters at a time; only the V chain is serial.
+ * On return every generated block has been consumed.
+ */
+static int _moto_get_prng_blocks(struct moto_prng_context *ctx,
+        unsigned char *buf, unsigned int nblocks, int cont_test)
+{
+    u32 I[AES_INTERLEAVE][DEFAULT_BLK_SZ / sizeof(u32)];
+    unsigned int total = nblocks * DEFAULT_BLK_SZ;
+    unsigned int i, n;
+    int err = 0;
+
+    trace_moto_prng_start(ctx, total, 0);
+    dbgprint(KERN_CRIT "Generating %u blocks for context %p\n",
+            nblocks, ctx);
+
+    while (nblocks) {
+        n = min(nblocks, (unsigned int)AES_INTERLEAVE);
+
+        for (i = 0; i < AES_INTERLEAVE; i++) {
+            memcpy(I[i], ctx->DT, DEFAULT_BLK_SZ);
+            if (i < n)
+                moto_inc_dt(ctx->DT);
+        }
+        moto_aes_encrypt_x4(&ctx->aes_ctx, (u8 *)I, (u8 *)I);
+
+        for (i = 0; i < n; i++) {
+            memcpy(ctx->I, I[i], DEFAULT_BLK_SZ);
+            err = _moto_prng_output(ctx, cont_test);
+            if (err)
+                goto out;
+            memcpy(buf, ctx->rand_data, DEFAULT_BLK_SZ);
+            buf += DEFAULT_BLK_SZ;
+        }
+
+        nblocks -= n;
+    }
+
+    out:
+    ctx->rand_data_valid = DEFAULT_BLK_SZ;
+    memset(I, 0, sizeof(I));
+    trace_moto_prng_done(ctx, total, err);
+    return err;
+}
+
 /* Our exported functions */
 static int moto_get_prng_bytes(char *buf, size_t nbytes, 
         struct moto_prng_context *ctx, int do_cont_test)
 {
     unsigned char *ptr = buf;
     unsigned int byte_count = (unsigned int)nbytes;
+    unsigned int n;
     int err;
 
 
@@ -254,18 +340,24 @@ static int moto_get_prng_bytes(char *buf, size_t nbytes,
     }
 
     /*
-     * Now copy whole blocks
+     * Now copy whole blocks, once the current block is used up the
+     * rest is generated in bulk straight into the caller's buffer
      */
-    for (; byte_count >= DEFAULT_BLK_SZ; byte_count -= DEFAULT_BLK_SZ) {
+    for (; byte_count >= DEFAULT_BLK_SZ; byte_count -= n) {
         if (ctx->rand_data_valid == DEFAULT_BLK_SZ) {
-            if (_moto_get_more_prng_bytes(ctx, do_cont_test) < 0) {
+            n = byte_count - byte_count % DEFAULT_BLK_SZ;
+            if (_moto_get_prng_blocks(ctx, ptr, n / DEFAULT_BLK_SZ,
+                    do_cont_test) < 0) {
                 memset(buf, 0, nbytes);
                 err = -EINVAL;
                 goto done;
             }
+            ptr += n;
+            continue;
         }
         if (ctx->rand_data_valid > 0)
             goto empty_rbuf;
+        n = DEFAULT_BLK_SZ;
         memcpy(ptr, ctx->rand_data, DEFAULT_BLK_SZ);
         ctx->rand_data_valid += DEFAULT_BLK_SZ;
         ptr += DEFAULT_BLK_SZ;
@@ -286,7 +378,7 @@ static int moto_get_prng_bytes(char *buf, size_t nbytes,
 
 static void moto_free_prng_context(struct moto_prng_context *ctx)
 {
-    crypto_free_blkcipher(ctx->tfm);
+    memset(&ctx->aes_ctx, 0, sizeof(ctx->aes_ctx));
 }
 
 static int moto_reset_prng_context(struct moto_prng_context *ctx,
@@ -319,7 +411,7 @@ static int moto_reset_prng_context(struct moto_prng_context *ctx,
 
     ctx->rand_data_valid = DEFAULT_BLK_SZ;
 
-    ret = crypto_blkcipher_setkey(ctx->tfm, prng_key, klen);
+    ret = moto_crypto_aes_expand_key(&ctx->aes_ctx, prng_key, klen);
     if (ret) {
         dbgprint(KERN_CRIT "PRNG: setkey() failed \n");
         goto out;
@@ -332,17 +424,9 @@ static int moto_reset_prng_context(struct moto_prng_context *ctx,
     return ret;
 }
 
-static int moto_cprng_init(struct crypto_tfm *tfm)
+static int moto_init_prng_context(struct moto_prng_context *ctx)
 {
-    struct moto_prng_context *ctx = crypto_tfm_ctx(tfm);
-
     spin_lock_init(&ctx->prng_lock);
-    ctx->tfm = crypto_alloc_blkcipher("ecb(aes)", 0, 0);
-    if (IS_ERR(ctx->tfm)) {
-        dbgprint(KERN_CRIT "Failed to alloc tfm for context %p\n",
-                ctx);
-        return PTR_ERR(ctx->tfm);
-    }
 
     if (moto_reset_prng_context(ctx, NULL, DEFAULT_PRNG_KSZ, 
             NULL, NULL) < 0)
@@ -357,29 +441,20 @@ static int moto_cprng_init(struct crypto_tfm *tfm)
     return 0;
 }
 
-static void moto_cprng_exit(struct crypto_tfm *tfm)
+static void moto_zeroize_prng_context(struct moto_prng_context *ctx)
 {
-    struct moto_prng_context *ctx = crypto_tfm_ctx(tfm);
-
     moto_free_prng_context(ctx);
     memset(ctx->V, 0, DEFAULT_BLK_SZ);
-#ifdef CONFIG_CRYPTO_MOTOROLA_SHOW_ZEROIZATION
-    printk(KERN_INFO "PRNG seed after zeroization:\n");
-    moto_hexdump(ctx->V, DEFAULT_BLK_SZ);
-#endif
-
 }
 
 /*
- *  This is the cprng_registered reset method the seed value is
- *  interpreted as the tuple { V KEY DT}
+ *  The seed value is interpreted as the tuple { V KEY DT}
  *  V and KEY are required during reset, and DT is optional, detected
  *  as being present by testing the length of the seed
  */
-static int moto_cprng_reset(struct crypto_rng *tfm, u8 *seed, 
+static int moto_seed_prng_context(struct moto_prng_context *prng, u8 *seed,
         unsigned int slen)
 {
-    struct moto_prng_context *prng = crypto_rng_ctx(tfm);
     u8 *key = seed + DEFAULT_BLK_SZ;
     u8 *dt = NULL;
 
@@ -400,12 +475,140 @@ static int moto_cprng_reset(struct crypto_rng *tfm, u8 *seed,
     return 0;
 }
 
+/*
+ * Pool refill, runs from the shared workqueue.  The generator is only
+ * ever advanced under the pool lock, so the pool always holds the next
+ * unread part of the X9.31 sequence and callers see the same output as
+ * without the pool.  The lock is dropped between chunks to keep the
+ * bottom half disabled sections short.
+ */
+static void moto_prng_pool_refill(struct work_struct *work)
+{
+    struct moto_prng_pool *pool = container_of(work, struct moto_prng_pool,
+            refill);
+    struct moto_fips_prng_context *ctx = container_of(pool,
+            struct moto_fips_prng_context, pool);
+    unsigned int high = min_t(unsigned int, prng_pool_high, 
+            MOTO_PRNG_POOL_SZ);
+    unsigned int tail, n;
+    int rc;
+
+    for (;;) {
+        spin_lock_bh(&pool->lock);
+        if (pool->count >= high) {
+            spin_unlock_bh(&pool->lock);
+            break;
+        }
+        tail = (pool->head + pool->count) % MOTO_PRNG_POOL_SZ;
+        n = min(high - pool->count, MOTO_PRNG_POOL_SZ - tail);
+        n = min_t(unsigned int, n, MOTO_PRNG_POOL_CHUNK);
+        rc = moto_get_prng_bytes(pool->data + tail, n, &ctx->prng, 1);
+        if (rc > 0) {
+            pool->count += rc;
+            atomic_add(rc, &moto_prng_pool_bytes);
+        }
+        spin_unlock_bh(&pool->lock);
+        if (rc <= 0)
+            break;
+        atomic_inc(&moto_prng_pool_refills);
+        atomic64_add(rc, &moto_prng_pool_refill_bytes);
+    }
+}
+
+/* Called with the pool lock held, or once the pool is no longer shared */
+static void moto_prng_pool_flush(struct moto_prng_pool *pool)
+{
+    atomic_sub(pool->count, &moto_prng_pool_bytes);
+    memset(pool->data, 0, MOTO_PRNG_POOL_SZ);
+    pool->head = 0;
+    pool->count = 0;
+}
+
+static int moto_cprng_init(struct crypto_tfm *tfm)
+{
+    struct moto_fips_prng_context *ctx = crypto_tfm_ctx(tfm);
+
+    spin_lock_init(&ctx->pool.lock);
+    INIT_WORK(&ctx->pool.refill, moto_prng_pool_refill);
+    ctx->pool.head = 0;
+    ctx->pool.count = 0;
+
+    return moto_init_prng_context(&ctx->prng);
+}
+
+static void moto_cprng_exit(struct crypto_tfm *tfm)
+{
+    struct moto_fips_prng_context *ctx = crypto_tfm_ctx(tfm);
+
+    cancel_work_sync(&ctx->pool.refill);
+    moto_prng_pool_flush(&ctx->pool);
+    moto_zeroize_prng_context(&ctx->prng);
+#ifdef CONFIG_CRYPTO_MOTOROLA_SHOW_ZEROIZATION
+    printk(KERN_INFO "PRNG seed after zeroization:\n");
+    moto_hexdump(ctx->prng.V, DEFAULT_BLK_SZ);
+#endif
+
+}
+
+/*
+ *  This is the cprng_registered reset method
+ */
+static int moto_cprng_reset(struct crypto_rng *tfm, u8 *seed, 
+        unsigned int slen)
+{
+    struct moto_fips_prng_context *ctx = crypto_rng_ctx(tfm);
+
+    return moto_seed_prng_context(&ctx->prng, seed, slen);
+}
+
+/*
+ * Requests are served from the pool first and only the part it cannot
+ * cover is generated inline.  Served pool bytes are wiped right away.
+ */
 static int moto_fips_cprng_get_random(struct crypto_rng *tfm, u8 *rdata,
         unsigned int dlen)
 {
-    struct moto_prng_context *prng = crypto_rng_ctx(tfm);
+    struct moto_fips_prng_context *ctx = crypto_rng_ctx(tfm);
+    struct moto_prng_pool *pool = &ctx->pool;
+    unsigned int low = min_t(unsigned int, prng_pool_low, MOTO_PRNG_POOL_SZ);
+    unsigned int done = 0, n;
+    ktime_t start = moto_stats_start();
+    int rc;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    spin_lock_bh(&pool->lock);
+
+    while (done < dlen && pool->count) {
+        n = min(dlen - done, MOTO_PRNG_POOL_SZ - pool->head);
+        n = min(n, pool->count);
+        memcpy(rdata + done, pool->data + pool->head, n);
+        memset(pool->data + pool->head, 0, n);
+        pool->head = (pool->head + n) % MOTO_PRNG_POOL_SZ;
+        pool->count -= n;
+        done += n;
+    }
+    atomic_sub(done, &moto_prng_pool_bytes);
+    atomic64_add(done, &moto_prng_pool_hit_bytes);
+
+    rc = dlen;
+    if (done < dlen) {
+        rc = moto_get_prng_bytes(rdata + done, dlen - done, &ctx->prng, 1);
+        if (rc < 0)
+            memset(rdata, 0, dlen);
+        else {
+            atomic64_add(rc, &moto_prng_pool_miss_bytes);
+            rc += done;
+        }
+    }
 
-    return moto_get_prng_bytes(rdata, dlen, prng, 1);
+    if (rc >= 0 && pool->count < low)
+        schedule_work(&pool->refill);
+
+    spin_unlock_bh(&pool->lock);
+    moto_stats_account(MOTO_STATS_CPRNG, dlen, start);
+    return rc;
 }
 
 static int moto_fips_cprng_reset(struct crypto_rng *tfm, u8 *seed, 
@@ -414,7 +617,12 @@ static int moto_fips_cprng_reset(struct crypto_rng *tfm, u8 *seed,
     u8 rdata[DEFAULT_BLK_SZ];
     int rc;
 
-    struct moto_prng_context *prng = crypto_rng_ctx(tfm);
+    struct moto_fips_prng_context *ctx = crypto_rng_ctx(tfm);
+    struct moto_prng_context *prng = &ctx->prng;
+
+    /* output of the old seed must never be handed out after a reset */
+    spin_lock_bh(&ctx->pool.lock);
+    moto_prng_pool_flush(&ctx->pool);
 
     rc = moto_cprng_reset(tfm, seed, slen);
 
@@ -426,15 +634,34 @@ static int moto_fips_cprng_reset(struct crypto_rng *tfm, u8 *seed,
     prng->rand_data_valid = DEFAULT_BLK_SZ;
 
     out:
+    if (!rc && prng_pool_low)
+        schedule_work(&ctx->pool.refill);
+    spin_unlock_bh(&ctx->pool.lock);
     return rc;
 }
 
+/*
+ * Pool statistics, summed over all instances, for the sysfs status class
+ */
+ssize_t moto_prng_pool_show(char *buf)
+{
+    return snprintf(buf, PAGE_SIZE, 
+            "low %u\nhigh %u\noccupancy %d\nrefills %d\n"
+            "refill_bytes %lld\nhit_bytes %lld\nmiss_bytes %lld\n",
+            prng_pool_low, prng_pool_high,
+            atomic_read(&moto_prng_pool_bytes),
+            atomic_read(&moto_prng_pool_refills),
+            (long long)atomic64_read(&moto_prng_pool_refill_bytes),
+            (long long)atomic64_read(&moto_prng_pool_hit_bytes),
+            (long long)atomic64_read(&moto_prng_pool_miss_bytes));
+}
+
 static struct crypto_alg moto_fips_rng_alg = {
         .cra_name           = "ansi_cprng",
         .cra_driver_name    = "moto_fips_ansi_cprng",
         .cra_priority       = 1000,
         .cra_flags          = CRYPTO_ALG_TYPE_RNG,
-        .cra_ctxsize        = sizeof(struct moto_prng_context),
+        .cra_ctxsize        = sizeof(struct moto_fips_prng_context),
         .cra_type           = &crypto_rng_type,
         .cra_module         = THIS_MODULE,
         .cra_list           = LIST_HEAD_INIT(moto_fips_rng_alg.cra_list),
@@ -449,16 +676,192 @@ static struct crypto_alg moto_fips_rng_alg = {
         }
 };
 
+/*
+ * Per-CPU mode: the caller's seed goes into a master generator and every
+ * CPU runs its own X9.31 instance, keyed from master output on first use
+ * after each reset.  Each instance has its own lock, continuous test
+ * state and reset flag, so callers on different CPUs never contend on
+ * a shared prng_lock.  The output is no longer the X9.31 sequence of the
+ * seed itself, hence the separate cra_name; the generator core is the
+ * same one covered by the ansi_cprng known answer test.
+ */
+struct moto_prng_percpu_context {
+    struct moto_prng_context master;
+    struct moto_prng_context __percpu *instances;
+};
+
+static int moto_reseed_prng_instance(struct moto_prng_context *master,
+        struct moto_prng_context *ctx)
+{
+    u8 seed[DEFAULT_BLK_SZ + DEFAULT_PRNG_KSZ + DEFAULT_BLK_SZ];
+    u8 rdata[DEFAULT_BLK_SZ];
+    int rc;
+
+    rc = moto_get_prng_bytes(seed, sizeof(seed), master, 1);
+    if (rc < 0)
+        goto out;
+
+    rc = moto_seed_prng_context(ctx, seed, sizeof(seed));
+    if (rc)
+        goto out;
+
+    /* this primes the instance's continuity test */
+    rc = moto_get_prng_bytes(rdata, DEFAULT_BLK_SZ, ctx, 0);
+    ctx->rand_data_valid = DEFAULT_BLK_SZ;
+    if (rc > 0)
+        rc = 0;
+
+    out:
+    memset(seed, 0, sizeof(seed));
+    memset(rdata, 0, sizeof(rdata));
+    return rc;
+}
+
+static int moto_percpu_cprng_get_random(struct crypto_rng *tfm, u8 *rdata,
+        unsigned int dlen)
+{
+    struct moto_prng_percpu_context *pctx = crypto_rng_ctx(tfm);
+    struct moto_prng_context *prng;
+    ktime_t start = moto_stats_start();
+    int rc;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    prng = get_cpu_ptr(pctx->instances);
+
+    if (prng->flags & PRNG_NEED_RESET) {
+        rc = moto_reseed_prng_instance(&pctx->master, prng);
+        if (rc)
+            goto out;
+    }
+
+    rc = moto_get_prng_bytes(rdata, dlen, prng, 1);
+
+    out:
+    put_cpu_ptr(pctx->instances);
+    moto_stats_account(MOTO_STATS_CPRNG_PERCPU, dlen, start);
+    return rc;
+}
+
+static int moto_percpu_cprng_reset(struct crypto_rng *tfm, u8 *seed, 
+        unsigned int slen)
+{
+    struct moto_prng_percpu_context *pctx = crypto_rng_ctx(tfm);
+    struct moto_prng_context *prng;
+    u8 rdata[DEFAULT_BLK_SZ];
+    int cpu;
+    int rc;
+
+    rc = moto_seed_prng_context(&pctx->master, seed, slen);
+    if (rc)
+        return rc;
+
+    /* this primes the master's continuity test */
+    rc = moto_get_prng_bytes(rdata, DEFAULT_BLK_SZ, &pctx->master, 0);
+    pctx->master.rand_data_valid = DEFAULT_BLK_SZ;
+    memset(rdata, 0, sizeof(rdata));
+    if (rc < 0)
+        return rc;
+
+    /* every instance rekeys from the new master on its next request */
+    for_each_possible_cpu(cpu) {
+        prng = per_cpu_ptr(pctx->instances, cpu);
+        spin_lock_bh(&prng->prng_lock);
+        prng->flags |= PRNG_NEED_RESET;
+        spin_unlock_bh(&prng->prng_lock);
+    }
+    return 0;
+}
+
+static int moto_percpu_cprng_init(struct crypto_tfm *tfm)
+{
+    struct moto_prng_percpu_context *pctx = crypto_tfm_ctx(tfm);
+    int cpu;
+    int rc;
+
+    /* the instances run the moto_fips_ansi_cprng generator core */
+    rc = moto_post_alg_check("moto_fips_ansi_cprng");
+    if (rc)
+        return rc;
+
+    rc = moto_init_prng_context(&pctx->master);
+    if (rc)
+        return rc;
+
+    pctx->instances = alloc_percpu(struct moto_prng_context);
+    if (!pctx->instances)
+        return -ENOMEM;
+
+    for_each_possible_cpu(cpu) {
+        rc = moto_init_prng_context(per_cpu_ptr(pctx->instances, cpu));
+        if (rc) {
+            free_percpu(pctx->instances);
+            return rc;
+        }
+    }
+    return 0;
+}
+
+static void moto_percpu_cprng_exit(struct crypto_tfm *tfm)
+{
+    struct moto_prng_percpu_context *pctx = crypto_tfm_ctx(tfm);
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        moto_zeroize_prng_context(per_cpu_ptr(pctx->instances, cpu));
+    free_percpu(pctx->instances);
+
+    moto_zeroize_prng_context(&pctx->master);
+#ifdef CONFIG_CRYPTO_MOTOROLA_SHOW_ZEROIZATION
+    printk(KERN_INFO "PRNG master seed after zeroization:\n");
+    moto_hexdump(pctx->master.V, DEFAULT_BLK_SZ);
+#endif
+}
+
+static struct crypto_alg moto_percpu_rng_alg = {
+        .cra_name           = "ansi_cprng_percpu",
+        .cra_driver_name    = "moto_fips_ansi_cprng_percpu",
+        .cra_priority       = 1000,
+        .cra_flags          = CRYPTO_ALG_TYPE_RNG,
+        .cra_ctxsize        = sizeof(struct moto_prng_percpu_context),
+        .cra_type           = &crypto_rng_type,
+        .cra_module         = THIS_MODULE,
+        .cra_list           = LIST_HEAD_INIT(moto_percpu_rng_alg.cra_list),
+        .cra_init           = moto_percpu_cprng_init,
+        .cra_exit           = moto_percpu_cprng_exit,
+        .cra_u              = {
+                .rng = {
+                        .rng_make_random    = moto_percpu_cprng_get_random,
+                        .rng_reset          = moto_percpu_cprng_reset,
+                        .seedsize           = DEFAULT_PRNG_KSZ + 2*DEFAULT_BLK_SZ,
+                }
+        }
+};
+
+static int moto_percpu_rng_registered = 0;
+
 int moto_prng_init(void)
 {
     int rc = 0;
 
-    rc = crypto_register_alg(&moto_fips_rng_alg);
+    rc = moto_post_alg_defer(&moto_fips_rng_alg, "moto_fips_ansi_cprng",
+            "ansi_cprng", MOTO_CRYPTO_FAILED_ALG_RNG) ?:
+            crypto_register_alg(&moto_fips_rng_alg);
     printk (KERN_INFO "moto_ansi_cprng register result: %d\n", rc);
     if (!rc) {
-        rc = moto_alg_test("moto_fips_ansi_cprng", "ansi_cprng", 0, 0);
+        rc = moto_post_alg_test("moto_fips_ansi_cprng", "ansi_cprng",
+                MOTO_CRYPTO_FAILED_ALG_RNG);
         printk (KERN_INFO "moto_ansi_cprng test result: %d\n", rc);
     } 
+    /* only offered once the shared generator core passed or deferred its test */
+    if (!rc) {
+        rc = crypto_register_alg(&moto_percpu_rng_alg);
+        printk (KERN_INFO "moto_ansi_cprng_percpu register result: %d\n", 
+                rc);
+        if (!rc)
+            moto_percpu_rng_registered = 1;
+    }
     return rc;
 }
 
@@ -466,6 +869,12 @@ void moto_prng_finish(void)
 {
     int err = 0;
 
+    if (moto_percpu_rng_registered) {
+        err = crypto_unregister_alg(&moto_percpu_rng_alg);
+        printk (KERN_INFO "moto_ansi_cprng_percpu unregister result: %d\n", 
+                err);
+        moto_percpu_rng_registered = 0;
+    }
     err = crypto_unregister_alg(&moto_fips_rng_alg);
     printk (KERN_INFO "moto_ansi_cprng unregister result: %d\n", err);
 }
@@ -0,0 +1,536 @@
+/*
+ * /dev/moto_crypto: batched cipher and hash jobs from userspace through
+ * shared memory rings, see include/moto_crypto_dev.h for the interface.
+ *
+ * Each open file owns one vmalloc_user() block holding the ring headers,
+ * the submission and completion entries and the data arena, mapped into
+ * the process as is. MOTO_CRYPTO_IOC_SUBMIT runs the queued jobs in the
+ * caller's context on the synchronous moto transforms, with scatterlists
+ * pointing straight at the arena pages.
+ *
+ * Everything the process can write to is read once and checked before
+ * use: the submission entry is copied out of the ring, the kernel keeps
+ * its own sq head, cq tail and masks, and arena offsets are bounds
+ * checked against the kernel's idea of the arena size.
+ */
+#include <linux/module.h>
+#include <linux/compat.h>
+#include <linux/crypto.h>
+#include <linux/err.h>
+#include <linux/fs.h>
+#include <linux/log2.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include <moto_crypto_dev.h>
+
+#include "moto_crypto_main.h"
+#include "moto_testmgr.h"
+
+/* Worst case pages spanned by one job buffer */
+#define MOTO_CRYPTO_DEV_MAX_SG  (MOTO_CRYPTO_DEV_MAX_JOB_LEN / PAGE_SIZE + 2)
+#define MOTO_CRYPTO_DEV_MAX_IV  32
+
+struct moto_crypto_dev_sess {
+    struct crypto_blkcipher *cipher;
+    struct crypto_hash *hash;
+    unsigned int ivsize;
+    unsigned int digestsize;
+};
+
+struct moto_crypto_dev_ctx {
+    struct mutex lock;
+
+    /* Rings, entries and arena, in this order, see setup */
+    void *mem;
+    size_t mem_size;
+    struct moto_crypto_rings *rings;
+    struct moto_crypto_sqe *sqes;
+    struct moto_crypto_cqe *cqes;
+    u8 *arena;
+    u32 arena_size;
+
+    /* Authoritative copies, the mapped ones are only published */
+    u32 sq_mask;
+    u32 cq_mask;
+    u32 sq_head;
+    u32 cq_tail;
+
+    struct moto_crypto_dev_sess sessions[MOTO_CRYPTO_DEV_MAX_SESSIONS];
+    struct scatterlist src_sg[MOTO_CRYPTO_DEV_MAX_SG];
+    struct scatterlist dst_sg[MOTO_CRYPTO_DEV_MAX_SG];
+};
+
+static int moto_crypto_dev_registered = 0;
+
+static int moto_crypto_dev_in_arena(struct moto_crypto_dev_ctx *ctx,
+        u32 off, u32 len)
+{
+    return off <= ctx->arena_size && len <= ctx->arena_size - off;
+}
+
+/* Describe len bytes of the arena at off, one entry per page touched */
+static void moto_crypto_dev_arena_sg(struct moto_crypto_dev_ctx *ctx,
+        struct scatterlist *sg, u32 off, u32 len)
+{
+    u8 *p = ctx->arena + off;
+    unsigned int chunk;
+    unsigned int n = 0;
+
+    if (!len) {
+        sg_init_table(sg, 1);
+        return;
+    }
+
+    sg_init_table(sg, MOTO_CRYPTO_DEV_MAX_SG);
+    while (len) {
+        chunk = min_t(u32, len, PAGE_SIZE - offset_in_page(p));
+        sg_set_page(&sg[n++], vmalloc_to_page(p), chunk,
+                offset_in_page(p));
+        p += chunk;
+        len -= chunk;
+    }
+    sg_mark_end(&sg[n - 1]);
+}
+
+static int moto_crypto_dev_cipher(struct moto_crypto_dev_ctx *ctx,
+        struct moto_crypto_dev_sess *sess,
+        const struct moto_crypto_sqe *sqe, u32 *written)
+{
+    struct blkcipher_desc desc;
+    struct scatterlist *dst = ctx->src_sg;
+    u8 iv[MOTO_CRYPTO_DEV_MAX_IV];
+    int err;
+
+    if (sqe->op != MOTO_CRYPTO_OP_ENCRYPT &&
+            sqe->op != MOTO_CRYPTO_OP_DECRYPT)
+        return -EINVAL;
+    if (!moto_crypto_dev_in_arena(ctx, sqe->dst_off, sqe->len) ||
+            !moto_crypto_dev_in_arena(ctx, sqe->iv_off, sess->ivsize))
+        return -EFAULT;
+    /* In place or disjoint, the walk can't do partial overlaps */
+    if (sqe->dst_off != sqe->src_off &&
+            sqe->dst_off < sqe->src_off + sqe->len &&
+            sqe->src_off < sqe->dst_off + sqe->len)
+        return -EINVAL;
+
+    moto_crypto_dev_arena_sg(ctx, ctx->src_sg, sqe->src_off, sqe->len);
+    if (sqe->dst_off != sqe->src_off) {
+        moto_crypto_dev_arena_sg(ctx, ctx->dst_sg, sqe->dst_off, sqe->len);
+        dst = ctx->dst_sg;
+    }
+
+    memcpy(iv, ctx->arena + sqe->iv_off, sess->ivsize);
+    desc.tfm = sess->cipher;
+    desc.info = iv;
+    desc.flags = 0;
+    if (sqe->op == MOTO_CRYPTO_OP_ENCRYPT)
+        err = crypto_blkcipher_encrypt_iv(&desc, dst, ctx->src_sg, sqe->len);
+    else
+        err = crypto_blkcipher_decrypt_iv(&desc, dst, ctx->src_sg, sqe->len);
+    if (err)
+        return err;
+
+    memcpy(ctx->arena + sqe->iv_off, iv, sess->ivsize);
+    *written = sqe->len;
+    return 0;
+}
+
+static int moto_crypto_dev_digest(struct moto_crypto_dev_ctx *ctx,
+        struct moto_crypto_dev_sess *sess,
+        const struct moto_crypto_sqe *sqe, u32 *written)
+{
+    struct hash_desc desc;
+    int err;
+
+    if (sqe->op != MOTO_CRYPTO_OP_DIGEST)
+        return -EINVAL;
+    if (!moto_crypto_dev_in_arena(ctx, sqe->dst_off, sess->digestsize))
+        return -EFAULT;
+
+    moto_crypto_dev_arena_sg(ctx, ctx->src_sg, sqe->src_off, sqe->len);
+    desc.tfm = sess->hash;
+    desc.flags = 0;
+    err = crypto_hash_digest(&desc, ctx->src_sg, sqe->len,
+            ctx->arena + sqe->dst_off);
+    if (err)
+        return err;
+
+    *written = sess->digestsize;
+    return 0;
+}
+
+static int moto_crypto_dev_run(struct moto_crypto_dev_ctx *ctx,
+        const struct moto_crypto_sqe *sqe, u32 *written)
+{
+    struct moto_crypto_dev_sess *sess;
+
+    if (sqe->session >= MOTO_CRYPTO_DEV_MAX_SESSIONS)
+        return -EINVAL;
+    sess = &ctx->sessions[sqe->session];
+    if (sqe->len > MOTO_CRYPTO_DEV_MAX_JOB_LEN)
+        return -EMSGSIZE;
+    if (!moto_crypto_dev_in_arena(ctx, sqe->src_off, sqe->len))
+        return -EFAULT;
+
+    if (sess->cipher)
+        return moto_crypto_dev_cipher(ctx, sess, sqe, written);
+    if (sess->hash)
+        return moto_crypto_dev_digest(ctx, sess, sqe, written);
+    return -EINVAL;
+}
+
+/*
+ * Run jobs until the submission ring is empty or the completion ring is
+ * full. The rings' head and tail are published once at the end.
+ */
+static long moto_crypto_dev_submit(struct moto_crypto_dev_ctx *ctx)
+{
+    struct moto_crypto_sqe sqe;
+    struct moto_crypto_cqe *cqe;
+    u32 tail, written;
+    long done = 0;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+    if (!ctx->mem)
+        return -EINVAL;
+
+    tail = ACCESS_ONCE(ctx->rings->sq.tail);
+    if (tail - ctx->sq_head > ctx->sq_mask + 1)
+        return -EINVAL;
+    /* Entries are read after the tail that covers them */
+    smp_rmb();
+
+    while (ctx->sq_head != tail) {
+        if (ctx->cq_tail - ACCESS_ONCE(ctx->rings->cq.head) > ctx->cq_mask)
+            break;
+        if (fatal_signal_pending(current))
+            break;
+
+        memcpy(&sqe, &ctx->sqes[ctx->sq_head & ctx->sq_mask], sizeof(sqe));
+        ctx->sq_head++;
+
+        written = 0;
+        cqe = &ctx->cqes[ctx->cq_tail & ctx->cq_mask];
+        cqe->result = moto_crypto_dev_run(ctx, &sqe, &written);
+        cqe->user_data = sqe.user_data;
+        cqe->len = written;
+        ctx->cq_tail++;
+        done++;
+
+        cond_resched();
+    }
+
+    /* Completion entries are visible before the tail that covers them */
+    smp_wmb();
+    ctx->rings->cq.tail = ctx->cq_tail;
+    ctx->rings->sq.head = ctx->sq_head;
+    return done;
+}
+
+static long moto_crypto_dev_setup(struct moto_crypto_dev_ctx *ctx,
+        struct moto_crypto_dev_setup __user *arg)
+{
+    struct moto_crypto_dev_setup setup;
+    u32 sq_entries, cq_entries;
+    void *mem;
+
+    if (ctx->mem)
+        return -EBUSY;
+    if (copy_from_user(&setup, arg, sizeof(setup)))
+        return -EFAULT;
+    if (!setup.sq_entries ||
+            setup.sq_entries > MOTO_CRYPTO_DEV_MAX_ENTRIES ||
+            !setup.cq_entries ||
+            setup.cq_entries > MOTO_CRYPTO_DEV_MAX_ENTRIES ||
+            !setup.arena_size ||
+            setup.arena_size > MOTO_CRYPTO_DEV_MAX_ARENA)
+        return -EINVAL;
+
+    sq_entries = roundup_pow_of_two(setup.sq_entries);
+    cq_entries = roundup_pow_of_two(setup.cq_entries);
+    setup.sq_entries = sq_entries;
+    setup.cq_entries = cq_entries;
+    setup.arena_size = PAGE_ALIGN(setup.arena_size);
+    setup.sq_off = PAGE_ALIGN(sizeof(struct moto_crypto_rings));
+    setup.cq_off = setup.sq_off +
+            PAGE_ALIGN(sq_entries * sizeof(struct moto_crypto_sqe));
+    setup.arena_off = setup.cq_off +
+            PAGE_ALIGN(cq_entries * sizeof(struct moto_crypto_cqe));
+    setup.mmap_size = setup.arena_off + setup.arena_size;
+
+    mem = vmalloc_user(setup.mmap_size);
+    if (!mem)
+        return -ENOMEM;
+    if (copy_to_user(arg, &setup, sizeof(setup))) {
+        vfree(mem);
+        return -EFAULT;
+    }
+
+    ctx->mem = mem;
+    ctx->mem_size = setup.mmap_size;
+    ctx->rings = mem;
+    ctx->sqes = mem + setup.sq_off;
+    ctx->cqes = mem + setup.cq_off;
+    ctx->arena = mem + setup.arena_off;
+    ctx->arena_size = setup.arena_size;
+    ctx->sq_mask = sq_entries - 1;
+    ctx->cq_mask = cq_entries - 1;
+    ctx->sq_head = 0;
+    ctx->cq_tail = 0;
+
+    ctx->rings->sq.mask = ctx->sq_mask;
+    ctx->rings->sq.entries = sq_entries;
+    ctx->rings->cq.mask = ctx->cq_mask;
+    ctx->rings->cq.entries = cq_entries;
+    return 0;
+}
+
+static void moto_crypto_dev_free_session(struct moto_crypto_dev_sess *sess)
+{
+    if (sess->cipher)
+        crypto_free_blkcipher(sess->cipher);
+    if (sess->hash)
+        crypto_free_hash(sess->hash);
+    memset(sess, 0, sizeof(*sess));
+}
+
+/*
+ * Only self tested moto drivers are served, whatever name resolved to
+ * them. A template instance over another driver, moto_hmac(sha256-generic)
+ * say, has no self test entry.
+ */
+static int moto_crypto_dev_is_tested(struct crypto_tfm *tfm)
+{
+    return moto_post_alg_passed(crypto_tfm_alg_driver_name(tfm));
+}
+
+static long moto_crypto_dev_session(struct moto_crypto_dev_ctx *ctx,
+        struct moto_crypto_dev_session __user *arg)
+{
+    struct moto_crypto_dev_session req;
+    struct moto_crypto_dev_sess *sess = NULL;
+    u8 key[MOTO_CRYPTO_DEV_MAX_KEY];
+    int i, err;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+    if (copy_from_user(&req, arg, sizeof(req)))
+        return -EFAULT;
+    req.driver[sizeof(req.driver) - 1] = '\0';
+    if (req.keylen > sizeof(key))
+        return -EINVAL;
+    if (copy_from_user(key, (void __user *)(unsigned long)req.key,
+            req.keylen))
+        return -EFAULT;
+
+    for (i = 0; i < MOTO_CRYPTO_DEV_MAX_SESSIONS; i++) {
+        if (!ctx->sessions[i].cipher && !ctx->sessions[i].hash) {
+            sess = &ctx->sessions[i];
+            break;
+        }
+    }
+    err = -ENOSPC;
+    if (!sess)
+        goto out;
+
+    switch (req.type) {
+    case MOTO_CRYPTO_SESSION_CIPHER:
+        sess->cipher = crypto_alloc_blkcipher(req.driver, 0, 0);
+        if (IS_ERR(sess->cipher)) {
+            err = PTR_ERR(sess->cipher);
+            sess->cipher = NULL;
+            goto out;
+        }
+        err = -EINVAL;
+        if (!moto_crypto_dev_is_tested(crypto_blkcipher_tfm(sess->cipher)))
+            goto out_free;
+        sess->ivsize = crypto_blkcipher_ivsize(sess->cipher);
+        if (sess->ivsize > MOTO_CRYPTO_DEV_MAX_IV)
+            goto out_free;
+        err = crypto_blkcipher_setkey(sess->cipher, key, req.keylen);
+        break;
+    case MOTO_CRYPTO_SESSION_HASH:
+        sess->hash = crypto_alloc_hash(req.driver, 0, 0);
+        if (IS_ERR(sess->hash)) {
+            err = PTR_ERR(sess->hash);
+            sess->hash = NULL;
+            goto out;
+        }
+        err = -EINVAL;
+        if (!moto_crypto_dev_is_tested(crypto_hash_tfm(sess->hash)))
+            goto out_free;
+        sess->digestsize = crypto_hash_digestsize(sess->hash);
+        /*
+         * Keyed hashes get their key even when it is empty, moto_hmac
+         * has no ipad/opad state until then. Only the plain hashes have
+         * no setkey.
+         */
+        err = crypto_hash_setkey(sess->hash, key, req.keylen);
+        if (err == -ENOSYS && !req.keylen)
+            err = 0;
+        break;
+    default:
+        err = -EINVAL;
+        goto out;
+    }
+    if (err)
+        goto out_free;
+
+    req.session = i;
+    req.ivsize = sess->ivsize;
+    req.digestsize = sess->digestsize;
+    err = -EFAULT;
+    if (copy_to_user(arg, &req, sizeof(req)))
+        goto out_free;
+
+    err = 0;
+    goto out;
+
+    out_free:
+    moto_crypto_dev_free_session(sess);
+    out:
+    memset(key, 0, sizeof(key));
+    return err;
+}
+
+static long moto_crypto_dev_end_session(struct moto_crypto_dev_ctx *ctx,
+        u32 __user *arg)
+{
+    u32 id;
+
+    if (get_user(id, arg))
+        return -EFAULT;
+    if (id >= MOTO_CRYPTO_DEV_MAX_SESSIONS ||
+            (!ctx->sessions[id].cipher && !ctx->sessions[id].hash))
+        return -EINVAL;
+
+    moto_crypto_dev_free_session(&ctx->sessions[id]);
+    return 0;
+}
+
+static long moto_crypto_dev_ioctl(struct file *file, unsigned int cmd,
+        unsigned long arg)
+{
+    struct moto_crypto_dev_ctx *ctx = file->private_data;
+    void __user *argp = (void __user *)arg;
+    long ret;
+
+    mutex_lock(&ctx->lock);
+    switch (cmd) {
+    case MOTO_CRYPTO_IOC_SETUP:
+        ret = moto_crypto_dev_setup(ctx, argp);
+        break;
+    case MOTO_CRYPTO_IOC_SESSION:
+        ret = moto_crypto_dev_session(ctx, argp);
+        break;
+    case MOTO_CRYPTO_IOC_END_SESSION:
+        ret = moto_crypto_dev_end_session(ctx, argp);
+        break;
+    case MOTO_CRYPTO_IOC_SUBMIT:
+        ret = moto_crypto_dev_submit(ctx);
+        break;
+    default:
+        ret = -ENOTTY;
+        break;
+    }
+    mutex_unlock(&ctx->lock);
+    return ret;
+}
+
+#ifdef CONFIG_COMPAT
+/* The structures have the same layout for 32-bit processes */
+static long moto_crypto_dev_compat_ioctl(struct file *file, unsigned int cmd,
+        unsigned long arg)
+{
+    return moto_crypto_dev_ioctl(file, cmd,
+            (unsigned long)compat_ptr(arg));
+}
+#endif
+
+/* One mapping of the whole block, set up beforehand */
+static int moto_crypto_dev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    struct moto_crypto_dev_ctx *ctx = file->private_data;
+    int ret = -EINVAL;
+
+    mutex_lock(&ctx->lock);
+    if (ctx->mem && !vma->vm_pgoff &&
+            vma->vm_end - vma->vm_start == ctx->mem_size)
+        ret = remap_vmalloc_range(vma, ctx->mem, 0);
+    mutex_unlock(&ctx->lock);
+    return ret;
+}
+
+static int moto_crypto_dev_open(struct inode *inode, struct file *file)
+{
+    struct moto_crypto_dev_ctx *ctx;
+
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return -ENOMEM;
+
+    mutex_init(&ctx->lock);
+    file->private_data = ctx;
+    return nonseekable_open(inode, file);
+}
+
+static int moto_crypto_dev_release(struct inode *inode, struct file *file)
+{
+    struct moto_crypto_dev_ctx *ctx = file->private_data;
+    int i;
+
+    for (i = 0; i < MOTO_CRYPTO_DEV_MAX_SESSIONS; i++)
+        moto_crypto_dev_free_session(&ctx->sessions[i]);
+    vfree(ctx->mem);
+    kfree(ctx);
+    return 0;
+}
+
+static const struct file_operations moto_crypto_dev_fops = {
+    .owner          = THIS_MODULE,
+    .open           = moto_crypto_dev_open,
+    .release        = moto_crypto_dev_release,
+    .unlocked_ioctl = moto_crypto_dev_ioctl,
+#ifdef CONFIG_COMPAT
+    .compat_ioctl   = moto_crypto_dev_compat_ioctl,
+#endif
+    .mmap           = moto_crypto_dev_mmap,
+    .llseek         = no_llseek,
+};
+
+static struct miscdevice moto_crypto_dev_misc = {
+    .minor          = MISC_DYNAMIC_MINOR,
+    .name           = MOTO_CRYPTO_DEV_NAME,
+    .fops           = &moto_crypto_dev_fops,
+};
+
+int moto_crypto_dev_start(void)
+{
+    int err;
+
+    err = misc_register(&moto_crypto_dev_misc);
+    if (err) {
+        printk(KERN_ERR "moto_crypto_dev_start(): "
+                "failed to register /dev/%s, error %d\n",
+                MOTO_CRYPTO_DEV_NAME, err);
+        return err;
+    }
+    moto_crypto_dev_registered = 1;
+    return 0;
+}
+
+void moto_crypto_dev_finish(void)
+{
+    if (moto_crypto_dev_registered)
+        misc_deregister(&moto_crypto_dev_misc);
+    moto_crypto_dev_registered = 0;
+}
@@ -1,26 +1,41 @@
 #include <moto_aes.h>
 #include <moto_tdes.h>
 #include <moto_sha.h>
+#include <moto_sha256_mb.h>
+#include <moto_crypto_dev.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/completion.h>
 #include <linux/device.h>
-#include <linux/jiffies.h>
+#include <linux/ktime.h>
 #include <linux/scatterlist.h>
 #include <linux/err.h>
 #include <linux/sort.h>
 #include <linux/elf.h>
+#include <linux/workqueue.h>
 
 #include "moto_crypto_main.h"
+#include "moto_testmgr.h"
+#include "moto_crypto_stats.h"
+
+#define CREATE_TRACE_POINTS
+#include <moto_crypto_trace.h>
 
 #define MOTO_CRYPTO_CLASS "moto_crypto"
 #define MOTO_CRYPTO_FIPS_VERSION "1.0"
 #define MOTO_CRYPTO_ATTR_FIPS_ENABLED     "fips_enabled"
 #define MOTO_CRYPTO_ATTR_FIPS_VERSION     "fips_version"
 #define MOTO_CRYPTO_ATTR_FIPS_POST_RESULT "fips_post_result"
+#define MOTO_CRYPTO_ATTR_FIPS_PRNG_POOL   "fips_prng_pool"
+#define MOTO_CRYPTO_ATTR_FIPS_POST_TIMING "fips_post_timing"
+#define MOTO_CRYPTO_ATTR_FIPS_STATS       "fips_stats"
 
 extern int moto_prng_init(void);
 extern void moto_prng_finish(void);
+extern ssize_t moto_prng_pool_show(char *buf);
 
 static char *moto_integrity_hmac_sha256_expected_value;
+static char *moto_integrity_hmac_sha256_tree_expected_value;
 
 struct section_header_data
 {
@@ -42,6 +57,16 @@ struct elf_section_headers
  */
 static unsigned failures = 0;
 
+/**
+ * POST phase durations in microseconds, exported through fips_post_timing
+ */
+static s64 post_init_us;
+static s64 integrity_elf_us;
+static s64 integrity_canonicalize_us;
+static s64 integrity_digest_us;
+
+static ssize_t moto_post_timing_show(char *buf, size_t size);
+
 unsigned char const moto_integrity_hmac_sha256_key[] = {
         0x3c, 0x09, 0x1d, 0x83, 0x74, 0x5f, 0x3e, 0xd3,
         0x2c, 0xab, 0x47, 0x45, 0x89, 0x50, 0xbc, 0xa6,
@@ -128,33 +153,23 @@ static int section_header_data_name_cmp(const void* a, const void* b)
  * Organize the module sections based on their names, so
  * we are able to calculate the hash always using the same
  * data order.
+ * Only the section table is rearranged, the section data is hashed
+ * in place by moto_crypto_hash_sections().
  */
-static int moto_crypto_canonicalize(struct module *mod,
-        struct elf_section_headers* elf_sections)
+static void moto_crypto_canonicalize(struct elf_section_headers* elf_sections)
 {
-    void *canonicalized_buffer;
-    char *data;
     struct section_header_data *curr_sec_hdr;
-
-    unsigned long canonicalized_buffer_size = 0;
+    struct section_header_data *kept_sec_hdr;
     unsigned int loop;
-    int error = 0;
 
-    /* 1 - Allocate a buffer to store the canonicalized section data */
-    canonicalized_buffer = kmalloc(mod->raw_binary_size, GFP_KERNEL);
-    if (IS_ERR_OR_NULL(canonicalized_buffer)) {
-        error = -ENOMEM;
-        goto abort;
-    }
-
-    /* 2 - Sort the sections in alphabetical order */
+    /* 1 - Sort the sections in alphabetical order */
     sort(elf_sections->sect_hdrs,
             elf_sections->nsects,
             sizeof(struct section_header_data),
             section_header_data_name_cmp,
             NULL);
 
-    /* 3 - Move the sections to the canonicalized buffer */
+    /* 2 - Drop the sections that are not part of the hash */
 
     /* At this stage we remove sections that don't add any value to the hash
      * security or that are modified due to kernel changes.
@@ -185,9 +200,8 @@ static int moto_crypto_canonicalize(struct module *mod,
      *             for every different kernel built, we remove it from
      *             the valid sections group.
      */
-    canonicalized_buffer_size = 0;
     curr_sec_hdr = elf_sections->sect_hdrs;
-    data = canonicalized_buffer;
+    kept_sec_hdr = elf_sections->sect_hdrs;
     for (loop = 0; loop < elf_sections->nsects; loop++) {
         if (curr_sec_hdr->size > 0 &&
                 (strcmp(curr_sec_hdr->name,".strtab") != 0 &&
@@ -196,24 +210,70 @@ static int moto_crypto_canonicalize(struct module *mod,
                         strcmp(curr_sec_hdr->name,"__versions") != 0 &&
                         strcmp(curr_sec_hdr->name,".gnu.linkonce.this_module") != 0 &&
                         strcmp(curr_sec_hdr->name,".note.gnu.build-id") != 0)) {
-            memcpy(data, (void *)curr_sec_hdr->address, curr_sec_hdr->size);
-            data += curr_sec_hdr->size;
-            canonicalized_buffer_size += curr_sec_hdr->size;
+            *kept_sec_hdr++ = *curr_sec_hdr;
         }
         curr_sec_hdr++;
     }
+    elf_sections->nsects = kept_sec_hdr - elf_sections->sect_hdrs;
+} /* end moto_crypto_canonicalize() */
 
-    /* 4 - Due to memory constraints, we will reuse the original buffer to
-     * copy the canonicalized one.
-     */
-    mod->raw_binary_size = canonicalized_buffer_size;
-    memcpy(mod->raw_binary_ptr, canonicalized_buffer, canonicalized_buffer_size);
+/*
+ * Error state entered after start up.  The algorithms cannot be
+ * unregistered while tfms are allocated, tfms hold a reference on the
+ * module, so the teardown polls until the users freed theirs.  Until
+ * then moto_crypto_in_error() fails their operations.
+ */
+int moto_crypto_error_state;
 
-    abort:
-    if (canonicalized_buffer != NULL)
-        kfree(canonicalized_buffer);
-    return error;
-} /* end moto_crypto_canonicalize() */
+static DEFINE_MUTEX(moto_crypto_teardown_lock);
+
+static void moto_crypto_error_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(moto_crypto_error_dwork, moto_crypto_error_work);
+
+/* Unregisters every algorithm, FSM_TRANS:T4 and module exit */
+static void moto_crypto_teardown(void)
+{
+    mutex_lock(&moto_crypto_teardown_lock);
+    moto_aes_finish();
+    moto_aes_bs_finish();
+    moto_aes_ni_finish();
+    moto_tdes_finish();
+    moto_hmac_finish();
+    moto_sha256_mb_finish();
+    moto_sha_x86_finish();
+    moto_sha1_finish();
+    moto_sha256_finish();
+    moto_sha512_finish();
+    moto_prng_finish();
+    mutex_unlock(&moto_crypto_teardown_lock);
+}
+
+static void moto_crypto_error_work(struct work_struct *work)
+{
+    /* no new sessions, open ones fail their jobs */
+    moto_crypto_dev_finish();
+
+    if (module_refcount(THIS_MODULE) != 0) {
+        schedule_delayed_work(&moto_crypto_error_dwork, HZ);
+        return;
+    }
+    /* FSM_TRANS:T4 */
+    printk(KERN_ERR "moto_crypto_main: failures: %0x, "
+            "unregistering the algorithms\n", failures);
+    moto_crypto_teardown();
+}
+
+/*
+ * Called by a deferred self test that failed, from the cra_init of the
+ * tfm it was run for.  Nothing can be unregistered from there, the
+ * teardown runs from a work item.
+ */
+void moto_crypto_post_failure(unsigned failure)
+{
+    failures |= failure;
+    if (xchg(&moto_crypto_error_state, 1) == 0)
+        schedule_delayed_work(&moto_crypto_error_dwork, 0);
+}
 
 /**
  * Show handler for moto_crypto_class attributes
@@ -234,7 +294,20 @@ static ssize_t moto_crypto_attr_show(struct class *class,
         n = ((failures == 0) ?
                 snprintf(buf, PAGE_SIZE, "0\n") :
                 snprintf(buf, PAGE_SIZE, "0x%08x\n", failures));
+        /* followed by one "<driver> <state>" line per algorithm */
+        n += moto_post_alg_show(buf + n, PAGE_SIZE - n);
+    }
+    else if (!strcmp(MOTO_CRYPTO_ATTR_FIPS_PRNG_POOL, attr_name)) {
+        n = moto_prng_pool_show(buf);
+    }
+    else if (!strcmp(MOTO_CRYPTO_ATTR_FIPS_POST_TIMING, attr_name)) {
+        n = moto_post_timing_show(buf, PAGE_SIZE);
     }
+#ifdef CONFIG_CRYPTO_MOTOROLA_FIPS_STATS
+    else if (!strcmp(MOTO_CRYPTO_ATTR_FIPS_STATS, attr_name)) {
+        n = moto_stats_show(buf, PAGE_SIZE);
+    }
+#endif
     printk(KERN_DEBUG "moto_crypto_attr_show: %s=%s",
             attr_name,
             n > 0 ? buf : "\n");
@@ -257,6 +330,20 @@ static struct class_attribute moto_crypto_class_attrs[] = {
                 .attr = { .name = MOTO_CRYPTO_ATTR_FIPS_POST_RESULT, .mode = S_IRUGO },
                 .show = moto_crypto_attr_show
         },
+        {
+                .attr = { .name = MOTO_CRYPTO_ATTR_FIPS_PRNG_POOL, .mode = S_IRUGO },
+                .show = moto_crypto_attr_show
+        },
+        {
+                .attr = { .name = MOTO_CRYPTO_ATTR_FIPS_POST_TIMING, .mode = S_IRUGO },
+                .show = moto_crypto_attr_show
+        },
+#ifdef CONFIG_CRYPTO_MOTOROLA_FIPS_STATS
+        {
+                .attr = { .name = MOTO_CRYPTO_ATTR_FIPS_STATS, .mode = S_IRUGO },
+                .show = moto_crypto_attr_show
+        },
+#endif
         __ATTR_NULL
 };
 
@@ -345,24 +432,170 @@ static struct scatterlist *vmalloc_to_sg(unsigned char *const buf,
     return NULL;
 }
 
+/**
+ * Hash len bytes of the canonicalized sections, starting offset bytes
+ * into them, straight out of the module image.  One update is made per
+ * section, giving the same digest as hashing the sections back to back
+ * in a single buffer.
+ */
+static int moto_crypto_hash_sections(struct hash_desc *desc,
+        struct elf_section_headers *elf_sections,
+        unsigned long offset, unsigned long len,
+        unsigned char *out)
+{
+    struct section_header_data *curr_sec_hdr = elf_sections->sect_hdrs;
+    struct scatterlist *sg;
+    unsigned long n;
+    unsigned int loop;
+    int error;
+
+    error = crypto_hash_init(desc);
+    if (error)
+        return error;
+
+    for (loop = 0; loop < elf_sections->nsects && len > 0;
+            loop++, curr_sec_hdr++) {
+        if (offset >= curr_sec_hdr->size) {
+            offset -= curr_sec_hdr->size;
+            continue;
+        }
+        n = min(len, curr_sec_hdr->size - offset);
+        sg = vmalloc_to_sg((unsigned char *)curr_sec_hdr->address + offset,
+                n);
+        if (sg == NULL) {
+            printk(KERN_ERR "vmalloc_to_sg(%lu) failed for %s\n",
+                    n, curr_sec_hdr->name);
+            return -ENOMEM;
+        }
+        error = crypto_hash_update(desc, sg, n);
+        kfree(sg);
+        if (error)
+            return error;
+        offset = 0;
+        len -= n;
+    }
+
+    return crypto_hash_final(desc, out);
+}
+
+/*
+ * Tree integrity format: the canonicalized sections are cut into
+ * MOTO_INTEGRITY_CHUNK_SIZE byte chunks, each chunk is hashed with
+ * SHA-256 and the HMAC-SHA256 of the concatenated chunk digests is the
+ * root, which is checked against the hmac_sha256_tree parameter.  The
+ * chunks are hashed concurrently.  Must match CHUNK_SIZE in
+ * scripts/fips_module_hmac.py.
+ */
+#define MOTO_INTEGRITY_CHUNK_SIZE 16384
+
+struct moto_integrity_leaf {
+    struct work_struct work;
+    struct elf_section_headers *elf_sections;
+    unsigned long offset;
+    unsigned long len;
+    unsigned char digest[SHA256_DIGEST_SIZE];
+    int error;
+};
+
+static void moto_integrity_leaf_work(struct work_struct *work)
+{
+    struct moto_integrity_leaf *leaf = container_of(work,
+            struct moto_integrity_leaf, work);
+    struct hash_desc desc = {NULL, 0};
+
+    desc.tfm = crypto_alloc_hash("moto-sha256", 0, 0);
+    if (IS_ERR(desc.tfm)) {
+        leaf->error = PTR_ERR(desc.tfm);
+        return;
+    }
+    leaf->error = moto_crypto_hash_sections(&desc, leaf->elf_sections,
+            leaf->offset, leaf->len, leaf->digest);
+    crypto_free_hash(desc.tfm);
+}
+
+static int moto_crypto_hash_tree(struct hash_desc *desc,
+        struct elf_section_headers *elf_sections,
+        unsigned long total,
+        unsigned char *out)
+{
+    struct workqueue_struct *wq;
+    struct moto_integrity_leaf *leaves;
+    unsigned char *digests;
+    struct scatterlist sg;
+    unsigned int nleaves = DIV_ROUND_UP(total, MOTO_INTEGRITY_CHUNK_SIZE);
+    unsigned int i;
+    int error = 0;
+
+    leaves = kcalloc(nleaves ? nleaves : 1, sizeof(*leaves), GFP_KERNEL);
+    digests = kmalloc(nleaves ? nleaves * SHA256_DIGEST_SIZE : 1,
+            GFP_KERNEL);
+    if (leaves == NULL || digests == NULL) {
+        error = -ENOMEM;
+        goto abort;
+    }
+
+    /* runs inline, one chunk after another, if there is no workqueue */
+    wq = alloc_workqueue("moto_crypto_integrity", WQ_UNBOUND, 0);
+    for (i = 0; i < nleaves; i++) {
+        leaves[i].elf_sections = elf_sections;
+        leaves[i].offset = (unsigned long)i * MOTO_INTEGRITY_CHUNK_SIZE;
+        leaves[i].len = min_t(unsigned long, MOTO_INTEGRITY_CHUNK_SIZE,
+                total - leaves[i].offset);
+        INIT_WORK(&leaves[i].work, moto_integrity_leaf_work);
+        if (wq != NULL)
+            queue_work(wq, &leaves[i].work);
+        else
+            moto_integrity_leaf_work(&leaves[i].work);
+    }
+    if (wq != NULL)
+        destroy_workqueue(wq);
+
+    for (i = 0; i < nleaves; i++) {
+        if (leaves[i].error) {
+            printk(KERN_ERR "integrity chunk %u failed: %d\n",
+                    i, leaves[i].error);
+            error = leaves[i].error;
+            goto abort;
+        }
+        memcpy(digests + i * SHA256_DIGEST_SIZE, leaves[i].digest,
+                SHA256_DIGEST_SIZE);
+    }
+
+    sg_init_one(&sg, digests, nleaves * SHA256_DIGEST_SIZE);
+    error = crypto_hash_digest(desc, &sg, nleaves * SHA256_DIGEST_SIZE, out);
+
+    abort:
+    kfree(leaves);
+    kfree(digests);
+    return error;
+}
+
 static int self_test_integrity(const char *alg_name, struct module *mod)
 {
     unsigned char expected[32];
     unsigned char actual[32];
-    struct scatterlist *sg = NULL;
     struct hash_desc desc = {NULL, 0};
     size_t digest_length;
     size_t const key_length = sizeof(moto_integrity_hmac_sha256_key);
     int error;
     struct elf_section_headers elf_sections;
+    const char *expected_value;
+    unsigned long total = 0;
+    unsigned int loop;
+    bool tree;
+    ktime_t start;
     elf_sections.sect_hdrs = NULL;
 
     if (mod->raw_binary_ptr == NULL)
         return -ENXIO;
-    if (moto_integrity_hmac_sha256_expected_value == NULL)
+    /* the tree format takes precedence when both values are given */
+    expected_value = moto_integrity_hmac_sha256_tree_expected_value;
+    tree = (expected_value != NULL);
+    if (!tree)
+        expected_value = moto_integrity_hmac_sha256_expected_value;
+    if (expected_value == NULL)
         return -ENOENT;
-    error = scan_hex(expected, sizeof(expected),
-            moto_integrity_hmac_sha256_expected_value);
+    error = scan_hex(expected, sizeof(expected), expected_value);
     if (error < 0) {
         printk(KERN_ERR
                 "FIPS module: Badly formatted hmac_sha256 parameter "
@@ -390,38 +623,38 @@ static int self_test_integrity(const char *alg_name, struct module *mod)
         goto abort;
     }
 
+    start = ktime_get();
     error = parse_elf_sections(mod->raw_binary_ptr,
             mod->raw_binary_size,
             &elf_sections);
+    integrity_elf_us = ktime_us_delta(ktime_get(), start);
     if (error) {
         printk(KERN_ERR "parse_elf_sections() failed: %d\n",
                 error);
         goto abort;
     }
 
-    error = moto_crypto_canonicalize(mod, &elf_sections);
-    if (error) {
-        printk(KERN_ERR "moto_crypto_canonicalize() failed: %d\n",
-                error);
-        goto abort;
-    }
+    start = ktime_get();
+    moto_crypto_canonicalize(&elf_sections);
+    integrity_canonicalize_us = ktime_us_delta(ktime_get(), start);
 
-    sg = vmalloc_to_sg(mod->raw_binary_ptr, mod->raw_binary_size);
-    if (IS_ERR_OR_NULL(sg)) {
-        printk(KERN_ERR "vmalloc_to_sg(%lu) failed: %d\n",
-                mod->raw_binary_size, (int)sg);
-        error = (sg == NULL ? -ENOMEM : (int)sg);
-        goto abort;
-    }
+    for (loop = 0; loop < elf_sections.nsects; loop++)
+        total += elf_sections.sect_hdrs[loop].size;
 
-    error = crypto_hash_digest(&desc, sg, mod->raw_binary_size, actual);
+    start = ktime_get();
+    if (tree)
+        error = moto_crypto_hash_tree(&desc, &elf_sections, total, actual);
+    else
+        error = moto_crypto_hash_sections(&desc, &elf_sections, 0, total,
+                actual);
+    integrity_digest_us = ktime_us_delta(ktime_get(), start);
     if (error) {
         printk(KERN_ERR "crypto_hash_digest(%s) failed: %d\n",
                 alg_name, error);
         goto abort;
     }
 
-    kfree(sg);
+    kfree(elf_sections.sect_hdrs);
     crypto_free_hash(desc.tfm);
 
 #ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
@@ -443,20 +676,251 @@ static int self_test_integrity(const char *alg_name, struct module *mod)
     return error;
 
     abort:
-    if (!IS_ERR_OR_NULL(sg))
-        kfree(sg);
     if (!IS_ERR_OR_NULL(desc.tfm))
         crypto_free_hash(desc.tfm);
     if (elf_sections.sect_hdrs != NULL)
         kfree(elf_sections.sect_hdrs);
     return error == -ENOMEM ? error : -EIO;
 }
+
+/*
+ * Power-on self tests, in the order they used to run one after another.
+ * Each entry only starts once the entries in its deps mask have passed,
+ * everything else runs concurrently on the POST workqueue.  Results are
+ * joined in table order and only the first failing entry is reported, so
+ * failures ends up with the same bit as a sequential run would set.
+ *
+ * As in the sequential code, the start functions register their drivers
+ * before the remaining tests and the integrity check are done, so a
+ * driver can be allocated from outside the POST while it runs.  There is
+ * no gate against that: the crypto manager tests each driver from its own
+ * threads while crypto_register_alg() waits, and template instances spawn
+ * drivers that passed already, so those threads cannot be told apart from
+ * other users without failing or deadlocking the registration.  Such users
+ * only see the outcome once moto_crypto_init() joined the failures and
+ * entered the error state, /dev/moto_crypto is not opened before.
+ */
+enum {
+    MOTO_POST_AES,
+    MOTO_POST_AES_BS,
+    MOTO_POST_AES_NI,
+    MOTO_POST_TDES,
+    MOTO_POST_SHA1,
+    MOTO_POST_SHA256,
+    MOTO_POST_SHA512,
+    MOTO_POST_SHA_X86,
+    MOTO_POST_SHA256_MB,
+    MOTO_POST_HMAC,
+    MOTO_POST_RNG,
+    MOTO_POST_INTEGRITY,
+    MOTO_POST_COUNT
+};
+
+#define MOTO_POST_DEP(x) (1 << (x))
+
+struct moto_post_test {
+    const char *name;
+    int (*run)(void);
+    unsigned failure;
+    unsigned deps;
+    struct work_struct work;
+    struct completion done;
+    int err;
+    s64 run_us;
+};
+
+static int moto_post_integrity(void)
+{
+    int err;
+
+    err = self_test_integrity("moto_hmac(moto-sha256)", &__this_module);
+    switch (err) {
+    case 0:
+        printk(KERN_INFO
+                "FIPS crypto module integrity check passed\n");
+        break;
+    case -ENXIO:
+        printk(KERN_ERR
+                "FIPS crypto module integrity check can only be run "
+                "when the module is loaded");
+        break;
+    case -ENOENT:
+        printk(KERN_ERR
+                "FIPS crypto module integrity check cannot be made: "
+                "Missing HMAC_SHA256 parameter\n");
+        /* FALLTHROUGH */
+    default:
+        printk(KERN_ERR
+                "FIPS crypto module self test integrity error\n");
+        break;
+    }
+    return err;
+}
+
+static struct moto_post_test moto_post_tests[MOTO_POST_COUNT] = {
+        [MOTO_POST_AES] = {
+                .name = "aes",
+                .run = moto_aes_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_AES,
+        },
+        [MOTO_POST_AES_BS] = {
+                .name = "aes_bs",
+                .run = moto_aes_bs_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_AES,
+        },
+        [MOTO_POST_AES_NI] = {
+                .name = "aes_ni",
+                .run = moto_aes_ni_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_AES,
+        },
+        [MOTO_POST_TDES] = {
+                .name = "tdes",
+                .run = moto_tdes_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_TDES,
+        },
+        [MOTO_POST_SHA1] = {
+                .name = "sha1",
+                .run = moto_sha1_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_SHA1,
+        },
+        [MOTO_POST_SHA256] = {
+                .name = "sha256",
+                .run = moto_sha256_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_SHA256,
+        },
+        [MOTO_POST_SHA512] = {
+                .name = "sha512",
+                .run = moto_sha512_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_SHA512,
+        },
+        /* Switches moto-sha1 and moto-sha256 to its block functions */
+        [MOTO_POST_SHA_X86] = {
+                .name = "sha_x86",
+                .run = moto_sha_x86_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_SHA256,
+                .deps = MOTO_POST_DEP(MOTO_POST_SHA1) |
+                        MOTO_POST_DEP(MOTO_POST_SHA256),
+        },
+        /* Checks its lanes against moto-sha256, picks them like sha_x86 */
+        [MOTO_POST_SHA256_MB] = {
+                .name = "sha256_mb",
+                .run = moto_sha256_mb_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_SHA256,
+                .deps = MOTO_POST_DEP(MOTO_POST_SHA256) |
+                        MOTO_POST_DEP(MOTO_POST_SHA_X86),
+        },
+        /* HMAC spawns the SHA drivers, authenc also spawns moto-aes-cbc */
+        [MOTO_POST_HMAC] = {
+                .name = "hmac",
+                .run = moto_hmac_start,
+                .failure = MOTO_CRYPTO_FAILED_ALG_HMAC,
+                .deps = MOTO_POST_DEP(MOTO_POST_AES) |
+                        MOTO_POST_DEP(MOTO_POST_SHA1) |
+                        MOTO_POST_DEP(MOTO_POST_SHA256) |
+                        MOTO_POST_DEP(MOTO_POST_SHA512) |
+                        MOTO_POST_DEP(MOTO_POST_SHA_X86),
+        },
+        [MOTO_POST_RNG] = {
+                .name = "rng",
+                .run = moto_prng_init,
+                .failure = MOTO_CRYPTO_FAILED_ALG_RNG,
+        },
+        [MOTO_POST_INTEGRITY] = {
+                .name = "integrity",
+                .run = moto_post_integrity,
+                .failure = MOTO_CRYPTO_FAILED_INTEGRITY,
+                .deps = MOTO_POST_DEP(MOTO_POST_HMAC),
+        },
+};
+
+static void moto_post_work(struct work_struct *work)
+{
+    struct moto_post_test *test = container_of(work, struct moto_post_test,
+            work);
+    ktime_t start;
+    int i;
+
+    test->err = 0;
+    for (i = 0; i < MOTO_POST_COUNT; i++) {
+        if (!(test->deps & MOTO_POST_DEP(i)))
+            continue;
+        wait_for_completion(&moto_post_tests[i].done);
+        /* a failed dependency is reported by itself, don't run */
+        if (moto_post_tests[i].err)
+            test->err = -ECANCELED;
+    }
+    if (!test->err) {
+        start = ktime_get();
+        test->err = test->run();
+        test->run_us = ktime_us_delta(ktime_get(), start);
+    }
+    complete(&test->done);
+}
+
+/*
+ * Run all power-on self tests and return the failure bit to report, 0 if
+ * they all passed.  Without a workqueue the tests run inline in table
+ * order, which is the old sequential behaviour.
+ */
+static unsigned moto_post_run(void)
+{
+    struct workqueue_struct *wq;
+    int i;
+
+    /* one worker per test, dependants block while their deps run */
+    wq = alloc_workqueue("moto_crypto_post", WQ_UNBOUND, MOTO_POST_COUNT);
+    if (wq == NULL)
+        printk(KERN_WARNING "moto_crypto_main: running POST sequentially\n");
+
+    for (i = 0; i < MOTO_POST_COUNT; i++) {
+        INIT_WORK(&moto_post_tests[i].work, moto_post_work);
+        init_completion(&moto_post_tests[i].done);
+        if (wq != NULL)
+            queue_work(wq, &moto_post_tests[i].work);
+        else
+            moto_post_work(&moto_post_tests[i].work);
+    }
+    for (i = 0; i < MOTO_POST_COUNT; i++)
+        wait_for_completion(&moto_post_tests[i].done);
+    if (wq != NULL)
+        destroy_workqueue(wq);
+
+    for (i = 0; i < MOTO_POST_COUNT; i++) {
+        if (moto_post_tests[i].err)
+            return moto_post_tests[i].failure;
+    }
+    return 0;
+}
+
+/*
+ * One "<phase> <usecs>" line per phase: the whole init, each start
+ * function, the integrity check steps and each algorithm test suite.
+ * Start functions include the test suites they ran.
+ */
+static ssize_t moto_post_timing_show(char *buf, size_t size)
+{
+    ssize_t n;
+    int i;
+
+    n = scnprintf(buf, size, "init %lld\n", post_init_us);
+    for (i = 0; i < MOTO_POST_COUNT; i++)
+        n += scnprintf(buf + n, size - n, "start:%s %lld\n",
+                moto_post_tests[i].name, moto_post_tests[i].run_us);
+    n += scnprintf(buf + n, size - n,
+            "integrity:elf %lld\n"
+            "integrity:canonicalize %lld\n"
+            "integrity:digest %lld\n",
+            integrity_elf_us, integrity_canonicalize_us,
+            integrity_digest_us);
+    n += moto_post_alg_show_timing(buf + n, size - n);
+    return n;
+}
+
 /* Module entry point */
 static int __init moto_crypto_init(void)
 {
     int err;
-    unsigned long start_jiffies;
-    long diff;
+    ktime_t start;
 
     /* FSM_TRANS:T1 */
     printk(KERN_INFO "moto_crypto_main: moto_crypto_init\n");
@@ -473,7 +937,7 @@ static int __init moto_crypto_init(void)
     }
 #endif
 
-    start_jiffies = jiffies;
+    start = ktime_get();
 
     /* Register sysfs entries for Motorola FIPS crypto module status */
     err = class_register(&moto_crypto_class);
@@ -484,65 +948,13 @@ static int __init moto_crypto_init(void)
     }
     failures = 0;
 
-    /* FSM_TRANS:T2 */
-    err = moto_aes_start();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_AES;
-        goto out;
-    }
-    err = moto_tdes_start();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_TDES;
-        goto out;
-    }
-    err = moto_sha1_start();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_SHA1;
+    /* FSM_TRANS:T2, keeps deferred test failures found meanwhile */
+    failures |= moto_post_run();
+    if (failures != 0)
         goto out;
-    }
-    err = moto_sha256_start();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_SHA256;
-        goto out;
-    }
-    err = moto_sha512_start();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_SHA512;
-        goto out;
-    }
-    err = moto_hmac_start();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_HMAC;
-        goto out;
-    }
-    err = moto_prng_init();
-    if (err) {
-        failures |= MOTO_CRYPTO_FAILED_ALG_RNG;
-        goto out;
-    }
 
-    switch (self_test_integrity("moto_hmac(moto-sha256)", &__this_module)) {
-    case 0:
-        printk(KERN_INFO
-                "FIPS crypto module integrity check passed\n");
-        break;
-    case -ENXIO:
-        printk(KERN_ERR
-                "FIPS crypto module integrity check can only be run "
-                "when the module is loaded");
-        failures |= MOTO_CRYPTO_FAILED_INTEGRITY;
-        goto out;
-    case -ENOENT:
-        printk(KERN_ERR
-                "FIPS crypto module integrity check cannot be made: "
-                "Missing HMAC_SHA256 parameter\n");
-        /* FALLTHROUGH */
-    default:
-        printk(KERN_ERR
-                "FIPS crypto module self test integrity error\n");
-        failures |= MOTO_CRYPTO_FAILED_INTEGRITY;
-        goto out;
-    }
+    /* Not a self test failure, the algorithms stay available */
+    moto_crypto_dev_start();
 
     printk(KERN_INFO
             "moto_crypto_main: moto_crypto_init successful initialization\n");
@@ -550,18 +962,13 @@ static int __init moto_crypto_init(void)
     out:
     printk(KERN_INFO
             "failures: %0x\n", failures);
-    diff = (long)jiffies - (long)start_jiffies;
-    printk(KERN_INFO "moto_crypto_main: Time to init: %ld msec\n", 
-            diff * 1000 / HZ);
+    post_init_us = ktime_us_delta(ktime_get(), start);
+    printk(KERN_INFO "moto_crypto_main: Time to init: %lld usec\n", 
+            post_init_us);
     if (failures != 0) {
         /* FSM_TRANS:T4 */
-        moto_aes_finish();
-        moto_tdes_finish();
-        moto_hmac_finish();
-        moto_sha1_finish();
-        moto_sha256_finish();
-        moto_sha512_finish();
-        moto_prng_finish();
+        moto_crypto_error_state = 1;
+        moto_crypto_teardown();
     }
     /* else FSM_TRANS:T3 */
 
@@ -572,14 +979,11 @@ static int __init moto_crypto_init(void)
 static void __exit moto_crypto_fini(void)
 {
     printk(KERN_INFO "moto_crypto_fini\n");
+    cancel_delayed_work_sync(&moto_crypto_error_dwork);
+    moto_crypto_dev_finish();
     class_unregister(&moto_crypto_class);
-    moto_aes_finish();
-    moto_tdes_finish();
-    moto_hmac_finish();
-    moto_sha1_finish();
-    moto_sha256_finish();
-    moto_sha512_finish();
-    moto_prng_finish();
+    moto_crypto_teardown();
+    moto_post_alg_free();
 }
 
 
@@ -590,6 +994,11 @@ module_param_named(hmac_sha256, moto_integrity_hmac_sha256_expected_value,
         charp, 0444);
 MODULE_PARM_DESC(hmac_sha256, "Module HMAC SHA-256 to be checked");
 
+module_param_named(hmac_sha256_tree, 
+        moto_integrity_hmac_sha256_tree_expected_value, charp, 0444);
+MODULE_PARM_DESC(hmac_sha256_tree, 
+        "Module HMAC SHA-256 tree root to be checked instead");
+
 #ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
 unsigned fault_injection_mask;
 char *fault_injection_mask_string;
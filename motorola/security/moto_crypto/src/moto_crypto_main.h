@@ -27,6 +27,16 @@
 
 #define MOTO_CRYPTO_MODULE_INTEGRITY 0x00400000
 
+#define MOTO_CRYPTO_ALG_AES_XTS_128 0x00800000
+#define MOTO_CRYPTO_ALG_AES_XTS_256 0x01000000
+#define MOTO_CRYPTO_ALG_AES_GCM_128 0x02000000
+#define MOTO_CRYPTO_ALG_AES_GCM_192 0x04000000
+#define MOTO_CRYPTO_ALG_AES_GCM_256 0x08000000
+#define MOTO_CRYPTO_ALG_AUTHENC     0x10000000
+#define MOTO_CRYPTO_ALG_SHA512_224  0x20000000
+#define MOTO_CRYPTO_ALG_SHA512_256  0x40000000
+/* moto_hmac over moto-sha512_224 and moto-sha512_256 uses HMAC_SHA512 */
+
 #ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
 extern unsigned fault_injection_mask;
 extern char* fault_injection_mask_string;
@@ -43,4 +53,19 @@ extern char* fault_injection_mask_string;
 
 #define MOTO_CRYPTO_FAILED_INTEGRITY  0x80000000
 
+/*
+ * Records a self test failure found after start up, see lazy_post.  The
+ * module enters the error state: the algorithms get unregistered once
+ * their users freed their tfms, until then every operation fails.
+ */
+void moto_crypto_post_failure(unsigned failure);
+
+extern int moto_crypto_error_state;
+
+/* Checked on entry of every operation, tfms allocated before included */
+static inline int moto_crypto_in_error(void)
+{
+    return unlikely(ACCESS_ONCE(moto_crypto_error_state));
+}
+
 #endif
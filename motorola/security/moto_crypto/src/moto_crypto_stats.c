@@ -0,0 +1,93 @@
+/*
+ * Per-CPU operation, byte and latency statistics for the moto drivers.
+ *
+ * Every CPU only ever updates its own counters with this_cpu operations,
+ * so the hot paths take no lock and touch no shared cache line. A reader
+ * sums all CPUs, which may see an operation counted in ops but not yet in
+ * bytes; that skew is harmless for statistics.
+ */
+#include <linux/kernel.h>
+#include <linux/bitops.h>
+#include <linux/percpu.h>
+#include "moto_crypto_stats.h"
+
+struct moto_stats {
+    u64 ops;
+    u64 bytes;
+    u64 latency[MOTO_STATS_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct moto_stats, moto_stats[MOTO_STATS_COUNT]);
+
+static const char * const moto_stats_names[MOTO_STATS_COUNT] = {
+    [MOTO_STATS_AES_ECB]      = "moto-aes-ecb",
+    [MOTO_STATS_AES_CBC]      = "moto-aes-cbc",
+    [MOTO_STATS_AES_CTR]      = "moto-aes-ctr",
+    [MOTO_STATS_AES_XTS]      = "moto-aes-xts",
+    [MOTO_STATS_AES_GCM]      = "moto-aes-gcm",
+    [MOTO_STATS_TDES_ECB]     = "moto-des3-ecb",
+    [MOTO_STATS_TDES_CBC]     = "moto-des3-cbc",
+    [MOTO_STATS_SHA1]         = "moto-sha1",
+    [MOTO_STATS_SHA224]       = "moto-sha224",
+    [MOTO_STATS_SHA256]       = "moto-sha256",
+    [MOTO_STATS_SHA384]       = "moto-sha384",
+    [MOTO_STATS_SHA512]       = "moto-sha512",
+    [MOTO_STATS_SHA512_224]   = "moto-sha512_224",
+    [MOTO_STATS_SHA512_256]   = "moto-sha512_256",
+    [MOTO_STATS_HMAC]         = "moto_hmac",
+    [MOTO_STATS_CPRNG]        = "moto_fips_ansi_cprng",
+    [MOTO_STATS_CPRNG_PERCPU] = "moto_fips_ansi_cprng_percpu",
+};
+
+void moto_stats_account(enum moto_stats_id id, unsigned int nbytes,
+        ktime_t start)
+{
+    s64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+    int bucket = ns > 0 ? fls64(ns) : 0;
+
+    if (bucket >= MOTO_STATS_BUCKETS)
+        bucket = MOTO_STATS_BUCKETS - 1;
+
+    this_cpu_inc(moto_stats[id].ops);
+    this_cpu_add(moto_stats[id].bytes, nbytes);
+    this_cpu_inc(moto_stats[id].latency[bucket]);
+}
+
+/*
+ * One line per driver that has seen traffic:
+ * "<driver> ops <n> bytes <n> lat <bucket>:<count> ..."
+ * listing only the non-empty latency buckets.
+ */
+ssize_t moto_stats_show(char *buf, size_t size)
+{
+    struct moto_stats sum;
+    struct moto_stats *s;
+    ssize_t n = 0;
+    int id;
+    int cpu;
+    int i;
+
+    for (id = 0; id < MOTO_STATS_COUNT; id++) {
+        memset(&sum, 0, sizeof(sum));
+        for_each_possible_cpu(cpu) {
+            s = &per_cpu(moto_stats, cpu)[id];
+            sum.ops += s->ops;
+            sum.bytes += s->bytes;
+            for (i = 0; i < MOTO_STATS_BUCKETS; i++)
+                sum.latency[i] += s->latency[i];
+        }
+        if (!sum.ops)
+            continue;
+
+        n += scnprintf(buf + n, size - n, "%s ops %llu bytes %llu lat",
+                moto_stats_names[id], sum.ops, sum.bytes);
+        for (i = 0; i < MOTO_STATS_BUCKETS; i++) {
+            if (sum.latency[i])
+                n += scnprintf(buf + n, size - n, " %d:%llu", i,
+                        sum.latency[i]);
+        }
+        n += scnprintf(buf + n, size - n, "\n");
+    }
+
+    return n;
+}
@@ -0,0 +1,57 @@
+#ifndef _MOTO_CRYPTO_STATS_H
+#define _MOTO_CRYPTO_STATS_H
+
+#include <linux/types.h>
+#include <linux/ktime.h>
+
+/* Drivers with operation statistics, see fips_stats */
+enum moto_stats_id {
+    MOTO_STATS_AES_ECB,
+    MOTO_STATS_AES_CBC,
+    MOTO_STATS_AES_CTR,
+    MOTO_STATS_AES_XTS,
+    MOTO_STATS_AES_GCM,
+    MOTO_STATS_TDES_ECB,
+    MOTO_STATS_TDES_CBC,
+    MOTO_STATS_SHA1,
+    MOTO_STATS_SHA224,
+    MOTO_STATS_SHA256,
+    MOTO_STATS_SHA384,
+    MOTO_STATS_SHA512,
+    MOTO_STATS_SHA512_224,
+    MOTO_STATS_SHA512_256,
+    MOTO_STATS_HMAC,
+    MOTO_STATS_CPRNG,
+    MOTO_STATS_CPRNG_PERCPU,
+    MOTO_STATS_COUNT
+};
+
+/* Latency bucket n counts operations that took less than 2^n ns */
+#define MOTO_STATS_BUCKETS 32
+
+#ifdef CONFIG_CRYPTO_MOTOROLA_FIPS_STATS
+
+static inline ktime_t moto_stats_start(void)
+{
+    return ktime_get();
+}
+
+void moto_stats_account(enum moto_stats_id id, unsigned int nbytes,
+        ktime_t start);
+ssize_t moto_stats_show(char *buf, size_t size);
+
+#else
+
+static inline ktime_t moto_stats_start(void)
+{
+    return ktime_set(0, 0);
+}
+
+static inline void moto_stats_account(enum moto_stats_id id,
+        unsigned int nbytes, ktime_t start)
+{
+}
+
+#endif
+
+#endif
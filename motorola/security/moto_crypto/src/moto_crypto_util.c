@@ -30,6 +30,34 @@ void moto_crypto_inc(u8 *a, unsigned int size)
     moto_crypto_inc_byte(a, size);
 }
 
+/*
+ * Store the @nblocks counter blocks following the 128 bit big endian counter
+ * @ctrblk in @ctrblks and advance @ctrblk past them. The counter is carried
+ * as two 64 bit halves so a batch costs one addition per block rather than
+ * a moto_crypto_inc() each. Both buffers must be 32 bit aligned.
+ */
+void moto_crypto_ctr_fill(u8 *ctrblks, u8 *ctrblk, unsigned int nblocks)
+{
+    __be32 *ctr = (__be32 *)ctrblk;
+    __be32 *blk = (__be32 *)ctrblks;
+    u64 hi = ((u64)be32_to_cpu(ctr[0]) << 32) | be32_to_cpu(ctr[1]);
+    u64 lo = ((u64)be32_to_cpu(ctr[2]) << 32) | be32_to_cpu(ctr[3]);
+
+    for (; nblocks; nblocks--, blk += 4) {
+        blk[0] = cpu_to_be32(hi >> 32);
+        blk[1] = cpu_to_be32(hi);
+        blk[2] = cpu_to_be32(lo >> 32);
+        blk[3] = cpu_to_be32(lo);
+        if (!++lo)
+            hi++;
+    }
+
+    ctr[0] = cpu_to_be32(hi >> 32);
+    ctr[1] = cpu_to_be32(hi);
+    ctr[2] = cpu_to_be32(lo >> 32);
+    ctr[3] = cpu_to_be32(lo);
+}
+
 static inline void moto_crypto_xor_byte(u8 *a, const u8 *b, unsigned int size)
 {
     for (; size; size--)
@@ -4,6 +4,7 @@
 #include <linux/types.h>
 
 void moto_crypto_inc(u8 *a, unsigned int size);
+void moto_crypto_ctr_fill(u8 *ctrblks, u8 *ctrblk, unsigned int nblocks);
 void moto_crypto_xor(u8 *dst, const u8 *src, unsigned int size);
 void moto_hexdump(unsigned char *buf, unsigned int len);
 
@@ -16,22 +16,34 @@
  *
  */
 
+#include <crypto/aead.h>
+#include <crypto/authenc.h>
 #include <crypto/internal/hash.h>
 #include <crypto/scatterwalk.h>
 #include <linux/err.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/random.h>
+#include <linux/rtnetlink.h>
 #include <linux/scatterlist.h>
+#include <linux/slab.h>
 #include <linux/string.h>
+#include <moto_aes.h>
+#include <moto_sha.h>
 
+#include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 
 struct moto_hmac_ctx {
     struct crypto_shash *hash;
 };
 
 static int moto_hmac_registered = 0;
+static int moto_authenc_registered = 0;
 
 static inline void *align_ptr(void *p, unsigned int align)
 {
@@ -60,18 +72,20 @@ static int moto_hmac_setkey(struct crypto_shash *parent,
         struct shash_desc shash;
         char ctx[crypto_shash_descsize(hash)];
     } desc;
+    unsigned int inlen = keylen;
     unsigned int i;
+    int err;
+
+    trace_moto_hash_start(crypto_shash_tfm(parent), "setkey", inlen);
 
     desc.shash.tfm = hash;
     desc.shash.flags = crypto_shash_get_flags(parent) &
             CRYPTO_TFM_REQ_MAY_SLEEP;
 
     if (keylen > bs) {
-        int err;
-
         err = crypto_shash_digest(&desc.shash, inkey, keylen, ipad);
         if (err)
-            return err;
+            goto out;
 
         keylen = ds;
     } else
@@ -85,12 +99,16 @@ static int moto_hmac_setkey(struct crypto_shash *parent,
         opad[i] ^= 0x5c;
     }
 
-    return crypto_shash_init(&desc.shash) ?:
+    err = crypto_shash_init(&desc.shash) ?:
             crypto_shash_update(&desc.shash, ipad, bs) ?:
                     crypto_shash_export(&desc.shash, ipad) ?:
                             crypto_shash_init(&desc.shash) ?:
                                     crypto_shash_update(&desc.shash, opad, bs) ?:
                                             crypto_shash_export(&desc.shash, opad);
+
+    out:
+    trace_moto_hash_done(crypto_shash_tfm(parent), "setkey", inlen);
+    return err;
 }
 
 static int moto_hmac_export(struct shash_desc *pdesc, void *out)
@@ -122,10 +140,17 @@ static int moto_hmac_update(struct shash_desc *pdesc,
         const u8 *data, unsigned int nbytes)
 {
     struct shash_desc *desc = shash_desc_ctx(pdesc);
+    ktime_t start = moto_stats_start();
+    int err;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
 
     desc->flags = pdesc->flags & CRYPTO_TFM_REQ_MAY_SLEEP;
 
-    return crypto_shash_update(desc, data, nbytes);
+    err = crypto_shash_update(desc, data, nbytes);
+    moto_stats_account(MOTO_STATS_HMAC, nbytes, start);
+    return err;
 }
 
 static int moto_hmac_final(struct shash_desc *pdesc, u8 *out)
@@ -135,12 +160,21 @@ static int moto_hmac_final(struct shash_desc *pdesc, u8 *out)
     int ss = crypto_shash_statesize(parent);
     char *opad = crypto_shash_ctx_aligned(parent) + ss;
     struct shash_desc *desc = shash_desc_ctx(pdesc);
+    ktime_t start = moto_stats_start();
+    int err;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
 
     desc->flags = pdesc->flags & CRYPTO_TFM_REQ_MAY_SLEEP;
 
-    return crypto_shash_final(desc, out) ?:
+    trace_moto_hash_start(crypto_shash_tfm(parent), "final", 0);
+    err = crypto_shash_final(desc, out) ?:
             crypto_shash_import(desc, opad) ?:
                     crypto_shash_finup(desc, out, ds, out);
+    trace_moto_hash_done(crypto_shash_tfm(parent), "final", 0);
+    moto_stats_account(MOTO_STATS_HMAC, 0, start);
+    return err;
 }
 
 static int moto_hmac_finup(struct shash_desc *pdesc, const u8 *data,
@@ -152,12 +186,21 @@ static int moto_hmac_finup(struct shash_desc *pdesc, const u8 *data,
     int ss = crypto_shash_statesize(parent);
     char *opad = crypto_shash_ctx_aligned(parent) + ss;
     struct shash_desc *desc = shash_desc_ctx(pdesc);
+    ktime_t start = moto_stats_start();
+    int err;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
 
     desc->flags = pdesc->flags & CRYPTO_TFM_REQ_MAY_SLEEP;
 
-    return crypto_shash_finup(desc, data, nbytes, out) ?:
+    trace_moto_hash_start(crypto_shash_tfm(parent), "finup", nbytes);
+    err = crypto_shash_finup(desc, data, nbytes, out) ?:
             crypto_shash_import(desc, opad) ?:
                     crypto_shash_finup(desc, out, ds, out);
+    trace_moto_hash_done(crypto_shash_tfm(parent), "finup", nbytes);
+    moto_stats_account(MOTO_STATS_HMAC, nbytes, start);
+    return err;
 }
 
 static int moto_hmac_init_tfm(struct crypto_tfm *tfm)
@@ -235,6 +278,7 @@ static int moto_hmac_create(struct crypto_template *tmpl, struct rtattr **tb)
 
     inst->alg.base.cra_init = moto_hmac_init_tfm;
     inst->alg.base.cra_exit = moto_hmac_exit_tfm;
+    moto_post_alg_hook(&inst->alg.base);
 
     inst->alg.init = moto_hmac_init;
     inst->alg.update = moto_hmac_update;
@@ -262,32 +306,521 @@ static struct crypto_template moto_hmac_tmpl = {
         .module = THIS_MODULE,
 };
 
-int moto_hmac_start(void)
+/*
+ * moto_authenc(auth,enc): encrypt-then-MAC AEAD over a keyed shash and a
+ * synchronous blkcipher, compatible with crypto/authenc.c (the MAC covers
+ * assoc || iv || ciphertext and the key is the same rtattr blob).
+ *
+ * Over moto-aes-cbc, encryption walks the payload only once: every page
+ * sized chunk is encrypted in place of the mapping by the table routine
+ * and, while it is still in L1, handed to the hash. Decryption checks the
+ * tag before it runs the cipher, like the generic template, so dst is
+ * left alone on -EBADMSG. All per-request state lives on the stack, so
+ * ESP sized packets are processed without any allocation.
+ */
+#define MOTO_AUTHENC_MAX_BLOCKSIZE 16
+
+struct moto_authenc_instance_ctx {
+    struct crypto_shash_spawn auth;
+    struct crypto_spawn enc;
+};
+
+struct moto_authenc_ctx {
+    struct crypto_shash *auth;
+    struct crypto_blkcipher *enc;
+    /* key schedule of enc when it is moto-aes-cbc, NULL otherwise */
+    const struct moto_crypto_aes_ctx *aes;
+    u32 salt[MOTO_AUTHENC_MAX_BLOCKSIZE / sizeof(u32)];
+};
+
+static int moto_authenc_setkey(struct crypto_aead *authenc, const u8 *key,
+        unsigned int keylen)
+{
+    struct moto_authenc_ctx *ctx = crypto_aead_ctx(authenc);
+    struct crypto_authenc_key_param *param;
+    struct rtattr *rta = (void *)key;
+    unsigned int enckeylen;
+    int err = -EINVAL;
+
+    if (!RTA_OK(rta, keylen))
+        goto badkey;
+    if (rta->rta_type != CRYPTO_AUTHENC_KEYA_PARAM)
+        goto badkey;
+    if (RTA_PAYLOAD(rta) < sizeof(*param))
+        goto badkey;
+
+    param = RTA_DATA(rta);
+    enckeylen = be32_to_cpu(param->enckeylen);
+
+    key += RTA_ALIGN(rta->rta_len);
+    keylen -= RTA_ALIGN(rta->rta_len);
+
+    if (keylen < enckeylen)
+        goto badkey;
+
+    crypto_shash_clear_flags(ctx->auth, CRYPTO_TFM_REQ_MASK);
+    crypto_shash_set_flags(ctx->auth, crypto_aead_get_flags(authenc) &
+            CRYPTO_TFM_REQ_MASK);
+    err = crypto_shash_setkey(ctx->auth, key, keylen - enckeylen);
+    crypto_aead_set_flags(authenc, crypto_shash_get_flags(ctx->auth) &
+            CRYPTO_TFM_RES_MASK);
+    if (err)
+        goto out;
+
+    crypto_blkcipher_clear_flags(ctx->enc, CRYPTO_TFM_REQ_MASK);
+    crypto_blkcipher_set_flags(ctx->enc, crypto_aead_get_flags(authenc) &
+            CRYPTO_TFM_REQ_MASK);
+    err = crypto_blkcipher_setkey(ctx->enc, key + keylen - enckeylen,
+            enckeylen);
+    crypto_aead_set_flags(authenc, crypto_blkcipher_get_flags(ctx->enc) &
+            CRYPTO_TFM_RES_MASK);
+
+    out:
+    return err;
+
+    badkey:
+    crypto_aead_set_flags(authenc, CRYPTO_TFM_RES_BAD_KEY_LEN);
+    goto out;
+}
+
+static int moto_authenc_hash_sg(struct shash_desc *desc,
+        struct scatterlist *sg, unsigned int nbytes)
 {
+    struct scatter_walk walk;
+    unsigned int n;
+    u8 *src;
+    int err = 0;
+
+    if (!nbytes)
+        return 0;
+
+    scatterwalk_start(&walk, sg);
+
+    while (nbytes && !err) {
+        n = scatterwalk_clamp(&walk, nbytes);
+        src = scatterwalk_map(&walk);
+
+        err = crypto_shash_update(desc, src, n);
+
+        scatterwalk_unmap(src);
+        scatterwalk_advance(&walk, n);
+        nbytes -= n;
+        scatterwalk_done(&walk, 0, nbytes);
+    }
+
+    return err;
+}
+
+/*
+ * CBC encrypts nbytes of src into dst with the table routine and feeds the
+ * ciphertext to the hash chunk by chunk. Chunks are whole blocks within
+ * one page of both lists; a block straddling a page or an sg entry, or one
+ * that is not 32-bit aligned, goes through a bounce block on the stack.
+ * iv is chained from one chunk to the next.
+ */
+static int moto_authenc_encrypt_sg(const struct moto_crypto_aes_ctx *aes,
+        struct shash_desc *hdesc, struct scatterlist *dst,
+        struct scatterlist *src, unsigned int nbytes, u8 *iv)
+{
+    struct scatter_walk src_walk;
+    struct scatter_walk dst_walk;
+    u32 block[AES_BLOCK_SIZE / sizeof(u32)];
+    unsigned int n;
+    u8 *s;
+    u8 *d;
+    int err = 0;
+
+    if (!nbytes)
+        return 0;
+
+    scatterwalk_start(&src_walk, src);
+    scatterwalk_start(&dst_walk, dst);
+
+    while (nbytes && !err) {
+        n = scatterwalk_clamp(&src_walk, nbytes);
+        n = scatterwalk_clamp(&dst_walk, n);
+        n -= n % AES_BLOCK_SIZE;
+        if ((src_walk.offset | dst_walk.offset) & AES_ALIGN_MASK)
+            n = 0;
+
+        if (!n) {
+            scatterwalk_copychunks(block, &src_walk, AES_BLOCK_SIZE, 0);
+            nbytes -= AES_BLOCK_SIZE;
+            scatterwalk_done(&src_walk, 0, nbytes);
+
+            moto_aes_cbc_encrypt_ctx(aes, (u8 *)block, (u8 *)block,
+                    AES_BLOCK_SIZE, iv);
+            err = crypto_shash_update(hdesc, (u8 *)block, AES_BLOCK_SIZE);
+
+            scatterwalk_copychunks(block, &dst_walk, AES_BLOCK_SIZE, 1);
+            scatterwalk_done(&dst_walk, 1, nbytes);
+            continue;
+        }
+
+        s = scatterwalk_map(&src_walk);
+        d = scatterwalk_map(&dst_walk);
+        moto_aes_cbc_encrypt_ctx(aes, d, s, n, iv);
+        err = crypto_shash_update(hdesc, d, n);
+        scatterwalk_unmap(d);
+        scatterwalk_unmap(s);
+
+        scatterwalk_advance(&src_walk, n);
+        scatterwalk_advance(&dst_walk, n);
+        nbytes -= n;
+        scatterwalk_done(&src_walk, 0, nbytes);
+        scatterwalk_done(&dst_walk, 1, nbytes);
+    }
+
+    memset(block, 0, sizeof(block));
+
+    return err;
+}
+
+static int moto_authenc_operate(struct aead_request *req, u8 *iv, int enc)
+{
+    struct crypto_aead *authenc = crypto_aead_reqtfm(req);
+    struct moto_authenc_ctx *ctx = crypto_aead_ctx(authenc);
+    unsigned int authsize = crypto_aead_authsize(authenc);
+    unsigned int ivsize = crypto_aead_ivsize(authenc);
+    unsigned int cryptlen = req->cryptlen;
+    u32 civ[MOTO_AUTHENC_MAX_BLOCKSIZE / sizeof(u32)];
+    u8 ihash[SHA512_DIGEST_SIZE];
+    u8 hash[SHA512_DIGEST_SIZE];
+    struct blkcipher_desc desc;
+    struct {
+        struct shash_desc shash;
+        char ctx[crypto_shash_descsize(ctx->auth)];
+    } hdesc;
+    unsigned int i;
+    u8 diff = 0;
     int err;
 
+    if (!enc) {
+        if (cryptlen < authsize)
+            return -EINVAL;
+        cryptlen -= authsize;
+    }
+
+    if (cryptlen % crypto_blkcipher_blocksize(ctx->enc))
+        return -EINVAL;
+
+    hdesc.shash.tfm = ctx->auth;
+    hdesc.shash.flags = req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    /* the cipher chains on its own copy, iv is hashed unmodified */
+    memcpy(civ, iv, ivsize);
+    desc.tfm = ctx->enc;
+    desc.info = civ;
+    desc.flags = req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    err = crypto_shash_init(&hdesc.shash) ?:
+            moto_authenc_hash_sg(&hdesc.shash, req->assoc,
+                    req->assoclen) ?:
+            crypto_shash_update(&hdesc.shash, iv, ivsize);
+    if (err)
+        goto out;
+
+    if (enc) {
+        if (ctx->aes)
+            err = moto_authenc_encrypt_sg(ctx->aes, &hdesc.shash,
+                    req->dst, req->src, cryptlen, (u8 *)civ);
+        else
+            err = crypto_blkcipher_encrypt_iv(&desc, req->dst, req->src,
+                    cryptlen) ?:
+                    moto_authenc_hash_sg(&hdesc.shash, req->dst,
+                            cryptlen);
+        err = err ?: crypto_shash_final(&hdesc.shash, hash);
+        if (!err)
+            scatterwalk_map_and_copy(hash, req->dst, cryptlen, authsize, 1);
+        goto out;
+    }
+
+    err = moto_authenc_hash_sg(&hdesc.shash, req->src, cryptlen) ?:
+            crypto_shash_final(&hdesc.shash, hash);
+    if (err)
+        goto out;
+
+    /*
+     * Nothing is decrypted before the tag matched. The compare is
+     * constant time so the tag does not leak through an early exit.
+     */
+    scatterwalk_map_and_copy(ihash, req->src, cryptlen, authsize, 0);
+    for (i = 0; i < authsize; i++)
+        diff |= ihash[i] ^ hash[i];
+    if (diff) {
+        err = -EBADMSG;
+        goto out;
+    }
+
+    err = crypto_blkcipher_decrypt_iv(&desc, req->dst, req->src, cryptlen);
+
+    out:
+    memset(&hdesc, 0, sizeof(hdesc));
+    memset(civ, 0, sizeof(civ));
+    memset(hash, 0, sizeof(hash));
+    return err;
+}
+
+static int moto_authenc_encrypt(struct aead_request *req)
+{
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    return moto_authenc_operate(req, req->iv, 1);
+}
+
+static int moto_authenc_decrypt(struct aead_request *req)
+{
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    return moto_authenc_operate(req, req->iv, 0);
+}
+
+/*
+ * The generated IV is E(K, salt ^ seq): unpredictable for CBC like the
+ * eseqiv one, but without a second pass over the payload.
+ */
+static int moto_authenc_givencrypt(struct aead_givcrypt_request *req)
+{
+    struct crypto_aead *authenc = aead_givcrypt_reqtfm(req);
+    struct moto_authenc_ctx *ctx = crypto_aead_ctx(authenc);
+    unsigned int ivsize = crypto_aead_ivsize(authenc);
+    u32 iv[MOTO_AUTHENC_MAX_BLOCKSIZE / sizeof(u32)];
+    u32 zero[MOTO_AUTHENC_MAX_BLOCKSIZE / sizeof(u32)];
+    __be64 seq = cpu_to_be64(req->seq);
+    struct blkcipher_desc desc;
+    struct scatterlist sg[1];
+    int err;
+
+    memcpy(iv, ctx->salt, ivsize);
+    moto_crypto_xor((u8 *)iv + ivsize - sizeof(seq), (u8 *)&seq,
+            sizeof(seq));
+
+    memset(zero, 0, sizeof(zero));
+    desc.tfm = ctx->enc;
+    desc.info = zero;
+    desc.flags = req->areq.base.flags & CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    sg_init_one(sg, iv, ivsize);
+    err = crypto_blkcipher_encrypt_iv(&desc, sg, sg, ivsize);
+    if (err)
+        return err;
+
+    memcpy(req->giv, iv, ivsize);
+
+    return moto_authenc_operate(&req->areq, req->giv, 1);
+}
+
+static int moto_authenc_init_tfm(struct crypto_tfm *tfm)
+{
+    struct crypto_instance *inst = (void *)tfm->__crt_alg;
+    struct moto_authenc_instance_ctx *ictx = crypto_instance_ctx(inst);
+    struct moto_authenc_ctx *ctx = crypto_tfm_ctx(tfm);
+    struct crypto_shash *auth;
+    struct crypto_blkcipher *enc;
+
+    auth = crypto_spawn_shash(&ictx->auth);
+    if (IS_ERR(auth))
+        return PTR_ERR(auth);
+
+    enc = crypto_spawn_blkcipher(&ictx->enc);
+    if (IS_ERR(enc)) {
+        crypto_free_shash(auth);
+        return PTR_ERR(enc);
+    }
+
+    ctx->auth = auth;
+    ctx->enc = enc;
+    ctx->aes = NULL;
+    if (!strcmp(crypto_tfm_alg_driver_name(crypto_blkcipher_tfm(enc)),
+            "moto-aes-cbc"))
+        ctx->aes = crypto_blkcipher_ctx(enc);
+    get_random_bytes(ctx->salt, sizeof(ctx->salt));
+
+    return 0;
+}
+
+static void moto_authenc_exit_tfm(struct crypto_tfm *tfm)
+{
+    struct moto_authenc_ctx *ctx = crypto_tfm_ctx(tfm);
+
+    crypto_free_shash(ctx->auth);
+    crypto_free_blkcipher(ctx->enc);
+    memset(ctx->salt, 0, sizeof(ctx->salt));
+}
+
+static struct crypto_instance *moto_authenc_alloc(struct rtattr **tb)
+{
+    struct moto_authenc_instance_ctx *ctx;
+    struct crypto_attr_type *algt;
+    struct crypto_instance *inst;
+    struct crypto_alg *auth_base;
+    struct shash_alg *auth;
+    struct crypto_alg *enc;
+    int err;
+
+    algt = crypto_get_attr_type(tb);
+    if (IS_ERR(algt))
+        return ERR_CAST(algt);
+
+    if ((algt->type ^ CRYPTO_ALG_TYPE_AEAD) & algt->mask)
+        return ERR_PTR(-EINVAL);
+
+    auth = shash_attr_alg(tb[1], 0, 0);
+    if (IS_ERR(auth))
+        return ERR_CAST(auth);
+
+    auth_base = &auth->base;
+
+    enc = crypto_attr_alg(tb[2], CRYPTO_ALG_TYPE_BLKCIPHER,
+            CRYPTO_ALG_TYPE_MASK);
+    err = PTR_ERR(enc);
+    if (IS_ERR(enc))
+        goto out_put_auth;
+
+    /* the chained and the generated IV are kept on the stack */
+    err = -EINVAL;
+    if (enc->cra_blocksize > MOTO_AUTHENC_MAX_BLOCKSIZE ||
+            enc->cra_blkcipher.ivsize > MOTO_AUTHENC_MAX_BLOCKSIZE ||
+            enc->cra_blkcipher.ivsize < sizeof(u64) ||
+            auth->digestsize > SHA512_DIGEST_SIZE)
+        goto out_put_enc;
+
+    inst = kzalloc(sizeof(*inst) + sizeof(*ctx), GFP_KERNEL);
+    err = -ENOMEM;
+    if (!inst)
+        goto out_put_enc;
+
+    ctx = crypto_instance_ctx(inst);
+
+    err = crypto_init_shash_spawn(&ctx->auth, auth, inst);
+    if (err)
+        goto err_free_inst;
+
+    err = crypto_init_spawn(&ctx->enc, enc, inst, CRYPTO_ALG_TYPE_MASK);
+    if (err)
+        goto err_drop_auth;
+
+    err = -ENAMETOOLONG;
+    if (snprintf(inst->alg.cra_name, CRYPTO_MAX_ALG_NAME,
+            "authenc(%s,%s)", auth_base->cra_name, enc->cra_name) >=
+            CRYPTO_MAX_ALG_NAME)
+        goto err_drop_enc;
+
+    if (snprintf(inst->alg.cra_driver_name, CRYPTO_MAX_ALG_NAME,
+            "moto_authenc(%s,%s)", auth_base->cra_driver_name,
+            enc->cra_driver_name) >= CRYPTO_MAX_ALG_NAME)
+        goto err_drop_enc;
+
+    inst->alg.cra_flags = CRYPTO_ALG_TYPE_AEAD;
+    /* one above the generic authenc over the same children */
+    inst->alg.cra_priority = enc->cra_priority * 10 +
+            auth_base->cra_priority + 1;
+    inst->alg.cra_blocksize = enc->cra_blocksize;
+    inst->alg.cra_alignmask = auth_base->cra_alignmask | enc->cra_alignmask;
+    inst->alg.cra_type = &crypto_aead_type;
+
+    inst->alg.cra_aead.ivsize = enc->cra_blkcipher.ivsize;
+    inst->alg.cra_aead.maxauthsize = auth->digestsize;
+
+    inst->alg.cra_ctxsize = sizeof(struct moto_authenc_ctx);
+
+    inst->alg.cra_init = moto_authenc_init_tfm;
+    inst->alg.cra_exit = moto_authenc_exit_tfm;
+    moto_post_alg_hook(&inst->alg);
+
+    inst->alg.cra_aead.setkey = moto_authenc_setkey;
+    inst->alg.cra_aead.encrypt = moto_authenc_encrypt;
+    inst->alg.cra_aead.decrypt = moto_authenc_decrypt;
+    inst->alg.cra_aead.givencrypt = moto_authenc_givencrypt;
+
+    out:
+    crypto_mod_put(enc);
+    crypto_mod_put(auth_base);
+    return inst;
+
+    err_drop_enc:
+    crypto_drop_spawn(&ctx->enc);
+    err_drop_auth:
+    crypto_drop_shash(&ctx->auth);
+    err_free_inst:
+    kfree(inst);
+    inst = ERR_PTR(err);
+    goto out;
+
+    out_put_enc:
+    crypto_mod_put(enc);
+    out_put_auth:
+    crypto_mod_put(auth_base);
+    return ERR_PTR(err);
+}
+
+static void moto_authenc_free(struct crypto_instance *inst)
+{
+    struct moto_authenc_instance_ctx *ctx = crypto_instance_ctx(inst);
+
+    crypto_drop_spawn(&ctx->enc);
+    crypto_drop_shash(&ctx->auth);
+    kfree(inst);
+}
+
+static struct crypto_template moto_authenc_tmpl = {
+        .name   = "moto_authenc",
+        .alloc  = moto_authenc_alloc,
+        .free   = moto_authenc_free,
+        .module = THIS_MODULE,
+};
+
+/* The instances tested at start up */
+static const char * const moto_hmac_post_drivers[] = {
+    "moto_hmac(moto-sha1)",
+    "moto_hmac(moto-sha224)",
+    "moto_hmac(moto-sha256)",
+    "moto_hmac(moto-sha384)",
+    "moto_hmac(moto-sha512)",
+    "moto_hmac(moto-sha512_224)",
+    "moto_hmac(moto-sha512_256)",
+};
+
+#define MOTO_AUTHENC_POST_DRIVER \
+    "moto_authenc(moto_hmac(moto-sha256),moto-aes-cbc)"
+#define MOTO_AUTHENC_POST_ALG   "authenc(moto_hmac(sha256),cbc(aes))"
+
+int moto_hmac_start(void)
+{
+    int i, err = 0;
+
+    /* Before the templates, their instances are hooked when created */
+    for (i = 0; !err && i < ARRAY_SIZE(moto_hmac_post_drivers); i++)
+        err = moto_post_alg_defer(NULL, moto_hmac_post_drivers[i],
+                moto_hmac_post_drivers[i], MOTO_CRYPTO_FAILED_ALG_HMAC);
+    if (!err)
+        err = moto_post_alg_defer(NULL, MOTO_AUTHENC_POST_DRIVER,
+                MOTO_AUTHENC_POST_ALG, MOTO_CRYPTO_FAILED_ALG_HMAC);
+    if (err)
+        return err;
+
     err = crypto_register_template(&moto_hmac_tmpl);
     printk (KERN_INFO "moto_hmac register result: %d\n", err);
-    if (!err) {
+    if (!err)
         moto_hmac_registered = 1;
-        err = moto_alg_test("moto_hmac(moto-sha1)", "moto_hmac(moto-sha1)", 0, 0);
-        printk (KERN_INFO "moto_hmac(moto-sha1) test result: %d\n", err);
-    }
-    if (!err) {
-        err = moto_alg_test("moto_hmac(moto-sha224)", "moto_hmac(moto-sha224)", 0, 0);
-        printk (KERN_INFO "moto_hmac(moto-sha224) test result: %d\n", err);
+    for (i = 0; !err && i < ARRAY_SIZE(moto_hmac_post_drivers); i++) {
+        err = moto_post_alg_test(moto_hmac_post_drivers[i],
+                moto_hmac_post_drivers[i], MOTO_CRYPTO_FAILED_ALG_HMAC);
+        printk (KERN_INFO "%s test result: %d\n", moto_hmac_post_drivers[i],
+                err);
     }
     if (!err) {
-        err = moto_alg_test("moto_hmac(moto-sha256)", "moto_hmac(moto-sha256)", 0, 0);
-        printk (KERN_INFO "moto_hmac(moto-sha256) test result: %d\n", err);
+        err = crypto_register_template(&moto_authenc_tmpl);
+        printk (KERN_INFO "moto_authenc register result: %d\n", err);
     }
     if (!err) {
-        err = moto_alg_test("moto_hmac(moto-sha384)", "moto_hmac(moto-sha384)", 0, 0);
-        printk (KERN_INFO "moto_hmac(moto-sha384) test result: %d\n", err);
-    }
-    if (!err) {
-        err = moto_alg_test("moto_hmac(moto-sha512)", "moto_hmac(moto-sha512)", 0, 0);
-        printk (KERN_INFO "moto_hmac(moto-sha512) test result: %d\n", err);
+        moto_authenc_registered = 1;
+        err = moto_post_alg_test(MOTO_AUTHENC_POST_DRIVER,
+                MOTO_AUTHENC_POST_ALG, MOTO_CRYPTO_FAILED_ALG_HMAC);
+        printk (KERN_INFO "%s test result: %d\n", MOTO_AUTHENC_POST_DRIVER,
+                err);
     }
 
     return err;
@@ -295,6 +828,11 @@ int moto_hmac_start(void)
 
 void moto_hmac_finish(void)
 {
+    if (moto_authenc_registered)
+    {
+        crypto_unregister_template(&moto_authenc_tmpl);
+        moto_authenc_registered = 0;
+    }
     if (moto_hmac_registered) 
     {
         crypto_unregister_template(&moto_hmac_tmpl);
@@ -26,7 +26,10 @@
 #include <asm/byteorder.h>
 
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 #include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 
 static int moto_sha1_registered = 0;
 
@@ -43,33 +46,81 @@ static int moto_sha1_registered = 0;
 #define K3  0x8F1BBCDCL			/* Rounds 40-59: sqrt(5) * 2^30 */
 #define K4  0xCA62C1D6L			/* Rounds 60-79: sqrt(10) * 2^30 */
 
-#define SHA_WORKSPACE_WORDS 80
+/* Message schedule word i >= 16, kept in a rolling window of 16 words */
+#define SHA1_W(i)   (W[(i) & 15] = rol32(W[((i) + 13) & 15] ^ \
+        W[((i) + 8) & 15] ^ W[((i) + 2) & 15] ^ W[(i) & 15], 1))
 
 /**
- * sha_transform - single block SHA1 transform
+ * moto_sha1_transform_blocks - SHA1 transform of consecutive blocks
  *
- * @digest: 160 bit digest to update
- * @data:   512 bits of data to hash
- * @W:      80 words of workspace (see note)
+ * @digest:  160 bit digest to update
+ * @in:      nblocks 512-bit blocks of data to hash
+ * @nblocks: number of blocks
  *
- * This function generates a SHA1 digest for a single 512-bit block.
- * Be warned, it does not handle padding and message digest, do not
+ * This function does not handle padding and message digest, do not
  * confuse it with the full FIPS 180-1 digest algorithm for variable
- * length messages.
- *
- * Note: If the hash is security sensitive, the caller should be sure
- * to clear the workspace. This is left to the caller to avoid
- * unnecessary clears between chained hashing operations.
+ * length messages. The message schedule is a 16-word window on the
+ * stack, wiped once before returning.
  */
-void moto_sha_transform(__u32 *digest, const char *in, __u32 *W)
+void moto_sha1_transform_blocks(u32 *digest, const u8 *in,
+        unsigned int nblocks)
 {
-    __u32 a, b, c, d, e, t, i;
+    u32 a, b, c, d, e, t, i;
+    u32 W[16];
+
+    a = digest[0];
+    b = digest[1];
+    c = digest[2];
+    d = digest[3];
+    e = digest[4];
+
+    while (nblocks--) {
+        for (i = 0; i < 16; i++) {
+            W[i] = be32_to_cpu(((const __be32 *)in)[i]);
+            t = f1(b, c, d) + K1 + rol32(a, 5) + e + W[i];
+            e = d; d = c; c = rol32(b, 30); b = a; a = t;
+        }
+
+        for (; i < 20; i++) {
+            t = f1(b, c, d) + K1 + rol32(a, 5) + e + SHA1_W(i);
+            e = d; d = c; c = rol32(b, 30); b = a; a = t;
+        }
+
+        for (; i < 40; i ++) {
+            t = f2(b, c, d) + K2 + rol32(a, 5) + e + SHA1_W(i);
+            e = d; d = c; c = rol32(b, 30); b = a; a = t;
+        }
+
+        for (; i < 60; i ++) {
+            t = f3(b, c, d) + K3 + rol32(a, 5) + e + SHA1_W(i);
+            e = d; d = c; c = rol32(b, 30); b = a; a = t;
+        }
+
+        for (; i < 80; i ++) {
+            t = f2(b, c, d) + K4 + rol32(a, 5) + e + SHA1_W(i);
+            e = d; d = c; c = rol32(b, 30); b = a; a = t;
+        }
 
-    for (i = 0; i < 16; i++)
-        W[i] = be32_to_cpu(((const __be32 *)in)[i]);
+        a = digest[0] += a;
+        b = digest[1] += b;
+        c = digest[2] += c;
+        d = digest[3] += d;
+        e = digest[4] += e;
+        in += SHA1_BLOCK_SIZE;
+    }
 
-    for (i = 0; i < 64; i++)
-        W[i+16] = rol32(W[i+13] ^ W[i+8] ^ W[i+2] ^ W[i], 1);
+    /* clear any sensitive info... */
+    a = b = c = d = e = t = 0;
+    memset(W, 0, sizeof(W));
+}
+
+/*
+ * SHA1 rounds of one block whose 80-word message schedule W[] was
+ * expanded by the caller, see moto_sha_x86.c.
+ */
+void moto_sha1_transform_w(u32 *digest, const u32 *W)
+{
+    u32 a, b, c, d, e, t, i;
 
     a = digest[0];
     b = digest[1];
@@ -102,9 +153,23 @@ void moto_sha_transform(__u32 *digest, const char *in, __u32 *W)
     digest[2] += c;
     digest[3] += d;
     digest[4] += e;
+
+    /* clear any sensitive info... */
+    a = b = c = d = e = t = 0;
 }
 
-static int moto_sha1_init(struct shash_desc *desc)
+/*
+ * Block function of moto-sha1, switched to an accelerated one by
+ * moto_sha_x86_start() once that one passed its tests
+ */
+static moto_sha_block_fn *moto_sha1_blocks = moto_sha1_transform_blocks;
+
+void moto_sha1_set_blocks(moto_sha_block_fn *blocks)
+{
+    moto_sha1_blocks = blocks ? blocks : moto_sha1_transform_blocks;
+}
+
+int moto_sha1_init(struct shash_desc *desc)
 {
     struct moto_sha1_state *sctx = shash_desc_ctx(desc);
 
@@ -115,8 +180,8 @@ static int moto_sha1_init(struct shash_desc *desc)
     return 0;
 }
 
-static int moto_sha1_update(struct shash_desc *desc, const u8 *data,
-        unsigned int len)
+static int _moto_sha1_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len, moto_sha_block_fn *blocks)
 {
     struct moto_sha1_state *sctx = shash_desc_ctx(desc);
     unsigned int partial, done;
@@ -128,21 +193,18 @@ static int moto_sha1_update(struct shash_desc *desc, const u8 *data,
     src = data;
 
     if ((partial + len) > 63) {
-        u32 temp[SHA_WORKSPACE_WORDS];
-
         if (partial) {
             done = -partial;
             memcpy(sctx->buffer + partial, data, done + 64);
-            src = sctx->buffer;
-        }
-
-        do {
-            moto_sha_transform(sctx->state, src, temp);
+            blocks(sctx->state, sctx->buffer, 1);
             done += 64;
-            src = data + done;
-        } while (done + 63 < len);
+        }
 
-        memset(temp, 0, sizeof(temp));
+        if (len - done > 63) {
+            blocks(sctx->state, data + done, (len - done) / 64);
+            done += (len - done) & ~63;
+        }
+        src = data + done;
         partial = 0;
     }
     memcpy(sctx->buffer + partial, src, len - done);
@@ -150,25 +212,53 @@ static int moto_sha1_update(struct shash_desc *desc, const u8 *data,
     return 0;
 }
 
+int moto_sha1_do_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len, moto_sha_block_fn *blocks)
+{
+    ktime_t start = moto_stats_start();
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_hash_start(crypto_shash_tfm(desc->tfm), "update", len);
+    _moto_sha1_update(desc, data, len, blocks);
+    trace_moto_hash_done(crypto_shash_tfm(desc->tfm), "update", len);
+    moto_stats_account(MOTO_STATS_SHA1, len, start);
+
+    return 0;
+}
+
+static int moto_sha1_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len)
+{
+    return moto_sha1_do_update(desc, data, len, moto_sha1_blocks);
+}
 
 /* Add padding and return the message digest. */
-static int moto_sha1_final(struct shash_desc *desc, u8 *out)
+int moto_sha1_do_final(struct shash_desc *desc, u8 *out,
+        moto_sha_block_fn *blocks)
 {
     struct moto_sha1_state *sctx = shash_desc_ctx(desc);
     __be32 *dst = (__be32 *)out;
     u32 i, index, padlen;
     __be64 bits;
     static const u8 padding[64] = { 0x80, };
+    ktime_t start = moto_stats_start();
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_hash_start(crypto_shash_tfm(desc->tfm), "final", 0);
 
     bits = cpu_to_be64(sctx->count << 3);
 
     /* Pad out to 56 mod 64 */
     index = sctx->count & 0x3f;
     padlen = (index < 56) ? (56 - index) : ((64+56) - index);
-    moto_sha1_update(desc, padding, padlen);
+    _moto_sha1_update(desc, padding, padlen, blocks);
 
     /* Append length */
-    moto_sha1_update(desc, (const u8 *)&bits, sizeof(bits));
+    _moto_sha1_update(desc, (const u8 *)&bits, sizeof(bits), blocks);
 
     /* Store state in digest */
     for (i = 0; i < 5; i++)
@@ -180,10 +270,17 @@ static int moto_sha1_final(struct shash_desc *desc, u8 *out)
     printk(KERN_INFO "SHA1 context after zeroization:\n");
     moto_hexdump((unsigned char *)(sctx), sizeof *sctx);
 #endif
+    trace_moto_hash_done(crypto_shash_tfm(desc->tfm), "final", 0);
+    moto_stats_account(MOTO_STATS_SHA1, 0, start);
 
     return 0;
 }
 
+static int moto_sha1_final(struct shash_desc *desc, u8 *out)
+{
+    return moto_sha1_do_final(desc, out, moto_sha1_blocks);
+}
+
 static int moto_sha1_export(struct shash_desc *desc, void *out)
 {
     struct moto_sha1_state *sctx = shash_desc_ctx(desc);
@@ -223,11 +320,14 @@ int moto_sha1_start(void)
 {
     int err;
 
-    err = crypto_register_shash(&alg);
+    err = moto_post_alg_defer(&alg.base, "moto-sha1",
+            "sha1", MOTO_CRYPTO_FAILED_ALG_SHA1) ?:
+            crypto_register_shash(&alg);
     printk (KERN_INFO "sha1 register result: %d\n", err);
     if (!err) {
         moto_sha1_registered = 1;
-        err = moto_alg_test("moto-sha1", "sha1", 0, 0);
+        err = moto_post_alg_test("moto-sha1", "sha1",
+                MOTO_CRYPTO_FAILED_ALG_SHA1);
         printk (KERN_INFO "sha1 test result: %d\n", err);
     }
     return err;
@@ -23,10 +23,14 @@
 #include <linux/mm.h>
 #include <linux/types.h>
 #include <moto_sha.h>
+#include <moto_sha256_mb.h>
 #include <asm/byteorder.h>
 
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 #include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 
 static int moto_sha224_registered = 0;
 static int moto_sha256_registered = 0;
@@ -46,181 +50,201 @@ static inline u32 Maj(u32 x, u32 y, u32 z)
 #define s0(x)       (ror32(x, 7) ^ ror32(x,18) ^ (x >> 3))
 #define s1(x)       (ror32(x,17) ^ ror32(x,19) ^ (x >> 10))
 
-static inline void LOAD_OP(int I, u32 *W, const u8 *input)
-{
-    W[I] = __be32_to_cpu( ((__be32*)(input))[I] );
-}
+const u32 moto_sha256_K[64] __aligned(16) = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+        0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+        0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+        0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+        0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
 
-static inline void BLEND_OP(int I, u32 *W)
-{
-    W[I] = s1(W[I-2]) + W[I-7] + s0(W[I-15]) + W[I-16];
-}
+/* Message schedule words, the last 16 of them kept in W[] */
+#define LOAD_OP(i)  (W[i] = __be32_to_cpu(((const __be32 *)(input))[i]))
+#define BLEND_OP(i) (W[(i) & 15] += s1(W[((i) - 2) & 15]) + \
+        W[((i) - 7) & 15] + s0(W[((i) - 15) & 15]))
+/* Or all 64 of them, computed beforehand */
+#define SCHED_OP(i) (W[i])
+
+#define ROUND(i, w, a, b, c, d, e, f, g, h)                             \
+    t1 = h + e1(e) + Ch(e,f,g) + moto_sha256_K[i] + (w);                \
+    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2
+
+#define ROUNDS8(i, OP)                                                  \
+    ROUND(i + 0, OP(i + 0), a, b, c, d, e, f, g, h);                    \
+    ROUND(i + 1, OP(i + 1), h, a, b, c, d, e, f, g);                    \
+    ROUND(i + 2, OP(i + 2), g, h, a, b, c, d, e, f);                    \
+    ROUND(i + 3, OP(i + 3), f, g, h, a, b, c, d, e);                    \
+    ROUND(i + 4, OP(i + 4), e, f, g, h, a, b, c, d);                    \
+    ROUND(i + 5, OP(i + 5), d, e, f, g, h, a, b, c);                    \
+    ROUND(i + 6, OP(i + 6), c, d, e, f, g, h, a, b);                    \
+    ROUND(i + 7, OP(i + 7), b, c, d, e, f, g, h, a)
 
-static void moto_sha256_transform(u32 *state, const u8 *input)
+/*
+ * SHA-256 transform of nblocks consecutive 64-byte blocks. The message
+ * schedule is a 16-word window on the stack, wiped once before returning.
+ */
+void moto_sha256_transform_blocks(u32 *state, const u8 *input,
+        unsigned int nblocks)
 {
     u32 a, b, c, d, e, f, g, h, t1, t2;
-    u32 W[64];
+    u32 W[16];
     int i;
 
-    /* load the input */
-    for (i = 0; i < 16; i++)
-        LOAD_OP(i, W, input);
+    /* load the state into our registers */
+    a=state[0];  b=state[1];  c=state[2];  d=state[3];
+    e=state[4];  f=state[5];  g=state[6];  h=state[7];
+
+    while (nblocks--) {
+        /* the first 16 rounds load the input, the others blend */
+        ROUNDS8(0, LOAD_OP);
+        ROUNDS8(8, LOAD_OP);
+        for (i = 16; i < 64; i += 8) {
+            ROUNDS8(i, BLEND_OP);
+        }
 
-    /* now blend */
-    for (i = 16; i < 64; i++)
-        BLEND_OP(i, W);
+        a = state[0] += a;  b = state[1] += b;
+        c = state[2] += c;  d = state[3] += d;
+        e = state[4] += e;  f = state[5] += f;
+        g = state[6] += g;  h = state[7] += h;
+        input += SHA256_BLOCK_SIZE;
+    }
+
+    /* clear any sensitive info... */
+    a = b = c = d = e = f = g = h = t1 = t2 = 0;
+    memset(W, 0, sizeof(W));
+}
+
+/*
+ * SHA-256 rounds of one block whose 64-word message schedule W[] was
+ * expanded by the caller, see moto_sha_x86.c.
+ */
+void moto_sha256_transform_w(u32 *state, const u32 *W)
+{
+    u32 a, b, c, d, e, f, g, h, t1, t2;
+    int i;
 
-    /* load the state into our registers */
     a=state[0];  b=state[1];  c=state[2];  d=state[3];
     e=state[4];  f=state[5];  g=state[6];  h=state[7];
 
-    /* now iterate */
-    t1 = h + e1(e) + Ch(e,f,g) + 0x428a2f98 + W[ 0];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0x71374491 + W[ 1];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0xb5c0fbcf + W[ 2];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0xe9b5dba5 + W[ 3];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0x3956c25b + W[ 4];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0x59f111f1 + W[ 5];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0x923f82a4 + W[ 6];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0xab1c5ed5 + W[ 7];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0xd807aa98 + W[ 8];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0x12835b01 + W[ 9];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0x243185be + W[10];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0x550c7dc3 + W[11];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0x72be5d74 + W[12];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0x80deb1fe + W[13];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0x9bdc06a7 + W[14];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0xc19bf174 + W[15];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0xe49b69c1 + W[16];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0xefbe4786 + W[17];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0x0fc19dc6 + W[18];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0x240ca1cc + W[19];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0x2de92c6f + W[20];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0x4a7484aa + W[21];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0x5cb0a9dc + W[22];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0x76f988da + W[23];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0x983e5152 + W[24];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0xa831c66d + W[25];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0xb00327c8 + W[26];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0xbf597fc7 + W[27];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0xc6e00bf3 + W[28];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0xd5a79147 + W[29];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0x06ca6351 + W[30];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0x14292967 + W[31];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0x27b70a85 + W[32];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0x2e1b2138 + W[33];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0x4d2c6dfc + W[34];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0x53380d13 + W[35];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0x650a7354 + W[36];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0x766a0abb + W[37];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0x81c2c92e + W[38];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0x92722c85 + W[39];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0xa2bfe8a1 + W[40];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0xa81a664b + W[41];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0xc24b8b70 + W[42];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0xc76c51a3 + W[43];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0xd192e819 + W[44];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0xd6990624 + W[45];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0xf40e3585 + W[46];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0x106aa070 + W[47];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0x19a4c116 + W[48];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0x1e376c08 + W[49];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0x2748774c + W[50];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0x34b0bcb5 + W[51];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0x391c0cb3 + W[52];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0x4ed8aa4a + W[53];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0x5b9cca4f + W[54];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0x682e6ff3 + W[55];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    t1 = h + e1(e) + Ch(e,f,g) + 0x748f82ee + W[56];
-    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-    t1 = g + e1(d) + Ch(d,e,f) + 0x78a5636f + W[57];
-    t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-    t1 = f + e1(c) + Ch(c,d,e) + 0x84c87814 + W[58];
-    t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-    t1 = e + e1(b) + Ch(b,c,d) + 0x8cc70208 + W[59];
-    t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-    t1 = d + e1(a) + Ch(a,b,c) + 0x90befffa + W[60];
-    t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-    t1 = c + e1(h) + Ch(h,a,b) + 0xa4506ceb + W[61];
-    t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-    t1 = b + e1(g) + Ch(g,h,a) + 0xbef9a3f7 + W[62];
-    t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-    t1 = a + e1(f) + Ch(f,g,h) + 0xc67178f2 + W[63];
-    t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-
-    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
-    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    for (i = 0; i < 64; i += 8) {
+        ROUNDS8(i, SCHED_OP);
+    }
+
+    state[0] += a;  state[1] += b;  state[2] += c;  state[3] += d;
+    state[4] += e;  state[5] += f;  state[6] += g;  state[7] += h;
 
     /* clear any sensitive info... */
     a = b = c = d = e = f = g = h = t1 = t2 = 0;
-    memset(W, 0, 64 * sizeof(u32));
 }
 
+/* One round on every lane, the lanes are independent chains */
+#define LANES_ROUND(i, a, b, c, d, e, f, g, h)                          \
+    for (l = 0; l < lanes; l++) {                                       \
+        t1 = h[l] + e1(e[l]) + Ch(e[l],f[l],g[l]) + moto_sha256_K[i] +  \
+                W[(i) * lanes + l];                                     \
+        t2 = e0(a[l]) + Maj(a[l],b[l],c[l]);                            \
+        d[l] += t1;   h[l] = t1 + t2;                                   \
+    }
 
-static int moto_sha224_init(struct shash_desc *desc)
+/*
+ * SHA-256 transform of one block in each of lanes independent messages,
+ * for the multi-buffer engine, see moto_sha256_mb.c. Words are stored
+ * lane after lane: state[8][lanes], W[64][lanes] with the first 16 rows
+ * loaded by the caller. Interleaving the lanes round by round keeps the
+ * otherwise serial rounds of several messages in flight at once.
+ */
+static __always_inline void __moto_sha256_transform_lanes(u32 *state, u32 *W,
+        const unsigned int lanes)
+{
+    u32 a[MOTO_SHA256_MB_MAX_LANES], b[MOTO_SHA256_MB_MAX_LANES];
+    u32 c[MOTO_SHA256_MB_MAX_LANES], d[MOTO_SHA256_MB_MAX_LANES];
+    u32 e[MOTO_SHA256_MB_MAX_LANES], f[MOTO_SHA256_MB_MAX_LANES];
+    u32 g[MOTO_SHA256_MB_MAX_LANES], h[MOTO_SHA256_MB_MAX_LANES];
+    u32 t1, t2;
+    unsigned int i, l;
+
+    for (i = 16; i < 64; i++) {
+        for (l = 0; l < lanes; l++)
+            W[i * lanes + l] = s1(W[(i - 2) * lanes + l]) +
+                    W[(i - 7) * lanes + l] + s0(W[(i - 15) * lanes + l]) +
+                    W[(i - 16) * lanes + l];
+    }
+
+    for (l = 0; l < lanes; l++) {
+        a[l] = state[0 * lanes + l];  b[l] = state[1 * lanes + l];
+        c[l] = state[2 * lanes + l];  d[l] = state[3 * lanes + l];
+        e[l] = state[4 * lanes + l];  f[l] = state[5 * lanes + l];
+        g[l] = state[6 * lanes + l];  h[l] = state[7 * lanes + l];
+    }
+
+    for (i = 0; i < 64; i += 8) {
+        LANES_ROUND(i + 0, a, b, c, d, e, f, g, h);
+        LANES_ROUND(i + 1, h, a, b, c, d, e, f, g);
+        LANES_ROUND(i + 2, g, h, a, b, c, d, e, f);
+        LANES_ROUND(i + 3, f, g, h, a, b, c, d, e);
+        LANES_ROUND(i + 4, e, f, g, h, a, b, c, d);
+        LANES_ROUND(i + 5, d, e, f, g, h, a, b, c);
+        LANES_ROUND(i + 6, c, d, e, f, g, h, a, b);
+        LANES_ROUND(i + 7, b, c, d, e, f, g, h, a);
+    }
+
+    for (l = 0; l < lanes; l++) {
+        state[0 * lanes + l] += a[l];  state[1 * lanes + l] += b[l];
+        state[2 * lanes + l] += c[l];  state[3 * lanes + l] += d[l];
+        state[4 * lanes + l] += e[l];  state[5 * lanes + l] += f[l];
+        state[6 * lanes + l] += g[l];  state[7 * lanes + l] += h[l];
+    }
+
+    /* clear any sensitive info... */
+    memset(a, 0, sizeof(a));  memset(b, 0, sizeof(b));
+    memset(c, 0, sizeof(c));  memset(d, 0, sizeof(d));
+    memset(e, 0, sizeof(e));  memset(f, 0, sizeof(f));
+    memset(g, 0, sizeof(g));  memset(h, 0, sizeof(h));
+    t1 = t2 = 0;
+}
+
+/* Constant lane counts let the compiler keep the lanes in registers */
+void moto_sha256_transform_lanes(u32 *state, u32 *W, unsigned int lanes)
+{
+    switch (lanes) {
+    case 2:
+        __moto_sha256_transform_lanes(state, W, 2);
+        break;
+    case 4:
+        __moto_sha256_transform_lanes(state, W, 4);
+        break;
+    case 8:
+        __moto_sha256_transform_lanes(state, W, 8);
+        break;
+    default:
+        __moto_sha256_transform_lanes(state, W, lanes);
+        break;
+    }
+}
+
+/*
+ * Block function of moto-sha224 and moto-sha256, switched to an
+ * accelerated one by moto_sha_x86_start() once that one passed its tests
+ */
+static moto_sha_block_fn *moto_sha256_blocks = moto_sha256_transform_blocks;
+
+void moto_sha256_set_blocks(moto_sha_block_fn *blocks)
+{
+    moto_sha256_blocks = blocks ? blocks : moto_sha256_transform_blocks;
+}
+
+int moto_sha224_init(struct shash_desc *desc)
 {
     struct moto_sha256_state *sctx = shash_desc_ctx(desc);
 
@@ -237,7 +261,7 @@ static int moto_sha224_init(struct shash_desc *desc)
     return 0;
 }
 
-static int moto_sha256_init(struct shash_desc *desc)
+int moto_sha256_init(struct shash_desc *desc)
 {
     struct moto_sha256_state *sctx = shash_desc_ctx(desc);
 
@@ -254,8 +278,15 @@ static int moto_sha256_init(struct shash_desc *desc)
     return 0;
 }
 
-static int moto_sha256_update(struct shash_desc *desc, const u8 *data,
-        unsigned int len)
+/* moto-sha224 shares the sha256 update and final */
+static inline enum moto_stats_id moto_sha256_stats_id(struct shash_desc *desc)
+{
+    return crypto_shash_digestsize(desc->tfm) == SHA224_DIGEST_SIZE ?
+        MOTO_STATS_SHA224 : MOTO_STATS_SHA256;
+}
+
+static int _moto_sha256_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len, moto_sha_block_fn *blocks)
 {
     struct moto_sha256_state *sctx = shash_desc_ctx(desc);
     unsigned int partial, done;
@@ -270,15 +301,15 @@ static int moto_sha256_update(struct shash_desc *desc, const u8 *data,
         if (partial) {
             done = -partial;
             memcpy(sctx->buf + partial, data, done + 64);
-            src = sctx->buf;
-        }
-
-        do {
-            moto_sha256_transform(sctx->state, src);
+            blocks(sctx->state, sctx->buf, 1);
             done += 64;
-            src = data + done;
-        } while (done + 63 < len);
+        }
 
+        if (len - done > 63) {
+            blocks(sctx->state, data + done, (len - done) / 64);
+            done += (len - done) & ~63;
+        }
+        src = data + done;
         partial = 0;
     }
     memcpy(sctx->buf + partial, src, len - done);
@@ -286,7 +317,30 @@ static int moto_sha256_update(struct shash_desc *desc, const u8 *data,
     return 0;
 }
 
-static int moto_sha256_final(struct shash_desc *desc, u8 *out)
+int moto_sha256_do_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len, moto_sha_block_fn *blocks)
+{
+    ktime_t start = moto_stats_start();
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_hash_start(crypto_shash_tfm(desc->tfm), "update", len);
+    _moto_sha256_update(desc, data, len, blocks);
+    trace_moto_hash_done(crypto_shash_tfm(desc->tfm), "update", len);
+    moto_stats_account(moto_sha256_stats_id(desc), len, start);
+
+    return 0;
+}
+
+static int moto_sha256_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len)
+{
+    return moto_sha256_do_update(desc, data, len, moto_sha256_blocks);
+}
+
+int moto_sha256_do_final(struct shash_desc *desc, u8 *out,
+        moto_sha_block_fn *blocks)
 {
     struct moto_sha256_state *sctx = shash_desc_ctx(desc);
     __be32 *dst = (__be32 *)out;
@@ -294,6 +348,12 @@ static int moto_sha256_final(struct shash_desc *desc, u8 *out)
     unsigned int index, pad_len;
     int i;
     static const u8 padding[64] = { 0x80, };
+    ktime_t start = moto_stats_start();
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_hash_start(crypto_shash_tfm(desc->tfm), "final", 0);
 
     /* Save number of bits */
     bits = cpu_to_be64(sctx->count << 3);
@@ -301,10 +361,11 @@ static int moto_sha256_final(struct shash_desc *desc, u8 *out)
     /* Pad out to 56 mod 64. */
     index = sctx->count & 0x3f;
     pad_len = (index < 56) ? (56 - index) : ((64+56) - index);
-    moto_sha256_update(desc, padding, pad_len);
+    _moto_sha256_update(desc, padding, pad_len, blocks);
 
     /* Append length (before padding) */
-    moto_sha256_update(desc, (const u8 *)&bits, sizeof(bits));
+    _moto_sha256_update(desc, (const u8 *)&bits, sizeof(bits),
+            blocks);
 
     /* Store state in digest */
     for (i = 0; i < 8; i++)
@@ -316,15 +377,25 @@ static int moto_sha256_final(struct shash_desc *desc, u8 *out)
     printk(KERN_INFO "SHA context after zeroization:\n");
     moto_hexdump((unsigned char *)(sctx), sizeof *sctx);
 #endif
+    trace_moto_hash_done(crypto_shash_tfm(desc->tfm), "final", 0);
+    moto_stats_account(moto_sha256_stats_id(desc), 0, start);
 
     return 0;
 }
 
+static int moto_sha256_final(struct shash_desc *desc, u8 *out)
+{
+    return moto_sha256_do_final(desc, out, moto_sha256_blocks);
+}
+
 static int moto_sha224_final(struct shash_desc *desc, u8 *hash)
 {
     u8 D[SHA256_DIGEST_SIZE];
+    int err;
 
-    moto_sha256_final(desc, D);
+    err = moto_sha256_final(desc, D);
+    if (err)
+        return err;
 
     memcpy(hash, D, SHA224_DIGEST_SIZE);
     memset(D, 0, SHA256_DIGEST_SIZE);
@@ -387,22 +458,28 @@ int moto_sha256_start(void)
 {
     int ret = 0;
 
-    ret = crypto_register_shash(&moto_sha224);
+    ret = moto_post_alg_defer(&moto_sha224.base, "moto-sha224",
+            "sha224", MOTO_CRYPTO_FAILED_ALG_SHA256) ?:
+            crypto_register_shash(&moto_sha224);
     printk (KERN_INFO "sha224 register result: %d\n", ret);
     if (ret) 
         return ret;
     moto_sha224_registered = 1;
-    ret = moto_alg_test("moto-sha224", "sha224", 0, 0);
+    ret = moto_post_alg_test("moto-sha224", "sha224",
+            MOTO_CRYPTO_FAILED_ALG_SHA256);
     printk (KERN_INFO "sha224 test result: %d\n", ret);
     if (ret)
         return ret;
 
-    ret = crypto_register_shash(&moto_sha256);
+    ret = moto_post_alg_defer(&moto_sha256.base, "moto-sha256",
+            "sha256", MOTO_CRYPTO_FAILED_ALG_SHA256) ?:
+            crypto_register_shash(&moto_sha256);
     printk (KERN_INFO "sha256 register result: %d\n", ret);
 
     if (!ret) {
         moto_sha256_registered = 1;
-        ret = moto_alg_test("moto-sha256", "sha256", 0, 0);
+        ret = moto_post_alg_test("moto-sha256", "sha256",
+                MOTO_CRYPTO_FAILED_ALG_SHA256);
         printk (KERN_INFO "sha256 test result: %d\n", ret);
     }
 
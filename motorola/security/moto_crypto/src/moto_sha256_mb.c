@@ -0,0 +1,284 @@
+/*
+ * Cryptographic API.
+ *
+ * Multi-buffer SHA-256 engine. Each lane of a lane implementation hashes
+ * its own message: a pass transforms one block in every lane, and a lane
+ * whose message is done is refilled with the next job of the batch. The
+ * padding blocks of a message are built in its lane and hashed the same
+ * way, so every pass is a full one until the batch runs out of jobs.
+ *
+ * The portable lanes interleave the scalar rounds of four messages, the
+ * x86_64 ones run four or eight messages in SSE2 or AVX2 registers.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ */
+#include <crypto/hash.h>
+#include <linux/err.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/types.h>
+#include <asm/unaligned.h>
+#include <moto_sha256_mb.h>
+
+#include "moto_crypto_main.h"
+#include "moto_crypto_stats.h"
+
+#define MOTO_SHA256_MB_PORTABLE_LANES   4
+
+struct moto_sha256_mb_lane {
+    struct moto_sha256_mb_job *job;
+    const u8 *src;
+    unsigned int blocks;        /* left at src */
+    unsigned int pad_blocks;    /* to hash from pad once src is done */
+    u8 pad[2 * SHA256_BLOCK_SIZE];
+};
+
+struct moto_sha256_mb_ctx {
+    const struct moto_sha256_mb_lanes *lanes;
+    u32 W[64 * MOTO_SHA256_MB_MAX_LANES];
+    u32 state[8 * MOTO_SHA256_MB_MAX_LANES];
+    struct moto_sha256_mb_lane lane[MOTO_SHA256_MB_MAX_LANES];
+};
+
+static void moto_sha256_mb_portable_blocks(u32 *state, u32 *W)
+{
+    moto_sha256_transform_lanes(state, W, MOTO_SHA256_MB_PORTABLE_LANES);
+}
+
+static const struct moto_sha256_mb_lanes moto_sha256_mb_portable = {
+    .name   = "portable",
+    .lanes  = MOTO_SHA256_MB_PORTABLE_LANES,
+    .blocks = moto_sha256_mb_portable_blocks,
+};
+
+struct moto_sha256_mb_ctx *moto_sha256_mb_alloc(
+        const struct moto_sha256_mb_lanes *lanes, gfp_t gfp)
+{
+    struct moto_sha256_mb_ctx *ctx;
+
+    ctx = kzalloc(sizeof(*ctx), gfp);
+    if (!ctx)
+        return NULL;
+
+    if (!lanes)
+        lanes = moto_sha256_mb_x86_lanes(0);
+    ctx->lanes = lanes ? lanes : &moto_sha256_mb_portable;
+
+    return ctx;
+}
+
+void moto_sha256_mb_free(struct moto_sha256_mb_ctx *ctx)
+{
+    kfree(ctx);
+}
+
+static void moto_sha256_mb_fill(struct moto_sha256_mb_ctx *ctx,
+        unsigned int l, struct moto_sha256_mb_job *job)
+{
+    struct moto_sha256_mb_lane *lane = &ctx->lane[l];
+    unsigned int n = ctx->lanes->lanes;
+    unsigned int partial = job->len & 0x3f;
+
+    lane->job = job;
+    lane->src = job->data;
+    lane->blocks = job->len / SHA256_BLOCK_SIZE;
+
+    /* Pad out to 56 mod 64 and append the length in bits */
+    lane->pad_blocks = partial < 56 ? 1 : 2;
+    memset(lane->pad, 0, sizeof(lane->pad));
+    memcpy(lane->pad, job->data + job->len - partial, partial);
+    lane->pad[partial] = 0x80;
+    put_unaligned_be64((u64)job->len << 3,
+            lane->pad + lane->pad_blocks * SHA256_BLOCK_SIZE - 8);
+
+    ctx->state[0 * n + l] = SHA256_H0;
+    ctx->state[1 * n + l] = SHA256_H1;
+    ctx->state[2 * n + l] = SHA256_H2;
+    ctx->state[3 * n + l] = SHA256_H3;
+    ctx->state[4 * n + l] = SHA256_H4;
+    ctx->state[5 * n + l] = SHA256_H5;
+    ctx->state[6 * n + l] = SHA256_H6;
+    ctx->state[7 * n + l] = SHA256_H7;
+}
+
+/* Moves a lane with nothing left at src on, returns 0 once it is idle */
+static int moto_sha256_mb_next(struct moto_sha256_mb_ctx *ctx,
+        unsigned int l, struct moto_sha256_mb_job *jobs,
+        unsigned int njobs, unsigned int *next)
+{
+    struct moto_sha256_mb_lane *lane = &ctx->lane[l];
+    unsigned int n = ctx->lanes->lanes;
+    int i;
+
+    while (!lane->blocks) {
+        if (lane->pad_blocks) {
+            lane->src = lane->pad;
+            lane->blocks = lane->pad_blocks;
+            lane->pad_blocks = 0;
+            break;
+        }
+
+        for (i = 0; i < 8; i++)
+            put_unaligned_be32(ctx->state[i * n + l],
+                    lane->job->digest + 4 * i);
+
+        if (*next == njobs) {
+            lane->job = NULL;
+            return 0;
+        }
+        moto_sha256_mb_fill(ctx, l, &jobs[(*next)++]);
+    }
+    return 1;
+}
+
+void moto_sha256_mb_digest(struct moto_sha256_mb_ctx *ctx,
+        struct moto_sha256_mb_job *jobs, unsigned int njobs)
+{
+    const struct moto_sha256_mb_lanes *lanes = ctx->lanes;
+    unsigned int n = lanes->lanes;
+    unsigned int l, t, run, active = 0, next = 0, nbytes = 0;
+    struct moto_sha256_mb_lane *lane;
+    ktime_t start = moto_stats_start();
+
+    for (l = 0; l < njobs; l++)
+        nbytes += jobs[l].len;
+
+    for (l = 0; l < n; l++) {
+        ctx->lane[l].job = NULL;
+        if (next == njobs)
+            continue;
+        moto_sha256_mb_fill(ctx, l, &jobs[next++]);
+        active += moto_sha256_mb_next(ctx, l, jobs, njobs, &next);
+    }
+
+    while (active) {
+        /* passes before some lane needs to be moved on */
+        run = UINT_MAX;
+        for (l = 0; l < n; l++) {
+            if (ctx->lane[l].job)
+                run = min(run, ctx->lane[l].blocks);
+        }
+
+        while (run--) {
+            for (l = 0; l < n; l++) {
+                lane = &ctx->lane[l];
+                if (!lane->job)
+                    continue;
+                for (t = 0; t < 16; t++)
+                    ctx->W[t * n + l] = get_unaligned_be32(lane->src + 4 * t);
+                lane->src += SHA256_BLOCK_SIZE;
+                lane->blocks--;
+            }
+            lanes->blocks(ctx->state, ctx->W);
+        }
+
+        for (l = 0; l < n; l++) {
+            if (ctx->lane[l].job && !ctx->lane[l].blocks)
+                active -= !moto_sha256_mb_next(ctx, l, jobs, njobs, &next);
+        }
+    }
+
+    /* Zeroize sensitive information. */
+    memset(ctx->W, 0, sizeof(ctx->W));
+    memset(ctx->state, 0, sizeof(ctx->state));
+    memset(ctx->lane, 0, sizeof(ctx->lane));
+
+    moto_stats_account(MOTO_STATS_SHA256, nbytes, start);
+}
+
+/*
+ * Self test of every lane implementation the CPU supports: a batch of
+ * messages around the padding boundaries, more of them than lanes so
+ * lanes get refilled, checked against moto-sha256.
+ */
+#define MOTO_SHA256_MB_TEST_JOBS    19
+#define MOTO_SHA256_MB_TEST_MSG     (4096 + MOTO_SHA256_MB_TEST_JOBS)
+
+static const unsigned int moto_sha256_mb_test_len[MOTO_SHA256_MB_TEST_JOBS] = {
+    0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 127, 128, 129, 200, 256, 311,
+    511, 1000, 4096
+};
+
+static int moto_sha256_mb_test(const struct moto_sha256_mb_lanes *lanes,
+        struct crypto_shash *tfm, const u8 *msg, u8 *digest)
+{
+    struct moto_sha256_mb_job jobs[MOTO_SHA256_MB_TEST_JOBS];
+    u8 expected[SHA256_DIGEST_SIZE];
+    struct moto_sha256_mb_ctx *ctx;
+    int i, err = 0;
+    struct {
+        struct shash_desc desc;
+        char ctx[sizeof(struct moto_sha256_state)];
+    } sdesc;
+
+    ctx = moto_sha256_mb_alloc(lanes, GFP_KERNEL);
+    if (!ctx)
+        return -ENOMEM;
+
+    for (i = 0; i < MOTO_SHA256_MB_TEST_JOBS; i++) {
+        /* every message starts at a different offset */
+        jobs[i].data = msg + i;
+        jobs[i].len = moto_sha256_mb_test_len[i];
+        jobs[i].digest = digest + i * SHA256_DIGEST_SIZE;
+    }
+    moto_sha256_mb_digest(ctx, jobs, MOTO_SHA256_MB_TEST_JOBS);
+    moto_sha256_mb_free(ctx);
+
+    sdesc.desc.tfm = tfm;
+    sdesc.desc.flags = 0;
+    for (i = 0; i < MOTO_SHA256_MB_TEST_JOBS; i++) {
+        err = crypto_shash_digest(&sdesc.desc, jobs[i].data, jobs[i].len,
+                expected);
+        if (err)
+            break;
+        if (memcmp(jobs[i].digest, expected, SHA256_DIGEST_SIZE)) {
+            printk(KERN_ERR "sha256 multi-buffer %s: wrong digest for "
+                    "%u bytes\n", lanes->name, jobs[i].len);
+            err = -EINVAL;
+            break;
+        }
+    }
+    printk (KERN_INFO "sha256 multi-buffer %s test result: %d\n",
+            lanes->name, err);
+
+    return err;
+}
+
+int moto_sha256_mb_self_test(void)
+{
+    const struct moto_sha256_mb_lanes *lanes;
+    struct crypto_shash *tfm;
+    unsigned int i;
+    u8 *msg, *digest;
+    int err;
+
+    /* the messages, then their digests */
+    msg = kmalloc(MOTO_SHA256_MB_TEST_MSG +
+            MOTO_SHA256_MB_TEST_JOBS * SHA256_DIGEST_SIZE, GFP_KERNEL);
+    if (!msg)
+        return -ENOMEM;
+    for (i = 0; i < MOTO_SHA256_MB_TEST_MSG; i++)
+        msg[i] = i * 7 + (i >> 8);
+
+    tfm = crypto_alloc_shash("moto-sha256", 0, 0);
+    if (IS_ERR(tfm)) {
+        kfree(msg);
+        return PTR_ERR(tfm);
+    }
+
+    digest = msg + MOTO_SHA256_MB_TEST_MSG;
+    err = moto_sha256_mb_test(&moto_sha256_mb_portable, tfm, msg, digest);
+    for (i = 0; !err && (lanes = moto_sha256_mb_x86_lanes(i)); i++)
+        err = moto_sha256_mb_test(lanes, tfm, msg, digest);
+
+    crypto_free_shash(tfm);
+    kfree(msg);
+
+    return err;
+}
@@ -0,0 +1,303 @@
+/*
+ * Cryptographic API.
+ *
+ * moto-sha256-mb, an asynchronous sha256 driver on the multi-buffer
+ * engine. digest() requests are queued and hashed in batches by a work
+ * item, so many independent small messages share the SIMD lanes. The
+ * lanes read the message in place, so only a message in one lowmem sg
+ * entry is queued; any other digest(), and the incremental
+ * init/update/final path, runs synchronously on moto-sha256.
+ *
+ * Its priority is below moto-sha256: callers that hash many messages at
+ * once ask for it by driver name. On CPUs with the SHA extensions
+ * moto-sha256 itself is faster than the lanes.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ */
+#include <crypto/internal/hash.h>
+#include <linux/err.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/scatterlist.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/workqueue.h>
+#include <moto_sha256_mb.h>
+
+#include "moto_testmgr.h"
+#include "moto_crypto_main.h"
+
+/* Requests hashed per engine run, and queued before -EBUSY */
+#define MOTO_SHA256_MB_BATCH        64
+#define MOTO_SHA256_MB_QUEUE_LEN    512
+
+struct moto_sha256_mb_tfm_ctx {
+    struct crypto_shash *child;
+};
+
+struct moto_sha256_mb_req_ctx {
+    struct shash_desc desc;
+};
+
+static struct crypto_queue moto_sha256_mb_queue;
+static DEFINE_SPINLOCK(moto_sha256_mb_lock);
+static struct workqueue_struct *moto_sha256_mb_wq;
+static struct moto_sha256_mb_ctx *moto_sha256_mb_engine;
+
+/* Only used by the work item, which the workqueue never runs twice at once */
+static struct {
+    struct ahash_request *reqs[MOTO_SHA256_MB_BATCH];
+    struct moto_sha256_mb_job jobs[MOTO_SHA256_MB_BATCH];
+} moto_sha256_mb_batch;
+
+static void moto_sha256_mb_work(struct work_struct *work);
+static DECLARE_WORK(moto_sha256_mb_worker, moto_sha256_mb_work);
+
+static void moto_sha256_mb_complete(struct crypto_async_request *base,
+        int err)
+{
+    local_bh_disable();
+    base->complete(base, err);
+    local_bh_enable();
+}
+
+/* Whether the lanes can read the message of req in place */
+static bool moto_sha256_mb_contiguous(struct ahash_request *req)
+{
+    struct scatterlist *sg = req->src;
+
+    return !req->nbytes ||
+            (sg->length >= req->nbytes && !PageHighMem(sg_page(sg)));
+}
+
+static void moto_sha256_mb_map(struct ahash_request *req,
+        struct moto_sha256_mb_job *job)
+{
+    job->len = req->nbytes;
+    job->digest = req->result;
+    /* any valid pointer for an empty message, nothing is read */
+    job->data = req->nbytes ? sg_virt(req->src) : req->result;
+}
+
+static void moto_sha256_mb_work(struct work_struct *work)
+{
+    struct crypto_async_request *base, *backlog;
+    unsigned int i, n;
+
+    for (;;) {
+        for (n = 0; n < MOTO_SHA256_MB_BATCH; n++) {
+            spin_lock_bh(&moto_sha256_mb_lock);
+            backlog = crypto_get_backlog(&moto_sha256_mb_queue);
+            base = crypto_dequeue_request(&moto_sha256_mb_queue);
+            spin_unlock_bh(&moto_sha256_mb_lock);
+
+            if (!base)
+                break;
+            if (backlog)
+                moto_sha256_mb_complete(backlog, -EINPROGRESS);
+            moto_sha256_mb_batch.reqs[n] = ahash_request_cast(base);
+        }
+        if (!n)
+            break;
+
+        if (moto_crypto_in_error()) {
+            for (i = 0; i < n; i++)
+                moto_sha256_mb_complete(&moto_sha256_mb_batch.reqs[i]->base,
+                        -ELIBBAD);
+            continue;
+        }
+
+        for (i = 0; i < n; i++)
+            moto_sha256_mb_map(moto_sha256_mb_batch.reqs[i],
+                    &moto_sha256_mb_batch.jobs[i]);
+
+        moto_sha256_mb_digest(moto_sha256_mb_engine,
+                moto_sha256_mb_batch.jobs, n);
+
+        for (i = 0; i < n; i++)
+            moto_sha256_mb_complete(&moto_sha256_mb_batch.reqs[i]->base, 0);
+
+        cond_resched();
+    }
+}
+
+static struct shash_desc *moto_sha256_mb_desc(struct ahash_request *req)
+{
+    struct moto_sha256_mb_tfm_ctx *ctx =
+            crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+    struct moto_sha256_mb_req_ctx *rctx = ahash_request_ctx(req);
+
+    rctx->desc.tfm = ctx->child;
+    rctx->desc.flags = req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP;
+
+    return &rctx->desc;
+}
+
+static int moto_sha256_mb_ahash_digest(struct ahash_request *req)
+{
+    int err;
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    /*
+     * Scattered or highmem messages, page cache and bio pages on 32-bit
+     * ARM say, are hashed right away rather than copied for the lanes.
+     */
+    if (!moto_sha256_mb_contiguous(req))
+        return shash_ahash_digest(req, moto_sha256_mb_desc(req));
+
+    spin_lock_bh(&moto_sha256_mb_lock);
+    err = ahash_enqueue_request(&moto_sha256_mb_queue, req);
+    spin_unlock_bh(&moto_sha256_mb_lock);
+
+    queue_work(moto_sha256_mb_wq, &moto_sha256_mb_worker);
+
+    return err;
+}
+
+static int moto_sha256_mb_ahash_init(struct ahash_request *req)
+{
+    return crypto_shash_init(moto_sha256_mb_desc(req));
+}
+
+static int moto_sha256_mb_ahash_update(struct ahash_request *req)
+{
+    return shash_ahash_update(req, moto_sha256_mb_desc(req));
+}
+
+static int moto_sha256_mb_ahash_final(struct ahash_request *req)
+{
+    return crypto_shash_final(moto_sha256_mb_desc(req), req->result);
+}
+
+static int moto_sha256_mb_ahash_finup(struct ahash_request *req)
+{
+    return shash_ahash_finup(req, moto_sha256_mb_desc(req));
+}
+
+static int moto_sha256_mb_ahash_export(struct ahash_request *req, void *out)
+{
+    return crypto_shash_export(moto_sha256_mb_desc(req), out);
+}
+
+static int moto_sha256_mb_ahash_import(struct ahash_request *req,
+        const void *in)
+{
+    return crypto_shash_import(moto_sha256_mb_desc(req), in);
+}
+
+static int moto_sha256_mb_cra_init(struct crypto_tfm *tfm)
+{
+    struct moto_sha256_mb_tfm_ctx *ctx = crypto_tfm_ctx(tfm);
+    struct crypto_shash *child;
+
+    child = crypto_alloc_shash("moto-sha256", 0, 0);
+    if (IS_ERR(child))
+        return PTR_ERR(child);
+
+    ctx->child = child;
+    crypto_ahash_set_reqsize(__crypto_ahash_cast(tfm),
+            sizeof(struct moto_sha256_mb_req_ctx) +
+            crypto_shash_descsize(child));
+
+    return 0;
+}
+
+static void moto_sha256_mb_cra_exit(struct crypto_tfm *tfm)
+{
+    struct moto_sha256_mb_tfm_ctx *ctx = crypto_tfm_ctx(tfm);
+
+    crypto_free_shash(ctx->child);
+}
+
+static struct ahash_alg moto_sha256_mb_alg = {
+    .init       = moto_sha256_mb_ahash_init,
+    .update     = moto_sha256_mb_ahash_update,
+    .final      = moto_sha256_mb_ahash_final,
+    .finup      = moto_sha256_mb_ahash_finup,
+    .digest     = moto_sha256_mb_ahash_digest,
+    .export     = moto_sha256_mb_ahash_export,
+    .import     = moto_sha256_mb_ahash_import,
+    .halg       = {
+        .digestsize = SHA256_DIGEST_SIZE,
+        .statesize  = sizeof(struct moto_sha256_state),
+        .base       = {
+            .cra_name        = "sha256",
+            .cra_driver_name = "moto-sha256-mb",
+            .cra_priority    = 900,
+            .cra_flags       = CRYPTO_ALG_TYPE_AHASH | CRYPTO_ALG_ASYNC,
+            .cra_blocksize   = SHA256_BLOCK_SIZE,
+            .cra_ctxsize     = sizeof(struct moto_sha256_mb_tfm_ctx),
+            .cra_type        = &crypto_ahash_type,
+            .cra_module      = THIS_MODULE,
+            .cra_init        = moto_sha256_mb_cra_init,
+            .cra_exit        = moto_sha256_mb_cra_exit,
+        }
+    }
+};
+
+static int moto_sha256_mb_registered;
+
+int moto_sha256_mb_start(void)
+{
+    int err;
+
+    err = moto_sha256_mb_self_test();
+    printk (KERN_INFO "sha256 multi-buffer self test result: %d\n", err);
+    if (err)
+        return err;
+
+    moto_sha256_mb_engine = moto_sha256_mb_alloc(NULL, GFP_KERNEL);
+    if (!moto_sha256_mb_engine)
+        return -ENOMEM;
+
+    moto_sha256_mb_wq = alloc_workqueue("moto_sha256_mb", WQ_UNBOUND, 1);
+    if (!moto_sha256_mb_wq) {
+        moto_sha256_mb_free(moto_sha256_mb_engine);
+        moto_sha256_mb_engine = NULL;
+        return -ENOMEM;
+    }
+    crypto_init_queue(&moto_sha256_mb_queue, MOTO_SHA256_MB_QUEUE_LEN);
+
+    err = moto_post_alg_defer(&moto_sha256_mb_alg.halg.base, "moto-sha256-mb",
+            "sha256", MOTO_CRYPTO_FAILED_ALG_SHA256) ?:
+            crypto_register_ahash(&moto_sha256_mb_alg);
+    printk (KERN_INFO "moto-sha256-mb register result: %d\n", err);
+    if (err)
+        return err;
+    moto_sha256_mb_registered = 1;
+
+    err = moto_post_alg_test("moto-sha256-mb", "sha256",
+            MOTO_CRYPTO_FAILED_ALG_SHA256);
+    printk (KERN_INFO "moto-sha256-mb test result: %d\n", err);
+
+    return err;
+}
+
+void moto_sha256_mb_finish(void)
+{
+    int err;
+
+    if (moto_sha256_mb_registered) {
+        err = crypto_unregister_ahash(&moto_sha256_mb_alg);
+        moto_sha256_mb_registered = 0;
+        printk (KERN_INFO "moto-sha256-mb unregister result: %d\n", err);
+    }
+
+    /* Runs the queue dry */
+    if (moto_sha256_mb_wq) {
+        destroy_workqueue(moto_sha256_mb_wq);
+        moto_sha256_mb_wq = NULL;
+    }
+
+    moto_sha256_mb_free(moto_sha256_mb_engine);
+    moto_sha256_mb_engine = NULL;
+}
@@ -18,16 +18,25 @@
 #include <linux/crypto.h>
 #include <linux/types.h>
 #include <moto_sha.h>
-#include <linux/percpu.h>
+#include <linux/sched.h>
 #include <asm/byteorder.h>
 
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 #include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 
 static int moto_sha384_registered = 0;
 static int moto_sha512_registered = 0;
+static int moto_sha512_224_registered = 0;
+static int moto_sha512_256_registered = 0;
 
-static DEFINE_PER_CPU(u64[80], msg_schedule);
+/*
+ * Whole blocks hashed between two reschedule points in update, when the
+ * caller may sleep
+ */
+#define MOTO_SHA512_CHUNK_BLOCKS    64
 
 static inline u64 Ch(u64 x, u64 y, u64 z)
 {
@@ -79,63 +88,58 @@ static const u64 sha512_K[80] = {
 #define s0(x)       (RORu64(x, 1) ^ RORu64(x, 8) ^ (x >> 7))
 #define s1(x)       (RORu64(x,19) ^ RORu64(x,61) ^ (x >> 6))
 
-static inline void LOAD_OP(int I, u64 *W, const u8 *input)
-{
-    W[I] = __be64_to_cpu( ((__be64*)(input))[I] );
-}
-
-static inline void BLEND_OP(int I, u64 *W)
-{
-    W[I] = s1(W[I-2]) + W[I-7] + s0(W[I-15]) + W[I-16];
-}
-
-static void
-moto_sha512_transform(u64 *state, const u8 *input)
+/* Message schedule words, the last 16 of them kept in W[] */
+#define LOAD_OP(i)  (W[i] = __be64_to_cpu(((const __be64 *)(input))[i]))
+#define BLEND_OP(i) (W[(i) & 15] += s1(W[((i) - 2) & 15]) + \
+        W[((i) - 7) & 15] + s0(W[((i) - 15) & 15]))
+
+#define ROUND(i, w, a, b, c, d, e, f, g, h)                             \
+    t1 = h + e1(e) + Ch(e,f,g) + sha512_K[i] + (w);                     \
+    t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2
+
+#define ROUNDS8(i, OP)                                                  \
+    ROUND(i + 0, OP(i + 0), a, b, c, d, e, f, g, h);                    \
+    ROUND(i + 1, OP(i + 1), h, a, b, c, d, e, f, g);                    \
+    ROUND(i + 2, OP(i + 2), g, h, a, b, c, d, e, f);                    \
+    ROUND(i + 3, OP(i + 3), f, g, h, a, b, c, d, e);                    \
+    ROUND(i + 4, OP(i + 4), e, f, g, h, a, b, c, d);                    \
+    ROUND(i + 5, OP(i + 5), d, e, f, g, h, a, b, c);                    \
+    ROUND(i + 6, OP(i + 6), c, d, e, f, g, h, a, b);                    \
+    ROUND(i + 7, OP(i + 7), b, c, d, e, f, g, h, a)
+
+/*
+ * SHA-512 transform of nblocks consecutive 128-byte blocks. The message
+ * schedule is a 16-word window on the stack, wiped once before returning.
+ */
+void moto_sha512_transform_blocks(u64 *state, const u8 *input,
+        unsigned int nblocks)
 {
     u64 a, b, c, d, e, f, g, h, t1, t2;
-
+    u64 W[16];
     int i;
-    u64 *W = get_cpu_var(msg_schedule);
-
-    /* load the input */
-    for (i = 0; i < 16; i++)
-        LOAD_OP(i, W, input);
-
-    for (i = 16; i < 80; i++) {
-        BLEND_OP(i, W);
-    }
 
     /* load the state into our registers */
     a=state[0];   b=state[1];   c=state[2];   d=state[3];
     e=state[4];   f=state[5];   g=state[6];   h=state[7];
 
-    /* now iterate */
-    for (i=0; i<80; i+=8) {
-        t1 = h + e1(e) + Ch(e,f,g) + sha512_K[i  ] + W[i  ];
-        t2 = e0(a) + Maj(a,b,c);    d+=t1;    h=t1+t2;
-        t1 = g + e1(d) + Ch(d,e,f) + sha512_K[i+1] + W[i+1];
-        t2 = e0(h) + Maj(h,a,b);    c+=t1;    g=t1+t2;
-        t1 = f + e1(c) + Ch(c,d,e) + sha512_K[i+2] + W[i+2];
-        t2 = e0(g) + Maj(g,h,a);    b+=t1;    f=t1+t2;
-        t1 = e + e1(b) + Ch(b,c,d) + sha512_K[i+3] + W[i+3];
-        t2 = e0(f) + Maj(f,g,h);    a+=t1;    e=t1+t2;
-        t1 = d + e1(a) + Ch(a,b,c) + sha512_K[i+4] + W[i+4];
-        t2 = e0(e) + Maj(e,f,g);    h+=t1;    d=t1+t2;
-        t1 = c + e1(h) + Ch(h,a,b) + sha512_K[i+5] + W[i+5];
-        t2 = e0(d) + Maj(d,e,f);    g+=t1;    c=t1+t2;
-        t1 = b + e1(g) + Ch(g,h,a) + sha512_K[i+6] + W[i+6];
-        t2 = e0(c) + Maj(c,d,e);    f+=t1;    b=t1+t2;
-        t1 = a + e1(f) + Ch(f,g,h) + sha512_K[i+7] + W[i+7];
-        t2 = e0(b) + Maj(b,c,d);    e+=t1;    a=t1+t2;
-    }
+    while (nblocks--) {
+        /* the first 16 rounds load the input, the others blend */
+        ROUNDS8(0, LOAD_OP);
+        ROUNDS8(8, LOAD_OP);
+        for (i = 16; i < 80; i += 8) {
+            ROUNDS8(i, BLEND_OP);
+        }
 
-    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
-    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        a = state[0] += a;  b = state[1] += b;
+        c = state[2] += c;  d = state[3] += d;
+        e = state[4] += e;  f = state[5] += f;
+        g = state[6] += g;  h = state[7] += h;
+        input += SHA512_BLOCK_SIZE;
+    }
 
     /* erase our data */
     a = b = c = d = e = f = g = h = t1 = t2 = 0;
-    memset(W, 0, sizeof(__get_cpu_var(msg_schedule)));
-    put_cpu_var(msg_schedule);
+    memset(W, 0, sizeof(W));
 }
 
 static int
@@ -174,12 +178,64 @@ moto_sha384_init(struct shash_desc *desc)
     return 0;
 }
 
+/* SHA-512/t, FIPS 180-4 5.3.6: the sha512 rounds from its own IV */
 static int
-moto_sha512_update(struct shash_desc *desc, const u8 *data, unsigned int len)
+moto_sha512_224_init(struct shash_desc *desc)
 {
     struct moto_sha512_state *sctx = shash_desc_ctx(desc);
 
-    unsigned int i, index, part_len;
+    sctx->state[0] = SHA512_224_H0;
+    sctx->state[1] = SHA512_224_H1;
+    sctx->state[2] = SHA512_224_H2;
+    sctx->state[3] = SHA512_224_H3;
+    sctx->state[4] = SHA512_224_H4;
+    sctx->state[5] = SHA512_224_H5;
+    sctx->state[6] = SHA512_224_H6;
+    sctx->state[7] = SHA512_224_H7;
+    sctx->count[0] = sctx->count[1] = 0;
+
+    return 0;
+}
+
+static int
+moto_sha512_256_init(struct shash_desc *desc)
+{
+    struct moto_sha512_state *sctx = shash_desc_ctx(desc);
+
+    sctx->state[0] = SHA512_256_H0;
+    sctx->state[1] = SHA512_256_H1;
+    sctx->state[2] = SHA512_256_H2;
+    sctx->state[3] = SHA512_256_H3;
+    sctx->state[4] = SHA512_256_H4;
+    sctx->state[5] = SHA512_256_H5;
+    sctx->state[6] = SHA512_256_H6;
+    sctx->state[7] = SHA512_256_H7;
+    sctx->count[0] = sctx->count[1] = 0;
+
+    return 0;
+}
+
+/* moto-sha384 and moto-sha512_t share the sha512 update and final */
+static inline enum moto_stats_id moto_sha512_stats_id(struct shash_desc *desc)
+{
+    switch (crypto_shash_digestsize(desc->tfm)) {
+    case SHA384_DIGEST_SIZE:
+        return MOTO_STATS_SHA384;
+    case SHA512_256_DIGEST_SIZE:
+        return MOTO_STATS_SHA512_256;
+    case SHA512_224_DIGEST_SIZE:
+        return MOTO_STATS_SHA512_224;
+    default:
+        return MOTO_STATS_SHA512;
+    }
+}
+
+static int
+_moto_sha512_update(struct shash_desc *desc, const u8 *data, unsigned int len)
+{
+    struct moto_sha512_state *sctx = shash_desc_ctx(desc);
+
+    unsigned int i, index, part_len, nblocks;
 
     /* Compute number of bytes mod 128 */
     index = sctx->count[0] & 0x7f;
@@ -193,10 +249,16 @@ moto_sha512_update(struct shash_desc *desc, const u8 *data, unsigned int len)
     /* Transform as many times as possible. */
     if (len >= part_len) {
         memcpy(&sctx->buf[index], data, part_len);
-        moto_sha512_transform(sctx->state, sctx->buf);
-
-        for (i = part_len; i + 127 < len; i+=128)
-            moto_sha512_transform(sctx->state, &data[i]);
+        moto_sha512_transform_blocks(sctx->state, sctx->buf, 1);
+
+        /* In bounded chunks, so a large update doesn't hog the CPU */
+        for (i = part_len; len - i > 127; i += nblocks * 128) {
+            nblocks = min_t(unsigned int, (len - i) / 128,
+                    MOTO_SHA512_CHUNK_BLOCKS);
+            moto_sha512_transform_blocks(sctx->state, &data[i], nblocks);
+            if (desc->flags & CRYPTO_TFM_REQ_MAY_SLEEP)
+                cond_resched();
+        }
 
         index = 0;
     } else {
@@ -209,6 +271,22 @@ moto_sha512_update(struct shash_desc *desc, const u8 *data, unsigned int len)
     return 0;
 }
 
+static int
+moto_sha512_update(struct shash_desc *desc, const u8 *data, unsigned int len)
+{
+    ktime_t start = moto_stats_start();
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_hash_start(crypto_shash_tfm(desc->tfm), "update", len);
+    _moto_sha512_update(desc, data, len);
+    trace_moto_hash_done(crypto_shash_tfm(desc->tfm), "update", len);
+    moto_stats_account(moto_sha512_stats_id(desc), len, start);
+
+    return 0;
+}
+
 static int
 moto_sha512_final(struct shash_desc *desc, u8 *hash)
 {
@@ -218,6 +296,12 @@ moto_sha512_final(struct shash_desc *desc, u8 *hash)
     __be64 bits[2];
     unsigned int index, pad_len;
     int i;
+    ktime_t start = moto_stats_start();
+
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_hash_start(crypto_shash_tfm(desc->tfm), "final", 0);
 
     /* Save number of bits */
     bits[1] = cpu_to_be64(sctx->count[0] << 3);
@@ -226,10 +310,10 @@ moto_sha512_final(struct shash_desc *desc, u8 *hash)
     /* Pad out to 112 mod 128. */
     index = sctx->count[0] & 0x7f;
     pad_len = (index < 112) ? (112 - index) : ((128+112) - index);
-    moto_sha512_update(desc, padding, pad_len);
+    _moto_sha512_update(desc, padding, pad_len);
 
     /* Append length (before padding) */
-    moto_sha512_update(desc, (const u8 *)bits, sizeof(bits));
+    _moto_sha512_update(desc, (const u8 *)bits, sizeof(bits));
 
     /* Store state in digest */
     for (i = 0; i < 8; i++)
@@ -241,17 +325,23 @@ moto_sha512_final(struct shash_desc *desc, u8 *hash)
     printk(KERN_INFO "SHA context after zeroization:\n");
     moto_hexdump((unsigned char *)(sctx), sizeof *sctx);
 #endif
+    trace_moto_hash_done(crypto_shash_tfm(desc->tfm), "final", 0);
+    moto_stats_account(moto_sha512_stats_id(desc), 0, start);
 
     return 0;
 }
 
-static int moto_sha384_final(struct shash_desc *desc, u8 *hash)
+/* The leftmost digestsize bytes of the sha512 final */
+static int moto_sha512_truncated_final(struct shash_desc *desc, u8 *hash)
 {
     u8 D[64];
+    int err;
 
-    moto_sha512_final(desc, D);
+    err = moto_sha512_final(desc, D);
+    if (err)
+        return err;
 
-    memcpy(hash, D, 48);
+    memcpy(hash, D, crypto_shash_digestsize(desc->tfm));
     memset(D, 0, 64);
 
     return 0;
@@ -277,7 +367,7 @@ static struct shash_alg moto_sha384 = {
         .digestsize = SHA384_DIGEST_SIZE,
         .init       = moto_sha384_init,
         .update     = moto_sha512_update,
-        .final      = moto_sha384_final,
+        .final      = moto_sha512_truncated_final,
         .descsize   = sizeof(struct moto_sha512_state),
         .base       = {
                 .cra_name       = "sha384",
@@ -289,24 +379,86 @@ static struct shash_alg moto_sha384 = {
         }
 };
 
+static struct shash_alg moto_sha512_224 = {
+        .digestsize = SHA512_224_DIGEST_SIZE,
+        .init       = moto_sha512_224_init,
+        .update     = moto_sha512_update,
+        .final      = moto_sha512_truncated_final,
+        .descsize   = sizeof(struct moto_sha512_state),
+        .base       = {
+                .cra_name       = "sha512_224",
+                .cra_driver_name= "moto-sha512_224",
+                .cra_priority   = 1000,
+                .cra_flags      = CRYPTO_ALG_TYPE_SHASH,
+                .cra_blocksize  = SHA512_BLOCK_SIZE,
+                .cra_module     = THIS_MODULE,
+        }
+};
+
+static struct shash_alg moto_sha512_256 = {
+        .digestsize = SHA512_256_DIGEST_SIZE,
+        .init       = moto_sha512_256_init,
+        .update     = moto_sha512_update,
+        .final      = moto_sha512_truncated_final,
+        .descsize   = sizeof(struct moto_sha512_state),
+        .base       = {
+                .cra_name       = "sha512_256",
+                .cra_driver_name= "moto-sha512_256",
+                .cra_priority   = 1000,
+                .cra_flags      = CRYPTO_ALG_TYPE_SHASH,
+                .cra_blocksize  = SHA512_BLOCK_SIZE,
+                .cra_module     = THIS_MODULE,
+        }
+};
+
 int moto_sha512_start(void)
 {
     int ret = 0;
 
-    ret = crypto_register_shash(&moto_sha384);
+    ret = moto_post_alg_defer(&moto_sha384.base, "moto-sha384",
+            "sha384", MOTO_CRYPTO_FAILED_ALG_SHA512) ?:
+            crypto_register_shash(&moto_sha384);
     if (ret)
         goto out;
     moto_sha384_registered = 1;
-    ret = moto_alg_test("moto-sha384", "sha384", 0, 0);
+    ret = moto_post_alg_test("moto-sha384", "sha384",
+            MOTO_CRYPTO_FAILED_ALG_SHA512);
     printk (KERN_INFO "sha384 test result: %d\n", ret);
     if (ret)
         goto out;
 
-    ret = crypto_register_shash(&moto_sha512);
+    ret = moto_post_alg_defer(&moto_sha512.base, "moto-sha512",
+            "sha512", MOTO_CRYPTO_FAILED_ALG_SHA512) ?:
+            crypto_register_shash(&moto_sha512);
+    if (ret)
+        goto out;
+    moto_sha512_registered = 1;
+    ret = moto_post_alg_test("moto-sha512", "sha512",
+            MOTO_CRYPTO_FAILED_ALG_SHA512);
+    printk (KERN_INFO "sha512 test result: %d\n", ret);
+    if (ret)
+        goto out;
+
+    ret = moto_post_alg_defer(&moto_sha512_224.base, "moto-sha512_224",
+            "sha512_224", MOTO_CRYPTO_FAILED_ALG_SHA512) ?:
+            crypto_register_shash(&moto_sha512_224);
+    if (ret)
+        goto out;
+    moto_sha512_224_registered = 1;
+    ret = moto_post_alg_test("moto-sha512_224", "sha512_224",
+            MOTO_CRYPTO_FAILED_ALG_SHA512);
+    printk (KERN_INFO "sha512_224 test result: %d\n", ret);
+    if (ret)
+        goto out;
+
+    ret = moto_post_alg_defer(&moto_sha512_256.base, "moto-sha512_256",
+            "sha512_256", MOTO_CRYPTO_FAILED_ALG_SHA512) ?:
+            crypto_register_shash(&moto_sha512_256);
     if (!ret) {
-        moto_sha512_registered = 1;
-        ret = moto_alg_test("moto-sha512", "sha512", 0, 0);
-        printk (KERN_INFO "sha512 test result: %d\n", ret);
+        moto_sha512_256_registered = 1;
+        ret = moto_post_alg_test("moto-sha512_256", "sha512_256",
+                MOTO_CRYPTO_FAILED_ALG_SHA512);
+        printk (KERN_INFO "sha512_256 test result: %d\n", ret);
     }
     out:
     return ret;
@@ -328,4 +480,16 @@ void moto_sha512_finish(void)
         moto_sha512_registered = 0;
     }
     printk (KERN_INFO "sha512 unregister result: %d\n", err);
+    if (moto_sha512_224_registered)
+    {
+        err = crypto_unregister_shash(&moto_sha512_224);
+        moto_sha512_224_registered = 0;
+    }
+    printk (KERN_INFO "sha512_224 unregister result: %d\n", err);
+    if (moto_sha512_256_registered)
+    {
+        err = crypto_unregister_shash(&moto_sha512_256);
+        moto_sha512_256_registered = 0;
+    }
+    printk (KERN_INFO "sha512_256 unregister result: %d\n", err);
 }
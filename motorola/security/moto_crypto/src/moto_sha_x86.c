@@ -0,0 +1,1210 @@
+/*
+ * Cryptographic API.
+ *
+ * SHA1 and SHA-256 block functions for x86_64: one using the SHA
+ * extensions, and for CPUs without them, two expanding the message
+ * schedule with SSSE3, or with AVX2 two blocks at a time, for the rounds
+ * of moto_sha1_transform_w() and moto_sha256_transform_w().
+ *
+ * Each variant the CPU supports is registered as its own set of drivers,
+ * moto-sha1-<variant>, moto-sha224-<variant> and moto-sha256-<variant>,
+ * and tested. The best one that passed then becomes the block function
+ * of moto-sha1, moto-sha224 and moto-sha256 themselves, so moto_hmac and
+ * the integrity check use it too. The portable block functions remain
+ * the fallback when the FPU cannot be used.
+ *
+ * The SSE2 and AVX2 lanes of the multi-buffer SHA-256 engine live here
+ * too, they hash four or eight independent messages per pass.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ */
+
+#include <crypto/internal/hash.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/types.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#include <moto_sha.h>
+#include <moto_sha256_mb.h>
+#include <asm/cpufeature.h>
+#include <asm/i387.h>
+
+#include "moto_testmgr.h"
+#include "moto_crypto_main.h"
+
+#ifndef X86_FEATURE_SHA_NI
+#define X86_FEATURE_SHA_NI  (9*32+29)
+#endif
+
+/* Blocks hashed per kernel_fpu_begin(), which disables preemption */
+#define MOTO_SHA_X86_FPU_BLOCKS 64
+
+static char *sha_x86;
+module_param(sha_x86, charp, 0444);
+MODULE_PARM_DESC(sha_x86, "x86 SHA variant for moto-sha1/moto-sha256: "
+        "ni, avx2, ssse3 or none, the best available by default; "
+        "none also keeps moto-sha256-mb on its portable lanes");
+
+/* pshufb masks, big endian words and the whole block reversed for SHA1 */
+static const u8 moto_sha_x86_bswap32[16] __aligned(16) = {
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+static const u8 moto_sha_x86_bswap128[16] __aligned(16) = {
+    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+/*
+ * As in moto_aes_ni.c, the helpers below use the vector registers without
+ * declaring them as clobbered: kernel code is built without SSE, so the
+ * compiler never keeps anything in them, and the user state is saved by
+ * kernel_fpu_begin(). They are only called with nblocks > 0.
+ */
+static void moto_sha1_ni(u32 *state, const u8 *data, unsigned int nblocks)
+{
+    unsigned long n = nblocks;
+
+    asm volatile(
+        "movdqa %[mask], %%xmm7\n\t"
+        "movdqu (%[state]), %%xmm0\n\t"
+        "pxor %%xmm1, %%xmm1\n\t"
+        "pinsrd $3, 16(%[state]), %%xmm1\n\t"
+        "pshufd $0x1b, %%xmm0, %%xmm0\n\t"
+        "1:\n\t"
+        "movdqa %%xmm0, %%xmm8\n\t"
+        "movdqa %%xmm1, %%xmm9\n\t"
+        /* rounds 0-3 */
+        "movdqu (%[in]), %%xmm3\n\t"
+        "pshufb %%xmm7, %%xmm3\n\t"
+        "paddd %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+        /* rounds 4-7 */
+        "movdqu 16(%[in]), %%xmm4\n\t"
+        "pshufb %%xmm7, %%xmm4\n\t"
+        "sha1nexte %%xmm4, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1rnds4 $0, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm4, %%xmm3\n\t"
+        /* rounds 8-11 */
+        "movdqu 32(%[in]), %%xmm5\n\t"
+        "pshufb %%xmm7, %%xmm5\n\t"
+        "sha1nexte %%xmm5, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm5, %%xmm4\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        /* rounds 12-15 */
+        "movdqu 48(%[in]), %%xmm6\n\t"
+        "pshufb %%xmm7, %%xmm6\n\t"
+        "sha1nexte %%xmm6, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm6, %%xmm3\n\t"
+        "sha1rnds4 $0, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm6, %%xmm5\n\t"
+        "pxor %%xmm6, %%xmm4\n\t"
+        /* rounds 16-19 */
+        "sha1nexte %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm3, %%xmm4\n\t"
+        "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm3, %%xmm6\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        /* rounds 20-23 */
+        "sha1nexte %%xmm4, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm4, %%xmm5\n\t"
+        "sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm4, %%xmm3\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        /* rounds 24-27 */
+        "sha1nexte %%xmm5, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm5, %%xmm6\n\t"
+        "sha1rnds4 $1, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm5, %%xmm4\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        /* rounds 28-31 */
+        "sha1nexte %%xmm6, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm6, %%xmm3\n\t"
+        "sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm6, %%xmm5\n\t"
+        "pxor %%xmm6, %%xmm4\n\t"
+        /* rounds 32-35 */
+        "sha1nexte %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm3, %%xmm4\n\t"
+        "sha1rnds4 $1, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm3, %%xmm6\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        /* rounds 36-39 */
+        "sha1nexte %%xmm4, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm4, %%xmm5\n\t"
+        "sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm4, %%xmm3\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        /* rounds 40-43 */
+        "sha1nexte %%xmm5, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm5, %%xmm6\n\t"
+        "sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm5, %%xmm4\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        /* rounds 44-47 */
+        "sha1nexte %%xmm6, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm6, %%xmm3\n\t"
+        "sha1rnds4 $2, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm6, %%xmm5\n\t"
+        "pxor %%xmm6, %%xmm4\n\t"
+        /* rounds 48-51 */
+        "sha1nexte %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm3, %%xmm4\n\t"
+        "sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm3, %%xmm6\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        /* rounds 52-55 */
+        "sha1nexte %%xmm4, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm4, %%xmm5\n\t"
+        "sha1rnds4 $2, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm4, %%xmm3\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        /* rounds 56-59 */
+        "sha1nexte %%xmm5, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm5, %%xmm6\n\t"
+        "sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm5, %%xmm4\n\t"
+        "pxor %%xmm5, %%xmm3\n\t"
+        /* rounds 60-63 */
+        "sha1nexte %%xmm6, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm6, %%xmm3\n\t"
+        "sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+        "sha1msg1 %%xmm6, %%xmm5\n\t"
+        "pxor %%xmm6, %%xmm4\n\t"
+        /* rounds 64-67 */
+        "sha1nexte %%xmm3, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm3, %%xmm4\n\t"
+        "sha1rnds4 $3, %%xmm1, %%xmm0\n\t"
+        "sha1msg1 %%xmm3, %%xmm6\n\t"
+        "pxor %%xmm3, %%xmm5\n\t"
+        /* rounds 68-71 */
+        "sha1nexte %%xmm4, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1msg2 %%xmm4, %%xmm5\n\t"
+        "sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+        "pxor %%xmm4, %%xmm6\n\t"
+        /* rounds 72-75 */
+        "sha1nexte %%xmm5, %%xmm1\n\t"
+        "movdqa %%xmm0, %%xmm2\n\t"
+        "sha1msg2 %%xmm5, %%xmm6\n\t"
+        "sha1rnds4 $3, %%xmm1, %%xmm0\n\t"
+        /* rounds 76-79 */
+        "sha1nexte %%xmm6, %%xmm2\n\t"
+        "movdqa %%xmm0, %%xmm1\n\t"
+        "sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+        "sha1nexte %%xmm9, %%xmm1\n\t"
+        "paddd %%xmm8, %%xmm0\n\t"
+        "add $64, %[in]\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "pshufd $0x1b, %%xmm0, %%xmm0\n\t"
+        "movdqu %%xmm0, (%[state])\n\t"
+        "pextrd $3, %%xmm1, 16(%[state])\n\t"
+        : [in] "+r" (data), [n] "+r" (n)
+        : [state] "r" (state), [mask] "m" (moto_sha_x86_bswap128)
+        : "cc", "memory");
+}
+
+static void moto_sha256_ni(u32 *state, const u8 *data, unsigned int nblocks)
+{
+    unsigned long n = nblocks;
+
+    /* the rounds work on the state rearranged as ABEF and CDGH */
+    asm volatile(
+        "movdqa %[mask], %%xmm8\n\t"
+        "movdqu (%[state]), %%xmm1\n\t"
+        "movdqu 16(%[state]), %%xmm2\n\t"
+        "pshufd $0xb1, %%xmm1, %%xmm1\n\t"
+        "pshufd $0x1b, %%xmm2, %%xmm2\n\t"
+        "movdqa %%xmm1, %%xmm7\n\t"
+        "palignr $8, %%xmm2, %%xmm1\n\t"
+        "pblendw $0xf0, %%xmm7, %%xmm2\n\t"
+        "1:\n\t"
+        "movdqa %%xmm1, %%xmm9\n\t"
+        "movdqa %%xmm2, %%xmm10\n\t"
+        /* rounds 0-3 */
+        "movdqu (%[in]), %%xmm0\n\t"
+        "pshufb %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm0, %%xmm3\n\t"
+        "paddd (%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        /* rounds 4-7 */
+        "movdqu 16(%[in]), %%xmm0\n\t"
+        "pshufb %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm0, %%xmm4\n\t"
+        "paddd 16(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm4, %%xmm3\n\t"
+        /* rounds 8-11 */
+        "movdqu 32(%[in]), %%xmm0\n\t"
+        "pshufb %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm0, %%xmm5\n\t"
+        "paddd 32(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm5, %%xmm4\n\t"
+        /* rounds 12-15 */
+        "movdqu 48(%[in]), %%xmm0\n\t"
+        "pshufb %%xmm8, %%xmm0\n\t"
+        "movdqa %%xmm0, %%xmm6\n\t"
+        "paddd 48(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm6, %%xmm7\n\t"
+        "palignr $4, %%xmm5, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm3\n\t"
+        "sha256msg2 %%xmm6, %%xmm3\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm6, %%xmm5\n\t"
+        /* rounds 16-19 */
+        "movdqa %%xmm3, %%xmm0\n\t"
+        "paddd 64(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm3, %%xmm7\n\t"
+        "palignr $4, %%xmm6, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm4\n\t"
+        "sha256msg2 %%xmm3, %%xmm4\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm3, %%xmm6\n\t"
+        /* rounds 20-23 */
+        "movdqa %%xmm4, %%xmm0\n\t"
+        "paddd 80(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm4, %%xmm7\n\t"
+        "palignr $4, %%xmm3, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm5\n\t"
+        "sha256msg2 %%xmm4, %%xmm5\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm4, %%xmm3\n\t"
+        /* rounds 24-27 */
+        "movdqa %%xmm5, %%xmm0\n\t"
+        "paddd 96(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm5, %%xmm7\n\t"
+        "palignr $4, %%xmm4, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm6\n\t"
+        "sha256msg2 %%xmm5, %%xmm6\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm5, %%xmm4\n\t"
+        /* rounds 28-31 */
+        "movdqa %%xmm6, %%xmm0\n\t"
+        "paddd 112(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm6, %%xmm7\n\t"
+        "palignr $4, %%xmm5, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm3\n\t"
+        "sha256msg2 %%xmm6, %%xmm3\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm6, %%xmm5\n\t"
+        /* rounds 32-35 */
+        "movdqa %%xmm3, %%xmm0\n\t"
+        "paddd 128(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm3, %%xmm7\n\t"
+        "palignr $4, %%xmm6, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm4\n\t"
+        "sha256msg2 %%xmm3, %%xmm4\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm3, %%xmm6\n\t"
+        /* rounds 36-39 */
+        "movdqa %%xmm4, %%xmm0\n\t"
+        "paddd 144(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm4, %%xmm7\n\t"
+        "palignr $4, %%xmm3, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm5\n\t"
+        "sha256msg2 %%xmm4, %%xmm5\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm4, %%xmm3\n\t"
+        /* rounds 40-43 */
+        "movdqa %%xmm5, %%xmm0\n\t"
+        "paddd 160(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm5, %%xmm7\n\t"
+        "palignr $4, %%xmm4, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm6\n\t"
+        "sha256msg2 %%xmm5, %%xmm6\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm5, %%xmm4\n\t"
+        /* rounds 44-47 */
+        "movdqa %%xmm6, %%xmm0\n\t"
+        "paddd 176(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm6, %%xmm7\n\t"
+        "palignr $4, %%xmm5, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm3\n\t"
+        "sha256msg2 %%xmm6, %%xmm3\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm6, %%xmm5\n\t"
+        /* rounds 48-51 */
+        "movdqa %%xmm3, %%xmm0\n\t"
+        "paddd 192(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm3, %%xmm7\n\t"
+        "palignr $4, %%xmm6, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm4\n\t"
+        "sha256msg2 %%xmm3, %%xmm4\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "sha256msg1 %%xmm3, %%xmm6\n\t"
+        /* rounds 52-55 */
+        "movdqa %%xmm4, %%xmm0\n\t"
+        "paddd 208(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm4, %%xmm7\n\t"
+        "palignr $4, %%xmm3, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm5\n\t"
+        "sha256msg2 %%xmm4, %%xmm5\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        /* rounds 56-59 */
+        "movdqa %%xmm5, %%xmm0\n\t"
+        "paddd 224(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "movdqa %%xmm5, %%xmm7\n\t"
+        "palignr $4, %%xmm4, %%xmm7\n\t"
+        "paddd %%xmm7, %%xmm6\n\t"
+        "sha256msg2 %%xmm5, %%xmm6\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        /* rounds 60-63 */
+        "movdqa %%xmm6, %%xmm0\n\t"
+        "paddd 240(%[k]), %%xmm0\n\t"
+        "sha256rnds2 %%xmm1, %%xmm2\n\t"
+        "pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+        "sha256rnds2 %%xmm2, %%xmm1\n\t"
+        "paddd %%xmm9, %%xmm1\n\t"
+        "paddd %%xmm10, %%xmm2\n\t"
+        "add $64, %[in]\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "pshufd $0x1b, %%xmm1, %%xmm1\n\t"
+        "pshufd $0xb1, %%xmm2, %%xmm2\n\t"
+        "movdqa %%xmm1, %%xmm7\n\t"
+        "pblendw $0xf0, %%xmm2, %%xmm1\n\t"
+        "palignr $8, %%xmm7, %%xmm2\n\t"
+        "movdqu %%xmm1, (%[state])\n\t"
+        "movdqu %%xmm2, 16(%[state])\n\t"
+        : [in] "+r" (data), [n] "+r" (n)
+        : [state] "r" (state), [k] "r" (moto_sha256_K),
+          [mask] "m" (moto_sha_x86_bswap32)
+        : "cc", "memory");
+}
+
+/*
+ * Message schedules. %xmm0-%xmm3 (%ymm0-%ymm3) hold the last 16 words
+ * W[t-16..t-1], each pass computes W[t..t+3] and slides the window. With
+ * AVX2 the low lane works on the first block and the high lane on the
+ * second one, whose schedule is stored right after the first.
+ */
+#define MOTO_SHA_SSE_ROL1(r, z)                                         \
+    "movdqa " r ", " z "\n\t"                                           \
+    "psrld $31, " z "\n\t"                                              \
+    "pslld $1, " r "\n\t"                                               \
+    "por " z ", " r "\n\t"
+
+#define MOTO_SHA_AVX_ROL1(r, z)                                         \
+    "vpsrld $31, " r ", " z "\n\t"                                      \
+    "vpslld $1, " r ", " r "\n\t"                                       \
+    "vpor " z ", " r ", " r "\n\t"
+
+/* d = ror(s, r1) ^ ror(s, r2) ^ (s >> sh), s and z clobbered */
+#define MOTO_SHA_SSE_SIGMA(s, d, z, r1, l1, r2, l2, sh)                 \
+    "movdqa " s ", " d "\n\t"                                           \
+    "psrld $" #r1 ", " d "\n\t"                                         \
+    "movdqa " s ", " z "\n\t"                                           \
+    "pslld $" #l1 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "movdqa " s ", " z "\n\t"                                           \
+    "psrld $" #r2 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "movdqa " s ", " z "\n\t"                                           \
+    "pslld $" #l2 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "psrld $" #sh ", " s "\n\t"                                         \
+    "pxor " s ", " d "\n\t"
+
+#define MOTO_SHA_AVX_SIGMA(s, d, z, r1, l1, r2, l2, sh)                 \
+    "vpsrld $" #r1 ", " s ", " d "\n\t"                                 \
+    "vpslld $" #l1 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpsrld $" #r2 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpslld $" #l2 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpsrld $" #sh ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"
+
+#define MOTO_SHA_SSE_LOAD(i)                                            \
+    "movdqu " #i "*16(%[in]), %%xmm" #i "\n\t"                          \
+    "pshufb %%xmm8, %%xmm" #i "\n\t"                                    \
+    "movdqu %%xmm" #i ", " #i "*16(%[w])\n\t"
+
+#define MOTO_SHA_AVX_LOAD(i, w2)                                        \
+    "vmovdqu " #i "*16(%[in]), %%xmm" #i "\n\t"                         \
+    "vinserti128 $1, 64+" #i "*16(%[in]), %%ymm" #i ", %%ymm" #i "\n\t" \
+    "vpshufb %%ymm8, %%ymm" #i ", %%ymm" #i "\n\t"                      \
+    "vmovdqu %%xmm" #i ", " #i "*16(%[w])\n\t"                          \
+    "vextracti128 $1, %%ymm" #i ", " #w2 "+" #i "*16(%[w])\n\t"
+
+#define MOTO_SHA_SSE_SLIDE                                              \
+    "movdqa %%xmm1, %%xmm0\n\t"                                         \
+    "movdqa %%xmm2, %%xmm1\n\t"                                         \
+    "movdqa %%xmm3, %%xmm2\n\t"                                         \
+    "movdqa %%xmm4, %%xmm3\n\t"                                         \
+    "movdqu %%xmm3, (%[w])\n\t"                                         \
+    "add $16, %[w]\n\t"                                                 \
+    "dec %[n]\n\t"                                                      \
+    "jnz 1b\n\t"
+
+#define MOTO_SHA_AVX_SLIDE(w2)                                          \
+    "vmovdqa %%ymm1, %%ymm0\n\t"                                        \
+    "vmovdqa %%ymm2, %%ymm1\n\t"                                        \
+    "vmovdqa %%ymm3, %%ymm2\n\t"                                        \
+    "vmovdqa %%ymm4, %%ymm3\n\t"                                        \
+    "vmovdqu %%xmm3, (%[w])\n\t"                                        \
+    "vextracti128 $1, %%ymm3, " #w2 "(%[w])\n\t"                        \
+    "add $16, %[w]\n\t"                                                 \
+    "dec %[n]\n\t"                                                      \
+    "jnz 1b\n\t"                                                        \
+    "vzeroupper\n\t"
+
+/* W[t] = rol(W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16], 1), W[t+3] needs W[t] */
+static void moto_sha1_ssse3_schedule(u32 *W, const u8 *data)
+{
+    unsigned long n = 16;
+
+    asm volatile(
+        "movdqa %[mask], %%xmm8\n\t"
+        MOTO_SHA_SSE_LOAD(0)
+        MOTO_SHA_SSE_LOAD(1)
+        MOTO_SHA_SSE_LOAD(2)
+        MOTO_SHA_SSE_LOAD(3)
+        "add $64, %[w]\n\t"
+        "1:\n\t"
+        "movdqa %%xmm1, %%xmm4\n\t"
+        "palignr $8, %%xmm0, %%xmm4\n\t"
+        "pxor %%xmm0, %%xmm4\n\t"
+        "pxor %%xmm2, %%xmm4\n\t"
+        "movdqa %%xmm3, %%xmm5\n\t"
+        "psrldq $4, %%xmm5\n\t"
+        "pxor %%xmm5, %%xmm4\n\t"
+        MOTO_SHA_SSE_ROL1("%%xmm4", "%%xmm5")
+        "movdqa %%xmm4, %%xmm5\n\t"
+        "pslldq $12, %%xmm5\n\t"
+        MOTO_SHA_SSE_ROL1("%%xmm5", "%%xmm6")
+        "pxor %%xmm5, %%xmm4\n\t"
+        MOTO_SHA_SSE_SLIDE
+        : [w] "+r" (W), [n] "+r" (n)
+        : [in] "r" (data), [mask] "m" (moto_sha_x86_bswap32)
+        : "cc", "memory");
+}
+
+static void moto_sha1_avx2_schedule(u32 *W, const u8 *data)
+{
+    unsigned long n = 16;
+
+    asm volatile(
+        "vbroadcasti128 %[mask], %%ymm8\n\t"
+        MOTO_SHA_AVX_LOAD(0, 320)
+        MOTO_SHA_AVX_LOAD(1, 320)
+        MOTO_SHA_AVX_LOAD(2, 320)
+        MOTO_SHA_AVX_LOAD(3, 320)
+        "add $64, %[w]\n\t"
+        "1:\n\t"
+        "vpalignr $8, %%ymm0, %%ymm1, %%ymm4\n\t"
+        "vpxor %%ymm0, %%ymm4, %%ymm4\n\t"
+        "vpxor %%ymm2, %%ymm4, %%ymm4\n\t"
+        "vpsrldq $4, %%ymm3, %%ymm5\n\t"
+        "vpxor %%ymm5, %%ymm4, %%ymm4\n\t"
+        MOTO_SHA_AVX_ROL1("%%ymm4", "%%ymm5")
+        "vpslldq $12, %%ymm4, %%ymm5\n\t"
+        MOTO_SHA_AVX_ROL1("%%ymm5", "%%ymm6")
+        "vpxor %%ymm5, %%ymm4, %%ymm4\n\t"
+        MOTO_SHA_AVX_SLIDE(320)
+        : [w] "+r" (W), [n] "+r" (n)
+        : [in] "r" (data), [mask] "m" (moto_sha_x86_bswap32)
+        : "cc", "memory");
+}
+
+/*
+ * W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16], s1 is added in two
+ * halves since W[t+2] and W[t+3] need W[t] and W[t+1].
+ */
+static void moto_sha256_ssse3_schedule(u32 *W, const u8 *data)
+{
+    unsigned long n = 12;
+
+    asm volatile(
+        "movdqa %[mask], %%xmm8\n\t"
+        MOTO_SHA_SSE_LOAD(0)
+        MOTO_SHA_SSE_LOAD(1)
+        MOTO_SHA_SSE_LOAD(2)
+        MOTO_SHA_SSE_LOAD(3)
+        "add $64, %[w]\n\t"
+        "1:\n\t"
+        "movdqa %%xmm1, %%xmm4\n\t"
+        "palignr $4, %%xmm0, %%xmm4\n\t"
+        MOTO_SHA_SSE_SIGMA("%%xmm4", "%%xmm5", "%%xmm6", 7, 25, 18, 14, 3)
+        "movdqa %%xmm3, %%xmm4\n\t"
+        "palignr $4, %%xmm2, %%xmm4\n\t"
+        "paddd %%xmm0, %%xmm4\n\t"
+        "paddd %%xmm5, %%xmm4\n\t"
+        "movdqa %%xmm3, %%xmm5\n\t"
+        "psrldq $8, %%xmm5\n\t"
+        MOTO_SHA_SSE_SIGMA("%%xmm5", "%%xmm6", "%%xmm7", 17, 15, 19, 13, 10)
+        "paddd %%xmm6, %%xmm4\n\t"
+        "movdqa %%xmm4, %%xmm5\n\t"
+        "pslldq $8, %%xmm5\n\t"
+        MOTO_SHA_SSE_SIGMA("%%xmm5", "%%xmm6", "%%xmm7", 17, 15, 19, 13, 10)
+        "paddd %%xmm6, %%xmm4\n\t"
+        MOTO_SHA_SSE_SLIDE
+        : [w] "+r" (W), [n] "+r" (n)
+        : [in] "r" (data), [mask] "m" (moto_sha_x86_bswap32)
+        : "cc", "memory");
+}
+
+static void moto_sha256_avx2_schedule(u32 *W, const u8 *data)
+{
+    unsigned long n = 12;
+
+    asm volatile(
+        "vbroadcasti128 %[mask], %%ymm8\n\t"
+        MOTO_SHA_AVX_LOAD(0, 256)
+        MOTO_SHA_AVX_LOAD(1, 256)
+        MOTO_SHA_AVX_LOAD(2, 256)
+        MOTO_SHA_AVX_LOAD(3, 256)
+        "add $64, %[w]\n\t"
+        "1:\n\t"
+        "vpalignr $4, %%ymm0, %%ymm1, %%ymm4\n\t"
+        MOTO_SHA_AVX_SIGMA("%%ymm4", "%%ymm5", "%%ymm6", 7, 25, 18, 14, 3)
+        "vpalignr $4, %%ymm2, %%ymm3, %%ymm4\n\t"
+        "vpaddd %%ymm0, %%ymm4, %%ymm4\n\t"
+        "vpaddd %%ymm5, %%ymm4, %%ymm4\n\t"
+        "vpsrldq $8, %%ymm3, %%ymm5\n\t"
+        MOTO_SHA_AVX_SIGMA("%%ymm5", "%%ymm6", "%%ymm7", 17, 15, 19, 13, 10)
+        "vpaddd %%ymm6, %%ymm4, %%ymm4\n\t"
+        "vpslldq $8, %%ymm4, %%ymm5\n\t"
+        MOTO_SHA_AVX_SIGMA("%%ymm5", "%%ymm6", "%%ymm7", 17, 15, 19, 13, 10)
+        "vpaddd %%ymm6, %%ymm4, %%ymm4\n\t"
+        MOTO_SHA_AVX_SLIDE(256)
+        : [w] "+r" (W), [n] "+r" (n)
+        : [in] "r" (data), [mask] "m" (moto_sha_x86_bswap32)
+        : "cc", "memory");
+}
+
+static void moto_sha1_ssse3(u32 *state, const u8 *data, unsigned int nblocks)
+{
+    u32 W[80];
+
+    while (nblocks--) {
+        moto_sha1_ssse3_schedule(W, data);
+        moto_sha1_transform_w(state, W);
+        data += SHA1_BLOCK_SIZE;
+    }
+    memset(W, 0, sizeof(W));
+}
+
+static void moto_sha1_avx2(u32 *state, const u8 *data, unsigned int nblocks)
+{
+    u32 W[2 * 80];
+
+    for (; nblocks >= 2; nblocks -= 2) {
+        moto_sha1_avx2_schedule(W, data);
+        moto_sha1_transform_w(state, W);
+        moto_sha1_transform_w(state, W + 80);
+        data += 2 * SHA1_BLOCK_SIZE;
+    }
+    if (nblocks) {
+        moto_sha1_ssse3_schedule(W, data);
+        moto_sha1_transform_w(state, W);
+    }
+    memset(W, 0, sizeof(W));
+}
+
+static void moto_sha256_ssse3(u32 *state, const u8 *data,
+        unsigned int nblocks)
+{
+    u32 W[64];
+
+    while (nblocks--) {
+        moto_sha256_ssse3_schedule(W, data);
+        moto_sha256_transform_w(state, W);
+        data += SHA256_BLOCK_SIZE;
+    }
+    memset(W, 0, sizeof(W));
+}
+
+static void moto_sha256_avx2(u32 *state, const u8 *data,
+        unsigned int nblocks)
+{
+    u32 W[2 * 64];
+
+    for (; nblocks >= 2; nblocks -= 2) {
+        moto_sha256_avx2_schedule(W, data);
+        moto_sha256_transform_w(state, W);
+        moto_sha256_transform_w(state, W + 64);
+        data += 2 * SHA256_BLOCK_SIZE;
+    }
+    if (nblocks) {
+        moto_sha256_ssse3_schedule(W, data);
+        moto_sha256_transform_w(state, W);
+    }
+    memset(W, 0, sizeof(W));
+}
+
+/* d = ror(s, r1) ^ ror(s, r2) ^ ror(s, r3), s preserved */
+#define MOTO_SHA_SSE_SUM(s, d, z, r1, l1, r2, l2, r3, l3)               \
+    "movdqa " s ", " d "\n\t"                                           \
+    "psrld $" #r1 ", " d "\n\t"                                         \
+    "movdqa " s ", " z "\n\t"                                           \
+    "pslld $" #l1 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "movdqa " s ", " z "\n\t"                                           \
+    "psrld $" #r2 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "movdqa " s ", " z "\n\t"                                           \
+    "pslld $" #l2 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "movdqa " s ", " z "\n\t"                                           \
+    "psrld $" #r3 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"                                             \
+    "movdqa " s ", " z "\n\t"                                           \
+    "pslld $" #l3 ", " z "\n\t"                                         \
+    "pxor " z ", " d "\n\t"
+
+#define MOTO_SHA_AVX_SUM(s, d, z, r1, l1, r2, l2, r3, l3)               \
+    "vpsrld $" #r1 ", " s ", " d "\n\t"                                 \
+    "vpslld $" #l1 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpsrld $" #r2 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpslld $" #l2 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpsrld $" #r3 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"                                     \
+    "vpslld $" #l3 ", " s ", " z "\n\t"                                 \
+    "vpxor " z ", " d ", " d "\n\t"
+
+/*
+ * Multi-buffer SHA-256 lanes, see moto_sha256_mb.c: every vector holds the
+ * same word of 4 (SSE2) or 8 (AVX2) messages, so the schedule and the
+ * rounds are the scalar ones on whole rows of W[64][lanes]. The working
+ * variables live in %xmm0-%xmm7 (%ymm0-%ymm7), h takes T1 and then T2
+ * so the eight rounds of a pass only rename registers.
+ */
+#define MOTO_SHA256_MB_SSE_ROUND(i, a, b, c, d, e, f, g, h)             \
+    "movd " #i "*4(%[k]), %%xmm10\n\t"                                  \
+    "pshufd $0, %%xmm10, %%xmm10\n\t"                                   \
+    "movdqu " #i "*16(%[w]), %%xmm11\n\t"                               \
+    "paddd %%xmm11, %%xmm10\n\t"                                        \
+    "paddd %%xmm10, " h "\n\t"                                          \
+    MOTO_SHA_SSE_SUM(e, "%%xmm8", "%%xmm10", 6, 26, 11, 21, 25, 7)      \
+    "paddd %%xmm8, " h "\n\t"                                           \
+    "movdqa " f ", %%xmm10\n\t"                                         \
+    "pxor " g ", %%xmm10\n\t"                                           \
+    "pand " e ", %%xmm10\n\t"                                           \
+    "pxor " g ", %%xmm10\n\t"                                           \
+    "paddd %%xmm10, " h "\n\t"                                          \
+    "paddd " h ", " d "\n\t"                                            \
+    MOTO_SHA_SSE_SUM(a, "%%xmm9", "%%xmm10", 2, 30, 13, 19, 22, 10)     \
+    "movdqa " a ", %%xmm10\n\t"                                         \
+    "por " b ", %%xmm10\n\t"                                            \
+    "pand " c ", %%xmm10\n\t"                                           \
+    "movdqa " a ", %%xmm11\n\t"                                         \
+    "pand " b ", %%xmm11\n\t"                                           \
+    "por %%xmm11, %%xmm10\n\t"                                          \
+    "paddd %%xmm10, %%xmm9\n\t"                                         \
+    "paddd %%xmm9, " h "\n\t"
+
+#define MOTO_SHA256_MB_AVX_ROUND(i, a, b, c, d, e, f, g, h)             \
+    "vpbroadcastd " #i "*4(%[k]), %%ymm10\n\t"                          \
+    "vpaddd " #i "*32(%[w]), %%ymm10, %%ymm10\n\t"                      \
+    "vpaddd %%ymm10, " h ", " h "\n\t"                                  \
+    MOTO_SHA_AVX_SUM(e, "%%ymm8", "%%ymm10", 6, 26, 11, 21, 25, 7)      \
+    "vpaddd %%ymm8, " h ", " h "\n\t"                                   \
+    "vpxor " f ", " g ", %%ymm10\n\t"                                   \
+    "vpand " e ", %%ymm10, %%ymm10\n\t"                                 \
+    "vpxor " g ", %%ymm10, %%ymm10\n\t"                                 \
+    "vpaddd %%ymm10, " h ", " h "\n\t"                                  \
+    "vpaddd " h ", " d ", " d "\n\t"                                    \
+    MOTO_SHA_AVX_SUM(a, "%%ymm9", "%%ymm10", 2, 30, 13, 19, 22, 10)     \
+    "vpor " a ", " b ", %%ymm10\n\t"                                    \
+    "vpand " c ", %%ymm10, %%ymm10\n\t"                                 \
+    "vpand " a ", " b ", %%ymm11\n\t"                                   \
+    "vpor %%ymm11, %%ymm10, %%ymm10\n\t"                                \
+    "vpaddd %%ymm10, %%ymm9, %%ymm9\n\t"                                \
+    "vpaddd %%ymm9, " h ", " h "\n\t"
+
+#define MOTO_SHA256_MB_ROUNDS8(ROUND, r)                                \
+    ROUND(0, r "0", r "1", r "2", r "3", r "4", r "5", r "6", r "7")    \
+    ROUND(1, r "7", r "0", r "1", r "2", r "3", r "4", r "5", r "6")    \
+    ROUND(2, r "6", r "7", r "0", r "1", r "2", r "3", r "4", r "5")    \
+    ROUND(3, r "5", r "6", r "7", r "0", r "1", r "2", r "3", r "4")    \
+    ROUND(4, r "4", r "5", r "6", r "7", r "0", r "1", r "2", r "3")    \
+    ROUND(5, r "3", r "4", r "5", r "6", r "7", r "0", r "1", r "2")    \
+    ROUND(6, r "2", r "3", r "4", r "5", r "6", r "7", r "0", r "1")    \
+    ROUND(7, r "1", r "2", r "3", r "4", r "5", r "6", r "7", r "0")
+
+#define MOTO_SHA256_MB_SSE_STATE(op, i)                                 \
+    "movdqu " #i "*16(%[st]), %%xmm8\n\t"                               \
+    op                                                                  \
+    "movdqu %%xmm" #i ", " #i "*16(%[st])\n\t"
+
+static void moto_sha256_mb_sse2(u32 *state, u32 *W)
+{
+    const u32 *k = moto_sha256_K;
+    u32 *w = W + 16 * 4;
+    unsigned long n = 48;
+
+    asm volatile(
+        /* W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16] */
+        "1:\n\t"
+        "movdqu -2*16(%[w]), %%xmm0\n\t"
+        MOTO_SHA_SSE_SIGMA("%%xmm0", "%%xmm1", "%%xmm2", 17, 15, 19, 13, 10)
+        "movdqu -7*16(%[w]), %%xmm0\n\t"
+        "paddd %%xmm0, %%xmm1\n\t"
+        "movdqu -15*16(%[w]), %%xmm0\n\t"
+        MOTO_SHA_SSE_SIGMA("%%xmm0", "%%xmm3", "%%xmm2", 7, 25, 18, 14, 3)
+        "paddd %%xmm3, %%xmm1\n\t"
+        "movdqu -16*16(%[w]), %%xmm0\n\t"
+        "paddd %%xmm0, %%xmm1\n\t"
+        "movdqu %%xmm1, (%[w])\n\t"
+        "add $16, %[w]\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "sub $64*16, %[w]\n\t"
+        "movdqu 0*16(%[st]), %%xmm0\n\t"
+        "movdqu 1*16(%[st]), %%xmm1\n\t"
+        "movdqu 2*16(%[st]), %%xmm2\n\t"
+        "movdqu 3*16(%[st]), %%xmm3\n\t"
+        "movdqu 4*16(%[st]), %%xmm4\n\t"
+        "movdqu 5*16(%[st]), %%xmm5\n\t"
+        "movdqu 6*16(%[st]), %%xmm6\n\t"
+        "movdqu 7*16(%[st]), %%xmm7\n\t"
+        "mov $8, %[n]\n\t"
+        "2:\n\t"
+        MOTO_SHA256_MB_ROUNDS8(MOTO_SHA256_MB_SSE_ROUND, "%%xmm")
+        "add $8*16, %[w]\n\t"
+        "add $8*4, %[k]\n\t"
+        "dec %[n]\n\t"
+        "jnz 2b\n\t"
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm0\n\t", 0)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm1\n\t", 1)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm2\n\t", 2)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm3\n\t", 3)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm4\n\t", 4)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm5\n\t", 5)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm6\n\t", 6)
+        MOTO_SHA256_MB_SSE_STATE("paddd %%xmm8, %%xmm7\n\t", 7)
+        : [w] "+r" (w), [k] "+r" (k), [n] "+r" (n)
+        : [st] "r" (state)
+        : "cc", "memory");
+}
+
+static void moto_sha256_mb_avx2(u32 *state, u32 *W)
+{
+    const u32 *k = moto_sha256_K;
+    u32 *w = W + 16 * 8;
+    unsigned long n = 48;
+
+    asm volatile(
+        "1:\n\t"
+        "vmovdqu -2*32(%[w]), %%ymm0\n\t"
+        MOTO_SHA_AVX_SIGMA("%%ymm0", "%%ymm1", "%%ymm2", 17, 15, 19, 13, 10)
+        "vpaddd -7*32(%[w]), %%ymm1, %%ymm1\n\t"
+        "vmovdqu -15*32(%[w]), %%ymm0\n\t"
+        MOTO_SHA_AVX_SIGMA("%%ymm0", "%%ymm3", "%%ymm2", 7, 25, 18, 14, 3)
+        "vpaddd %%ymm3, %%ymm1, %%ymm1\n\t"
+        "vpaddd -16*32(%[w]), %%ymm1, %%ymm1\n\t"
+        "vmovdqu %%ymm1, (%[w])\n\t"
+        "add $32, %[w]\n\t"
+        "dec %[n]\n\t"
+        "jnz 1b\n\t"
+        "sub $64*32, %[w]\n\t"
+        "vmovdqu 0*32(%[st]), %%ymm0\n\t"
+        "vmovdqu 1*32(%[st]), %%ymm1\n\t"
+        "vmovdqu 2*32(%[st]), %%ymm2\n\t"
+        "vmovdqu 3*32(%[st]), %%ymm3\n\t"
+        "vmovdqu 4*32(%[st]), %%ymm4\n\t"
+        "vmovdqu 5*32(%[st]), %%ymm5\n\t"
+        "vmovdqu 6*32(%[st]), %%ymm6\n\t"
+        "vmovdqu 7*32(%[st]), %%ymm7\n\t"
+        "mov $8, %[n]\n\t"
+        "2:\n\t"
+        MOTO_SHA256_MB_ROUNDS8(MOTO_SHA256_MB_AVX_ROUND, "%%ymm")
+        "add $8*32, %[w]\n\t"
+        "add $8*4, %[k]\n\t"
+        "dec %[n]\n\t"
+        "jnz 2b\n\t"
+        "vpaddd 0*32(%[st]), %%ymm0, %%ymm0\n\t"
+        "vpaddd 1*32(%[st]), %%ymm1, %%ymm1\n\t"
+        "vpaddd 2*32(%[st]), %%ymm2, %%ymm2\n\t"
+        "vpaddd 3*32(%[st]), %%ymm3, %%ymm3\n\t"
+        "vpaddd 4*32(%[st]), %%ymm4, %%ymm4\n\t"
+        "vpaddd 5*32(%[st]), %%ymm5, %%ymm5\n\t"
+        "vpaddd 6*32(%[st]), %%ymm6, %%ymm6\n\t"
+        "vpaddd 7*32(%[st]), %%ymm7, %%ymm7\n\t"
+        "vmovdqu %%ymm0, 0*32(%[st])\n\t"
+        "vmovdqu %%ymm1, 1*32(%[st])\n\t"
+        "vmovdqu %%ymm2, 2*32(%[st])\n\t"
+        "vmovdqu %%ymm3, 3*32(%[st])\n\t"
+        "vmovdqu %%ymm4, 4*32(%[st])\n\t"
+        "vmovdqu %%ymm5, 5*32(%[st])\n\t"
+        "vmovdqu %%ymm6, 6*32(%[st])\n\t"
+        "vmovdqu %%ymm7, 7*32(%[st])\n\t"
+        "vzeroupper\n\t"
+        : [w] "+r" (w), [k] "+r" (k), [n] "+r" (n)
+        : [st] "r" (state)
+        : "cc", "memory");
+}
+
+static void moto_sha256_mb_sse2_blocks(u32 *state, u32 *W)
+{
+    if (!irq_fpu_usable()) {
+        moto_sha256_transform_lanes(state, W, 4);
+        return;
+    }
+    kernel_fpu_begin();
+    moto_sha256_mb_sse2(state, W);
+    kernel_fpu_end();
+}
+
+static void moto_sha256_mb_avx2_blocks(u32 *state, u32 *W)
+{
+    if (!irq_fpu_usable()) {
+        moto_sha256_transform_lanes(state, W, 8);
+        return;
+    }
+    kernel_fpu_begin();
+    moto_sha256_mb_avx2(state, W);
+    kernel_fpu_end();
+}
+
+static const struct moto_sha256_mb_lanes moto_sha256_mb_sse2_lanes = {
+    .name   = "sse2",
+    .lanes  = 4,
+    .blocks = moto_sha256_mb_sse2_blocks,
+};
+
+static const struct moto_sha256_mb_lanes moto_sha256_mb_avx2_lanes = {
+    .name   = "avx2",
+    .lanes  = 8,
+    .blocks = moto_sha256_mb_avx2_blocks,
+};
+
+static void moto_sha_x86_fpu(moto_sha_block_fn *blocks,
+        moto_sha_block_fn *fallback, u32 *state, const u8 *data,
+        unsigned int nblocks)
+{
+    unsigned int n;
+
+    if (!irq_fpu_usable()) {
+        fallback(state, data, nblocks);
+        return;
+    }
+
+    while (nblocks) {
+        n = min_t(unsigned int, nblocks, MOTO_SHA_X86_FPU_BLOCKS);
+        kernel_fpu_begin();
+        blocks(state, data, n);
+        kernel_fpu_end();
+        data += n * SHA1_BLOCK_SIZE;
+        nblocks -= n;
+    }
+}
+
+#define MOTO_SHA_X86_BLOCKS(alg, variant)                               \
+static void moto_##alg##_##variant##_blocks(u32 *state, const u8 *data, \
+        unsigned int nblocks)                                           \
+{                                                                       \
+    moto_sha_x86_fpu(moto_##alg##_##variant,                            \
+            moto_##alg##_transform_blocks, state, data, nblocks);       \
+}
+
+MOTO_SHA_X86_BLOCKS(sha1, ni)
+MOTO_SHA_X86_BLOCKS(sha1, avx2)
+MOTO_SHA_X86_BLOCKS(sha1, ssse3)
+MOTO_SHA_X86_BLOCKS(sha256, ni)
+MOTO_SHA_X86_BLOCKS(sha256, avx2)
+MOTO_SHA_X86_BLOCKS(sha256, ssse3)
+
+struct moto_sha_x86_alg {
+    struct shash_alg alg;
+    moto_sha_block_fn *blocks;
+    int registered;
+};
+
+static inline moto_sha_block_fn *moto_sha_x86_blocks(struct shash_desc *desc)
+{
+    return container_of(crypto_shash_alg(desc->tfm),
+            struct moto_sha_x86_alg, alg)->blocks;
+}
+
+static int moto_sha1_x86_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len)
+{
+    return moto_sha1_do_update(desc, data, len, moto_sha_x86_blocks(desc));
+}
+
+static int moto_sha1_x86_final(struct shash_desc *desc, u8 *out)
+{
+    return moto_sha1_do_final(desc, out, moto_sha_x86_blocks(desc));
+}
+
+static int moto_sha256_x86_update(struct shash_desc *desc, const u8 *data,
+        unsigned int len)
+{
+    return moto_sha256_do_update(desc, data, len, moto_sha_x86_blocks(desc));
+}
+
+static int moto_sha256_x86_final(struct shash_desc *desc, u8 *out)
+{
+    return moto_sha256_do_final(desc, out, moto_sha_x86_blocks(desc));
+}
+
+static int moto_sha224_x86_final(struct shash_desc *desc, u8 *hash)
+{
+    u8 D[SHA256_DIGEST_SIZE];
+    int err;
+
+    err = moto_sha256_x86_final(desc, D);
+    if (err)
+        return err;
+
+    memcpy(hash, D, SHA224_DIGEST_SIZE);
+    memset(D, 0, SHA256_DIGEST_SIZE);
+
+    return 0;
+}
+
+static int moto_sha_x86_export(struct shash_desc *desc, void *out)
+{
+    memcpy(out, shash_desc_ctx(desc), crypto_shash_statesize(desc->tfm));
+    return 0;
+}
+
+static int moto_sha_x86_import(struct shash_desc *desc, const void *in)
+{
+    memcpy(shash_desc_ctx(desc), in, crypto_shash_statesize(desc->tfm));
+    return 0;
+}
+
+#define MOTO_SHA_X86_ALG(name, variant, size, init_fn, update_fn,       \
+        final_fn, state, blocks_fn)                                     \
+    {                                                                   \
+        .alg = {                                                        \
+            .digestsize = size,                                         \
+            .init       = init_fn,                                      \
+            .update     = update_fn,                                    \
+            .final      = final_fn,                                     \
+            .export     = moto_sha_x86_export,                          \
+            .import     = moto_sha_x86_import,                          \
+            .descsize   = sizeof(struct state),                         \
+            .statesize  = sizeof(struct state),                         \
+            .base       = {                                             \
+                .cra_name       = #name,                                \
+                .cra_driver_name= "moto-" #name "-" #variant,           \
+                .cra_priority   = 900,                                  \
+                .cra_flags      = CRYPTO_ALG_TYPE_SHASH,                \
+                .cra_blocksize  = SHA1_BLOCK_SIZE,                      \
+                .cra_module     = THIS_MODULE,                          \
+            }                                                           \
+        },                                                              \
+        .blocks = blocks_fn,                                            \
+    }
+
+enum {
+    MOTO_SHA_X86_SHA1,
+    MOTO_SHA_X86_SHA224,
+    MOTO_SHA_X86_SHA256,
+    MOTO_SHA_X86_ALGS
+};
+
+#define MOTO_SHA_X86_VARIANT(variant)                                   \
+    .name = #variant,                                                   \
+    .algs = {                                                           \
+        MOTO_SHA_X86_ALG(sha1, variant, SHA1_DIGEST_SIZE,               \
+                moto_sha1_init, moto_sha1_x86_update,                   \
+                moto_sha1_x86_final, moto_sha1_state,                   \
+                moto_sha1_##variant##_blocks),                          \
+        MOTO_SHA_X86_ALG(sha224, variant, SHA224_DIGEST_SIZE,           \
+                moto_sha224_init, moto_sha256_x86_update,               \
+                moto_sha224_x86_final, moto_sha256_state,               \
+                moto_sha256_##variant##_blocks),                        \
+        MOTO_SHA_X86_ALG(sha256, variant, SHA256_DIGEST_SIZE,           \
+                moto_sha256_init, moto_sha256_x86_update,               \
+                moto_sha256_x86_final, moto_sha256_state,               \
+                moto_sha256_##variant##_blocks),                        \
+    }
+
+struct moto_sha_x86_variant {
+    const char *name;
+    int (*usable)(void);
+    struct moto_sha_x86_alg algs[MOTO_SHA_X86_ALGS];
+};
+
+static int moto_sha_ni_usable(void)
+{
+    return boot_cpu_has(X86_FEATURE_SHA_NI) &&
+            boot_cpu_has(X86_FEATURE_XMM4_1);
+}
+
+static int moto_sha_avx2_usable(void)
+{
+    return boot_cpu_has(X86_FEATURE_AVX2) &&
+            boot_cpu_has(X86_FEATURE_OSXSAVE);
+}
+
+static int moto_sha_ssse3_usable(void)
+{
+    return boot_cpu_has(X86_FEATURE_SSSE3);
+}
+
+/* Best first */
+static struct moto_sha_x86_variant moto_sha_x86_variants[] = {
+    {
+        MOTO_SHA_X86_VARIANT(ni),
+        .usable = moto_sha_ni_usable,
+    },
+    {
+        MOTO_SHA_X86_VARIANT(avx2),
+        .usable = moto_sha_avx2_usable,
+    },
+    {
+        MOTO_SHA_X86_VARIANT(ssse3),
+        .usable = moto_sha_ssse3_usable,
+    },
+};
+
+static const unsigned moto_sha_x86_failure[MOTO_SHA_X86_ALGS] = {
+    [MOTO_SHA_X86_SHA1] = MOTO_CRYPTO_FAILED_ALG_SHA1,
+    [MOTO_SHA_X86_SHA224] = MOTO_CRYPTO_FAILED_ALG_SHA256,
+    [MOTO_SHA_X86_SHA256] = MOTO_CRYPTO_FAILED_ALG_SHA256,
+};
+
+static int moto_sha_x86_register(struct moto_sha_x86_variant *variant)
+{
+    struct moto_sha_x86_alg *x;
+    int i, err;
+
+    for (i = 0; i < MOTO_SHA_X86_ALGS; i++) {
+        x = &variant->algs[i];
+        err = moto_post_alg_defer(&x->alg.base, x->alg.base.cra_driver_name,
+                x->alg.base.cra_name, moto_sha_x86_failure[i]) ?:
+                crypto_register_shash(&x->alg);
+        printk (KERN_INFO "%s register result: %d\n",
+                x->alg.base.cra_driver_name, err);
+        if (err)
+            return err;
+        x->registered = 1;
+        err = moto_post_alg_test(x->alg.base.cra_driver_name,
+                x->alg.base.cra_name, moto_sha_x86_failure[i]);
+        printk (KERN_INFO "%s test result: %d\n",
+                x->alg.base.cra_driver_name, err);
+        if (err)
+            return err;
+    }
+    return 0;
+}
+
+/* SSE2 is part of x86_64 */
+const struct moto_sha256_mb_lanes *moto_sha256_mb_x86_lanes(unsigned int i)
+{
+    if (sha_x86 && !strcmp(sha_x86, "none"))
+        return NULL;
+
+    if (moto_sha_avx2_usable()) {
+        if (!i)
+            return &moto_sha256_mb_avx2_lanes;
+        i--;
+    }
+    return i ? NULL : &moto_sha256_mb_sse2_lanes;
+}
+
+int moto_sha_x86_start(void)
+{
+    struct moto_sha_x86_variant *variant, *best = NULL;
+    int i, err;
+
+    for (i = 0; i < ARRAY_SIZE(moto_sha_x86_variants); i++) {
+        variant = &moto_sha_x86_variants[i];
+        if (!variant->usable()) {
+            printk (KERN_INFO "SHA %s not supported by the CPU\n",
+                    variant->name);
+            continue;
+        }
+        err = moto_sha_x86_register(variant);
+        if (err)
+            return err;
+        if (!best && (!sha_x86 || !strcmp(sha_x86, variant->name)))
+            best = variant;
+    }
+
+    if (sha_x86 && !strcmp(sha_x86, "none"))
+        best = NULL;
+    if (best) {
+        moto_sha1_set_blocks(best->algs[MOTO_SHA_X86_SHA1].blocks);
+        moto_sha256_set_blocks(best->algs[MOTO_SHA_X86_SHA256].blocks);
+    }
+    printk (KERN_INFO "moto-sha1/moto-sha256 block function: %s\n",
+            best ? best->name : "portable");
+
+    return 0;
+}
+
+void moto_sha_x86_finish(void)
+{
+    struct moto_sha_x86_alg *x;
+    int i, j, err;
+
+    moto_sha1_set_blocks(NULL);
+    moto_sha256_set_blocks(NULL);
+
+    for (i = 0; i < ARRAY_SIZE(moto_sha_x86_variants); i++) {
+        for (j = 0; j < MOTO_SHA_X86_ALGS; j++) {
+            x = &moto_sha_x86_variants[i].algs[j];
+            if (!x->registered)
+                continue;
+            err = crypto_unregister_shash(&x->alg);
+            x->registered = 0;
+            printk (KERN_INFO "%s unregister result: %d\n",
+                    x->alg.base.cra_driver_name, err);
+        }
+    }
+}
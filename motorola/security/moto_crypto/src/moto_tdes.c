@@ -24,7 +24,10 @@
 #include <moto_tdes.h>
 
 #include "moto_crypto_util.h"
+#include "moto_crypto_stats.h"
+#include <moto_crypto_trace.h>
 #include "moto_testmgr.h"
+#include "moto_crypto_main.h"
 
 #define ROL(x, r) ((x) = rol32((x), (r)))
 #define ROR(x, r) ((x) = ror32((x), (r)))
@@ -878,19 +881,80 @@ static void moto_des3_ede_decrypt(struct crypto_tfm *tfm, u8 *dst,
     d[1] = cpu_to_le32(L);
 }
 
+/*
+ * Number of blocks handled by moto_des3_ede_decrypt_x4(). The Feistel
+ * rounds of the independent blocks are issued side by side so the S-box
+ * lookups of one block overlap with those of the others.
+ */
+#define DES3_EDE_INTERLEAVE	4
+
+#define ROUND_X4(L, R, A, B, K, d)		\
+        ROUND(L[0], R[0], A, B, K, 0);	\
+        ROUND(L[1], R[1], A, B, K, 0);	\
+        ROUND(L[2], R[2], A, B, K, 0);	\
+        ROUND(L[3], R[3], A, B, K, d);
+
+/*
+ * Decrypt DES3_EDE_INTERLEAVE consecutive blocks. @dst may be equal to
+ * @src, all input words are loaded before the first output word is stored.
+ */
+static void moto_des3_ede_decrypt_x4(const struct moto_des3_ede_ctx *dctx,
+        u8 *dst, const u8 *src)
+{
+    const u32 *K = dctx->expkey + DES3_EDE_EXPKEY_WORDS - 2;
+    const __le32 *s = (const __le32 *)src;
+    __le32 *d = (__le32 *)dst;
+    u32 L[DES3_EDE_INTERLEAVE], R[DES3_EDE_INTERLEAVE], A, B;
+    int i;
+
+    for (i = 0; i < DES3_EDE_INTERLEAVE; i++, s += 2) {
+        L[i] = le32_to_cpu(s[0]);
+        R[i] = le32_to_cpu(s[1]);
+        IP(L[i], R[i], A);
+    }
+
+    for (i = 0; i < 8; i++) {
+        ROUND_X4(L, R, A, B, K, -2);
+        ROUND_X4(R, L, A, B, K, -2);
+    }
+    for (i = 0; i < 8; i++) {
+        ROUND_X4(R, L, A, B, K, -2);
+        ROUND_X4(L, R, A, B, K, -2);
+    }
+    for (i = 0; i < 8; i++) {
+        ROUND_X4(L, R, A, B, K, -2);
+        ROUND_X4(R, L, A, B, K, -2);
+    }
+
+    for (i = 0; i < DES3_EDE_INTERLEAVE; i++, d += 2) {
+        FP(R[i], L[i], A);
+        d[0] = cpu_to_le32(R[i]);
+        d[1] = cpu_to_le32(L[i]);
+    }
+}
+
 static int moto_ecb_des3_ede_operate(struct blkcipher_desc *desc,
         struct scatterlist *dst, struct scatterlist *src,
         unsigned int nbytes, void (*fn)(struct crypto_tfm *, u8 *, const u8 *))
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
+    int enc = (fn == moto_des3_ede_encrypt);
     int err;
     u8 *wsrc;
     u8 *wdst;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
     if (nbytes % DES3_EDE_BLOCK_SIZE)
         return -EINVAL;
 
+    trace_moto_cipher_start(crypto_blkcipher_tfm(desc->tfm), enc, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
 
     err = blkcipher_walk_virt(desc, &walk);
@@ -900,6 +964,9 @@ static int moto_ecb_des3_ede_operate(struct blkcipher_desc *desc,
 
         wsrc = walk.src.virt.addr;
         wdst = walk.dst.virt.addr;
+        segments++;
+        if (wsrc == wdst)
+            inplace++;
 
         do {
             fn(crypto_blkcipher_tfm(tfm), wdst, wsrc);
@@ -912,6 +979,9 @@ static int moto_ecb_des3_ede_operate(struct blkcipher_desc *desc,
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(desc->tfm), enc, total,
+            segments, inplace, err);
+    moto_stats_account(MOTO_STATS_TDES_ECB, total, start);
     return err;
 }
 
@@ -979,21 +1049,34 @@ static int moto_cbc_des3_ede_encrypt(struct blkcipher_desc *desc,
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm = desc->tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
     int err;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_cipher_start(crypto_blkcipher_tfm(tfm), 1, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
     err = blkcipher_walk_virt(desc, &walk);
 
     while ((nbytes = walk.nbytes)) {
-        if (walk.src.virt.addr == walk.dst.virt.addr)
+        segments++;
+        if (walk.src.virt.addr == walk.dst.virt.addr) {
+            inplace++;
             nbytes = moto_cbc_des3_ede_encrypt_inplace(desc, &walk,
                     tfm);
-        else
+        } else
             nbytes = moto_cbc_des3_ede_encrypt_segment(desc, &walk,
                     tfm);
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(tfm), 1, total, segments,
+            inplace, err);
+    moto_stats_account(MOTO_STATS_TDES_CBC, total, start);
     return err;
 }
 
@@ -1001,19 +1084,34 @@ static int moto_cbc_des3_ede_decrypt_segment(struct blkcipher_desc *desc,
         struct blkcipher_walk *walk,
         struct crypto_blkcipher *tfm)
 {
+    const struct moto_des3_ede_ctx *dctx = crypto_blkcipher_ctx(tfm);
     unsigned int nbytes = walk->nbytes;
     u8 *src = walk->src.virt.addr;
     u8 *dst = walk->dst.virt.addr;
     u8 *iv = walk->iv;
 
-    do {
+    /* decrypt several blocks at once, then apply the chaining */
+    while (nbytes >= DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE) {
+        moto_des3_ede_decrypt_x4(dctx, dst, src);
+        moto_crypto_xor(dst, iv, DES3_EDE_BLOCK_SIZE);
+        moto_crypto_xor(dst + DES3_EDE_BLOCK_SIZE, src,
+                (DES3_EDE_INTERLEAVE - 1) * DES3_EDE_BLOCK_SIZE);
+        iv = src + (DES3_EDE_INTERLEAVE - 1) * DES3_EDE_BLOCK_SIZE;
+
+        src += DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE;
+        dst += DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE;
+        nbytes -= DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE;
+    }
+
+    while (nbytes >= DES3_EDE_BLOCK_SIZE) {
         moto_des3_ede_decrypt(crypto_blkcipher_tfm(tfm), dst, src);
         moto_crypto_xor(dst, iv, DES3_EDE_BLOCK_SIZE);
         iv = src;
 
         src += DES3_EDE_BLOCK_SIZE;
         dst += DES3_EDE_BLOCK_SIZE;
-    } while ((nbytes -= DES3_EDE_BLOCK_SIZE) >= DES3_EDE_BLOCK_SIZE);
+        nbytes -= DES3_EDE_BLOCK_SIZE;
+    }
 
     memcpy(walk->iv, iv, DES3_EDE_BLOCK_SIZE);
 
@@ -1024,9 +1122,34 @@ static int moto_cbc_des3_ede_decrypt_inplace(struct blkcipher_desc *desc,
         struct blkcipher_walk *walk,
         struct crypto_blkcipher *tfm)
 {
+    const struct moto_des3_ede_ctx *dctx = crypto_blkcipher_ctx(tfm);
     unsigned int nbytes = walk->nbytes;
     u8 *src = walk->src.virt.addr;
     u8 last_iv[DES3_EDE_BLOCK_SIZE];
+    u32 buf[DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE / sizeof(u32)];
+
+    /*
+     * Decrypt whole groups into a bounce buffer, so the ciphertext the
+     * chaining needs is still in place, and carry the last ciphertext
+     * block of each group over in walk->iv.
+     */
+    while (nbytes >= DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE) {
+        moto_des3_ede_decrypt_x4(dctx, (u8 *)buf, src);
+        moto_crypto_xor((u8 *)buf, walk->iv, DES3_EDE_BLOCK_SIZE);
+        moto_crypto_xor((u8 *)buf + DES3_EDE_BLOCK_SIZE, src,
+                (DES3_EDE_INTERLEAVE - 1) * DES3_EDE_BLOCK_SIZE);
+        memcpy(walk->iv,
+                src + (DES3_EDE_INTERLEAVE - 1) * DES3_EDE_BLOCK_SIZE,
+                DES3_EDE_BLOCK_SIZE);
+        memcpy(src, buf, DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE);
+
+        src += DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE;
+        nbytes -= DES3_EDE_INTERLEAVE * DES3_EDE_BLOCK_SIZE;
+    }
+    memset(buf, 0, sizeof(buf));
+
+    if (nbytes < DES3_EDE_BLOCK_SIZE)
+        return nbytes;
 
     /* Start of the last block. */
     src += nbytes - (nbytes & (DES3_EDE_BLOCK_SIZE - 1)) 
@@ -1056,21 +1179,34 @@ static int moto_cbc_des3_ede_decrypt(struct blkcipher_desc *desc,
 {
     struct blkcipher_walk walk;
     struct crypto_blkcipher *tfm = desc->tfm;
+    ktime_t start = moto_stats_start();
+    unsigned int total = nbytes;
+    unsigned int segments = 0, inplace = 0;
     int err;
 
+    if (moto_crypto_in_error())
+        return -ELIBBAD;
+
+    trace_moto_cipher_start(crypto_blkcipher_tfm(tfm), 0, total);
+
     blkcipher_walk_init(&walk, dst, src, nbytes);
     err = blkcipher_walk_virt(desc, &walk);
 
     while ((nbytes = walk.nbytes)) {
-        if (walk.src.virt.addr == walk.dst.virt.addr)
+        segments++;
+        if (walk.src.virt.addr == walk.dst.virt.addr) {
+            inplace++;
             nbytes = moto_cbc_des3_ede_decrypt_inplace(desc, &walk,
                     tfm);
-        else
+        } else
             nbytes = moto_cbc_des3_ede_decrypt_segment(desc, &walk,
                     tfm);
         err = blkcipher_walk_done(desc, &walk, nbytes);
     }
 
+    trace_moto_cipher_done(crypto_blkcipher_tfm(tfm), 0, total, segments,
+            inplace, err);
+    moto_stats_account(MOTO_STATS_TDES_CBC, total, start);
     return err;
 }
 
@@ -1137,10 +1273,13 @@ int moto_tdes_start(void)
 {
     int ret = 0;
 
-    ret = crypto_register_alg(&moto_ecb_des3_ede_alg);
+    ret = moto_post_alg_defer(&moto_ecb_des3_ede_alg, "moto-des3-ecb",
+            "ecb(des3_ede)", MOTO_CRYPTO_FAILED_ALG_TDES) ?:
+            crypto_register_alg(&moto_ecb_des3_ede_alg);
     printk (KERN_INFO "ecb(des3) register result: %d\n", ret);
     if (!ret) {
-        ret = moto_alg_test("moto-des3-ecb", "ecb(des3_ede)", 0, 0);
+        ret = moto_post_alg_test("moto-des3-ecb", "ecb(des3_ede)",
+                MOTO_CRYPTO_FAILED_ALG_TDES);
         printk (KERN_INFO "ecb(des3_ede) test result: %d\n", ret);
         if (ret) {
             goto out;
@@ -1149,10 +1288,13 @@ int moto_tdes_start(void)
     else {
         goto out;
     }
-    ret = crypto_register_alg(&moto_cbc_des3_ede_alg);
+    ret = moto_post_alg_defer(&moto_cbc_des3_ede_alg, "moto-des3-cbc",
+            "cbc(des3_ede)", MOTO_CRYPTO_FAILED_ALG_TDES) ?:
+            crypto_register_alg(&moto_cbc_des3_ede_alg);
     printk (KERN_INFO "cbc(des3) register result: %d\n", ret);
     if (!ret) {
-        ret = moto_alg_test("moto-des3-cbc", "cbc(des3_ede)", 0, 0);
+        ret = moto_post_alg_test("moto-des3-cbc", "cbc(des3_ede)",
+                MOTO_CRYPTO_FAILED_ALG_TDES);
         printk (KERN_INFO "cbc(des3_ede) test result: %d\n", ret);
     }
     out:
@@ -20,9 +20,16 @@
  *
  */
 
+#include <crypto/aead.h>
 #include <crypto/hash.h>
+#include <linux/completion.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
 #include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
 #include <linux/scatterlist.h>
 #include <linux/slab.h>
 #include <linux/string.h>
@@ -264,6 +271,90 @@ static struct moto_hash_testvec moto_sha512_tv_template[] = {
         },
 };
 
+/*
+ * SHA512/224 test vectors on the SHA512 inputs, abc and the 112 byte
+ * message are the NIST examples
+ */
+#define SHA512_224_TEST_VECTORS	4
+
+static struct moto_hash_testvec moto_sha512_224_tv_template[] = {
+        {
+                .plaintext = "abc",
+                .psize	= 3,
+                .digest	= "\x46\x34\x27\x0f\x70\x7b\x6a\x54"
+                        "\xda\xae\x75\x30\x46\x08\x42\xe2"
+                        "\x0e\x37\xed\x26\x5c\xee\xe9\xa4"
+                        "\x3e\x89\x24\xaa",
+        }, {
+                .plaintext = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                .psize	= 56,
+                .digest	= "\xe5\x30\x2d\x6d\x54\xbb\x24\x22"
+                        "\x75\xd1\xe7\x62\x2d\x68\xdf\x6e"
+                        "\xb0\x2d\xed\xd1\x3f\x56\x4c\x13"
+                        "\xdb\xda\x21\x74",
+        }, {
+                .plaintext = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+                        "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+                .psize	= 112,
+                .digest	= "\x23\xfe\xc5\xbb\x94\xd6\x0b\x23"
+                        "\x30\x81\x92\x64\x0b\x0c\x45\x33"
+                        "\x35\xd6\x64\x73\x4f\xe4\x0e\x72"
+                        "\x68\x67\x4a\xf9",
+        }, {
+                .plaintext = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcd"
+                        "efghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz",
+                .psize	= 104,
+                .digest	= "\x48\x65\x5b\xd9\xea\xe2\x72\x4a"
+                        "\x6b\xff\x8f\x20\x8c\x34\xb5\xca"
+                        "\x6b\x1b\x2e\x00\x99\xa2\x31\x50"
+                        "\x16\xcf\x68\x7c",
+                .np	= 4,
+                .tap	= { 26, 26, 26, 26 }
+        },
+};
+
+/*
+ * SHA512/256 test vectors on the SHA512 inputs, abc and the 112 byte
+ * message are the NIST examples
+ */
+#define SHA512_256_TEST_VECTORS	4
+
+static struct moto_hash_testvec moto_sha512_256_tv_template[] = {
+        {
+                .plaintext = "abc",
+                .psize	= 3,
+                .digest	= "\x53\x04\x8e\x26\x81\x94\x1e\xf9"
+                        "\x9b\x2e\x29\xb7\x6b\x4c\x7d\xab"
+                        "\xe4\xc2\xd0\xc6\x34\xfc\x6d\x46"
+                        "\xe0\xe2\xf1\x31\x07\xe7\xaf\x23",
+        }, {
+                .plaintext = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                .psize	= 56,
+                .digest	= "\xbd\xe8\xe1\xf9\xf1\x9b\xb9\xfd"
+                        "\x34\x06\xc9\x0e\xc6\xbc\x47\xbd"
+                        "\x36\xd8\xad\xa9\xf1\x18\x80\xdb"
+                        "\xc8\xa2\x2a\x70\x78\xb6\xa4\x61",
+        }, {
+                .plaintext = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+                        "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+                .psize	= 112,
+                .digest	= "\x39\x28\xe1\x84\xfb\x86\x90\xf8"
+                        "\x40\xda\x39\x88\x12\x1d\x31\xbe"
+                        "\x65\xcb\x9d\x3e\xf8\x3e\xe6\x14"
+                        "\x6f\xea\xc8\x61\xe1\x9b\x56\x3a",
+        }, {
+                .plaintext = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcd"
+                        "efghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz",
+                .psize	= 104,
+                .digest	= "\x1a\x59\xbe\x4c\xb0\x31\x0d\x17"
+                        "\x04\x15\x21\x68\x5d\xfd\x17\x4c"
+                        "\x48\xc0\xc3\x59\xed\x4b\x1d\xfb"
+                        "\xa6\x3e\x98\x4b\x40\x34\xa4\x0d",
+                .np	= 4,
+                .tap	= { 26, 26, 26, 26 }
+        },
+};
+
 /*
  * HMAC-SHA1 test vectors from RFC2202
  */
@@ -813,6 +904,196 @@ static struct moto_hash_testvec moto_hmac_sha512_tv_template[] = {
         },
 };
 
+/*
+ * SHA512/224 HMAC test vectors, the inputs of RFC4231 test cases 1, 2,
+ * 6 and 7
+ */
+
+#define HMAC_SHA512_224_TEST_VECTORS	4
+
+static struct moto_hash_testvec moto_hmac_sha512_224_tv_template[] = {
+        {
+                .key	= "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b"
+                        "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b"
+                        "\x0b\x0b\x0b\x0b",
+                .ksize	= 20,
+                .plaintext = "Hi There",
+                .psize	= 8,
+                .digest	= "\xb2\x44\xba\x01\x30\x7c\x0e\x7a"
+                        "\x8c\xca\xad\x13\xb1\x06\x7a\x4c"
+                        "\xf6\xb9\x61\xfe\x0c\x6a\x20\xbd"
+                        "\xa3\xd9\x20\x39",
+        }, {
+                .key	= "Jefe",
+                .ksize	= 4,
+                .plaintext = "what do ya want for nothing?",
+                .psize	= 28,
+                .digest	= "\x4a\x53\x0b\x31\xa7\x9e\xbc\xce"
+                        "\x36\x91\x65\x46\x31\x7c\x45\xf2"
+                        "\x47\xd8\x32\x41\xdf\xb8\x18\xfd"
+                        "\x37\x25\x4b\xde",
+                .np	= 4,
+                .tap	= { 7, 7, 7, 7 }
+        }, {
+                .key	= "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa",
+                .ksize	= 131,
+                .plaintext = "Test Using Large"
+                        "r Than Block-Siz"
+                        "e Key - Hash Key"
+                        " First",
+                .psize	= 54,
+                .digest	= "\x29\xbe\xf8\xce\x88\xb5\x4d\x42"
+                        "\x26\xc3\xc7\x71\x8e\xa9\xe3\x2a"
+                        "\xce\x24\x29\x02\x6f\x08\x9e\x38"
+                        "\xce\xa9\xae\xda",
+        }, {
+                .key	= "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa",
+                .ksize	= 131,
+                .plaintext = "This is a test u"
+                        "sing a larger th"
+                        "an block-size ke"
+                        "y and a larger t"
+                        "han block-size d"
+                        "ata. The key nee"
+                        "ds to be hashed "
+                        "before being use"
+                        "d by the HMAC al"
+                        "gorithm.",
+                .psize	= 152,
+                .digest	= "\x82\xa9\x61\x9b\x47\xaf\x0c\xea"
+                        "\x73\xa8\xb9\x74\x13\x55\xce\x90"
+                        "\x2d\x80\x7a\xd8\x7e\xe9\x07\x85"
+                        "\x22\xa2\x46\xe1",
+        },
+};
+
+/*
+ * SHA512/256 HMAC test vectors, the inputs of RFC4231 test cases 1, 2,
+ * 6 and 7
+ */
+
+#define HMAC_SHA512_256_TEST_VECTORS	4
+
+static struct moto_hash_testvec moto_hmac_sha512_256_tv_template[] = {
+        {
+                .key	= "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b"
+                        "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b"
+                        "\x0b\x0b\x0b\x0b",
+                .ksize	= 20,
+                .plaintext = "Hi There",
+                .psize	= 8,
+                .digest	= "\x9f\x91\x26\xc3\xd9\xc3\xc3\x30"
+                        "\xd7\x60\x42\x5c\xa8\xa2\x17\xe3"
+                        "\x1f\xea\xe3\x1b\xfe\x70\x19\x6f"
+                        "\xf8\x16\x42\xb8\x68\x40\x2e\xab",
+        }, {
+                .key	= "Jefe",
+                .ksize	= 4,
+                .plaintext = "what do ya want for nothing?",
+                .psize	= 28,
+                .digest	= "\x6d\xf7\xb2\x46\x30\xd5\xcc\xb2"
+                        "\xee\x33\x54\x07\x08\x1a\x87\x18"
+                        "\x8c\x22\x14\x89\x76\x8f\xa2\x02"
+                        "\x05\x13\xb2\xd5\x93\x35\x94\x56",
+                .np	= 4,
+                .tap	= { 7, 7, 7, 7 }
+        }, {
+                .key	= "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa",
+                .ksize	= 131,
+                .plaintext = "Test Using Large"
+                        "r Than Block-Siz"
+                        "e Key - Hash Key"
+                        " First",
+                .psize	= 54,
+                .digest	= "\x87\x12\x3c\x45\xf7\xc5\x37\xa4"
+                        "\x04\xf8\xf4\x7c\xdb\xed\xda\x1f"
+                        "\xc9\xbe\xc6\x0e\xeb\x97\x19\x82"
+                        "\xce\x7e\xf1\x0e\x77\x4e\x65\x39",
+        }, {
+                .key	= "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa"
+                        "\xaa\xaa\xaa",
+                .ksize	= 131,
+                .plaintext = "This is a test u"
+                        "sing a larger th"
+                        "an block-size ke"
+                        "y and a larger t"
+                        "han block-size d"
+                        "ata. The key nee"
+                        "ds to be hashed "
+                        "before being use"
+                        "d by the HMAC al"
+                        "gorithm.",
+                .psize	= 152,
+                .digest	= "\x6e\xa8\x3f\x8e\x73\x15\x07\x2c"
+                        "\x0b\xda\xa3\x3b\x93\xa2\x6f\xc1"
+                        "\x65\x99\x74\x63\x7a\x9d\xb8\xa8"
+                        "\x87\xd0\x6c\x05\xa7\xf3\x5a\x66",
+        },
+};
+
 /*
  * DES test vectors.
  */
@@ -981,6 +1262,8 @@ static struct moto_cipher_testvec moto_des3_ede_cbc_dec_tv_template[] = {
 #define AES_CBC_DEC_TEST_VECTORS 4
 #define AES_CTR_ENC_TEST_VECTORS 3
 #define AES_CTR_DEC_TEST_VECTORS 3
+#define AES_XTS_ENC_TEST_VECTORS 4
+#define AES_XTS_DEC_TEST_VECTORS 3
 
 static struct moto_cipher_testvec moto_aes_enc_tv_template[] = {
         { /* From FIPS-197 */
@@ -1379,6 +1662,1235 @@ static struct moto_cipher_testvec moto_aes_ctr_dec_tv_template[] = {
 };
 
 
+static struct moto_cipher_testvec moto_aes_xts_enc_tv_template[] = {
+        { /* IEEE 1619-2007, Vector 2 */
+                .key	= "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x22\x22\x22\x22\x22\x22\x22\x22"
+                        "\x22\x22\x22\x22\x22\x22\x22\x22",
+                        .klen	= 32,
+                        .iv	= "\x33\x33\x33\x33\x33\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\x44\x44\x44\x44\x44\x44\x44\x44"
+                                        "\x44\x44\x44\x44\x44\x44\x44\x44"
+                                        "\x44\x44\x44\x44\x44\x44\x44\x44"
+                                        "\x44\x44\x44\x44\x44\x44\x44\x44",
+                                        .ilen	= 32,
+                                        .result	= "\xc4\x54\x18\x5e\x6a\x16\x93\x6e"
+                                                "\x39\x33\x40\x38\xac\xef\x83\x8b"
+                                                "\xfb\x18\x6f\xff\x74\x80\xad\xc4"
+                                                "\x28\x93\x82\xec\xd6\xd3\x94\xf0",
+                                                .rlen	= 32,
+        }, { /* IEEE 1619-2007, Vector 4 */
+                .key	= "\x27\x18\x28\x18\x28\x45\x90\x45"
+                        "\x23\x53\x60\x28\x74\x71\x35\x26"
+                        "\x31\x41\x59\x26\x53\x58\x97\x93"
+                        "\x23\x84\x62\x64\x33\x83\x27\x95",
+                        .klen	= 32,
+                        .iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                        "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                        "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                        "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                        "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                        "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                        "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                        "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                        "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                        "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                        "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                        "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                        "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                        "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                        "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                        "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                        "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                        "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                        "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                        "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                        "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                        "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                        "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                        "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                        "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                        "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                        "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                        "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff"
+                                        "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                        "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                        "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                        "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                        "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                        "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                        "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                        "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                        "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                        "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                        "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                        "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                        "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                        "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                        "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                        "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                        "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                        "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                        "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                        "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                        "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                        "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                        "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                        "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                        "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                        "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                        "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                        "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff",
+                                        .ilen	= 512,
+                                        .result	= "\x27\xa7\x47\x9b\xef\xa1\xd4\x76"
+                                                "\x48\x9f\x30\x8c\xd4\xcf\xa6\xe2"
+                                                "\xa9\x6e\x4b\xbe\x32\x08\xff\x25"
+                                                "\x28\x7d\xd3\x81\x96\x16\xe8\x9c"
+                                                "\xc7\x8c\xf7\xf5\xe5\x43\x44\x5f"
+                                                "\x83\x33\xd8\xfa\x7f\x56\x00\x00"
+                                                "\x05\x27\x9f\xa5\xd8\xb5\xe4\xad"
+                                                "\x40\xe7\x36\xdd\xb4\xd3\x54\x12"
+                                                "\x32\x80\x63\xfd\x2a\xab\x53\xe5"
+                                                "\xea\x1e\x0a\x9f\x33\x25\x00\xa5"
+                                                "\xdf\x94\x87\xd0\x7a\x5c\x92\xcc"
+                                                "\x51\x2c\x88\x66\xc7\xe8\x60\xce"
+                                                "\x93\xfd\xf1\x66\xa2\x49\x12\xb4"
+                                                "\x22\x97\x61\x46\xae\x20\xce\x84"
+                                                "\x6b\xb7\xdc\x9b\xa9\x4a\x76\x7a"
+                                                "\xae\xf2\x0c\x0d\x61\xad\x02\x65"
+                                                "\x5e\xa9\x2d\xc4\xc4\xe4\x1a\x89"
+                                                "\x52\xc6\x51\xd3\x31\x74\xbe\x51"
+                                                "\xa1\x0c\x42\x11\x10\xe6\xd8\x15"
+                                                "\x88\xed\xe8\x21\x03\xa2\x52\xd8"
+                                                "\xa7\x50\xe8\x76\x8d\xef\xff\xed"
+                                                "\x91\x22\x81\x0a\xae\xb9\x9f\x91"
+                                                "\x72\xaf\x82\xb6\x04\xdc\x4b\x8e"
+                                                "\x51\xbc\xb0\x82\x35\xa6\xf4\x34"
+                                                "\x13\x32\xe4\xca\x60\x48\x2a\x4b"
+                                                "\xa1\xa0\x3b\x3e\x65\x00\x8f\xc5"
+                                                "\xda\x76\xb7\x0b\xf1\x69\x0d\xb4"
+                                                "\xea\xe2\x9c\x5f\x1b\xad\xd0\x3c"
+                                                "\x5c\xcf\x2a\x55\xd7\x05\xdd\xcd"
+                                                "\x86\xd4\x49\x51\x1c\xeb\x7e\xc3"
+                                                "\x0b\xf1\x2b\x1f\xa3\x5b\x91\x3f"
+                                                "\x9f\x74\x7a\x8a\xfd\x1b\x13\x0e"
+                                                "\x94\xbf\xf9\x4e\xff\xd0\x1a\x91"
+                                                "\x73\x5c\xa1\x72\x6a\xcd\x0b\x19"
+                                                "\x7c\x4e\x5b\x03\x39\x36\x97\xe1"
+                                                "\x26\x82\x6f\xb6\xbb\xde\x8e\xcc"
+                                                "\x1e\x08\x29\x85\x16\xe2\xc9\xed"
+                                                "\x03\xff\x3c\x1b\x78\x60\xf6\xde"
+                                                "\x76\xd4\xce\xcd\x94\xc8\x11\x98"
+                                                "\x55\xef\x52\x97\xca\x67\xe9\xf3"
+                                                "\xe7\xff\x72\xb1\xe9\x97\x85\xca"
+                                                "\x0a\x7e\x77\x20\xc5\xb3\x6d\xc6"
+                                                "\xd7\x2c\xac\x95\x74\xc8\xcb\xbc"
+                                                "\x2f\x80\x1e\x23\xe5\x6f\xd3\x44"
+                                                "\xb0\x7f\x22\x15\x4b\xeb\xa0\xf0"
+                                                "\x8c\xe8\x89\x1e\x64\x3e\xd9\x95"
+                                                "\xc9\x4d\x9a\x69\xc9\xf1\xb5\xf4"
+                                                "\x99\x02\x7a\x78\x57\x2a\xee\xbd"
+                                                "\x74\xd2\x0c\xc3\x98\x81\xc2\x13"
+                                                "\xee\x77\x0b\x10\x10\xe4\xbe\xa7"
+                                                "\x18\x84\x69\x77\xae\x11\x9f\x7a"
+                                                "\x02\x3a\xb5\x8c\xca\x0a\xd7\x52"
+                                                "\xaf\xe6\x56\xbb\x3c\x17\x25\x6a"
+                                                "\x9f\x6e\x9b\xf1\x9f\xdd\x5a\x38"
+                                                "\xfc\x82\xbb\xe8\x72\xc5\x53\x9e"
+                                                "\xdb\x60\x9e\xf4\xf7\x9c\x20\x3e"
+                                                "\xbb\x14\x0f\x2e\x58\x3c\xb2\xad"
+                                                "\x15\xb4\xaa\x5b\x65\x50\x16\xa8"
+                                                "\x44\x92\x77\xdb\xd4\x77\xef\x2c"
+                                                "\x8d\x6c\x01\x7d\xb7\x38\xb1\x8d"
+                                                "\xeb\x4a\x42\x7d\x19\x23\xce\x3f"
+                                                "\xf2\x62\x73\x57\x79\xa4\x18\xf2"
+                                                "\x0a\x28\x2d\xf9\x20\x14\x7b\xea"
+                                                "\xbe\x42\x1e\xe5\x31\x9d\x05\x68",
+                                                .rlen	= 512,
+        }, { /* IEEE 1619-2007, Vector 10 */
+                .key	= "\x27\x18\x28\x18\x28\x45\x90\x45"
+                        "\x23\x53\x60\x28\x74\x71\x35\x26"
+                        "\x62\x49\x77\x57\x24\x70\x93\x69"
+                        "\x99\x59\x57\x49\x66\x96\x76\x27"
+                        "\x31\x41\x59\x26\x53\x58\x97\x93"
+                        "\x23\x84\x62\x64\x33\x83\x27\x95"
+                        "\x02\x88\x41\x97\x16\x93\x99\x37"
+                        "\x51\x05\x82\x09\x74\x94\x45\x92",
+                        .klen	= 64,
+                        .iv	= "\xff\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                        "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                        "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                        "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                        "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                        "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                        "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                        "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                        "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                        "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                        "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                        "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                        "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                        "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                        "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                        "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                        "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                        "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                        "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                        "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                        "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                        "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                        "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                        "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                        "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                        "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                        "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                        "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff"
+                                        "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                        "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                        "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                        "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                        "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                        "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                        "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                        "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                        "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                        "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                        "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                        "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                        "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                        "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                        "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                        "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                        "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                        "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                        "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                        "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                        "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                        "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                        "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                        "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                        "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                        "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                        "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                        "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff",
+                                        .ilen	= 512,
+                                        .result	= "\x1c\x3b\x3a\x10\x2f\x77\x03\x86"
+                                                "\xe4\x83\x6c\x99\xe3\x70\xcf\x9b"
+                                                "\xea\x00\x80\x3f\x5e\x48\x23\x57"
+                                                "\xa4\xae\x12\xd4\x14\xa3\xe6\x3b"
+                                                "\x5d\x31\xe2\x76\xf8\xfe\x4a\x8d"
+                                                "\x66\xb3\x17\xf9\xac\x68\x3f\x44"
+                                                "\x68\x0a\x86\xac\x35\xad\xfc\x33"
+                                                "\x45\xbe\xfe\xcb\x4b\xb1\x88\xfd"
+                                                "\x57\x76\x92\x6c\x49\xa3\x09\x5e"
+                                                "\xb1\x08\xfd\x10\x98\xba\xec\x70"
+                                                "\xaa\xa6\x69\x99\xa7\x2a\x82\xf2"
+                                                "\x7d\x84\x8b\x21\xd4\xa7\x41\xb0"
+                                                "\xc5\xcd\x4d\x5f\xff\x9d\xac\x89"
+                                                "\xae\xba\x12\x29\x61\xd0\x3a\x75"
+                                                "\x71\x23\xe9\x87\x0f\x8a\xcf\x10"
+                                                "\x00\x02\x08\x87\x89\x14\x29\xca"
+                                                "\x2a\x3e\x7a\x7d\x7d\xf7\xb1\x03"
+                                                "\x55\x16\x5c\x8b\x9a\x6d\x0a\x7d"
+                                                "\xe8\xb0\x62\xc4\x50\x0d\xc4\xcd"
+                                                "\x12\x0c\x0f\x74\x18\xda\xe3\xd0"
+                                                "\xb5\x78\x1c\x34\x80\x3f\xa7\x54"
+                                                "\x21\xc7\x90\xdf\xe1\xde\x18\x34"
+                                                "\xf2\x80\xd7\x66\x7b\x32\x7f\x6c"
+                                                "\x8c\xd7\x55\x7e\x12\xac\x3a\x0f"
+                                                "\x93\xec\x05\xc5\x2e\x04\x93\xef"
+                                                "\x31\xa1\x2d\x3d\x92\x60\xf7\x9a"
+                                                "\x28\x9d\x6a\x37\x9b\xc7\x0c\x50"
+                                                "\x84\x14\x73\xd1\xa8\xcc\x81\xec"
+                                                "\x58\x3e\x96\x45\xe0\x7b\x8d\x96"
+                                                "\x70\x65\x5b\xa5\xbb\xcf\xec\xc6"
+                                                "\xdc\x39\x66\x38\x0a\xd8\xfe\xcb"
+                                                "\x17\xb6\xba\x02\x46\x9a\x02\x0a"
+                                                "\x84\xe1\x8e\x8f\x84\x25\x20\x70"
+                                                "\xc1\x3e\x9f\x1f\x28\x9b\xe5\x4f"
+                                                "\xbc\x48\x14\x57\x77\x8f\x61\x60"
+                                                "\x15\xe1\x32\x7a\x02\xb1\x40\xf1"
+                                                "\x50\x5e\xb3\x09\x32\x6d\x68\x37"
+                                                "\x8f\x83\x74\x59\x5c\x84\x9d\x84"
+                                                "\xf4\xc3\x33\xec\x44\x23\x88\x51"
+                                                "\x43\xcb\x47\xbd\x71\xc5\xed\xae"
+                                                "\x9b\xe6\x9a\x2f\xfe\xce\xb1\xbe"
+                                                "\xc9\xde\x24\x4f\xbe\x15\x99\x2b"
+                                                "\x11\xb7\x7c\x04\x0f\x12\xbd\x8f"
+                                                "\x6a\x97\x5a\x44\xa0\xf9\x0c\x29"
+                                                "\xa9\xab\xc3\xd4\xd8\x93\x92\x72"
+                                                "\x84\xc5\x87\x54\xcc\xe2\x94\x52"
+                                                "\x9f\x86\x14\xdc\xd2\xab\xa9\x91"
+                                                "\x92\x5f\xed\xc4\xae\x74\xff\xac"
+                                                "\x6e\x33\x3b\x93\xeb\x4a\xff\x04"
+                                                "\x79\xda\x9a\x41\x0e\x44\x50\xe0"
+                                                "\xdd\x7a\xe4\xc6\xe2\x91\x09\x00"
+                                                "\x57\x5d\xa4\x01\xfc\x07\x05\x9f"
+                                                "\x64\x5e\x8b\x7e\x9b\xfd\xef\x33"
+                                                "\x94\x30\x54\xff\x84\x01\x14\x93"
+                                                "\xc2\x7b\x34\x29\xea\xed\xb4\xed"
+                                                "\x53\x76\x44\x1a\x77\xed\x43\x85"
+                                                "\x1a\xd7\x7f\x16\xf5\x41\xdf\xd2"
+                                                "\x69\xd5\x0d\x6a\x5f\x14\xfb\x0a"
+                                                "\xab\x1c\xbb\x4c\x15\x50\xbe\x97"
+                                                "\xf7\xab\x40\x66\x19\x3c\x4c\xaa"
+                                                "\x77\x3d\xad\x38\x01\x4b\xd2\x09"
+                                                "\x2f\xa7\x55\xc8\x24\xbb\x5e\x54"
+                                                "\xc4\xf3\x6f\xfd\xa9\xfc\xea\x70"
+                                                "\xb9\xc6\xe6\x93\xe1\x48\xc1\x51",
+                                                .rlen	= 512,
+        }, { /* Identical key halves, FIPS 140-2 IG A.9 */
+                .key	= "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x11\x11\x11\x11\x11\x11\x11\x11",
+                        .klen	= 32,
+                        .fail	= 1,
+                        .iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                        "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                        .ilen	= 16,
+                                        .result	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                                .rlen	= 16,
+        }
+};
+
+static struct moto_cipher_testvec moto_aes_xts_dec_tv_template[] = {
+        { /* IEEE 1619-2007, Vector 2 */
+                .key	= "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x11\x11\x11\x11\x11\x11\x11\x11"
+                        "\x22\x22\x22\x22\x22\x22\x22\x22"
+                        "\x22\x22\x22\x22\x22\x22\x22\x22",
+                        .klen	= 32,
+                        .iv	= "\x33\x33\x33\x33\x33\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\xc4\x54\x18\x5e\x6a\x16\x93\x6e"
+                                        "\x39\x33\x40\x38\xac\xef\x83\x8b"
+                                        "\xfb\x18\x6f\xff\x74\x80\xad\xc4"
+                                        "\x28\x93\x82\xec\xd6\xd3\x94\xf0",
+                                        .ilen	= 32,
+                                        .result	= "\x44\x44\x44\x44\x44\x44\x44\x44"
+                                                "\x44\x44\x44\x44\x44\x44\x44\x44"
+                                                "\x44\x44\x44\x44\x44\x44\x44\x44"
+                                                "\x44\x44\x44\x44\x44\x44\x44\x44",
+                                                .rlen	= 32,
+        }, { /* IEEE 1619-2007, Vector 4 */
+                .key	= "\x27\x18\x28\x18\x28\x45\x90\x45"
+                        "\x23\x53\x60\x28\x74\x71\x35\x26"
+                        "\x31\x41\x59\x26\x53\x58\x97\x93"
+                        "\x23\x84\x62\x64\x33\x83\x27\x95",
+                        .klen	= 32,
+                        .iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\x27\xa7\x47\x9b\xef\xa1\xd4\x76"
+                                        "\x48\x9f\x30\x8c\xd4\xcf\xa6\xe2"
+                                        "\xa9\x6e\x4b\xbe\x32\x08\xff\x25"
+                                        "\x28\x7d\xd3\x81\x96\x16\xe8\x9c"
+                                        "\xc7\x8c\xf7\xf5\xe5\x43\x44\x5f"
+                                        "\x83\x33\xd8\xfa\x7f\x56\x00\x00"
+                                        "\x05\x27\x9f\xa5\xd8\xb5\xe4\xad"
+                                        "\x40\xe7\x36\xdd\xb4\xd3\x54\x12"
+                                        "\x32\x80\x63\xfd\x2a\xab\x53\xe5"
+                                        "\xea\x1e\x0a\x9f\x33\x25\x00\xa5"
+                                        "\xdf\x94\x87\xd0\x7a\x5c\x92\xcc"
+                                        "\x51\x2c\x88\x66\xc7\xe8\x60\xce"
+                                        "\x93\xfd\xf1\x66\xa2\x49\x12\xb4"
+                                        "\x22\x97\x61\x46\xae\x20\xce\x84"
+                                        "\x6b\xb7\xdc\x9b\xa9\x4a\x76\x7a"
+                                        "\xae\xf2\x0c\x0d\x61\xad\x02\x65"
+                                        "\x5e\xa9\x2d\xc4\xc4\xe4\x1a\x89"
+                                        "\x52\xc6\x51\xd3\x31\x74\xbe\x51"
+                                        "\xa1\x0c\x42\x11\x10\xe6\xd8\x15"
+                                        "\x88\xed\xe8\x21\x03\xa2\x52\xd8"
+                                        "\xa7\x50\xe8\x76\x8d\xef\xff\xed"
+                                        "\x91\x22\x81\x0a\xae\xb9\x9f\x91"
+                                        "\x72\xaf\x82\xb6\x04\xdc\x4b\x8e"
+                                        "\x51\xbc\xb0\x82\x35\xa6\xf4\x34"
+                                        "\x13\x32\xe4\xca\x60\x48\x2a\x4b"
+                                        "\xa1\xa0\x3b\x3e\x65\x00\x8f\xc5"
+                                        "\xda\x76\xb7\x0b\xf1\x69\x0d\xb4"
+                                        "\xea\xe2\x9c\x5f\x1b\xad\xd0\x3c"
+                                        "\x5c\xcf\x2a\x55\xd7\x05\xdd\xcd"
+                                        "\x86\xd4\x49\x51\x1c\xeb\x7e\xc3"
+                                        "\x0b\xf1\x2b\x1f\xa3\x5b\x91\x3f"
+                                        "\x9f\x74\x7a\x8a\xfd\x1b\x13\x0e"
+                                        "\x94\xbf\xf9\x4e\xff\xd0\x1a\x91"
+                                        "\x73\x5c\xa1\x72\x6a\xcd\x0b\x19"
+                                        "\x7c\x4e\x5b\x03\x39\x36\x97\xe1"
+                                        "\x26\x82\x6f\xb6\xbb\xde\x8e\xcc"
+                                        "\x1e\x08\x29\x85\x16\xe2\xc9\xed"
+                                        "\x03\xff\x3c\x1b\x78\x60\xf6\xde"
+                                        "\x76\xd4\xce\xcd\x94\xc8\x11\x98"
+                                        "\x55\xef\x52\x97\xca\x67\xe9\xf3"
+                                        "\xe7\xff\x72\xb1\xe9\x97\x85\xca"
+                                        "\x0a\x7e\x77\x20\xc5\xb3\x6d\xc6"
+                                        "\xd7\x2c\xac\x95\x74\xc8\xcb\xbc"
+                                        "\x2f\x80\x1e\x23\xe5\x6f\xd3\x44"
+                                        "\xb0\x7f\x22\x15\x4b\xeb\xa0\xf0"
+                                        "\x8c\xe8\x89\x1e\x64\x3e\xd9\x95"
+                                        "\xc9\x4d\x9a\x69\xc9\xf1\xb5\xf4"
+                                        "\x99\x02\x7a\x78\x57\x2a\xee\xbd"
+                                        "\x74\xd2\x0c\xc3\x98\x81\xc2\x13"
+                                        "\xee\x77\x0b\x10\x10\xe4\xbe\xa7"
+                                        "\x18\x84\x69\x77\xae\x11\x9f\x7a"
+                                        "\x02\x3a\xb5\x8c\xca\x0a\xd7\x52"
+                                        "\xaf\xe6\x56\xbb\x3c\x17\x25\x6a"
+                                        "\x9f\x6e\x9b\xf1\x9f\xdd\x5a\x38"
+                                        "\xfc\x82\xbb\xe8\x72\xc5\x53\x9e"
+                                        "\xdb\x60\x9e\xf4\xf7\x9c\x20\x3e"
+                                        "\xbb\x14\x0f\x2e\x58\x3c\xb2\xad"
+                                        "\x15\xb4\xaa\x5b\x65\x50\x16\xa8"
+                                        "\x44\x92\x77\xdb\xd4\x77\xef\x2c"
+                                        "\x8d\x6c\x01\x7d\xb7\x38\xb1\x8d"
+                                        "\xeb\x4a\x42\x7d\x19\x23\xce\x3f"
+                                        "\xf2\x62\x73\x57\x79\xa4\x18\xf2"
+                                        "\x0a\x28\x2d\xf9\x20\x14\x7b\xea"
+                                        "\xbe\x42\x1e\xe5\x31\x9d\x05\x68",
+                                        .ilen	= 512,
+                                        .result	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                                "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                                "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                                "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                                "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                                "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                                "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                                "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                                "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                                "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                                "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                                "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                                "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                                "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                                "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                                "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                                "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                                "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                                "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                                "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                                "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                                "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                                "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                                "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                                "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                                "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                                "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                                "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                                "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                                "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff"
+                                                "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                                "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                                "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                                "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                                "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                                "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                                "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                                "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                                "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                                "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                                "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                                "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                                "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                                "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                                "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                                "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                                "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                                "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                                "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                                "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                                "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                                "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                                "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                                "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                                "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                                "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                                "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                                "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                                "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                                "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff",
+                                                .rlen	= 512,
+        }, { /* IEEE 1619-2007, Vector 10 */
+                .key	= "\x27\x18\x28\x18\x28\x45\x90\x45"
+                        "\x23\x53\x60\x28\x74\x71\x35\x26"
+                        "\x62\x49\x77\x57\x24\x70\x93\x69"
+                        "\x99\x59\x57\x49\x66\x96\x76\x27"
+                        "\x31\x41\x59\x26\x53\x58\x97\x93"
+                        "\x23\x84\x62\x64\x33\x83\x27\x95"
+                        "\x02\x88\x41\x97\x16\x93\x99\x37"
+                        "\x51\x05\x82\x09\x74\x94\x45\x92",
+                        .klen	= 64,
+                        .iv	= "\xff\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                .input	= "\x1c\x3b\x3a\x10\x2f\x77\x03\x86"
+                                        "\xe4\x83\x6c\x99\xe3\x70\xcf\x9b"
+                                        "\xea\x00\x80\x3f\x5e\x48\x23\x57"
+                                        "\xa4\xae\x12\xd4\x14\xa3\xe6\x3b"
+                                        "\x5d\x31\xe2\x76\xf8\xfe\x4a\x8d"
+                                        "\x66\xb3\x17\xf9\xac\x68\x3f\x44"
+                                        "\x68\x0a\x86\xac\x35\xad\xfc\x33"
+                                        "\x45\xbe\xfe\xcb\x4b\xb1\x88\xfd"
+                                        "\x57\x76\x92\x6c\x49\xa3\x09\x5e"
+                                        "\xb1\x08\xfd\x10\x98\xba\xec\x70"
+                                        "\xaa\xa6\x69\x99\xa7\x2a\x82\xf2"
+                                        "\x7d\x84\x8b\x21\xd4\xa7\x41\xb0"
+                                        "\xc5\xcd\x4d\x5f\xff\x9d\xac\x89"
+                                        "\xae\xba\x12\x29\x61\xd0\x3a\x75"
+                                        "\x71\x23\xe9\x87\x0f\x8a\xcf\x10"
+                                        "\x00\x02\x08\x87\x89\x14\x29\xca"
+                                        "\x2a\x3e\x7a\x7d\x7d\xf7\xb1\x03"
+                                        "\x55\x16\x5c\x8b\x9a\x6d\x0a\x7d"
+                                        "\xe8\xb0\x62\xc4\x50\x0d\xc4\xcd"
+                                        "\x12\x0c\x0f\x74\x18\xda\xe3\xd0"
+                                        "\xb5\x78\x1c\x34\x80\x3f\xa7\x54"
+                                        "\x21\xc7\x90\xdf\xe1\xde\x18\x34"
+                                        "\xf2\x80\xd7\x66\x7b\x32\x7f\x6c"
+                                        "\x8c\xd7\x55\x7e\x12\xac\x3a\x0f"
+                                        "\x93\xec\x05\xc5\x2e\x04\x93\xef"
+                                        "\x31\xa1\x2d\x3d\x92\x60\xf7\x9a"
+                                        "\x28\x9d\x6a\x37\x9b\xc7\x0c\x50"
+                                        "\x84\x14\x73\xd1\xa8\xcc\x81\xec"
+                                        "\x58\x3e\x96\x45\xe0\x7b\x8d\x96"
+                                        "\x70\x65\x5b\xa5\xbb\xcf\xec\xc6"
+                                        "\xdc\x39\x66\x38\x0a\xd8\xfe\xcb"
+                                        "\x17\xb6\xba\x02\x46\x9a\x02\x0a"
+                                        "\x84\xe1\x8e\x8f\x84\x25\x20\x70"
+                                        "\xc1\x3e\x9f\x1f\x28\x9b\xe5\x4f"
+                                        "\xbc\x48\x14\x57\x77\x8f\x61\x60"
+                                        "\x15\xe1\x32\x7a\x02\xb1\x40\xf1"
+                                        "\x50\x5e\xb3\x09\x32\x6d\x68\x37"
+                                        "\x8f\x83\x74\x59\x5c\x84\x9d\x84"
+                                        "\xf4\xc3\x33\xec\x44\x23\x88\x51"
+                                        "\x43\xcb\x47\xbd\x71\xc5\xed\xae"
+                                        "\x9b\xe6\x9a\x2f\xfe\xce\xb1\xbe"
+                                        "\xc9\xde\x24\x4f\xbe\x15\x99\x2b"
+                                        "\x11\xb7\x7c\x04\x0f\x12\xbd\x8f"
+                                        "\x6a\x97\x5a\x44\xa0\xf9\x0c\x29"
+                                        "\xa9\xab\xc3\xd4\xd8\x93\x92\x72"
+                                        "\x84\xc5\x87\x54\xcc\xe2\x94\x52"
+                                        "\x9f\x86\x14\xdc\xd2\xab\xa9\x91"
+                                        "\x92\x5f\xed\xc4\xae\x74\xff\xac"
+                                        "\x6e\x33\x3b\x93\xeb\x4a\xff\x04"
+                                        "\x79\xda\x9a\x41\x0e\x44\x50\xe0"
+                                        "\xdd\x7a\xe4\xc6\xe2\x91\x09\x00"
+                                        "\x57\x5d\xa4\x01\xfc\x07\x05\x9f"
+                                        "\x64\x5e\x8b\x7e\x9b\xfd\xef\x33"
+                                        "\x94\x30\x54\xff\x84\x01\x14\x93"
+                                        "\xc2\x7b\x34\x29\xea\xed\xb4\xed"
+                                        "\x53\x76\x44\x1a\x77\xed\x43\x85"
+                                        "\x1a\xd7\x7f\x16\xf5\x41\xdf\xd2"
+                                        "\x69\xd5\x0d\x6a\x5f\x14\xfb\x0a"
+                                        "\xab\x1c\xbb\x4c\x15\x50\xbe\x97"
+                                        "\xf7\xab\x40\x66\x19\x3c\x4c\xaa"
+                                        "\x77\x3d\xad\x38\x01\x4b\xd2\x09"
+                                        "\x2f\xa7\x55\xc8\x24\xbb\x5e\x54"
+                                        "\xc4\xf3\x6f\xfd\xa9\xfc\xea\x70"
+                                        "\xb9\xc6\xe6\x93\xe1\x48\xc1\x51",
+                                        .ilen	= 512,
+                                        .result	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                                "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                                "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                                "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                                "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                                "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                                "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                                "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                                "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                                "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                                "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                                "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                                "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                                "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                                "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                                "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                                "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                                "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                                "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                                "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                                "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                                "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                                "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                                "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                                "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                                "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                                "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                                "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                                "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                                "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff"
+                                                "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                                "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f"
+                                                "\x20\x21\x22\x23\x24\x25\x26\x27"
+                                                "\x28\x29\x2a\x2b\x2c\x2d\x2e\x2f"
+                                                "\x30\x31\x32\x33\x34\x35\x36\x37"
+                                                "\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f"
+                                                "\x40\x41\x42\x43\x44\x45\x46\x47"
+                                                "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                                                "\x50\x51\x52\x53\x54\x55\x56\x57"
+                                                "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                                                "\x60\x61\x62\x63\x64\x65\x66\x67"
+                                                "\x68\x69\x6a\x6b\x6c\x6d\x6e\x6f"
+                                                "\x70\x71\x72\x73\x74\x75\x76\x77"
+                                                "\x78\x79\x7a\x7b\x7c\x7d\x7e\x7f"
+                                                "\x80\x81\x82\x83\x84\x85\x86\x87"
+                                                "\x88\x89\x8a\x8b\x8c\x8d\x8e\x8f"
+                                                "\x90\x91\x92\x93\x94\x95\x96\x97"
+                                                "\x98\x99\x9a\x9b\x9c\x9d\x9e\x9f"
+                                                "\xa0\xa1\xa2\xa3\xa4\xa5\xa6\xa7"
+                                                "\xa8\xa9\xaa\xab\xac\xad\xae\xaf"
+                                                "\xb0\xb1\xb2\xb3\xb4\xb5\xb6\xb7"
+                                                "\xb8\xb9\xba\xbb\xbc\xbd\xbe\xbf"
+                                                "\xc0\xc1\xc2\xc3\xc4\xc5\xc6\xc7"
+                                                "\xc8\xc9\xca\xcb\xcc\xcd\xce\xcf"
+                                                "\xd0\xd1\xd2\xd3\xd4\xd5\xd6\xd7"
+                                                "\xd8\xd9\xda\xdb\xdc\xdd\xde\xdf"
+                                                "\xe0\xe1\xe2\xe3\xe4\xe5\xe6\xe7"
+                                                "\xe8\xe9\xea\xeb\xec\xed\xee\xef"
+                                                "\xf0\xf1\xf2\xf3\xf4\xf5\xf6\xf7"
+                                                "\xf8\xf9\xfa\xfb\xfc\xfd\xfe\xff",
+                                                .rlen	= 512,
+        }
+};
+
+/*
+ * AES-GCM test vectors, Test Cases from "The Galois/Counter Mode of
+ * Operation (GCM)" by McGrew and Viega, the last decryption vector has a
+ * corrupted tag and must fail to verify.
+ */
+#define AES_GCM_ENC_TEST_VECTORS 6
+#define AES_GCM_DEC_TEST_VECTORS 6
+
+static struct moto_aead_testvec moto_aes_gcm_enc_tv_template[] = {
+        { /* Test Case 1 */
+                .key	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                        "\x00\x00\x00\x00\x00\x00\x00\x00",
+                        .klen	= 16,
+                        .iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00",
+                                .input	= "",
+                                        .ilen	= 0,
+                                        .result	= "\x58\xe2\xfc\xce\xfa\x7e\x30\x61"
+                                                "\x36\x7f\x1d\x57\xa4\xe7\x45\x5a",
+                                                .rlen	= 16,
+        }, { /* Test Case 2 */
+                .key	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                        "\x00\x00\x00\x00\x00\x00\x00\x00",
+                        .klen	= 16,
+                        .iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00",
+                                .input	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                        "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                        .ilen	= 16,
+                                        .result	= "\x03\x88\xda\xce\x60\xb6\xa3\x92"
+                                                "\xf3\x28\xc2\xb9\x71\xb2\xfe\x78"
+                                                "\xab\x6e\x47\xd4\x2c\xec\x13\xbd"
+                                                "\xf5\x3a\x67\xb2\x12\x57\xbd\xdf",
+                                                .rlen	= 32,
+        }, { /* Test Case 4 */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 16,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                        "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                        "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                        "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                        "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                        "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                        "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                        "\xba\x63\x7b\x39",
+                                        .ilen	= 60,
+                                        .result	= "\x42\x83\x1e\xc2\x21\x77\x74\x24"
+                                                "\x4b\x72\x21\xb7\x84\xd0\xd4\x9c"
+                                                "\xe3\xaa\x21\x2f\x2c\x02\xa4\xe0"
+                                                "\x35\xc1\x7e\x23\x29\xac\xa1\x2e"
+                                                "\x21\xd5\x14\xb2\x54\x66\x93\x1c"
+                                                "\x7d\x8f\x6a\x5a\xac\x84\xaa\x05"
+                                                "\x1b\xa3\x0b\x39\x6a\x0a\xac\x97"
+                                                "\x3d\x58\xe0\x91\x5b\xc9\x4f\xbc"
+                                                "\x32\x21\xa5\xdb\x94\xfa\xe9\x5a"
+                                                "\xe7\x12\x1a\x47",
+                                                .rlen	= 76,
+        }, { /* Test Case 4, split into chunks */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 16,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                        "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                        "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                        "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                        "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                        "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                        "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                        "\xba\x63\x7b\x39",
+                                        .ilen	= 60,
+                                        .result	= "\x42\x83\x1e\xc2\x21\x77\x74\x24"
+                                                "\x4b\x72\x21\xb7\x84\xd0\xd4\x9c"
+                                                "\xe3\xaa\x21\x2f\x2c\x02\xa4\xe0"
+                                                "\x35\xc1\x7e\x23\x29\xac\xa1\x2e"
+                                                "\x21\xd5\x14\xb2\x54\x66\x93\x1c"
+                                                "\x7d\x8f\x6a\x5a\xac\x84\xaa\x05"
+                                                "\x1b\xa3\x0b\x39\x6a\x0a\xac\x97"
+                                                "\x3d\x58\xe0\x91\x5b\xc9\x4f\xbc"
+                                                "\x32\x21\xa5\xdb\x94\xfa\xe9\x5a"
+                                                "\xe7\x12\x1a\x47",
+                                                .rlen	= 76,
+                                                .np	= 2,
+                                                .tap	= { 32, 28 },
+                                                .anp	= 2,
+                                                .atap	= { 8, 12 },
+        }, { /* Test Case 10 */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08"
+                        "\xfe\xff\xe9\x92\x86\x65\x73\x1c",
+                        .klen	= 24,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                        "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                        "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                        "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                        "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                        "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                        "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                        "\xba\x63\x7b\x39",
+                                        .ilen	= 60,
+                                        .result	= "\x39\x80\xca\x0b\x3c\x00\xe8\x41"
+                                                "\xeb\x06\xfa\xc4\x87\x2a\x27\x57"
+                                                "\x85\x9e\x1c\xea\xa6\xef\xd9\x84"
+                                                "\x62\x85\x93\xb4\x0c\xa1\xe1\x9c"
+                                                "\x7d\x77\x3d\x00\xc1\x44\xc5\x25"
+                                                "\xac\x61\x9d\x18\xc8\x4a\x3f\x47"
+                                                "\x18\xe2\x44\x8b\x2f\xe3\x24\xd9"
+                                                "\xcc\xda\x27\x10\x25\x19\x49\x8e"
+                                                "\x80\xf1\x47\x8f\x37\xba\x55\xbd"
+                                                "\x6d\x27\x61\x8c",
+                                                .rlen	= 76,
+        }, { /* Test Case 16 */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08"
+                        "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 32,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                        "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                        "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                        "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                        "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                        "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                        "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                        "\xba\x63\x7b\x39",
+                                        .ilen	= 60,
+                                        .result	= "\x52\x2d\xc1\xf0\x99\x56\x7d\x07"
+                                                "\xf4\x7f\x37\xa3\x2a\x84\x42\x7d"
+                                                "\x64\x3a\x8c\xdc\xbf\xe5\xc0\xc9"
+                                                "\x75\x98\xa2\xbd\x25\x55\xd1\xaa"
+                                                "\x8c\xb0\x8e\x48\x59\x0d\xbb\x3d"
+                                                "\xa7\xb0\x8b\x10\x56\x82\x88\x38"
+                                                "\xc5\xf6\x1e\x63\x93\xba\x7a\x0a"
+                                                "\xbc\xc9\xf6\x62\x76\xfc\x6e\xce"
+                                                "\x0f\x4e\x17\x68\xcd\xdf\x88\x53"
+                                                "\xbb\x2d\x55\x1b",
+                                                .rlen	= 76,
+        }
+};
+
+static struct moto_aead_testvec moto_aes_gcm_dec_tv_template[] = {
+        { /* Test Case 2 */
+                .key	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                        "\x00\x00\x00\x00\x00\x00\x00\x00",
+                        .klen	= 16,
+                        .iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                "\x00\x00\x00\x00",
+                                .input	= "\x03\x88\xda\xce\x60\xb6\xa3\x92"
+                                        "\xf3\x28\xc2\xb9\x71\xb2\xfe\x78"
+                                        "\xab\x6e\x47\xd4\x2c\xec\x13\xbd"
+                                        "\xf5\x3a\x67\xb2\x12\x57\xbd\xdf",
+                                        .ilen	= 32,
+                                        .result	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+                                                "\x00\x00\x00\x00\x00\x00\x00\x00",
+                                                .rlen	= 16,
+        }, { /* Test Case 4 */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 16,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\x42\x83\x1e\xc2\x21\x77\x74\x24"
+                                        "\x4b\x72\x21\xb7\x84\xd0\xd4\x9c"
+                                        "\xe3\xaa\x21\x2f\x2c\x02\xa4\xe0"
+                                        "\x35\xc1\x7e\x23\x29\xac\xa1\x2e"
+                                        "\x21\xd5\x14\xb2\x54\x66\x93\x1c"
+                                        "\x7d\x8f\x6a\x5a\xac\x84\xaa\x05"
+                                        "\x1b\xa3\x0b\x39\x6a\x0a\xac\x97"
+                                        "\x3d\x58\xe0\x91\x5b\xc9\x4f\xbc"
+                                        "\x32\x21\xa5\xdb\x94\xfa\xe9\x5a"
+                                        "\xe7\x12\x1a\x47",
+                                        .ilen	= 76,
+                                        .result	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                                "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                                "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                                "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                                "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                                "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                                "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                                "\xba\x63\x7b\x39",
+                                                .rlen	= 60,
+        }, { /* Test Case 4, split into chunks */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 16,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\x42\x83\x1e\xc2\x21\x77\x74\x24"
+                                        "\x4b\x72\x21\xb7\x84\xd0\xd4\x9c"
+                                        "\xe3\xaa\x21\x2f\x2c\x02\xa4\xe0"
+                                        "\x35\xc1\x7e\x23\x29\xac\xa1\x2e"
+                                        "\x21\xd5\x14\xb2\x54\x66\x93\x1c"
+                                        "\x7d\x8f\x6a\x5a\xac\x84\xaa\x05"
+                                        "\x1b\xa3\x0b\x39\x6a\x0a\xac\x97"
+                                        "\x3d\x58\xe0\x91\x5b\xc9\x4f\xbc"
+                                        "\x32\x21\xa5\xdb\x94\xfa\xe9\x5a"
+                                        "\xe7\x12\x1a\x47",
+                                        .ilen	= 76,
+                                        .result	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                                "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                                "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                                "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                                "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                                "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                                "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                                "\xba\x63\x7b\x39",
+                                                .rlen	= 60,
+                                                .np	= 2,
+                                                .tap	= { 32, 44 },
+                                                .anp	= 2,
+                                                .atap	= { 8, 12 },
+        }, { /* Test Case 10 */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08"
+                        "\xfe\xff\xe9\x92\x86\x65\x73\x1c",
+                        .klen	= 24,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\x39\x80\xca\x0b\x3c\x00\xe8\x41"
+                                        "\xeb\x06\xfa\xc4\x87\x2a\x27\x57"
+                                        "\x85\x9e\x1c\xea\xa6\xef\xd9\x84"
+                                        "\x62\x85\x93\xb4\x0c\xa1\xe1\x9c"
+                                        "\x7d\x77\x3d\x00\xc1\x44\xc5\x25"
+                                        "\xac\x61\x9d\x18\xc8\x4a\x3f\x47"
+                                        "\x18\xe2\x44\x8b\x2f\xe3\x24\xd9"
+                                        "\xcc\xda\x27\x10\x25\x19\x49\x8e"
+                                        "\x80\xf1\x47\x8f\x37\xba\x55\xbd"
+                                        "\x6d\x27\x61\x8c",
+                                        .ilen	= 76,
+                                        .result	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                                "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                                "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                                "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                                "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                                "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                                "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                                "\xba\x63\x7b\x39",
+                                                .rlen	= 60,
+        }, { /* Test Case 16 */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08"
+                        "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 32,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\x52\x2d\xc1\xf0\x99\x56\x7d\x07"
+                                        "\xf4\x7f\x37\xa3\x2a\x84\x42\x7d"
+                                        "\x64\x3a\x8c\xdc\xbf\xe5\xc0\xc9"
+                                        "\x75\x98\xa2\xbd\x25\x55\xd1\xaa"
+                                        "\x8c\xb0\x8e\x48\x59\x0d\xbb\x3d"
+                                        "\xa7\xb0\x8b\x10\x56\x82\x88\x38"
+                                        "\xc5\xf6\x1e\x63\x93\xba\x7a\x0a"
+                                        "\xbc\xc9\xf6\x62\x76\xfc\x6e\xce"
+                                        "\x0f\x4e\x17\x68\xcd\xdf\x88\x53"
+                                        "\xbb\x2d\x55\x1b",
+                                        .ilen	= 76,
+                                        .result	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                                "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                                "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                                "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                                "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                                "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                                "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                                "\xba\x63\x7b\x39",
+                                                .rlen	= 60,
+        }, { /* Test Case 4, tag with one bit flipped */
+                .key	= "\xfe\xff\xe9\x92\x86\x65\x73\x1c"
+                        "\x6d\x6a\x8f\x94\x67\x30\x83\x08",
+                        .klen	= 16,
+                        .iv	= "\xca\xfe\xba\xbe\xfa\xce\xdb\xad"
+                                "\xde\xca\xf8\x88",
+                        .assoc	= "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xfe\xed\xfa\xce\xde\xad\xbe\xef"
+                                "\xab\xad\xda\xd2",
+                                .alen	= 20,
+                                .input	= "\x42\x83\x1e\xc2\x21\x77\x74\x24"
+                                        "\x4b\x72\x21\xb7\x84\xd0\xd4\x9c"
+                                        "\xe3\xaa\x21\x2f\x2c\x02\xa4\xe0"
+                                        "\x35\xc1\x7e\x23\x29\xac\xa1\x2e"
+                                        "\x21\xd5\x14\xb2\x54\x66\x93\x1c"
+                                        "\x7d\x8f\x6a\x5a\xac\x84\xaa\x05"
+                                        "\x1b\xa3\x0b\x39\x6a\x0a\xac\x97"
+                                        "\x3d\x58\xe0\x91\x5b\xc9\x4f\xbc"
+                                        "\x32\x21\xa5\xdb\x94\xfa\xe9\x5a"
+                                        "\xe7\x12\x1a\x46",
+                                        .ilen	= 76,
+                                        .result	= "\xd9\x31\x32\x25\xf8\x84\x06\xe5"
+                                                "\xa5\x59\x09\xc5\xaf\xf5\x26\x9a"
+                                                "\x86\xa7\xa9\x53\x15\x34\xf7\xda"
+                                                "\x2e\x4c\x30\x3d\x8a\x31\x8a\x72"
+                                                "\x1c\x3c\x0c\x95\x95\x68\x09\x53"
+                                                "\x2f\xcf\x0e\x24\x49\xa6\xb5\x25"
+                                                "\xb1\x6a\xed\xf5\xaa\x0d\xe6\x57"
+                                                "\xba\x63\x7b\x39",
+                                                .rlen	= 60,
+                                                .novrfy	= 1,
+                                                .np	= 2,
+                                                .tap	= { 32, 44 },
+                                                .anp	= 2,
+                                                .atap	= { 8, 12 },
+        }
+};
+
+/*
+ * authenc(hmac(sha256),cbc(aes)) test vectors. The AES-128 cipher key, IV
+ * and plaintext are RFC 3602 Case #2; expected results were computed with
+ * an independent AES-CBC and HMAC-SHA256 implementation over
+ * assoc || iv || ciphertext, with the tag truncated to the vector's
+ * authsize. The key blob is the rtattr encoded key of crypto/authenc.c.
+ */
+#define AUTHENC_HMAC_SHA256_AES_CBC_ENC_TEST_VECTORS 3
+#define AUTHENC_HMAC_SHA256_AES_CBC_DEC_TEST_VECTORS 4
+
+static struct moto_aead_testvec moto_authenc_hmac_sha256_aes_cbc_enc_tv_template[] = {
+        { /* AES-128, HMAC-SHA256-128 */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x10"
+                        "\x11\x12\x13\x14\x15\x16\x17\x18"
+                        "\x19\x1a\x1b\x1c\x1d\x1e\x1f\x20"
+                        "\x21\x22\x23\x24\x25\x26\x27\x28"
+                        "\x29\x2a\x2b\x2c\x2d\x2e\x2f\x30"
+                        "\xc2\x86\x69\x6d\x88\x7c\x9a\xa0"
+                        "\x61\x1b\xbb\x3e\x20\x25\xa4\x5a",
+                        .klen	= 56,
+                        .iv	= "\x56\x2e\x17\x99\x6d\x09\x3d\x28"
+                                "\xdd\xb3\xba\x69\x5a\x2e\x6f\x58",
+                        .assoc	= "\x00\x00\x43\x55\x00\x00\x00\x01",
+                                .alen	= 8,
+                                .input	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                        "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                        "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                        "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f",
+                                        .ilen	= 32,
+                                        .result	= "\xd2\x96\xcd\x94\xc2\xcc\xcf\x8a"
+                                                "\x3a\x86\x30\x28\xb5\xe1\xdc\x0a"
+                                                "\x75\x86\x60\x2d\x25\x3c\xff\xf9"
+                                                "\x1b\x82\x66\xbe\xa6\xd6\x1a\xb1"
+                                                "\x3d\x35\x9a\xf5\x3d\x02\x00\x9b"
+                                                "\x58\xa8\x3b\x46\xf4\x12\x09\x13",
+                                                .rlen	= 48,
+        }, { /* AES-256, HMAC-SHA256-256 */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x20"
+                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                        "\x60\x3d\xeb\x10\x15\xca\x71\xbe"
+                        "\x2b\x73\xae\xf0\x85\x7d\x77\x81"
+                        "\x1f\x35\x2c\x07\x3b\x61\x08\xd7"
+                        "\x2d\x98\x10\xa3\x09\x14\xdf\xf4",
+                        .klen	= 72,
+                        .iv	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+                        .assoc	= "\x43\x21\x00\x00\x00\x00\x00\x02",
+                                .alen	= 8,
+                                .input	= "\x03\x0a\x11\x18\x1f\x26\x2d\x34"
+                                        "\x3b\x42\x49\x50\x57\x5e\x65\x6c"
+                                        "\x73\x7a\x81\x88\x8f\x96\x9d\xa4"
+                                        "\xab\xb2\xb9\xc0\xc7\xce\xd5\xdc"
+                                        "\xe3\xea\xf1\xf8\xff\x06\x0d\x14"
+                                        "\x1b\x22\x29\x30\x37\x3e\x45\x4c"
+                                        "\x53\x5a\x61\x68\x6f\x76\x7d\x84"
+                                        "\x8b\x92\x99\xa0\xa7\xae\xb5\xbc"
+                                        "\xc3\xca\xd1\xd8\xdf\xe6\xed\xf4"
+                                        "\xfb\x02\x09\x10\x17\x1e\x25\x2c",
+                                        .ilen	= 80,
+                                        .result	= "\x6b\x0c\xc2\xfa\x3f\x07\xc1\x00"
+                                                "\x59\x7c\x41\x2b\x40\xbe\xbb\x35"
+                                                "\x3f\x19\xf3\xcb\xbe\x9a\x00\x46"
+                                                "\x85\x97\xd4\xdb\x1e\xb7\x22\x9b"
+                                                "\xba\x92\x9d\x9e\x64\xbb\xc8\xcf"
+                                                "\xe6\x19\x5a\xb8\xd1\x61\xdb\x70"
+                                                "\x16\x86\x8d\xf3\x20\xf1\x24\xb0"
+                                                "\x22\x51\x7b\x17\x61\xd2\x1e\x4c"
+                                                "\xc0\x17\xb5\x42\xba\x00\x0e\x0d"
+                                                "\xf6\x51\x3a\x4b\x57\x6b\x5b\x66"
+                                                "\xa1\x71\xd6\x7f\x29\xbd\x16\x9e"
+                                                "\x88\xa8\x0c\x62\x36\xd2\x4c\xe2"
+                                                "\xf2\xe9\xca\xbc\x31\xcc\x22\xda"
+                                                "\xde\x0f\x3a\xf5\x69\x40\x86\x2a",
+                                                .rlen	= 112,
+        }, { /* AES-256, HMAC-SHA256-256, split into chunks */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x20"
+                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                        "\x60\x3d\xeb\x10\x15\xca\x71\xbe"
+                        "\x2b\x73\xae\xf0\x85\x7d\x77\x81"
+                        "\x1f\x35\x2c\x07\x3b\x61\x08\xd7"
+                        "\x2d\x98\x10\xa3\x09\x14\xdf\xf4",
+                        .klen	= 72,
+                        .iv	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+                        .assoc	= "\x43\x21\x00\x00\x00\x00\x00\x02",
+                                .alen	= 8,
+                                .input	= "\x03\x0a\x11\x18\x1f\x26\x2d\x34"
+                                        "\x3b\x42\x49\x50\x57\x5e\x65\x6c"
+                                        "\x73\x7a\x81\x88\x8f\x96\x9d\xa4"
+                                        "\xab\xb2\xb9\xc0\xc7\xce\xd5\xdc"
+                                        "\xe3\xea\xf1\xf8\xff\x06\x0d\x14"
+                                        "\x1b\x22\x29\x30\x37\x3e\x45\x4c"
+                                        "\x53\x5a\x61\x68\x6f\x76\x7d\x84"
+                                        "\x8b\x92\x99\xa0\xa7\xae\xb5\xbc"
+                                        "\xc3\xca\xd1\xd8\xdf\xe6\xed\xf4"
+                                        "\xfb\x02\x09\x10\x17\x1e\x25\x2c",
+                                        .ilen	= 80,
+                                        .result	= "\x6b\x0c\xc2\xfa\x3f\x07\xc1\x00"
+                                                "\x59\x7c\x41\x2b\x40\xbe\xbb\x35"
+                                                "\x3f\x19\xf3\xcb\xbe\x9a\x00\x46"
+                                                "\x85\x97\xd4\xdb\x1e\xb7\x22\x9b"
+                                                "\xba\x92\x9d\x9e\x64\xbb\xc8\xcf"
+                                                "\xe6\x19\x5a\xb8\xd1\x61\xdb\x70"
+                                                "\x16\x86\x8d\xf3\x20\xf1\x24\xb0"
+                                                "\x22\x51\x7b\x17\x61\xd2\x1e\x4c"
+                                                "\xc0\x17\xb5\x42\xba\x00\x0e\x0d"
+                                                "\xf6\x51\x3a\x4b\x57\x6b\x5b\x66"
+                                                "\xa1\x71\xd6\x7f\x29\xbd\x16\x9e"
+                                                "\x88\xa8\x0c\x62\x36\xd2\x4c\xe2"
+                                                "\xf2\xe9\xca\xbc\x31\xcc\x22\xda"
+                                                "\xde\x0f\x3a\xf5\x69\x40\x86\x2a",
+                                                .rlen	= 112,
+                                                .np	= 2,
+                                                .tap	= { 37, 43 },
+                                                .anp	= 2,
+                                                .atap	= { 3, 5 },
+        }
+};
+
+static struct moto_aead_testvec moto_authenc_hmac_sha256_aes_cbc_dec_tv_template[] = {
+        { /* AES-128, HMAC-SHA256-128 */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x10"
+                        "\x11\x12\x13\x14\x15\x16\x17\x18"
+                        "\x19\x1a\x1b\x1c\x1d\x1e\x1f\x20"
+                        "\x21\x22\x23\x24\x25\x26\x27\x28"
+                        "\x29\x2a\x2b\x2c\x2d\x2e\x2f\x30"
+                        "\xc2\x86\x69\x6d\x88\x7c\x9a\xa0"
+                        "\x61\x1b\xbb\x3e\x20\x25\xa4\x5a",
+                        .klen	= 56,
+                        .iv	= "\x56\x2e\x17\x99\x6d\x09\x3d\x28"
+                                "\xdd\xb3\xba\x69\x5a\x2e\x6f\x58",
+                        .assoc	= "\x00\x00\x43\x55\x00\x00\x00\x01",
+                                .alen	= 8,
+                                .input	= "\xd2\x96\xcd\x94\xc2\xcc\xcf\x8a"
+                                        "\x3a\x86\x30\x28\xb5\xe1\xdc\x0a"
+                                        "\x75\x86\x60\x2d\x25\x3c\xff\xf9"
+                                        "\x1b\x82\x66\xbe\xa6\xd6\x1a\xb1"
+                                        "\x3d\x35\x9a\xf5\x3d\x02\x00\x9b"
+                                        "\x58\xa8\x3b\x46\xf4\x12\x09\x13",
+                                        .ilen	= 48,
+                                        .result	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                                "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f",
+                                                .rlen	= 32,
+        }, { /* AES-256, HMAC-SHA256-256 */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x20"
+                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                        "\x60\x3d\xeb\x10\x15\xca\x71\xbe"
+                        "\x2b\x73\xae\xf0\x85\x7d\x77\x81"
+                        "\x1f\x35\x2c\x07\x3b\x61\x08\xd7"
+                        "\x2d\x98\x10\xa3\x09\x14\xdf\xf4",
+                        .klen	= 72,
+                        .iv	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+                        .assoc	= "\x43\x21\x00\x00\x00\x00\x00\x02",
+                                .alen	= 8,
+                                .input	= "\x6b\x0c\xc2\xfa\x3f\x07\xc1\x00"
+                                        "\x59\x7c\x41\x2b\x40\xbe\xbb\x35"
+                                        "\x3f\x19\xf3\xcb\xbe\x9a\x00\x46"
+                                        "\x85\x97\xd4\xdb\x1e\xb7\x22\x9b"
+                                        "\xba\x92\x9d\x9e\x64\xbb\xc8\xcf"
+                                        "\xe6\x19\x5a\xb8\xd1\x61\xdb\x70"
+                                        "\x16\x86\x8d\xf3\x20\xf1\x24\xb0"
+                                        "\x22\x51\x7b\x17\x61\xd2\x1e\x4c"
+                                        "\xc0\x17\xb5\x42\xba\x00\x0e\x0d"
+                                        "\xf6\x51\x3a\x4b\x57\x6b\x5b\x66"
+                                        "\xa1\x71\xd6\x7f\x29\xbd\x16\x9e"
+                                        "\x88\xa8\x0c\x62\x36\xd2\x4c\xe2"
+                                        "\xf2\xe9\xca\xbc\x31\xcc\x22\xda"
+                                        "\xde\x0f\x3a\xf5\x69\x40\x86\x2a",
+                                        .ilen	= 112,
+                                        .result	= "\x03\x0a\x11\x18\x1f\x26\x2d\x34"
+                                                "\x3b\x42\x49\x50\x57\x5e\x65\x6c"
+                                                "\x73\x7a\x81\x88\x8f\x96\x9d\xa4"
+                                                "\xab\xb2\xb9\xc0\xc7\xce\xd5\xdc"
+                                                "\xe3\xea\xf1\xf8\xff\x06\x0d\x14"
+                                                "\x1b\x22\x29\x30\x37\x3e\x45\x4c"
+                                                "\x53\x5a\x61\x68\x6f\x76\x7d\x84"
+                                                "\x8b\x92\x99\xa0\xa7\xae\xb5\xbc"
+                                                "\xc3\xca\xd1\xd8\xdf\xe6\xed\xf4"
+                                                "\xfb\x02\x09\x10\x17\x1e\x25\x2c",
+                                                .rlen	= 80,
+        }, { /* AES-256, HMAC-SHA256-256, split into chunks */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x20"
+                        "\x40\x41\x42\x43\x44\x45\x46\x47"
+                        "\x48\x49\x4a\x4b\x4c\x4d\x4e\x4f"
+                        "\x50\x51\x52\x53\x54\x55\x56\x57"
+                        "\x58\x59\x5a\x5b\x5c\x5d\x5e\x5f"
+                        "\x60\x3d\xeb\x10\x15\xca\x71\xbe"
+                        "\x2b\x73\xae\xf0\x85\x7d\x77\x81"
+                        "\x1f\x35\x2c\x07\x3b\x61\x08\xd7"
+                        "\x2d\x98\x10\xa3\x09\x14\xdf\xf4",
+                        .klen	= 72,
+                        .iv	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+                        .assoc	= "\x43\x21\x00\x00\x00\x00\x00\x02",
+                                .alen	= 8,
+                                .input	= "\x6b\x0c\xc2\xfa\x3f\x07\xc1\x00"
+                                        "\x59\x7c\x41\x2b\x40\xbe\xbb\x35"
+                                        "\x3f\x19\xf3\xcb\xbe\x9a\x00\x46"
+                                        "\x85\x97\xd4\xdb\x1e\xb7\x22\x9b"
+                                        "\xba\x92\x9d\x9e\x64\xbb\xc8\xcf"
+                                        "\xe6\x19\x5a\xb8\xd1\x61\xdb\x70"
+                                        "\x16\x86\x8d\xf3\x20\xf1\x24\xb0"
+                                        "\x22\x51\x7b\x17\x61\xd2\x1e\x4c"
+                                        "\xc0\x17\xb5\x42\xba\x00\x0e\x0d"
+                                        "\xf6\x51\x3a\x4b\x57\x6b\x5b\x66"
+                                        "\xa1\x71\xd6\x7f\x29\xbd\x16\x9e"
+                                        "\x88\xa8\x0c\x62\x36\xd2\x4c\xe2"
+                                        "\xf2\xe9\xca\xbc\x31\xcc\x22\xda"
+                                        "\xde\x0f\x3a\xf5\x69\x40\x86\x2a",
+                                        .ilen	= 112,
+                                        .result	= "\x03\x0a\x11\x18\x1f\x26\x2d\x34"
+                                                "\x3b\x42\x49\x50\x57\x5e\x65\x6c"
+                                                "\x73\x7a\x81\x88\x8f\x96\x9d\xa4"
+                                                "\xab\xb2\xb9\xc0\xc7\xce\xd5\xdc"
+                                                "\xe3\xea\xf1\xf8\xff\x06\x0d\x14"
+                                                "\x1b\x22\x29\x30\x37\x3e\x45\x4c"
+                                                "\x53\x5a\x61\x68\x6f\x76\x7d\x84"
+                                                "\x8b\x92\x99\xa0\xa7\xae\xb5\xbc"
+                                                "\xc3\xca\xd1\xd8\xdf\xe6\xed\xf4"
+                                                "\xfb\x02\x09\x10\x17\x1e\x25\x2c",
+                                                .rlen	= 80,
+                                                .np	= 2,
+                                                .tap	= { 37, 75 },
+                                                .anp	= 2,
+                                                .atap	= { 3, 5 },
+        }, { /* AES-128, HMAC-SHA256-128, tag with one bit flipped */
+                .key	= "\x08\x00\x01\x00\x00\x00\x00\x10"
+                        "\x11\x12\x13\x14\x15\x16\x17\x18"
+                        "\x19\x1a\x1b\x1c\x1d\x1e\x1f\x20"
+                        "\x21\x22\x23\x24\x25\x26\x27\x28"
+                        "\x29\x2a\x2b\x2c\x2d\x2e\x2f\x30"
+                        "\xc2\x86\x69\x6d\x88\x7c\x9a\xa0"
+                        "\x61\x1b\xbb\x3e\x20\x25\xa4\x5a",
+                        .klen	= 56,
+                        .iv	= "\x56\x2e\x17\x99\x6d\x09\x3d\x28"
+                                "\xdd\xb3\xba\x69\x5a\x2e\x6f\x58",
+                        .assoc	= "\x00\x00\x43\x55\x00\x00\x00\x01",
+                                .alen	= 8,
+                                .input	= "\xd2\x96\xcd\x94\xc2\xcc\xcf\x8a"
+                                        "\x3a\x86\x30\x28\xb5\xe1\xdc\x0a"
+                                        "\x75\x86\x60\x2d\x25\x3c\xff\xf9"
+                                        "\x1b\x82\x66\xbe\xa6\xd6\x1a\xb1"
+                                        "\x3d\x35\x9a\xf5\x3d\x02\x00\x9b"
+                                        "\x58\xa8\x3b\x46\xf4\x12\x09\x12",
+                                        .ilen	= 48,
+                                        .result	= "\x00\x01\x02\x03\x04\x05\x06\x07"
+                                                "\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+                                                "\x10\x11\x12\x13\x14\x15\x16\x17"
+                                                "\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f",
+                                                .rlen	= 32,
+                                                .novrfy	= 1,
+        }
+};
+
 /*
  * ANSI X9.31 Continuous Pseudo-Random Number Generator (AES mode)
  * test vectors, taken from Appendix B.2.9 and B.2.10:
@@ -1487,7 +2999,14 @@ struct moto_cipher_test_suite {
     } enc, dec;
 };
 
-struct moto_hash_test_suite {
+struct moto_aead_test_suite {
+    struct {
+        struct moto_aead_testvec *vecs;
+        unsigned int count;
+    } enc, dec;
+};
+
+struct moto_hash_test_suite {
     struct moto_hash_testvec *vecs;
     unsigned int count;
 };
@@ -1503,6 +3022,7 @@ struct moto_alg_test_desc {
             u32 type, u32 mask);
     unsigned alg_id;
     union {
+        struct moto_aead_test_suite aead;
         struct moto_cipher_test_suite cipher;
         struct moto_hash_test_suite hash;
         struct moto_cprng_test_suite cprng;
@@ -1999,6 +3519,335 @@ static int moto_test_skcipher(struct crypto_ablkcipher *tfm, int enc,
 }
 
 
+static int moto_test_aead(struct crypto_aead *tfm, int enc,
+        struct moto_aead_testvec *template, 
+        unsigned int tcount, int inject_fault)
+{
+    const char *algo = crypto_tfm_alg_driver_name(crypto_aead_tfm(tfm));
+    unsigned int i, j, k, n, temp;
+    char *q;
+    struct aead_request *req;
+    struct scatterlist sg[8];
+    struct scatterlist asg[8];
+    const char *e;
+    struct moto_tcrypt_result result;
+    unsigned int authsize;
+    void *input;
+    void *assoc;
+    char iv[MAX_IVLEN];
+    char *xbuf[XBUFSIZE];
+    char *axbuf[XBUFSIZE];
+    int ret = -ENOMEM;
+
+    if (moto_testmgr_alloc_buf(xbuf))
+        goto out_noxbuf;
+    if (moto_testmgr_alloc_buf(axbuf))
+        goto out_noaxbuf;
+
+    if (enc == ENCRYPT)
+        e = "encryption";
+    else
+        e = "decryption";
+
+    init_completion(&result.completion);
+
+    req = aead_request_alloc(tfm, GFP_KERNEL);
+    if (!req) {
+        printk(KERN_ERR 
+                "moto_crypto: aead: Failed to allocate request "
+                "for %s\n", algo);
+        goto out;
+    }
+
+    aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+            moto_tcrypt_complete, &result);
+
+    j = 0;
+    for (i = 0; i < tcount; i++) {
+        if (template[i].iv)
+            memcpy(iv, template[i].iv, MAX_IVLEN);
+        else
+            memset(iv, 0, MAX_IVLEN);
+
+        if (!(template[i].np)) {
+            j++;
+
+            ret = -EINVAL;
+            if (WARN_ON(template[i].ilen > PAGE_SIZE ||
+                    template[i].alen > PAGE_SIZE))
+                goto out;
+
+            input = xbuf[0];
+            assoc = axbuf[0];
+            memcpy(input, template[i].input, template[i].ilen);
+            memcpy(assoc, template[i].assoc, template[i].alen);
+
+            crypto_aead_clear_flags(tfm, ~0);
+            if (template[i].wk)
+                crypto_aead_set_flags(tfm, CRYPTO_TFM_REQ_WEAK_KEY);
+
+            ret = crypto_aead_setkey(tfm, template[i].key,
+                    template[i].klen);
+            if (!ret == template[i].fail) {
+                printk(KERN_ERR 
+                        "moto_crypto: aead: setkey failed "
+                        "on test %d for %s: flags=%x\n", j,
+                        algo, crypto_aead_get_flags(tfm));
+                goto out;
+            } else if (ret)
+                continue;
+
+            /* the tag is appended on encryption and consumed on decryption */
+            authsize = abs(template[i].rlen - template[i].ilen);
+            ret = crypto_aead_setauthsize(tfm, authsize);
+            if (ret) {
+                printk(KERN_ERR 
+                        "moto_crypto: aead: Failed to set "
+                        "authsize to %u on test %d for %s\n",
+                        authsize, j, algo);
+                goto out;
+            }
+
+            sg_init_one(&sg[0], input,
+                    template[i].ilen + (enc ? authsize : 0));
+            sg_init_one(&asg[0], assoc, template[i].alen);
+
+            aead_request_set_crypt(req, sg, sg,
+                    template[i].ilen, iv);
+            aead_request_set_assoc(req, asg, template[i].alen);
+
+            ret = enc ?
+                    crypto_aead_encrypt(req) :
+                    crypto_aead_decrypt(req);
+
+            switch (ret) {
+            case 0:
+                if (template[i].novrfy) {
+                    printk(KERN_ERR 
+                            "moto_crypto: aead: %s accepted a "
+                            "corrupted tag on test %d for %s\n",
+                            e, j, algo);
+                    ret = -EBADMSG;
+                    goto out;
+                }
+                break;
+            case -EINPROGRESS:
+            case -EBUSY:
+                ret = wait_for_completion_interruptible(
+                        &result.completion);
+                if (!ret && !((ret = result.err))) {
+                    INIT_COMPLETION(result.completion);
+                    break;
+                }
+                /* fall through */
+            case -EBADMSG:
+                if (ret == -EBADMSG && template[i].novrfy)
+                    continue;
+                /* fall through */
+            default:
+                printk(KERN_ERR 
+                        "moto_crypto: aead: %s failed on "
+                        "test %d for %s: ret=%d\n", e, j, algo,
+                        -ret);
+                goto out;
+            }
+
+            q = input;
+
+#ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
+            if (inject_fault == INJECT_FAULT_ALL_KEY_LENGHTS ||
+                    inject_fault == (template[i].klen * 8)) {
+                q[0] ^= 0xff;
+            }
+#endif
+            if (memcmp(q, template[i].result, template[i].rlen)) {
+                printk(KERN_ERR 
+                        "moto_crypto: aead: Test %d "
+                        "failed on %s for %s\n", j, e, algo);
+                moto_hexdump(q, template[i].rlen);
+                ret = -EINVAL;
+                goto out;
+            }
+        }
+    }
+
+    j = 0;
+    for (i = 0; i < tcount; i++) {
+
+        if (template[i].iv)
+            memcpy(iv, template[i].iv, MAX_IVLEN);
+        else
+            memset(iv, 0, MAX_IVLEN);
+
+        if (template[i].np) {
+            j++;
+
+            crypto_aead_clear_flags(tfm, ~0);
+            if (template[i].wk)
+                crypto_aead_set_flags(tfm, CRYPTO_TFM_REQ_WEAK_KEY);
+
+            ret = crypto_aead_setkey(tfm, template[i].key,
+                    template[i].klen);
+            if (!ret == template[i].fail) {
+                printk(KERN_ERR 
+                        "moto_crypto: aead: setkey failed "
+                        "on chunk test %d for %s: flags=%x\n",
+                        j, algo, crypto_aead_get_flags(tfm));
+                goto out;
+            } else if (ret)
+                continue;
+
+            authsize = abs(template[i].rlen - template[i].ilen);
+            ret = crypto_aead_setauthsize(tfm, authsize);
+            if (ret) {
+                printk(KERN_ERR 
+                        "moto_crypto: aead: Failed to set "
+                        "authsize to %u on chunk test %d for %s\n",
+                        authsize, j, algo);
+                goto out;
+            }
+
+            temp = 0;
+            ret = -EINVAL;
+            sg_init_table(sg, template[i].np);
+            for (k = 0; k < template[i].np; k++) {
+                n = template[i].tap[k];
+                if (k == template[i].np - 1 && enc)
+                    n += authsize;
+
+                if (WARN_ON(offset_in_page(MOTO_IDX[k]) + n >
+                        PAGE_SIZE))
+                    goto out;
+
+                q = xbuf[MOTO_IDX[k] >> PAGE_SHIFT] +
+                        offset_in_page(MOTO_IDX[k]);
+
+                memcpy(q, template[i].input + temp,
+                        template[i].tap[k]);
+
+                if (offset_in_page(q) + n < PAGE_SIZE)
+                    q[n] = 0;
+
+                sg_set_buf(&sg[k], q, n);
+
+                temp += template[i].tap[k];
+            }
+
+            temp = 0;
+            sg_init_table(asg, template[i].anp);
+            for (k = 0; k < template[i].anp; k++) {
+                if (WARN_ON(offset_in_page(MOTO_IDX[k]) +
+                        template[i].atap[k] > PAGE_SIZE))
+                    goto out;
+
+                q = axbuf[MOTO_IDX[k] >> PAGE_SHIFT] +
+                        offset_in_page(MOTO_IDX[k]);
+
+                memcpy(q, template[i].assoc + temp,
+                        template[i].atap[k]);
+                sg_set_buf(&asg[k], q, template[i].atap[k]);
+
+                temp += template[i].atap[k];
+            }
+
+            aead_request_set_crypt(req, sg, sg,
+                    template[i].ilen, iv);
+            aead_request_set_assoc(req, asg, template[i].alen);
+
+            ret = enc ?
+                    crypto_aead_encrypt(req) :
+                    crypto_aead_decrypt(req);
+
+            switch (ret) {
+            case 0:
+                if (template[i].novrfy) {
+                    printk(KERN_ERR 
+                            "moto_crypto: aead: %s accepted a "
+                            "corrupted tag on chunk test %d "
+                            "for %s\n", e, j, algo);
+                    ret = -EBADMSG;
+                    goto out;
+                }
+                break;
+            case -EINPROGRESS:
+            case -EBUSY:
+                ret = wait_for_completion_interruptible(
+                        &result.completion);
+                if (!ret && !((ret = result.err))) {
+                    INIT_COMPLETION(result.completion);
+                    break;
+                }
+                /* fall through */
+            case -EBADMSG:
+                if (ret == -EBADMSG && template[i].novrfy)
+                    continue;
+                /* fall through */
+            default:
+                printk(KERN_ERR 
+                        "moto_crypto: aead: %s failed on "
+                        "chunk test %d for %s: ret=%d\n", e, j,
+                        algo, -ret);
+                goto out;
+            }
+
+            temp = 0;
+            ret = -EINVAL;
+            for (k = 0; k < template[i].np; k++) {
+                q = xbuf[MOTO_IDX[k] >> PAGE_SHIFT] +
+                        offset_in_page(MOTO_IDX[k]);
+
+                /* the tag sits at the end of the last chunk */
+                n = template[i].tap[k];
+                if (k == template[i].np - 1)
+                    n = enc ? n + authsize : n - authsize;
+
+                if (memcmp(q, template[i].result + temp, n)) {
+                    printk(KERN_ERR 
+                            "moto_crypto: aead: Chunk "
+                            "test %d failed on %s at page "
+                            "%u for %s\n", j, e, k, algo);
+                    moto_hexdump(q, n);
+                    goto out;
+                }
+
+                q += n;
+                if (k == template[i].np - 1 && !enc) {
+                    /* the tag must be left untouched */
+                    if (memcmp(q, template[i].input + temp + n,
+                            authsize))
+                        n = authsize;
+                    else
+                        n = 0;
+                } else {
+                    for (n = 0; offset_in_page(q + n) && q[n]; n++)
+                        ;
+                }
+                if (n) {
+                    printk(KERN_ERR 
+                            "moto_crypto: aead: "
+                            "Result buffer corruption in "
+                            "chunk test %d on %s at page "
+                            "%u for %s: %u bytes:\n", j, e,
+                            k, algo, n);
+                    moto_hexdump(q, n);
+                    goto out;
+                }
+                temp += template[i].tap[k];
+            }
+        }
+    }
+
+    ret = 0;
+
+    out:
+    aead_request_free(req);
+    moto_testmgr_buf(axbuf);
+    out_noaxbuf:
+    moto_testmgr_buf(xbuf);
+    out_noxbuf:
+    return ret;
+}
+
 static int moto_test_cprng(struct crypto_rng *tfm, 
         struct moto_cprng_testvec *template,
         unsigned int tcount, int inject_fault)
@@ -2072,6 +3921,87 @@ static int moto_test_cprng(struct crypto_rng *tfm,
     return err;
 }
 
+/* Tests for authenticated encryption */
+static int moto_alg_test_aead(const struct moto_alg_test_desc *desc,
+        const char *driver, u32 type, u32 mask)
+{
+    struct crypto_aead *tfm;
+    int err = 0;
+    int inject_fault = 0;
+
+    tfm = crypto_alloc_aead(driver, type, mask);
+    if (IS_ERR(tfm)) {
+        printk(KERN_ERR 
+                "moto_crypto: aead: Failed to load transform for "
+                "%s: %ld\n", driver, PTR_ERR(tfm));
+        return PTR_ERR(tfm);
+    }
+
+#ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
+    if (fault_injection_mask & desc->alg_id) {
+        printk(KERN_WARNING 
+                "Moto crypto: injecting fault in aead %s\n", driver);
+        inject_fault = INJECT_FAULT_ALL_KEY_LENGHTS;
+    }
+    if (!strcmp(driver, "moto-aes-gcm")) {
+        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_GCM_128) {
+            inject_fault = 128;
+        }
+        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_GCM_192) {
+            inject_fault = 192;
+        }
+        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_GCM_256) {
+            inject_fault = 256;
+        }
+    }
+#endif
+
+    if (desc->suite.aead.enc.vecs) {
+        err = moto_test_aead(tfm, ENCRYPT, 
+                desc->suite.aead.enc.vecs,
+                desc->suite.aead.enc.count, 
+                inject_fault);
+        if (err)
+            goto out;
+    }
+
+    if (desc->suite.aead.dec.vecs)
+        err = moto_test_aead(tfm, DECRYPT, 
+                desc->suite.aead.dec.vecs,
+                desc->suite.aead.dec.count, 
+                inject_fault);
+
+    out:
+    crypto_free_aead(tfm);
+    return err;
+}
+
+#ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
+/*
+ * Per key length faults of the AES modes.  These match the algorithm
+ * rather than the driver, so the table, AES-NI and bitsliced drivers of a
+ * mode are all covered.  Later entries take precedence.
+ */
+static const struct {
+    const char *alg;
+    unsigned alg_id;
+    int bits;
+} moto_fault_key_lengths[] = {
+    { "ecb(aes)", MOTO_CRYPTO_ALG_AES_ECB_128, 128 },
+    { "ecb(aes)", MOTO_CRYPTO_ALG_AES_ECB_192, 192 },
+    { "ecb(aes)", MOTO_CRYPTO_ALG_AES_ECB_256, 256 },
+    { "cbc(aes)", MOTO_CRYPTO_ALG_AES_CBC_128, 128 },
+    { "cbc(aes)", MOTO_CRYPTO_ALG_AES_CBC_192, 192 },
+    { "cbc(aes)", MOTO_CRYPTO_ALG_AES_CBC_256, 256 },
+    { "ctr(aes)", MOTO_CRYPTO_ALG_AES_CTR_128, 128 },
+    { "ctr(aes)", MOTO_CRYPTO_ALG_AES_CTR_192, 192 },
+    { "ctr(aes)", MOTO_CRYPTO_ALG_AES_CTR_256, 256 },
+    /* XTS keys are two AES keys, the template klen covers both */
+    { "xts(aes)", MOTO_CRYPTO_ALG_AES_XTS_128, 256 },
+    { "xts(aes)", MOTO_CRYPTO_ALG_AES_XTS_256, 512 },
+};
+#endif
+
 /* Tests for symmetric key ciphers */
 static int moto_alg_test_skcipher(const struct moto_alg_test_desc *desc,
         const char *driver, u32 type, u32 mask)
@@ -2079,6 +4009,9 @@ static int moto_alg_test_skcipher(const struct moto_alg_test_desc *desc,
     struct crypto_ablkcipher *tfm;
     int err = 0;
     int inject_fault = 0;
+#ifdef CONFIG_CRYPTO_MOTOROLA_FAULT_INJECTION
+    int i;
+#endif
 
     printk(KERN_ERR 
             "moto_alg_test_skcipher driver=%s type=%d mask=%d\n", 
@@ -2098,38 +4031,10 @@ static int moto_alg_test_skcipher(const struct moto_alg_test_desc *desc,
                 driver);
         inject_fault = INJECT_FAULT_ALL_KEY_LENGHTS;
     }
-    if (!strcmp(driver, "moto-aes-ecb")) {
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_ECB_128) {
-            inject_fault = 128;
-        }
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_ECB_192) {
-            inject_fault = 192;
-        }
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_ECB_256) {
-            inject_fault = 256;
-        }
-    }
-    if (!strcmp(driver, "moto-aes-cbc")) {
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_CBC_128) {
-            inject_fault = 128;
-        }
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_CBC_192) {
-            inject_fault = 192;
-        }
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_CBC_256) {
-            inject_fault = 256;
-        }
-    }
-    if (!strcmp(driver, "moto-aes-ctr")) {
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_CTR_128) {
-            inject_fault = 128;
-        }
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_CTR_192) {
-            inject_fault = 192;
-        }
-        if (fault_injection_mask & MOTO_CRYPTO_ALG_AES_CTR_256) {
-            inject_fault = 256;
-        }
+    for (i = 0; i < ARRAY_SIZE(moto_fault_key_lengths); i++) {
+        if (!strcmp(desc->alg, moto_fault_key_lengths[i].alg) &&
+                (fault_injection_mask & moto_fault_key_lengths[i].alg_id))
+            inject_fault = moto_fault_key_lengths[i].bits;
     }
 #endif
 
@@ -2230,6 +4135,22 @@ static const struct moto_alg_test_desc moto_alg_test_descs[] = {
                                 .count = ANSI_CPRNG_AES_TEST_VECTORS
                         }
                 }
+        }, {
+                .alg = "authenc(moto_hmac(sha256),cbc(aes))",
+                .test = moto_alg_test_aead,
+                .alg_id = MOTO_CRYPTO_ALG_AUTHENC,
+                .suite = {
+                        .aead = {
+                                .enc = {
+                                        .vecs = moto_authenc_hmac_sha256_aes_cbc_enc_tv_template,
+                                        .count = AUTHENC_HMAC_SHA256_AES_CBC_ENC_TEST_VECTORS
+                                },
+                                .dec = {
+                                        .vecs = moto_authenc_hmac_sha256_aes_cbc_dec_tv_template,
+                                        .count = AUTHENC_HMAC_SHA256_AES_CBC_DEC_TEST_VECTORS
+                                }
+                        }
+                }
         }, {
                 .alg = "cbc(aes)",
                 .test = moto_alg_test_skcipher,
@@ -2307,6 +4228,21 @@ static const struct moto_alg_test_desc moto_alg_test_descs[] = {
                                 }
                         }
                 }
+        }, {
+                .alg = "gcm(aes)",
+                .test = moto_alg_test_aead,
+                .suite = {
+                        .aead = {
+                                .enc = {
+                                        .vecs = moto_aes_gcm_enc_tv_template,
+                                        .count = AES_GCM_ENC_TEST_VECTORS
+                                },
+                                .dec = {
+                                        .vecs = moto_aes_gcm_dec_tv_template,
+                                        .count = AES_GCM_DEC_TEST_VECTORS
+                                }
+                        }
+                }
         }, {
                 .alg = "moto_hmac(moto-sha1)",
                 .test = moto_alg_test_hash,
@@ -2357,6 +4293,26 @@ static const struct moto_alg_test_desc moto_alg_test_descs[] = {
                                 .count = HMAC_SHA512_TEST_VECTORS
                         }
                 }
+        }, {
+                .alg = "moto_hmac(moto-sha512_224)",
+                .test = moto_alg_test_hash,
+                .alg_id = MOTO_CRYPTO_ALG_HMAC_SHA512,
+                .suite = {
+                        .hash = {
+                                .vecs = moto_hmac_sha512_224_tv_template,
+                                .count = HMAC_SHA512_224_TEST_VECTORS
+                        }
+                }
+        }, {
+                .alg = "moto_hmac(moto-sha512_256)",
+                .test = moto_alg_test_hash,
+                .alg_id = MOTO_CRYPTO_ALG_HMAC_SHA512,
+                .suite = {
+                        .hash = {
+                                .vecs = moto_hmac_sha512_256_tv_template,
+                                .count = HMAC_SHA512_256_TEST_VECTORS
+                        }
+                }
         }, {
                 .alg = "sha1",
                 .test = moto_alg_test_hash,
@@ -2407,6 +4363,41 @@ static const struct moto_alg_test_desc moto_alg_test_descs[] = {
                                 .count = SHA512_TEST_VECTORS
                         }
                 }
+        }, {
+                .alg = "sha512_224",
+                .test = moto_alg_test_hash,
+                .alg_id = MOTO_CRYPTO_ALG_SHA512_224,
+                .suite = {
+                        .hash = {
+                                .vecs = moto_sha512_224_tv_template,
+                                .count = SHA512_224_TEST_VECTORS
+                        }
+                }
+        }, {
+                .alg = "sha512_256",
+                .test = moto_alg_test_hash,
+                .alg_id = MOTO_CRYPTO_ALG_SHA512_256,
+                .suite = {
+                        .hash = {
+                                .vecs = moto_sha512_256_tv_template,
+                                .count = SHA512_256_TEST_VECTORS
+                        }
+                }
+        }, {
+                .alg = "xts(aes)",
+                .test = moto_alg_test_skcipher,
+                .suite = {
+                        .cipher = {
+                                .enc = {
+                                        .vecs = moto_aes_xts_enc_tv_template,
+                                        .count = AES_XTS_ENC_TEST_VECTORS
+                                },
+                                .dec = {
+                                        .vecs = moto_aes_xts_dec_tv_template,
+                                        .count = AES_XTS_DEC_TEST_VECTORS
+                                }
+                        }
+                }
         }
 };
 
@@ -2472,3 +4463,303 @@ int moto_alg_test(const char *driver, const char *alg, u32 type, u32 mask)
     printk(KERN_INFO "moto_crypto: No test for %s (%s)\n", alg, driver);
     return 0;
 }
+
+/*
+ * Self test bookkeeping.  Every driver tested at start up has an entry
+ * holding its self test state.  With lazy_post set the tests are not run
+ * at start up: the driver's cra_init is routed through
+ * moto_post_alg_init() and the first tfm allocation runs them, exactly
+ * once.  Concurrent first users wait for the result, allocations made by
+ * the test itself go through.  A failed deferred test puts the module in
+ * its error state, see moto_crypto_post_failure().
+ */
+static bool lazy_post;
+module_param(lazy_post, bool, 0444);
+MODULE_PARM_DESC(lazy_post, "Run algorithm self tests on first use");
+
+enum moto_post_alg_state {
+    MOTO_POST_ALG_PENDING,
+    MOTO_POST_ALG_RUNNING,
+    MOTO_POST_ALG_PASSED,
+    MOTO_POST_ALG_FAILED,
+};
+
+static const char * const moto_post_alg_state_names[] = {
+        [MOTO_POST_ALG_PENDING] = "pending",
+        [MOTO_POST_ALG_RUNNING] = "running",
+        [MOTO_POST_ALG_PASSED]  = "passed",
+        [MOTO_POST_ALG_FAILED]  = "failed",
+};
+
+struct moto_post_alg {
+    struct list_head list;
+    const char *driver;
+    const char *alg;
+    unsigned failure;
+    enum moto_post_alg_state state;
+    struct task_struct *tester;
+    struct completion done;
+    int (*cra_init)(struct crypto_tfm *tfm);
+    s64 test_us;
+};
+
+static LIST_HEAD(moto_post_algs);
+static DEFINE_MUTEX(moto_post_alg_lock);
+
+/* Once a deferred test failed no further tfm is handed out */
+static bool moto_post_alg_failed;
+
+static struct moto_post_alg *moto_post_alg_find(const char *driver)
+{
+    struct moto_post_alg *entry;
+
+    list_for_each_entry(entry, &moto_post_algs, list) {
+        if (!strcmp(entry->driver, driver))
+            return entry;
+    }
+    return NULL;
+}
+
+static int moto_post_alg_run(struct moto_post_alg *entry)
+{
+    ktime_t start;
+    int err;
+
+    mutex_lock(&moto_post_alg_lock);
+    if (moto_post_alg_failed) {
+        mutex_unlock(&moto_post_alg_lock);
+        return -ELIBBAD;
+    }
+
+    switch (entry->state) {
+    case MOTO_POST_ALG_PENDING:
+        entry->state = MOTO_POST_ALG_RUNNING;
+        entry->tester = current;
+        mutex_unlock(&moto_post_alg_lock);
+
+        start = ktime_get();
+        err = moto_alg_test(entry->driver, entry->alg, 0, 0);
+        entry->test_us = ktime_us_delta(ktime_get(), start);
+        printk (KERN_INFO "%s deferred test result: %d\n", 
+                entry->driver, err);
+
+        mutex_lock(&moto_post_alg_lock);
+        entry->tester = NULL;
+        if (err) {
+            entry->state = MOTO_POST_ALG_FAILED;
+            moto_post_alg_failed = true;
+            moto_crypto_post_failure(entry->failure);
+            err = -ELIBBAD;
+        }
+        else
+            entry->state = MOTO_POST_ALG_PASSED;
+        complete_all(&entry->done);
+        mutex_unlock(&moto_post_alg_lock);
+        return err;
+
+    case MOTO_POST_ALG_RUNNING:
+        /* the known answer test allocating its own tfms */
+        if (entry->tester == current) {
+            mutex_unlock(&moto_post_alg_lock);
+            return 0;
+        }
+        mutex_unlock(&moto_post_alg_lock);
+        wait_for_completion(&entry->done);
+        return entry->state == MOTO_POST_ALG_PASSED ? 0 : -ELIBBAD;
+
+    case MOTO_POST_ALG_PASSED:
+        mutex_unlock(&moto_post_alg_lock);
+        return 0;
+
+    default:
+        mutex_unlock(&moto_post_alg_lock);
+        return -ELIBBAD;
+    }
+}
+
+static int moto_post_alg_init(struct crypto_tfm *tfm)
+{
+    struct moto_post_alg *entry;
+    int err;
+
+    mutex_lock(&moto_post_alg_lock);
+    entry = moto_post_alg_find(crypto_tfm_alg_driver_name(tfm));
+    mutex_unlock(&moto_post_alg_lock);
+    if (entry == NULL)
+        return -ENOENT;
+
+    err = moto_post_alg_run(entry);
+    if (err)
+        return err;
+    return entry->cra_init ? entry->cra_init(tfm) : 0;
+}
+
+static struct moto_post_alg *moto_post_alg_new(const char *driver,
+        const char *name, unsigned failure)
+{
+    struct moto_post_alg *entry;
+
+    entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+    if (entry == NULL)
+        return NULL;
+
+    entry->driver = driver;
+    entry->alg = name;
+    entry->failure = failure;
+    init_completion(&entry->done);
+    return entry;
+}
+
+/*
+ * With lazy_post set, defer the self test of driver to the first
+ * allocation of alg.  Called before alg gets registered, so no tfm of it
+ * is ever handed out untested.  alg is NULL for template instances, which
+ * are hooked by moto_post_alg_hook() when they get created.
+ */
+int moto_post_alg_defer(struct crypto_alg *alg, const char *driver,
+        const char *name, unsigned failure)
+{
+    struct moto_post_alg *entry;
+
+    if (!lazy_post)
+        return 0;
+
+    entry = moto_post_alg_new(driver, name, failure);
+    if (entry == NULL)
+        return -ENOMEM;
+    entry->state = MOTO_POST_ALG_PENDING;
+
+    mutex_lock(&moto_post_alg_lock);
+    list_add_tail(&entry->list, &moto_post_algs);
+    mutex_unlock(&moto_post_alg_lock);
+
+    if (alg != NULL)
+        moto_post_alg_hook(alg);
+    return 0;
+}
+
+/*
+ * Self test a registered driver, unless moto_post_alg_defer() deferred
+ * the test.
+ */
+int moto_post_alg_test(const char *driver, const char *name,
+        unsigned failure)
+{
+    struct moto_post_alg *entry;
+    ktime_t start;
+    int err;
+
+    if (lazy_post) {
+        mutex_lock(&moto_post_alg_lock);
+        entry = moto_post_alg_find(driver);
+        mutex_unlock(&moto_post_alg_lock);
+        if (entry != NULL)
+            return 0;
+    }
+
+    entry = moto_post_alg_new(driver, name, failure);
+    if (entry == NULL)
+        return -ENOMEM;
+
+    start = ktime_get();
+    err = moto_alg_test(driver, name, 0, 0);
+    entry->test_us = ktime_us_delta(ktime_get(), start);
+    entry->state = err ? MOTO_POST_ALG_FAILED : MOTO_POST_ALG_PASSED;
+    complete_all(&entry->done);
+
+    mutex_lock(&moto_post_alg_lock);
+    list_add_tail(&entry->list, &moto_post_algs);
+    mutex_unlock(&moto_post_alg_lock);
+    return err;
+}
+
+/*
+ * Route the first allocation of a driver with a deferred self test
+ * through the test.  Does nothing unless lazy_post is set.
+ */
+void moto_post_alg_hook(struct crypto_alg *alg)
+{
+    struct moto_post_alg *entry;
+
+    if (!lazy_post || alg->cra_init == moto_post_alg_init)
+        return;
+
+    mutex_lock(&moto_post_alg_lock);
+    entry = moto_post_alg_find(alg->cra_driver_name);
+    if (entry != NULL) {
+        entry->cra_init = alg->cra_init;
+        alg->cra_init = moto_post_alg_init;
+    }
+    mutex_unlock(&moto_post_alg_lock);
+}
+
+/*
+ * For drivers built on top of another one: make sure the self test of
+ * driver has run and passed.
+ */
+int moto_post_alg_check(const char *driver)
+{
+    struct moto_post_alg *entry;
+
+    mutex_lock(&moto_post_alg_lock);
+    entry = moto_post_alg_find(driver);
+    mutex_unlock(&moto_post_alg_lock);
+
+    return entry != NULL ? moto_post_alg_run(entry) : 0;
+}
+
+/*
+ * For interfaces that only serve self tested drivers: whether driver has a
+ * self test entry that passed, running a deferred test first.
+ */
+int moto_post_alg_passed(const char *driver)
+{
+    struct moto_post_alg *entry;
+
+    mutex_lock(&moto_post_alg_lock);
+    entry = moto_post_alg_find(driver);
+    mutex_unlock(&moto_post_alg_lock);
+
+    return entry != NULL && moto_post_alg_run(entry) == 0;
+}
+
+ssize_t moto_post_alg_show(char *buf, size_t size)
+{
+    struct moto_post_alg *entry;
+    ssize_t n = 0;
+
+    mutex_lock(&moto_post_alg_lock);
+    list_for_each_entry(entry, &moto_post_algs, list) {
+        n += scnprintf(buf + n, size - n, "%s %s\n", entry->driver,
+                moto_post_alg_state_names[entry->state]);
+    }
+    mutex_unlock(&moto_post_alg_lock);
+    return n;
+}
+
+/* Test suite durations in microseconds, 0 while a test is pending */
+ssize_t moto_post_alg_show_timing(char *buf, size_t size)
+{
+    struct moto_post_alg *entry;
+    ssize_t n = 0;
+
+    mutex_lock(&moto_post_alg_lock);
+    list_for_each_entry(entry, &moto_post_algs, list) {
+        n += scnprintf(buf + n, size - n, "test:%s %lld\n", entry->driver,
+                entry->test_us);
+    }
+    mutex_unlock(&moto_post_alg_lock);
+    return n;
+}
+
+void moto_post_alg_free(void)
+{
+    struct moto_post_alg *entry, *next;
+
+    mutex_lock(&moto_post_alg_lock);
+    list_for_each_entry_safe(entry, next, &moto_post_algs, list) {
+        list_del(&entry->list);
+        kfree(entry);
+    }
+    mutex_unlock(&moto_post_alg_lock);
+}
@@ -24,6 +24,7 @@
 #ifndef _MOTO_CRYPTO_TESTMGR_H
 #define _MOTO_CRYPTO_TESTMGR_H
 
+#include <linux/crypto.h>
 #include <linux/netlink.h>
 
 #define MAX_DIGEST_SIZE     64
@@ -57,6 +58,25 @@ struct moto_cipher_testvec {
     unsigned short rlen;
 };
 
+struct moto_aead_testvec {
+    char *key;
+    char *iv;
+    char *input;
+    char *assoc;
+    char *result;
+    unsigned char tap[MAX_TAP];
+    unsigned char atap[MAX_TAP];
+    int np;
+    int anp;
+    unsigned char fail;
+    unsigned char novrfy; /* tag verification failure expected */
+    unsigned char wk; /* weak key flag */
+    unsigned char klen;
+    unsigned short ilen;
+    unsigned short alen;
+    unsigned short rlen;
+};
+
 struct moto_cprng_testvec {
     char *key;
     char *dt;
@@ -71,4 +91,15 @@ struct moto_cprng_testvec {
 
 int moto_alg_test(const char *driver, const char *alg, u32 type, u32 mask);
 
+int moto_post_alg_defer(struct crypto_alg *alg, const char *driver,
+        const char *name, unsigned failure);
+int moto_post_alg_test(const char *driver, const char *name,
+        unsigned failure);
+void moto_post_alg_hook(struct crypto_alg *alg);
+int moto_post_alg_check(const char *driver);
+int moto_post_alg_passed(const char *driver);
+ssize_t moto_post_alg_show(char *buf, size_t size);
+ssize_t moto_post_alg_show_timing(char *buf, size_t size);
+void moto_post_alg_free(void);
+
 #endif  /* _MOTO_CRYPTO_TESTMGR_H */
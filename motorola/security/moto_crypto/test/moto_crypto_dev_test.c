@@ -0,0 +1,917 @@
+/*
+ * Userspace test of /dev/moto_crypto.
+ *
+ * Checks ring setup and mapping, session creation, known answers for
+ * cipher, hash and HMAC jobs, the rejection of jobs and rings that point
+ * outside what was set up, completion ring back pressure, and compares
+ * the results with AF_ALG over random inputs. Last it times small records
+ * through one SUBMIT per ring against one AF_ALG round trip per record
+ * on the same moto driver.
+ *
+ * Build with "make dev-test", run as root with moto_crypto loaded:
+ *
+ *   test/moto_crypto_dev_test [-g min_gain] [-t seconds]
+ *
+ * Exits 0 when everything passed, 1 on a failure and 77 when there is no
+ * /dev/moto_crypto.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <linux/if_alg.h>
+
+#include "moto_crypto_dev.h"
+
+#ifndef SOL_ALG
+#define SOL_ALG 279
+#endif
+
+#define DEV_PATH            "/dev/" MOTO_CRYPTO_DEV_NAME
+
+#define AES_CBC_DRIVER      "moto-aes-cbc"
+#define AES_CTR_DRIVER      "moto-aes-ctr"
+#define SHA256_DRIVER       "moto-sha256"
+#define HMAC_DRIVER         "moto_hmac(moto-sha256)"
+
+#define ARRAY_SIZE(a)       (sizeof(a) / sizeof((a)[0]))
+
+struct dev_ctx {
+    int fd;
+    struct moto_crypto_dev_setup setup;
+    unsigned char *mem;
+    struct moto_crypto_rings *rings;
+    struct moto_crypto_sqe *sqes;
+    struct moto_crypto_cqe *cqes;
+    unsigned char *arena;
+};
+
+static int failures;
+static int checks;
+
+#define CHECK(cond, fmt, ...)                                           \
+    do {                                                                \
+        checks++;                                                       \
+        if (!(cond)) {                                                  \
+            failures++;                                                 \
+            printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__,         \
+                    ##__VA_ARGS__);                                     \
+        }                                                               \
+    } while (0)
+
+/* SP800-38A F.2.1 and F.5.1, AES-128 */
+static const unsigned char aes_key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const unsigned char aes_plain[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+static const unsigned char aes_cbc_iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const unsigned char aes_cbc_cipher[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+    0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+    0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7
+};
+static const unsigned char aes_ctr_iv[16] = {
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+static const unsigned char aes_ctr_cipher[64] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+    0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+    0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+    0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1,
+    0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+};
+
+/* FIPS 180-2 B.1 */
+static const unsigned char sha256_abc[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+    0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+/* RFC 4231 test case 2 */
+static const unsigned char hmac_jefe[32] = {
+    0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e,
+    0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+    0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+    0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43
+};
+
+/* HMAC-SHA256 of the empty message under the empty key */
+static const unsigned char hmac_empty[32] = {
+    0xb6, 0x13, 0x67, 0x9a, 0x08, 0x14, 0xd9, 0xec,
+    0x77, 0x2f, 0x95, 0xd7, 0x78, 0xc3, 0x5f, 0xc5,
+    0xff, 0x16, 0x97, 0xc4, 0x93, 0x71, 0x56, 0x53,
+    0xc6, 0xc7, 0x12, 0x14, 0x42, 0x92, 0xc5, 0xad
+};
+
+static double moto_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void moto_fill(unsigned char *buf, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        buf[i] = rand();
+}
+
+/* ----- /dev/moto_crypto ----- */
+
+static int dev_open(void)
+{
+    return open(DEV_PATH, O_RDWR);
+}
+
+static int dev_setup(struct dev_ctx *ctx, unsigned sq, unsigned cq,
+        unsigned arena)
+{
+    int err;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->fd = dev_open();
+    if (ctx->fd < 0)
+        return -errno;
+
+    ctx->setup.sq_entries = sq;
+    ctx->setup.cq_entries = cq;
+    ctx->setup.arena_size = arena;
+    if (ioctl(ctx->fd, MOTO_CRYPTO_IOC_SETUP, &ctx->setup) < 0)
+        goto fail;
+
+    ctx->mem = mmap(NULL, ctx->setup.mmap_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, ctx->fd, 0);
+    if (ctx->mem == MAP_FAILED)
+        goto fail;
+    ctx->rings = (struct moto_crypto_rings *)ctx->mem;
+    ctx->sqes = (struct moto_crypto_sqe *)(ctx->mem + ctx->setup.sq_off);
+    ctx->cqes = (struct moto_crypto_cqe *)(ctx->mem + ctx->setup.cq_off);
+    ctx->arena = ctx->mem + ctx->setup.arena_off;
+    return 0;
+
+fail:
+    err = -errno;
+    close(ctx->fd);
+    return err;
+}
+
+static void dev_close(struct dev_ctx *ctx)
+{
+    munmap(ctx->mem, ctx->setup.mmap_size);
+    close(ctx->fd);
+}
+
+/* Returns the session id or a negative errno */
+static int dev_session(struct dev_ctx *ctx, const char *driver,
+        unsigned type, const void *key, unsigned keylen)
+{
+    struct moto_crypto_dev_session req;
+
+    memset(&req, 0, sizeof(req));
+    strncpy(req.driver, driver, sizeof(req.driver) - 1);
+    req.key = (uintptr_t)key;
+    req.keylen = keylen;
+    req.type = type;
+    if (ioctl(ctx->fd, MOTO_CRYPTO_IOC_SESSION, &req) < 0)
+        return -errno;
+    return req.session;
+}
+
+static int dev_end_session(struct dev_ctx *ctx, __u32 id)
+{
+    if (ioctl(ctx->fd, MOTO_CRYPTO_IOC_END_SESSION, &id) < 0)
+        return -errno;
+    return 0;
+}
+
+static void dev_queue(struct dev_ctx *ctx, const struct moto_crypto_sqe *sqe)
+{
+    struct moto_crypto_ring *sq = &ctx->rings->sq;
+    __u32 tail = sq->tail;
+
+    ctx->sqes[tail & sq->mask] = *sqe;
+    __atomic_store_n(&sq->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static long dev_submit(struct dev_ctx *ctx)
+{
+    long ret = ioctl(ctx->fd, MOTO_CRYPTO_IOC_SUBMIT);
+
+    return ret < 0 ? -errno : ret;
+}
+
+/* Returns 1 and the next completion, 0 when the ring is empty */
+static int dev_reap(struct dev_ctx *ctx, struct moto_crypto_cqe *cqe)
+{
+    struct moto_crypto_ring *cq = &ctx->rings->cq;
+    __u32 head = cq->head;
+
+    if (head == __atomic_load_n(&cq->tail, __ATOMIC_ACQUIRE))
+        return 0;
+    *cqe = ctx->cqes[head & cq->mask];
+    __atomic_store_n(&cq->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/* Runs one job and returns its result, len gets the bytes written */
+static int dev_run(struct dev_ctx *ctx, __u32 session, __u32 op,
+        __u32 src_off, __u32 dst_off, __u32 iv_off, __u32 len, __u32 *written)
+{
+    struct moto_crypto_sqe sqe = {
+        .user_data = 0x6d6f746f00000000ull | src_off,
+        .session = session,
+        .op = op,
+        .src_off = src_off,
+        .dst_off = dst_off,
+        .iv_off = iv_off,
+        .len = len,
+    };
+    struct moto_crypto_cqe cqe;
+    long done;
+
+    dev_queue(ctx, &sqe);
+    done = dev_submit(ctx);
+    if (done != 1 || !dev_reap(ctx, &cqe)) {
+        printf("submit returned %ld\n", done);
+        return -EIO;
+    }
+    if (cqe.user_data != sqe.user_data)
+        return -EIO;
+    if (written)
+        *written = cqe.len;
+    return cqe.result;
+}
+
+/* ----- AF_ALG reference ----- */
+
+static int alg_open(const char *type, const char *name,
+        const void *key, unsigned keylen, int setkey)
+{
+    struct sockaddr_alg sa;
+    int tfmfd, opfd;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.salg_family = AF_ALG;
+    strncpy((char *)sa.salg_type, type, sizeof(sa.salg_type) - 1);
+    strncpy((char *)sa.salg_name, name, sizeof(sa.salg_name) - 1);
+
+    tfmfd = socket(AF_ALG, SOCK_SEQPACKET, 0);
+    if (tfmfd < 0)
+        return -1;
+    if (bind(tfmfd, (struct sockaddr *)&sa, sizeof(sa)) < 0 ||
+            (setkey && setsockopt(tfmfd, SOL_ALG, ALG_SET_KEY,
+                    key, keylen) < 0)) {
+        close(tfmfd);
+        return -1;
+    }
+    opfd = accept(tfmfd, NULL, 0);
+    close(tfmfd);
+    return opfd;
+}
+
+static int alg_cipher(int opfd, int encrypt, const unsigned char *iv,
+        const unsigned char *in, unsigned char *out, size_t len)
+{
+    char cbuf[CMSG_SPACE(sizeof(__u32)) +
+            CMSG_SPACE(sizeof(struct af_alg_iv) + 16)];
+    struct af_alg_iv *aiv;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+
+    memset(cbuf, 0, sizeof(cbuf));
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_OP;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(__u32));
+    *(__u32 *)CMSG_DATA(cmsg) = encrypt ? ALG_OP_ENCRYPT : ALG_OP_DECRYPT;
+
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_IV;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct af_alg_iv) + 16);
+    aiv = (struct af_alg_iv *)CMSG_DATA(cmsg);
+    aiv->ivlen = 16;
+    memcpy(aiv->iv, iv, 16);
+
+    iov.iov_base = (void *)in;
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (sendmsg(opfd, &msg, 0) != (ssize_t)len)
+        return -1;
+    if (read(opfd, out, len) != (ssize_t)len)
+        return -1;
+    return 0;
+}
+
+static int alg_hash(int opfd, const unsigned char *in, size_t len,
+        unsigned char *out, size_t outlen)
+{
+    if (send(opfd, in, len, 0) != (ssize_t)len)
+        return -1;
+    if (read(opfd, out, outlen) != (ssize_t)outlen)
+        return -1;
+    return 0;
+}
+
+/* ----- tests ----- */
+
+static void test_setup(void)
+{
+    struct moto_crypto_dev_setup setup;
+    void *mem;
+    int fd;
+
+    fd = dev_open();
+    CHECK(fd >= 0, "open: %s", strerror(errno));
+    if (fd < 0)
+        return;
+
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SUBMIT) < 0 && errno == EINVAL,
+            "submit before setup");
+    CHECK(mmap(NULL, 4096, PROT_READ, MAP_SHARED, fd, 0) == MAP_FAILED,
+            "mmap before setup");
+
+    memset(&setup, 0, sizeof(setup));
+    setup.sq_entries = 0;
+    setup.cq_entries = 4;
+    setup.arena_size = 4096;
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SETUP, &setup) < 0 && errno == EINVAL,
+            "zero sq entries");
+    setup.sq_entries = MOTO_CRYPTO_DEV_MAX_ENTRIES + 1;
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SETUP, &setup) < 0 && errno == EINVAL,
+            "too many sq entries");
+    setup.sq_entries = 4;
+    setup.cq_entries = 0;
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SETUP, &setup) < 0 && errno == EINVAL,
+            "zero cq entries");
+    setup.cq_entries = 4;
+    setup.arena_size = MOTO_CRYPTO_DEV_MAX_ARENA + 1;
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SETUP, &setup) < 0 && errno == EINVAL,
+            "oversized arena");
+
+    setup.sq_entries = 3;
+    setup.cq_entries = 5;
+    setup.arena_size = 5000;
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SETUP, &setup) == 0,
+            "setup: %s", strerror(errno));
+    CHECK(setup.sq_entries == 4 && setup.cq_entries == 8,
+            "entries %u %u not rounded up", setup.sq_entries,
+            setup.cq_entries);
+    CHECK(setup.arena_size == 8192, "arena %u not page aligned",
+            setup.arena_size);
+    CHECK(setup.sq_off && setup.cq_off > setup.sq_off &&
+            setup.arena_off > setup.cq_off &&
+            setup.mmap_size == setup.arena_off + setup.arena_size,
+            "layout %u %u %u %u", setup.sq_off, setup.cq_off,
+            setup.arena_off, setup.mmap_size);
+    CHECK(ioctl(fd, MOTO_CRYPTO_IOC_SETUP, &setup) < 0 && errno == EBUSY,
+            "second setup");
+
+    mem = mmap(NULL, setup.mmap_size + 4096, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    CHECK(mem == MAP_FAILED, "oversized mmap");
+    mem = mmap(NULL, setup.mmap_size - 4096, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 4096);
+    CHECK(mem == MAP_FAILED, "mmap at an offset");
+    mem = mmap(NULL, setup.mmap_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    CHECK(mem != MAP_FAILED, "mmap: %s", strerror(errno));
+    if (mem != MAP_FAILED) {
+        struct moto_crypto_rings *rings = mem;
+
+        CHECK(rings->sq.entries == 4 && rings->sq.mask == 3 &&
+                rings->cq.entries == 8 && rings->cq.mask == 7,
+                "ring headers");
+        munmap(mem, setup.mmap_size);
+    }
+    close(fd);
+}
+
+static void test_sessions(struct dev_ctx *ctx)
+{
+    unsigned char key[MOTO_CRYPTO_DEV_MAX_KEY + 1];
+    int ids[MOTO_CRYPTO_DEV_MAX_SESSIONS];
+    int i, id;
+
+    memset(key, 0x5a, sizeof(key));
+    CHECK(dev_session(ctx, AES_CBC_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            key, sizeof(key)) == -EINVAL, "oversized key");
+    CHECK(dev_session(ctx, AES_CBC_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            key, 15) < 0, "bad AES key length");
+    CHECK(dev_session(ctx, AES_CBC_DRIVER, 7, aes_key, 16) == -EINVAL,
+            "bad session type");
+    CHECK(dev_session(ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            NULL, 0) < 0, "hash as a cipher");
+    CHECK(dev_session(ctx, "cbc(aes-generic)", MOTO_CRYPTO_SESSION_CIPHER,
+            aes_key, 16) < 0, "non moto driver");
+    CHECK(dev_session(ctx, "sha256-generic", MOTO_CRYPTO_SESSION_HASH,
+            NULL, 0) < 0, "non moto hash");
+    CHECK(dev_session(ctx, "moto_hmac(sha256-generic)",
+            MOTO_CRYPTO_SESSION_HASH, aes_key, 16) < 0,
+            "moto template over a non moto hash");
+    CHECK(dev_end_session(ctx, 0) == -EINVAL, "end of an unused session");
+    CHECK(dev_end_session(ctx, MOTO_CRYPTO_DEV_MAX_SESSIONS) == -EINVAL,
+            "end of an out of range session");
+
+    for (i = 0; i < MOTO_CRYPTO_DEV_MAX_SESSIONS; i++) {
+        ids[i] = dev_session(ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_HASH,
+                NULL, 0);
+        CHECK(ids[i] >= 0, "session %d: %d", i, ids[i]);
+    }
+    CHECK(dev_session(ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_HASH,
+            NULL, 0) == -ENOSPC, "session table overflow");
+    for (i = 0; i < MOTO_CRYPTO_DEV_MAX_SESSIONS; i++)
+        if (ids[i] >= 0)
+            CHECK(dev_end_session(ctx, ids[i]) == 0, "end %d", ids[i]);
+
+    id = dev_session(ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_HASH, NULL, 0);
+    CHECK(id >= 0, "session after freeing: %d", id);
+    if (id >= 0)
+        dev_end_session(ctx, id);
+}
+
+static void test_known_answers(struct dev_ctx *ctx)
+{
+    unsigned char *a = ctx->arena;
+    int cbc, ctr, sha, hmac, hmac0;
+    __u32 written;
+    int err;
+
+    cbc = dev_session(ctx, AES_CBC_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            aes_key, sizeof(aes_key));
+    ctr = dev_session(ctx, AES_CTR_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            aes_key, sizeof(aes_key));
+    sha = dev_session(ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_HASH, NULL, 0);
+    hmac = dev_session(ctx, HMAC_DRIVER, MOTO_CRYPTO_SESSION_HASH, "Jefe", 4);
+    hmac0 = dev_session(ctx, HMAC_DRIVER, MOTO_CRYPTO_SESSION_HASH, NULL, 0);
+    CHECK(cbc >= 0 && ctr >= 0 && sha >= 0 && hmac >= 0 && hmac0 >= 0,
+            "sessions %d %d %d %d %d", cbc, ctr, sha, hmac, hmac0);
+    if (cbc < 0 || ctr < 0 || sha < 0 || hmac < 0 || hmac0 < 0)
+        goto out;
+
+    /* CBC to a separate buffer, then back in place */
+    memcpy(a, aes_plain, 64);
+    memcpy(a + 256, aes_cbc_iv, 16);
+    err = dev_run(ctx, cbc, MOTO_CRYPTO_OP_ENCRYPT, 0, 64, 256, 64, &written);
+    CHECK(!err && written == 64, "cbc encrypt %d %u", err, written);
+    CHECK(!memcmp(a + 64, aes_cbc_cipher, 64), "cbc ciphertext");
+    CHECK(!memcmp(a + 256, aes_cbc_cipher + 48, 16), "cbc chaining value");
+
+    memcpy(a + 256, aes_cbc_iv, 16);
+    err = dev_run(ctx, cbc, MOTO_CRYPTO_OP_DECRYPT, 64, 64, 256, 64, NULL);
+    CHECK(!err && !memcmp(a + 64, aes_plain, 64), "cbc decrypt %d", err);
+
+    /* Two jobs sharing one IV continue the stream */
+    memcpy(a + 256, aes_cbc_iv, 16);
+    memcpy(a, aes_plain, 64);
+    err = dev_run(ctx, cbc, MOTO_CRYPTO_OP_ENCRYPT, 0, 0, 256, 32, NULL);
+    err |= dev_run(ctx, cbc, MOTO_CRYPTO_OP_ENCRYPT, 32, 32, 256, 32, NULL);
+    CHECK(!err && !memcmp(a, aes_cbc_cipher, 64), "chained cbc %d", err);
+
+    memcpy(a, aes_plain, 64);
+    memcpy(a + 256, aes_ctr_iv, 16);
+    err = dev_run(ctx, ctr, MOTO_CRYPTO_OP_ENCRYPT, 0, 0, 256, 48, NULL);
+    err |= dev_run(ctx, ctr, MOTO_CRYPTO_OP_ENCRYPT, 48, 48, 256, 16, NULL);
+    CHECK(!err && !memcmp(a, aes_ctr_cipher, 64), "chained ctr %d", err);
+
+    memcpy(a, "abc", 3);
+    err = dev_run(ctx, sha, MOTO_CRYPTO_OP_DIGEST, 0, 512, 0, 3, &written);
+    CHECK(!err && written == 32, "sha256 %d %u", err, written);
+    CHECK(!memcmp(a + 512, sha256_abc, 32), "sha256 digest");
+
+    memcpy(a, "what do ya want for nothing?", 28);
+    err = dev_run(ctx, hmac, MOTO_CRYPTO_OP_DIGEST, 0, 512, 0, 28, NULL);
+    CHECK(!err && !memcmp(a + 512, hmac_jefe, 32), "hmac %d", err);
+
+    err = dev_run(ctx, hmac0, MOTO_CRYPTO_OP_DIGEST, 0, 512, 0, 0, NULL);
+    CHECK(!err && !memcmp(a + 512, hmac_empty, 32), "empty key hmac %d",
+            err);
+
+out:
+    dev_end_session(ctx, cbc);
+    dev_end_session(ctx, ctr);
+    dev_end_session(ctx, sha);
+    dev_end_session(ctx, hmac);
+    dev_end_session(ctx, hmac0);
+}
+
+/*
+ * Every job here must fail with its own result while the ones queued
+ * after it still run, all from one SUBMIT.
+ */
+static void test_bounds(struct dev_ctx *ctx)
+{
+    const __u32 size = ctx->setup.arena_size;
+    int cbc, sha;
+    struct {
+        const char *what;
+        int hash;
+        __u32 op, src_off, dst_off, iv_off, len;
+        int result;
+    } jobs[] = {
+        { "src past the arena", 0, 0, size, 0, 0, 16, -EFAULT },
+        { "src runs off the arena", 0, 0, size - 16, 0, 0, 32, -EFAULT },
+        { "src wraps", 0, 0, 0xfffffff0u, 0, 0, 32, -EFAULT },
+        { "dst runs off the arena", 0, 0, 0, size - 16, 0, 32, -EFAULT },
+        { "iv runs off the arena", 0, 0, 0, 0, size - 8, 16, -EFAULT },
+        { "iv past the arena", 0, 0, 0, 0, 0xfffffff8u, 16, -EFAULT },
+        { "dst overlaps src", 0, 0, 0, 16, 1024, 64, -EINVAL },
+        { "src overlaps dst", 0, 0, 16, 0, 1024, 64, -EINVAL },
+        { "oversized job", 0, 0, 0, 0, 1024,
+                MOTO_CRYPTO_DEV_MAX_JOB_LEN + 16, -EMSGSIZE },
+        { "digest on a cipher", 0, MOTO_CRYPTO_OP_DIGEST, 0, 0, 1024, 16,
+                -EINVAL },
+        { "encrypt on a hash", 1, MOTO_CRYPTO_OP_ENCRYPT, 0, 64, 0, 16,
+                -EINVAL },
+        { "digest runs off the arena", 1, MOTO_CRYPTO_OP_DIGEST, 0,
+                size - 16, 0, 16, -EFAULT },
+        { "hashed data past the arena", 1, MOTO_CRYPTO_OP_DIGEST,
+                size - 8, 0, 0, 16, -EFAULT },
+        { "in place", 0, 0, 0, 0, 1024, 64, 0 },
+        { "disjoint", 0, 0, 0, 64, 1024, 64, 0 },
+        { "digest", 1, MOTO_CRYPTO_OP_DIGEST, 0, 2048, 0, 64, 0 },
+    };
+    struct moto_crypto_sqe sqe;
+    struct moto_crypto_cqe cqe;
+    unsigned i, n;
+    long done;
+
+    cbc = dev_session(ctx, AES_CBC_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            aes_key, sizeof(aes_key));
+    sha = dev_session(ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_HASH, NULL, 0);
+    CHECK(cbc >= 0 && sha >= 0, "sessions %d %d", cbc, sha);
+    if (cbc < 0 || sha < 0)
+        goto out;
+
+    memset(&sqe, 0, sizeof(sqe));
+    for (i = 0; i < ARRAY_SIZE(jobs); i++) {
+        sqe.user_data = i;
+        sqe.session = jobs[i].hash ? sha : cbc;
+        sqe.op = jobs[i].op;
+        sqe.src_off = jobs[i].src_off;
+        sqe.dst_off = jobs[i].dst_off;
+        sqe.iv_off = jobs[i].iv_off;
+        sqe.len = jobs[i].len;
+        dev_queue(ctx, &sqe);
+    }
+    /* Sessions out of range and unused */
+    sqe.user_data = i++;
+    sqe.session = MOTO_CRYPTO_DEV_MAX_SESSIONS;
+    dev_queue(ctx, &sqe);
+    sqe.user_data = i++;
+    sqe.session = MOTO_CRYPTO_DEV_MAX_SESSIONS - 1;
+    dev_queue(ctx, &sqe);
+
+    done = dev_submit(ctx);
+    CHECK(done == (long)i, "submit ran %ld of %u", done, i);
+    for (n = 0; dev_reap(ctx, &cqe); n++) {
+        int want = cqe.user_data < ARRAY_SIZE(jobs) ?
+                jobs[cqe.user_data].result : -EINVAL;
+        const char *what = cqe.user_data < ARRAY_SIZE(jobs) ?
+                jobs[cqe.user_data].what : "bad session";
+
+        CHECK(cqe.user_data == n, "completion %u out of order", n);
+        CHECK(cqe.result == want, "%s: %d, wanted %d", what, cqe.result,
+                want);
+        CHECK(cqe.result || cqe.len, "%s wrote nothing", what);
+        CHECK(!cqe.result || !cqe.len, "%s failed but wrote %u", what,
+                cqe.len);
+    }
+    CHECK(n == i, "reaped %u of %u", n, i);
+
+    /* A tail further than a ring away from head is refused as a whole */
+    ctx->rings->sq.tail = ctx->rings->sq.head + ctx->rings->sq.entries + 1;
+    CHECK(dev_submit(ctx) == -EINVAL, "tail past a full ring");
+    ctx->rings->sq.tail = ctx->rings->sq.head - 1;
+    CHECK(dev_submit(ctx) == -EINVAL, "tail behind head");
+    ctx->rings->sq.tail = ctx->rings->sq.head;
+    CHECK(dev_submit(ctx) == 0, "empty ring");
+
+out:
+    dev_end_session(ctx, cbc);
+    dev_end_session(ctx, sha);
+}
+
+/* SUBMIT stops when the completion ring is full and resumes once reaped */
+static void test_full_cq(void)
+{
+    struct moto_crypto_sqe sqe;
+    struct moto_crypto_cqe cqe;
+    struct dev_ctx ctx;
+    unsigned i, n;
+    int sha, err;
+    long done;
+
+    err = dev_setup(&ctx, 8, 4, 4096);
+    CHECK(!err, "setup %d", err);
+    if (err)
+        return;
+    sha = dev_session(&ctx, SHA256_DRIVER, MOTO_CRYPTO_SESSION_HASH, NULL, 0);
+    CHECK(sha >= 0, "session %d", sha);
+    if (sha < 0)
+        goto out;
+
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.session = sha;
+    sqe.op = MOTO_CRYPTO_OP_DIGEST;
+    sqe.len = 64;
+    for (i = 0; i < 8; i++) {
+        sqe.user_data = i;
+        sqe.dst_off = 1024 + i * 32;
+        dev_queue(&ctx, &sqe);
+    }
+
+    done = dev_submit(&ctx);
+    CHECK(done == 4, "first submit ran %ld", done);
+    CHECK(ctx.rings->sq.head == 4 && ctx.rings->cq.tail == 4,
+            "sq head %u cq tail %u", ctx.rings->sq.head, ctx.rings->cq.tail);
+    done = dev_submit(&ctx);
+    CHECK(done == 0, "submit into a full cq ran %ld", done);
+
+    for (n = 0; n < 2 && dev_reap(&ctx, &cqe); n++)
+        CHECK(cqe.user_data == n && !cqe.result, "cqe %u", n);
+    done = dev_submit(&ctx);
+    CHECK(done == 2, "submit after reaping two ran %ld", done);
+    while (dev_reap(&ctx, &cqe)) {
+        CHECK(cqe.user_data == n && !cqe.result, "cqe %u", n);
+        n++;
+    }
+    done = dev_submit(&ctx);
+    CHECK(done == 2, "last submit ran %ld", done);
+    while (dev_reap(&ctx, &cqe)) {
+        CHECK(cqe.user_data == n && !cqe.result, "cqe %u", n);
+        n++;
+    }
+    CHECK(n == 8, "reaped %u", n);
+
+    for (i = 1; i < 8; i++)
+        CHECK(!memcmp(ctx.arena + 1024, ctx.arena + 1024 + i * 32, 32),
+                "digest %u", i);
+
+    dev_end_session(&ctx, sha);
+out:
+    dev_close(&ctx);
+}
+
+/* Random lengths, keys and data against the kernel's generic drivers */
+static void test_af_alg(struct dev_ctx *ctx)
+{
+    unsigned char key[MOTO_CRYPTO_DEV_MAX_KEY];
+    unsigned char iv[16], ref[4096], md[32];
+    unsigned char *a = ctx->arena;
+    int round, cbc, hmac, opfd;
+    size_t len, keylen;
+    int err;
+
+    opfd = alg_open("skcipher", "cbc(aes-generic)", aes_key, 16, 1);
+    if (opfd < 0) {
+        printf("skipping AF_ALG comparison: %s\n", strerror(errno));
+        return;
+    }
+    close(opfd);
+
+    for (round = 0; round < 64; round++) {
+        keylen = (round & 1) ? 32 : 16;
+        moto_fill(key, keylen);
+        moto_fill(iv, sizeof(iv));
+        len = 16 * (1 + rand() % 256);
+        moto_fill(a, len);
+
+        cbc = dev_session(ctx, AES_CBC_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+                key, keylen);
+        opfd = alg_open("skcipher", "cbc(aes-generic)", key, keylen, 1);
+        CHECK(cbc >= 0 && opfd >= 0, "cbc sessions %d %d", cbc, opfd);
+        if (cbc < 0 || opfd < 0)
+            goto next_cbc;
+
+        memcpy(a + 8192, iv, 16);
+        err = alg_cipher(opfd, 1, iv, a, ref, len);
+        err |= dev_run(ctx, cbc, MOTO_CRYPTO_OP_ENCRYPT, 0, 4096, 8192,
+                len, NULL);
+        CHECK(!err && !memcmp(a + 4096, ref, len),
+                "cbc encrypt of %zu bytes, %zu byte key", len, keylen);
+
+        memcpy(a + 8192, iv, 16);
+        err = alg_cipher(opfd, 0, iv, a, ref, len);
+        err |= dev_run(ctx, cbc, MOTO_CRYPTO_OP_DECRYPT, 0, 4096, 8192,
+                len, NULL);
+        CHECK(!err && !memcmp(a + 4096, ref, len),
+                "cbc decrypt of %zu bytes, %zu byte key", len, keylen);
+
+next_cbc:
+        if (opfd >= 0)
+            close(opfd);
+        if (cbc >= 0)
+            dev_end_session(ctx, cbc);
+    }
+
+    /* Includes the empty key and keys longer than a block */
+    for (round = 0; round < 64; round++) {
+        keylen = round == 0 ? 0 : rand() % (sizeof(key) + 1);
+        moto_fill(key, keylen);
+        len = round == 1 ? 0 : rand() % 4096;
+        moto_fill(a, len);
+
+        hmac = dev_session(ctx, HMAC_DRIVER, MOTO_CRYPTO_SESSION_HASH,
+                key, keylen);
+        opfd = alg_open("hash", "hmac(sha256-generic)", key, keylen, 1);
+        CHECK(hmac >= 0 && opfd >= 0, "hmac sessions %d %d", hmac, opfd);
+        if (hmac < 0 || opfd < 0)
+            goto next_hmac;
+
+        err = alg_hash(opfd, a, len, md, sizeof(md));
+        err |= dev_run(ctx, hmac, MOTO_CRYPTO_OP_DIGEST, 0, 8192, 0, len,
+                NULL);
+        CHECK(!err && !memcmp(a + 8192, md, sizeof(md)),
+                "hmac of %zu bytes, %zu byte key", len, keylen);
+
+next_hmac:
+        if (opfd >= 0)
+            close(opfd);
+        if (hmac >= 0)
+            dev_end_session(ctx, hmac);
+    }
+}
+
+/*
+ * Records per second through AF_ALG, one sendmsg() and read() per
+ * record, and through the device, one SUBMIT per ring of records. Both
+ * run moto-aes-cbc so the difference is the interface.
+ */
+static void test_speed(double seconds, double min_gain)
+{
+    static const unsigned sizes[] = { 16, 64, 256, 1024 };
+    const unsigned entries = 1024;
+    unsigned char buf[1024], iv[16];
+    struct moto_crypto_sqe sqe;
+    struct moto_crypto_cqe cqe;
+    struct dev_ctx ctx;
+    unsigned i, s;
+    int cbc, opfd, err;
+
+    err = dev_setup(&ctx, entries, entries, entries * (1024 + 16));
+    CHECK(!err, "setup %d", err);
+    if (err)
+        return;
+    cbc = dev_session(&ctx, AES_CBC_DRIVER, MOTO_CRYPTO_SESSION_CIPHER,
+            aes_key, sizeof(aes_key));
+    opfd = alg_open("skcipher", AES_CBC_DRIVER, aes_key, sizeof(aes_key), 1);
+    CHECK(cbc >= 0, "session %d", cbc);
+    if (opfd < 0)
+        printf("no AF_ALG %s: %s, timing the device only\n",
+                AES_CBC_DRIVER, strerror(errno));
+    if (cbc < 0)
+        goto out;
+
+    moto_fill(ctx.arena, ctx.setup.arena_size);
+    moto_fill(buf, sizeof(buf));
+    memset(iv, 0, sizeof(iv));
+
+    printf("%8s %14s %14s %8s\n", "record", "af_alg rec/s", "dev rec/s",
+            "gain");
+    for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+        unsigned len = sizes[s];
+        double start, alg_rate = 0, dev_rate;
+        unsigned long records;
+
+        if (opfd >= 0) {
+            records = 0;
+            start = moto_now();
+            do {
+                for (i = 0; i < 256; i++)
+                    if (alg_cipher(opfd, 1, iv, buf, buf, len))
+                        break;
+                records += i;
+            } while (i == 256 && moto_now() - start < seconds);
+            CHECK(i == 256, "af_alg encrypt of %u bytes", len);
+            alg_rate = records / (moto_now() - start);
+        }
+
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.session = cbc;
+        sqe.op = MOTO_CRYPTO_OP_ENCRYPT;
+        sqe.len = len;
+        records = 0;
+        start = moto_now();
+        do {
+            for (i = 0; i < entries; i++) {
+                sqe.user_data = i;
+                sqe.src_off = i * 1024;
+                sqe.dst_off = sqe.src_off;
+                sqe.iv_off = entries * 1024 + i * 16;
+                dev_queue(&ctx, &sqe);
+            }
+            err = dev_submit(&ctx) != (long)entries;
+            while (dev_reap(&ctx, &cqe))
+                err |= cqe.result != 0;
+            records += entries;
+        } while (!err && moto_now() - start < seconds);
+        CHECK(!err, "device encrypt of %u bytes", len);
+        dev_rate = records / (moto_now() - start);
+
+        if (opfd < 0) {
+            printf("%8u %14s %14.0f %8s\n", len, "-", dev_rate, "-");
+            continue;
+        }
+        printf("%8u %14.0f %14.0f %7.1fx\n", len, alg_rate, dev_rate,
+                dev_rate / alg_rate);
+        /* The device is for small records, where the syscalls dominate */
+        if (len <= 256)
+            CHECK(dev_rate >= min_gain * alg_rate,
+                    "%u byte records only %.1fx faster than AF_ALG", len,
+                    dev_rate / alg_rate);
+    }
+
+    dev_end_session(&ctx, cbc);
+out:
+    if (opfd >= 0)
+        close(opfd);
+    dev_close(&ctx);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 1.0, min_gain = 2.0;
+    struct dev_ctx ctx;
+    int opt, err;
+
+    while ((opt = getopt(argc, argv, "g:t:")) != -1) {
+        switch (opt) {
+        case 'g':
+            min_gain = atof(optarg);
+            break;
+        case 't':
+            seconds = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-g min_gain] [-t seconds]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    err = dev_setup(&ctx, 64, 64, 64 << 10);
+    if (err == -ENOENT || err == -ENODEV || err == -ENXIO) {
+        printf("%s: %s, skipping\n", DEV_PATH, strerror(-err));
+        return 77;
+    }
+    if (err) {
+        printf("%s: %s\n", DEV_PATH, strerror(-err));
+        return 1;
+    }
+    srand(time(NULL));
+
+    test_setup();
+    test_sessions(&ctx);
+    test_known_answers(&ctx);
+    test_bounds(&ctx);
+    test_full_cq();
+    test_af_alg(&ctx);
+    dev_close(&ctx);
+    test_speed(seconds, min_gain);
+
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
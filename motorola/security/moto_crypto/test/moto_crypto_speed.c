@@ -0,0 +1,731 @@
+/*
+ * Throughput benchmark for the moto_crypto drivers, after crypto/tcrypt.c.
+ *
+ * Every moto-* driver is timed next to the generic kernel implementation
+ * of the same algorithm, for buffer lengths from 16 bytes to 64 KB,
+ * in-place and out-of-place, with one or several scatterlist entries,
+ * and through both the synchronous and the asynchronous API.  Each
+ * measurement is reported as one line of key=value pairs:
+ *
+ *   moto_speed: driver=moto-aes-cbc alg=cbc(aes) op=encrypt api=async
+ *   sg=multi buf=inplace len=4096 ops=256 ns=... cycles=...
+ *   cycles_per_byte=... ops_per_sec=...
+ *
+ * (on a single line).  buf is "none" for hashes and sg and buf are "none"
+ * for the CPRNG.  cycles is 0 on targets without get_cycles().
+ *
+ * api=batch lines time MOTO_SPEED_BATCH digest() requests in flight at
+ * once, the load a multi-buffer driver such as moto-sha256-mb batches;
+ * ops counts the requests.
+ *
+ * Module parameters:
+ *   alg=<str>   only run drivers whose driver or algorithm name contains str
+ *   generic=0   skip the generic drivers
+ *   sec=<n>     run each measurement for n seconds instead of for a fixed
+ *               amount of data
+ *
+ * Like tcrypt, the module fails to load once the run is over so that it
+ * can be inserted again without being removed.
+ */
+#include <crypto/aead.h>
+#include <crypto/hash.h>
+#include <crypto/rng.h>
+#include <linux/atomic.h>
+#include <linux/completion.h>
+#include <linux/err.h>
+#include <linux/gfp.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/timex.h>
+
+/* Largest buffer and the room behind it for an AEAD tag */
+#define MOTO_SPEED_MAX_LEN      65536
+#define MOTO_SPEED_TAIL         64
+#define MOTO_SPEED_MAX_SG       8
+#define MOTO_SPEED_MAX_KEY      64
+#define MOTO_SPEED_IVLEN        16
+#define MOTO_SPEED_WARMUP       4
+
+/* Amount of data per measurement when sec is 0 */
+#define MOTO_SPEED_BYTES        (1 << 20)
+#define MOTO_SPEED_MIN_OPS      16
+
+#define MOTO_SPEED_GCM_TAG      16
+
+/* Digest requests in flight at once for MOTO_SPEED_HASH_BATCH */
+#define MOTO_SPEED_BATCH        64
+
+static char *alg_param;
+static int generic_param = 1;
+static unsigned int sec_param;
+
+static const unsigned int moto_speed_lens[] = {
+    16, 64, 256, 1024, 4096, 16384, 65536
+};
+
+enum moto_speed_type {
+    MOTO_SPEED_CIPHER,
+    MOTO_SPEED_AEAD,
+    MOTO_SPEED_HASH,
+    MOTO_SPEED_HASH_BATCH,
+    MOTO_SPEED_RNG,
+};
+
+struct moto_speed_desc {
+    const char *alg;
+    const char *driver;
+    enum moto_speed_type type;
+    unsigned int klen;
+    int generic;
+};
+
+static const struct moto_speed_desc moto_speed_descs[] = {
+    { "ecb(aes)", "moto-aes-ecb", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ecb(aes)", "moto-aes-bs-ecb", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ecb(aes)", "moto-aes-bs-ssse3-ecb", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ecb(aes)", "moto-aes-ni-ecb", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ecb(aes)", "ecb(aes-generic)", MOTO_SPEED_CIPHER, 16, 1 },
+    { "cbc(aes)", "moto-aes-cbc", MOTO_SPEED_CIPHER, 16, 0 },
+    { "cbc(aes)", "moto-aes-bs-cbc", MOTO_SPEED_CIPHER, 16, 0 },
+    { "cbc(aes)", "moto-aes-bs-ssse3-cbc", MOTO_SPEED_CIPHER, 16, 0 },
+    { "cbc(aes)", "moto-aes-ni-cbc", MOTO_SPEED_CIPHER, 16, 0 },
+    { "cbc(aes)", "cbc(aes-generic)", MOTO_SPEED_CIPHER, 16, 1 },
+    { "ctr(aes)", "moto-aes-ctr", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ctr(aes)", "moto-aes-bs-ctr", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ctr(aes)", "moto-aes-bs-ssse3-ctr", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ctr(aes)", "moto-aes-ni-ctr", MOTO_SPEED_CIPHER, 16, 0 },
+    { "ctr(aes)", "ctr(aes-generic)", MOTO_SPEED_CIPHER, 16, 1 },
+    { "xts(aes)", "moto-aes-xts", MOTO_SPEED_CIPHER, 32, 0 },
+    { "xts(aes)", "xts(aes-generic)", MOTO_SPEED_CIPHER, 32, 1 },
+    { "gcm(aes)", "moto-aes-gcm", MOTO_SPEED_AEAD, 16, 0 },
+    { "gcm(aes)", "gcm_base(ctr(aes-generic),ghash-generic)",
+            MOTO_SPEED_AEAD, 16, 1 },
+    { "ecb(des3_ede)", "moto-des3-ecb", MOTO_SPEED_CIPHER, 24, 0 },
+    { "ecb(des3_ede)", "ecb(des3_ede-generic)", MOTO_SPEED_CIPHER, 24, 1 },
+    { "cbc(des3_ede)", "moto-des3-cbc", MOTO_SPEED_CIPHER, 24, 0 },
+    { "cbc(des3_ede)", "cbc(des3_ede-generic)", MOTO_SPEED_CIPHER, 24, 1 },
+    { "sha1", "moto-sha1", MOTO_SPEED_HASH, 0, 0 },
+    { "sha1", "moto-sha1-ni", MOTO_SPEED_HASH, 0, 0 },
+    { "sha1", "moto-sha1-avx2", MOTO_SPEED_HASH, 0, 0 },
+    { "sha1", "moto-sha1-ssse3", MOTO_SPEED_HASH, 0, 0 },
+    { "sha1", "sha1-generic", MOTO_SPEED_HASH, 0, 1 },
+    { "sha224", "moto-sha224", MOTO_SPEED_HASH, 0, 0 },
+    { "sha224", "moto-sha224-ni", MOTO_SPEED_HASH, 0, 0 },
+    { "sha224", "moto-sha224-avx2", MOTO_SPEED_HASH, 0, 0 },
+    { "sha224", "moto-sha224-ssse3", MOTO_SPEED_HASH, 0, 0 },
+    { "sha224", "sha224-generic", MOTO_SPEED_HASH, 0, 1 },
+    { "sha256", "moto-sha256", MOTO_SPEED_HASH, 0, 0 },
+    { "sha256", "moto-sha256-ni", MOTO_SPEED_HASH, 0, 0 },
+    { "sha256", "moto-sha256-avx2", MOTO_SPEED_HASH, 0, 0 },
+    { "sha256", "moto-sha256-ssse3", MOTO_SPEED_HASH, 0, 0 },
+    { "sha256", "sha256-generic", MOTO_SPEED_HASH, 0, 1 },
+    /* the multi-buffer driver next to the one it batches over */
+    { "sha256", "moto-sha256-mb", MOTO_SPEED_HASH_BATCH, 0, 0 },
+    { "sha256", "moto-sha256", MOTO_SPEED_HASH_BATCH, 0, 0 },
+    { "sha384", "moto-sha384", MOTO_SPEED_HASH, 0, 0 },
+    { "sha384", "sha384-generic", MOTO_SPEED_HASH, 0, 1 },
+    { "sha512", "moto-sha512", MOTO_SPEED_HASH, 0, 0 },
+    { "sha512", "sha512-generic", MOTO_SPEED_HASH, 0, 1 },
+    { "sha512_224", "moto-sha512_224", MOTO_SPEED_HASH, 0, 0 },
+    { "sha512_256", "moto-sha512_256", MOTO_SPEED_HASH, 0, 0 },
+    { "hmac(sha1)", "moto_hmac(moto-sha1)", MOTO_SPEED_HASH, 20, 0 },
+    { "hmac(sha1)", "hmac(sha1-generic)", MOTO_SPEED_HASH, 20, 1 },
+    { "hmac(sha256)", "moto_hmac(moto-sha256)", MOTO_SPEED_HASH, 32, 0 },
+    { "hmac(sha256)", "hmac(sha256-generic)", MOTO_SPEED_HASH, 32, 1 },
+    { "hmac(sha512)", "moto_hmac(moto-sha512)", MOTO_SPEED_HASH, 64, 0 },
+    { "hmac(sha512)", "hmac(sha512-generic)", MOTO_SPEED_HASH, 64, 1 },
+    { "ansi_cprng", "moto_fips_ansi_cprng", MOTO_SPEED_RNG, 0, 0 },
+    { "ansi_cprng", "moto_fips_ansi_cprng_percpu", MOTO_SPEED_RNG, 0, 0 },
+    { "ansi_cprng", "ansi_cprng", MOTO_SPEED_RNG, 0, 1 },
+};
+
+struct moto_speed_result {
+    struct completion completion;
+    int err;
+};
+
+/* One benchmark run: the buffers and the operation being timed */
+struct moto_speed_ctx {
+    const struct moto_speed_desc *desc;
+    u8 *src;
+    u8 *dst;
+    struct scatterlist src_sg[MOTO_SPEED_MAX_SG];
+    struct scatterlist dst_sg[MOTO_SPEED_MAX_SG];
+    struct scatterlist *dst_sgp;
+    struct scatterlist assoc_sg;
+    u8 iv[MOTO_SPEED_IVLEN];
+    u8 digest[64];
+    struct moto_speed_result result;
+    unsigned int len;
+    int enc;
+    int async;
+    int multi_sg;
+    int inplace;
+
+    struct blkcipher_desc bdesc;
+    struct ablkcipher_request *areq;
+    struct aead_request *aead_req;
+    struct hash_desc hdesc;
+    struct ahash_request *hreq;
+    struct ahash_request *hreqs[MOTO_SPEED_BATCH];
+    atomic_t pending;
+    struct crypto_rng *rng;
+};
+
+static void moto_speed_complete(struct crypto_async_request *req, int err)
+{
+    struct moto_speed_result *res = req->data;
+
+    if (err == -EINPROGRESS)
+        return;
+
+    res->err = err;
+    complete(&res->completion);
+}
+
+static void moto_speed_batch_complete(struct crypto_async_request *req,
+        int err)
+{
+    struct moto_speed_ctx *ctx = req->data;
+
+    if (err == -EINPROGRESS)
+        return;
+
+    if (err)
+        ctx->result.err = err;
+    if (atomic_dec_and_test(&ctx->pending))
+        complete(&ctx->result.completion);
+}
+
+static int moto_speed_wait(struct moto_speed_result *res, int ret)
+{
+    if (ret == -EINPROGRESS || ret == -EBUSY) {
+        wait_for_completion(&res->completion);
+        INIT_COMPLETION(res->completion);
+        ret = res->err;
+    }
+    return ret;
+}
+
+/*
+ * Split len bytes of buf over up to MOTO_SPEED_MAX_SG entries of 16 bytes
+ * or more, the last entry taking the remainder.
+ */
+static void moto_speed_init_sg(struct scatterlist *sg, u8 *buf,
+        unsigned int len, int multi_sg)
+{
+    unsigned int nents = 1;
+    unsigned int chunk;
+    unsigned int i;
+
+    if (multi_sg)
+        nents = min_t(unsigned int, MOTO_SPEED_MAX_SG, len / 16);
+    if (nents == 0)
+        nents = 1;
+    chunk = len / nents;
+
+    sg_init_table(sg, nents);
+    for (i = 0; i < nents - 1; i++)
+        sg_set_buf(&sg[i], buf + i * chunk, chunk);
+    sg_set_buf(&sg[i], buf + i * chunk, len - i * chunk);
+}
+
+static int moto_speed_cipher_op(struct moto_speed_ctx *ctx)
+{
+    int ret;
+
+    if (!ctx->async) {
+        if (ctx->enc)
+            return crypto_blkcipher_encrypt_iv(&ctx->bdesc, ctx->dst_sgp,
+                    ctx->src_sg, ctx->len);
+        return crypto_blkcipher_decrypt_iv(&ctx->bdesc, ctx->dst_sgp,
+                ctx->src_sg, ctx->len);
+    }
+
+    ablkcipher_request_set_crypt(ctx->areq, ctx->src_sg, ctx->dst_sgp,
+            ctx->len, ctx->iv);
+    ret = ctx->enc ? crypto_ablkcipher_encrypt(ctx->areq) :
+            crypto_ablkcipher_decrypt(ctx->areq);
+    return moto_speed_wait(&ctx->result, ret);
+}
+
+/* Only encryption, decryption of the unauthenticated buffer would fail */
+static int moto_speed_aead_op(struct moto_speed_ctx *ctx)
+{
+    aead_request_set_crypt(ctx->aead_req, ctx->src_sg, ctx->dst_sgp,
+            ctx->len, ctx->iv);
+    aead_request_set_assoc(ctx->aead_req, &ctx->assoc_sg, 0);
+    return moto_speed_wait(&ctx->result,
+            crypto_aead_encrypt(ctx->aead_req));
+}
+
+static int moto_speed_hash_op(struct moto_speed_ctx *ctx)
+{
+    if (!ctx->async)
+        return crypto_hash_digest(&ctx->hdesc, ctx->src_sg, ctx->len,
+                ctx->digest);
+
+    ahash_request_set_crypt(ctx->hreq, ctx->src_sg, ctx->digest, ctx->len);
+    return moto_speed_wait(&ctx->result, crypto_ahash_digest(ctx->hreq));
+}
+
+/*
+ * MOTO_SPEED_BATCH digests of the same message, each into its own slot of
+ * dst.  pending holds one count for the submitter, so the completion only
+ * fires once every request was both submitted and completed.
+ */
+static int moto_speed_hash_batch_op(struct moto_speed_ctx *ctx)
+{
+    int i, ret, err = 0;
+
+    ctx->result.err = 0;
+    atomic_set(&ctx->pending, MOTO_SPEED_BATCH + 1);
+    for (i = 0; i < MOTO_SPEED_BATCH; i++) {
+        ahash_request_set_crypt(ctx->hreqs[i], ctx->src_sg,
+                ctx->dst + i * sizeof(ctx->digest), ctx->len);
+        ret = crypto_ahash_digest(ctx->hreqs[i]);
+        if (ret == -EINPROGRESS || ret == -EBUSY)
+            continue;
+        if (ret)
+            err = ret;
+        atomic_dec(&ctx->pending);
+    }
+    if (!atomic_dec_and_test(&ctx->pending)) {
+        wait_for_completion(&ctx->result.completion);
+        INIT_COMPLETION(ctx->result.completion);
+    }
+    return err ?: ctx->result.err;
+}
+
+static int moto_speed_rng_op(struct moto_speed_ctx *ctx)
+{
+    int ret = crypto_rng_get_bytes(ctx->rng, ctx->dst, ctx->len);
+
+    return ret < 0 ? ret : 0;
+}
+
+static int moto_speed_op(struct moto_speed_ctx *ctx)
+{
+    switch (ctx->desc->type) {
+    case MOTO_SPEED_CIPHER:
+        return moto_speed_cipher_op(ctx);
+    case MOTO_SPEED_AEAD:
+        return moto_speed_aead_op(ctx);
+    case MOTO_SPEED_HASH:
+        return moto_speed_hash_op(ctx);
+    case MOTO_SPEED_HASH_BATCH:
+        return moto_speed_hash_batch_op(ctx);
+    case MOTO_SPEED_RNG:
+        return moto_speed_rng_op(ctx);
+    }
+    return -EINVAL;
+}
+
+/*
+ * Time one configuration and print its result line. Async requests are
+ * waited for one at a time, so async measures the cost of the request
+ * path rather than any queueing.
+ */
+static int moto_speed_measure(struct moto_speed_ctx *ctx, const char *op)
+{
+    const struct moto_speed_desc *desc = ctx->desc;
+    unsigned int batch = desc->type == MOTO_SPEED_HASH_BATCH ?
+            MOTO_SPEED_BATCH : 1;
+    unsigned long end = 0;
+    unsigned int ops = 0;
+    unsigned int target;
+    cycles_t cycles;
+    ktime_t start;
+    u64 ns, bytes, cpb, cpb_int, rate;
+    int i, ret;
+
+    if (desc->type != MOTO_SPEED_RNG) {
+        moto_speed_init_sg(ctx->src_sg, ctx->src,
+                ctx->len + (desc->type == MOTO_SPEED_AEAD ?
+                MOTO_SPEED_GCM_TAG : 0), ctx->multi_sg);
+        ctx->dst_sgp = ctx->src_sg;
+        if (!ctx->inplace) {
+            moto_speed_init_sg(ctx->dst_sg, ctx->dst,
+                    ctx->len + (desc->type == MOTO_SPEED_AEAD ?
+                    MOTO_SPEED_GCM_TAG : 0), ctx->multi_sg);
+            ctx->dst_sgp = ctx->dst_sg;
+        }
+    }
+
+    for (i = 0; i < MOTO_SPEED_WARMUP; i++) {
+        ret = moto_speed_op(ctx);
+        if (ret)
+            goto out;
+    }
+
+    target = max_t(unsigned int, MOTO_SPEED_MIN_OPS,
+            MOTO_SPEED_BYTES / (ctx->len * batch));
+    if (sec_param)
+        end = jiffies + sec_param * HZ;
+
+    start = ktime_get();
+    cycles = get_cycles();
+    do {
+        ret = moto_speed_op(ctx);
+        if (ret)
+            goto out;
+        ops++;
+        cond_resched();
+    } while (sec_param ? time_before(jiffies, end) : ops < target);
+    cycles = get_cycles() - cycles;
+    ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+    ops *= batch;
+
+    bytes = (u64)ops * ctx->len;
+    /* Two decimals, without a 64-bit modulo on 32-bit targets */
+    cpb = div64_u64((u64)cycles * 100, bytes);
+    cpb_int = div64_u64(cpb, 100);
+    rate = ns ? div64_u64((u64)ops * NSEC_PER_SEC, ns) : 0;
+
+    printk(KERN_INFO "moto_speed: driver=%s alg=%s op=%s api=%s sg=%s "
+            "buf=%s len=%u ops=%u ns=%llu cycles=%llu "
+            "cycles_per_byte=%llu.%02llu ops_per_sec=%llu\n",
+            desc->driver, desc->alg, op, batch > 1 ? "batch" :
+            ctx->async ? "async" : "sync",
+            desc->type == MOTO_SPEED_RNG ? "none" :
+            ctx->multi_sg ? "multi" : "single",
+            desc->type >= MOTO_SPEED_HASH ? "none" :
+            ctx->inplace ? "inplace" : "outofplace", ctx->len, ops,
+            ns, (u64)cycles, cpb_int, cpb - cpb_int * 100, rate);
+    return 0;
+
+    out:
+    printk(KERN_ERR "moto_speed: driver=%s alg=%s op=%s len=%u err=%d\n",
+            desc->driver, desc->alg, op, ctx->len, ret);
+    return ret;
+}
+
+/*
+ * Measure every buffer length for both scatterlist layouts, and for both
+ * buffer placements if placement is set.
+ */
+static int moto_speed_sweep(struct moto_speed_ctx *ctx, const char *op,
+        int placement)
+{
+    int i, ret;
+
+    for (ctx->multi_sg = 0; ctx->multi_sg < 2; ctx->multi_sg++) {
+        for (ctx->inplace = 1; ctx->inplace >= !placement; ctx->inplace--) {
+            for (i = 0; i < ARRAY_SIZE(moto_speed_lens); i++) {
+                ctx->len = moto_speed_lens[i];
+                ret = moto_speed_measure(ctx, op);
+                if (ret)
+                    return ret;
+            }
+        }
+    }
+    return 0;
+}
+
+static int moto_speed_cipher(struct moto_speed_ctx *ctx)
+{
+    const struct moto_speed_desc *desc = ctx->desc;
+    struct crypto_blkcipher *btfm;
+    struct crypto_ablkcipher *atfm;
+    u8 key[MOTO_SPEED_MAX_KEY];
+    int ret;
+
+    get_random_bytes(key, desc->klen);
+    get_random_bytes(ctx->iv, sizeof(ctx->iv));
+
+    btfm = crypto_alloc_blkcipher(desc->driver, 0, 0);
+    if (IS_ERR(btfm))
+        return PTR_ERR(btfm);
+    ret = crypto_blkcipher_setkey(btfm, key, desc->klen);
+    if (ret)
+        goto out_blk;
+    ctx->bdesc.tfm = btfm;
+    ctx->bdesc.info = ctx->iv;
+    ctx->bdesc.flags = 0;
+    ctx->async = 0;
+    for (ctx->enc = 1; ctx->enc >= 0; ctx->enc--) {
+        ret = moto_speed_sweep(ctx, ctx->enc ? "encrypt" : "decrypt", 1);
+        if (ret)
+            goto out_blk;
+    }
+
+    atfm = crypto_alloc_ablkcipher(desc->driver, 0, 0);
+    if (IS_ERR(atfm)) {
+        ret = PTR_ERR(atfm);
+        goto out_blk;
+    }
+    ret = crypto_ablkcipher_setkey(atfm, key, desc->klen);
+    if (ret)
+        goto out_ablk;
+    ctx->areq = ablkcipher_request_alloc(atfm, GFP_KERNEL);
+    if (!ctx->areq) {
+        ret = -ENOMEM;
+        goto out_ablk;
+    }
+    ablkcipher_request_set_callback(ctx->areq, CRYPTO_TFM_REQ_MAY_BACKLOG,
+            moto_speed_complete, &ctx->result);
+    ctx->async = 1;
+    for (ctx->enc = 1; ctx->enc >= 0; ctx->enc--) {
+        ret = moto_speed_sweep(ctx, ctx->enc ? "encrypt" : "decrypt", 1);
+        if (ret)
+            break;
+    }
+    ablkcipher_request_free(ctx->areq);
+
+    out_ablk:
+    crypto_free_ablkcipher(atfm);
+    out_blk:
+    crypto_free_blkcipher(btfm);
+    memset(key, 0, sizeof(key));
+    return ret;
+}
+
+/* AEADs have no synchronous interface */
+static int moto_speed_aead(struct moto_speed_ctx *ctx)
+{
+    const struct moto_speed_desc *desc = ctx->desc;
+    struct crypto_aead *tfm;
+    u8 key[MOTO_SPEED_MAX_KEY];
+    int ret;
+
+    get_random_bytes(key, desc->klen);
+    get_random_bytes(ctx->iv, sizeof(ctx->iv));
+    sg_init_one(&ctx->assoc_sg, ctx->digest, 0);
+
+    tfm = crypto_alloc_aead(desc->driver, 0, 0);
+    if (IS_ERR(tfm))
+        return PTR_ERR(tfm);
+    ret = crypto_aead_setkey(tfm, key, desc->klen);
+    if (!ret)
+        ret = crypto_aead_setauthsize(tfm, MOTO_SPEED_GCM_TAG);
+    if (ret)
+        goto out;
+    ctx->aead_req = aead_request_alloc(tfm, GFP_KERNEL);
+    if (!ctx->aead_req) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    aead_request_set_callback(ctx->aead_req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+            moto_speed_complete, &ctx->result);
+    ctx->async = 1;
+    ctx->enc = 1;
+    ret = moto_speed_sweep(ctx, "encrypt", 1);
+    aead_request_free(ctx->aead_req);
+
+    out:
+    crypto_free_aead(tfm);
+    memset(key, 0, sizeof(key));
+    return ret;
+}
+
+static int moto_speed_hash(struct moto_speed_ctx *ctx)
+{
+    const struct moto_speed_desc *desc = ctx->desc;
+    struct crypto_hash *htfm;
+    struct crypto_ahash *atfm;
+    u8 key[MOTO_SPEED_MAX_KEY];
+    int ret = 0;
+
+    get_random_bytes(key, desc->klen);
+
+    htfm = crypto_alloc_hash(desc->driver, 0, 0);
+    if (IS_ERR(htfm))
+        return PTR_ERR(htfm);
+    if (desc->klen)
+        ret = crypto_hash_setkey(htfm, key, desc->klen);
+    if (ret)
+        goto out_hash;
+    ctx->hdesc.tfm = htfm;
+    ctx->hdesc.flags = 0;
+    ctx->async = 0;
+    ret = moto_speed_sweep(ctx, "digest", 0);
+    if (ret)
+        goto out_hash;
+
+    atfm = crypto_alloc_ahash(desc->driver, 0, 0);
+    if (IS_ERR(atfm)) {
+        ret = PTR_ERR(atfm);
+        goto out_hash;
+    }
+    if (desc->klen)
+        ret = crypto_ahash_setkey(atfm, key, desc->klen);
+    if (ret)
+        goto out_ahash;
+    ctx->hreq = ahash_request_alloc(atfm, GFP_KERNEL);
+    if (!ctx->hreq) {
+        ret = -ENOMEM;
+        goto out_ahash;
+    }
+    ahash_request_set_callback(ctx->hreq, CRYPTO_TFM_REQ_MAY_BACKLOG,
+            moto_speed_complete, &ctx->result);
+    ctx->async = 1;
+    ret = moto_speed_sweep(ctx, "digest", 0);
+    ahash_request_free(ctx->hreq);
+
+    out_ahash:
+    crypto_free_ahash(atfm);
+    out_hash:
+    crypto_free_hash(htfm);
+    memset(key, 0, sizeof(key));
+    return ret;
+}
+
+/* Asynchronous interface only, the synchronous one cannot batch */
+static int moto_speed_hash_batch(struct moto_speed_ctx *ctx)
+{
+    const struct moto_speed_desc *desc = ctx->desc;
+    struct crypto_ahash *tfm;
+    int i, ret = 0;
+
+    tfm = crypto_alloc_ahash(desc->driver, 0, 0);
+    if (IS_ERR(tfm))
+        return PTR_ERR(tfm);
+    for (i = 0; i < MOTO_SPEED_BATCH; i++) {
+        ctx->hreqs[i] = ahash_request_alloc(tfm, GFP_KERNEL);
+        if (!ctx->hreqs[i]) {
+            ret = -ENOMEM;
+            goto out;
+        }
+        ahash_request_set_callback(ctx->hreqs[i],
+                CRYPTO_TFM_REQ_MAY_BACKLOG, moto_speed_batch_complete, ctx);
+    }
+    ctx->async = 1;
+    ret = moto_speed_sweep(ctx, "digest", 0);
+
+    out:
+    for (i = 0; i < MOTO_SPEED_BATCH && ctx->hreqs[i]; i++) {
+        ahash_request_free(ctx->hreqs[i]);
+        ctx->hreqs[i] = NULL;
+    }
+    crypto_free_ahash(tfm);
+    return ret;
+}
+
+static int moto_speed_rng(struct moto_speed_ctx *ctx)
+{
+    u8 seed[MOTO_SPEED_MAX_KEY];
+    int seedsize;
+    int i, ret;
+
+    ctx->rng = crypto_alloc_rng(ctx->desc->driver, 0, 0);
+    if (IS_ERR(ctx->rng))
+        return PTR_ERR(ctx->rng);
+
+    seedsize = crypto_rng_seedsize(ctx->rng);
+    ret = -EINVAL;
+    if (seedsize > sizeof(seed))
+        goto out;
+    get_random_bytes(seed, seedsize);
+    ret = crypto_rng_reset(ctx->rng, seed, seedsize);
+    if (ret)
+        goto out;
+
+    ctx->async = 0;
+    ctx->multi_sg = 0;
+    ctx->inplace = 0;
+    for (i = 0; i < ARRAY_SIZE(moto_speed_lens); i++) {
+        ctx->len = moto_speed_lens[i];
+        ret = moto_speed_measure(ctx, "generate");
+        if (ret)
+            break;
+    }
+
+    out:
+    crypto_free_rng(ctx->rng);
+    memset(seed, 0, sizeof(seed));
+    return ret;
+}
+
+static int moto_speed_selected(const struct moto_speed_desc *desc)
+{
+    if (desc->generic && !generic_param)
+        return 0;
+    if (!alg_param || !*alg_param)
+        return 1;
+    return strstr(desc->driver, alg_param) || strstr(desc->alg, alg_param);
+}
+
+/* Module entry point */
+static int __init moto_crypto_speed_init(void)
+{
+    struct moto_speed_ctx *ctx;
+    int order = get_order(MOTO_SPEED_MAX_LEN + MOTO_SPEED_TAIL);
+    int i, ret = -ENOMEM;
+
+    printk(KERN_INFO "moto_crypto_speed_init\n");
+
+    ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        goto out;
+    ctx->src = (u8 *)__get_free_pages(GFP_KERNEL, order);
+    ctx->dst = (u8 *)__get_free_pages(GFP_KERNEL, order);
+    if (!ctx->src || !ctx->dst)
+        goto out_free;
+    get_random_bytes(ctx->src, MOTO_SPEED_MAX_LEN);
+    init_completion(&ctx->result.completion);
+
+    for (i = 0; i < ARRAY_SIZE(moto_speed_descs); i++) {
+        ctx->desc = &moto_speed_descs[i];
+        if (!moto_speed_selected(ctx->desc))
+            continue;
+
+        switch (ctx->desc->type) {
+        case MOTO_SPEED_CIPHER:
+            ret = moto_speed_cipher(ctx);
+            break;
+        case MOTO_SPEED_AEAD:
+            ret = moto_speed_aead(ctx);
+            break;
+        case MOTO_SPEED_HASH:
+            ret = moto_speed_hash(ctx);
+            break;
+        case MOTO_SPEED_HASH_BATCH:
+            ret = moto_speed_hash_batch(ctx);
+            break;
+        case MOTO_SPEED_RNG:
+            ret = moto_speed_rng(ctx);
+            break;
+        }
+        if (ret)
+            printk(KERN_INFO "moto_speed: driver=%s alg=%s skipped err=%d\n",
+                    ctx->desc->driver, ctx->desc->alg, ret);
+    }
+    printk(KERN_INFO "moto_speed: done\n");
+
+    /* Don't stay loaded, see the comment at the top */
+    ret = -EAGAIN;
+
+    out_free:
+    if (ctx->src)
+        free_pages((unsigned long)ctx->src, order);
+    if (ctx->dst)
+        free_pages((unsigned long)ctx->dst, order);
+    kfree(ctx);
+    out:
+    return ret;
+}
+
+/* Module finalization function */
+static void __exit moto_crypto_speed_fini(void)
+{
+}
+
+module_init(moto_crypto_speed_init);
+module_exit(moto_crypto_speed_fini);
+
+module_param_named(alg, alg_param, charp, 0);
+MODULE_PARM_DESC(alg, "Only run drivers whose name contains this string");
+module_param_named(generic, generic_param, int, 0);
+MODULE_PARM_DESC(generic, "Also run the generic drivers (default 1)");
+module_param_named(sec, sec_param, uint, 0);
+MODULE_PARM_DESC(sec, "Seconds per measurement, 0 for a fixed data size");
+
+MODULE_DESCRIPTION("Motorola cryptographic module speed test");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS("crypto_speed");
@@ -15,11 +15,17 @@
 #include "moto_crypto_test.h"
 
 #define TEST_AES
+/* needs alg_test_aes_xts.c, generated with ParseAlg.py -a xts */
+#undef TEST_AES_XTS
 #define TEST_SHA1
 #define TEST_SHA224
 #define TEST_SHA256
 #define TEST_SHA384
 #define TEST_SHA512
+/* need alg_test_sha512_224.c and alg_test_sha512_256.c, generated with
+ * ParseAlg.py -a sha from a req set that has the SHA-512/t files */
+#undef TEST_SHA512_224
+#undef TEST_SHA512_256
 #define TEST_TDES
 #define TEST_RNG
 #define TEST_HMAC
@@ -300,6 +306,10 @@ static struct scatterlist *vmalloc_to_sg(unsigned char *const buf,
 #include "alg_test_aes.c" 
 #endif
 
+#ifdef TEST_AES_XTS
+#include "alg_test_aes_xts.c"
+#endif
+
 #ifdef TEST_SHA1
 #include "alg_test_sha1.c" 
 #endif
@@ -320,6 +330,14 @@ static struct scatterlist *vmalloc_to_sg(unsigned char *const buf,
 #include "alg_test_sha512.c" 
 #endif
 
+#ifdef TEST_SHA512_224
+#include "alg_test_sha512_224.c" 
+#endif
+
+#ifdef TEST_SHA512_256
+#include "alg_test_sha512_256.c" 
+#endif
+
 #ifdef TEST_TDES
 #include "alg_test_tdes.c" 
 #endif
@@ -1417,6 +1435,29 @@ abort:
         crypto_free_hash(desc.tfm);
 }
 
+/*
+ * Vectors and Monte Carlo test of the x86 SHA variant drivers, see
+ * moto_sha_x86.c. Variants the CPU does not support are not registered.
+ */
+static void moto_test_sha_x86(const char *alg, char *seed)
+{
+#ifdef CONFIG_X86_64
+    static const char *variants[] = { "ni", "avx2", "ssse3" };
+    char driver[CRYPTO_MAX_ALG_NAME];
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(variants); i++) {
+        snprintf(driver, sizeof(driver), "moto-%s-%s", alg, variants[i]);
+        if (!crypto_has_alg(driver, 0, 0)) {
+            printk(KERN_INFO "%s not registered\n", driver);
+            continue;
+        }
+        moto_test_alg_test(driver, alg, 0, 0);
+        moto_test_hash_monte(driver, seed);
+    }
+#endif
+}
+
 /* Module entry point */
 static int __init moto_crypto_test_init(void)
 {
@@ -1449,20 +1490,29 @@ static int __init moto_crypto_test_init(void)
     }
     rc = moto_test_alg_test("moto-aes-cbc", "cbc(aes)", 0, 0);
 #endif
+#ifdef TEST_AES_XTS
+    printk(KERN_INFO "Starting XTS AES tests\n");
+    rc = moto_test_alg_test("moto-aes-xts", "xts(aes)", 0, 0);
+#endif
 #ifdef TEST_SHA1
     printk(KERN_INFO "Starting SHA-1 tests\n");
     rc = moto_test_alg_test("moto-sha1", "sha1", 0, 0);
     moto_test_hash_monte("moto-sha1", moto_test_monte_SHA1);
+    moto_test_sha_x86("sha1", moto_test_monte_SHA1);
 #endif
 #ifdef TEST_SHA224
     printk(KERN_INFO "Starting SHA-224 tests\n");
     rc = moto_test_alg_test("moto-sha224", "sha224", 0, 0);
     moto_test_hash_monte("moto-sha224", moto_test_monte_SHA224);
+    moto_test_sha_x86("sha224", moto_test_monte_SHA224);
 #endif
 #ifdef TEST_SHA256
     printk(KERN_INFO "Starting SHA-256 tests\n");
     rc = moto_test_alg_test("moto-sha256", "sha256", 0, 0);
     moto_test_hash_monte("moto-sha256", moto_test_monte_SHA256);
+    moto_test_sha_x86("sha256", moto_test_monte_SHA256);
+    /* asynchronous, the Monte Carlo test only takes synchronous hashes */
+    rc = moto_test_alg_test("moto-sha256-mb", "sha256", 0, 0);
 #endif
 #ifdef TEST_SHA384
     printk(KERN_INFO "Starting SHA-384 tests\n");
@@ -1474,6 +1524,16 @@ static int __init moto_crypto_test_init(void)
     rc = moto_test_alg_test("moto-sha512", "sha512", 0, 0);
     moto_test_hash_monte("moto-sha512", moto_test_monte_SHA512);
 #endif
+#ifdef TEST_SHA512_224
+    printk(KERN_INFO "Starting SHA-512/224 tests\n");
+    rc = moto_test_alg_test("moto-sha512_224", "sha512_224", 0, 0);
+    moto_test_hash_monte("moto-sha512_224", moto_test_monte_SHA512_224);
+#endif
+#ifdef TEST_SHA512_256
+    printk(KERN_INFO "Starting SHA-512/256 tests\n");
+    rc = moto_test_alg_test("moto-sha512_256", "sha512_256", 0, 0);
+    moto_test_hash_monte("moto-sha512_256", moto_test_monte_SHA512_256);
+#endif
 #ifdef TEST_HMAC
     printk(KERN_INFO "Starting HMAC(SHA-1) tests\n");
     rc = moto_test_alg_test("moto_hmac(moto-sha1)", NULL, 0, 0);
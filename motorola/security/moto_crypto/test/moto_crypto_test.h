@@ -66,5 +66,15 @@ struct moto_test_cprng_testvec {
 
 #define MOTO_CRYPTO_MODULE_INTEGRITY 0x00400000
 
+#define MOTO_CRYPTO_ALG_AES_XTS_128 0x00800000
+#define MOTO_CRYPTO_ALG_AES_XTS_256 0x01000000
+#define MOTO_CRYPTO_ALG_AES_GCM_128 0x02000000
+#define MOTO_CRYPTO_ALG_AES_GCM_192 0x04000000
+#define MOTO_CRYPTO_ALG_AES_GCM_256 0x08000000
+#define MOTO_CRYPTO_ALG_AUTHENC     0x10000000
+#define MOTO_CRYPTO_ALG_SHA512_224  0x20000000
+#define MOTO_CRYPTO_ALG_SHA512_256  0x40000000
+/* moto_hmac over moto-sha512_224 and moto-sha512_256 uses HMAC_SHA512 */
+
 #endif
 